@@ -0,0 +1,700 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#include <chrono>
+
+#include "AudioSendPath.h"
+#include "CapturePipeline.h"
+#include "ConnectToAgora.h"
+
+// Media timestamps handed to the SDK are in milliseconds
+static const BMDTimeScale kTimestampScale = 1000;
+
+// The SDK takes PCM in 10 ms chunks
+static const int kAudioChunkMs = 10;
+
+// Drift compensation: the buffered audio level is averaged over about a
+// second of chunks, a level error is worked off over a minute, and the
+// resampling ratio never strays further than this from 1
+static const double kAudioLevelSmoothing = 0.01;
+static const double kAudioLevelCorrectionSeconds = 60.0;
+static const double kMaxAudioCorrectionPpm = 1000.0;
+
+// The meter thread wakes this often to drain its ring, publishes a loudness
+// reading at the slower update interval, and can fall this far behind before
+// its ring drops audio
+static const int kMeterPollMs = 50;
+static const int kLoudnessUpdateMs = 200;
+static const int kMeterRingMs = 500;
+
+// A/V sync: both streams' send latencies are averaged over about half a
+// second, and video that has not been sent for this long is left out of the
+// measurement
+static const double kSyncLatencySmoothing = 0.02;
+static const int kSyncVideoTimeoutMs = 1000;
+
+// Mix input clocks are learned from frame arrival the same way as the
+// capture clock
+static const double kMixClockSmoothing = 1.0 / (1 << CaptureClock::kSmoothingShift);
+
+AudioSendPath::AudioSendPath(const CaptureClock* captureClock) :
+	m_captureClock(captureClock),
+	m_resampleInputEndMs(0),
+	m_comfortNoiseState(1),
+	m_metering(false),
+	m_streamToHardwareMs(0),
+	m_hasStreamToHardware(false),
+	m_audioDelayPending(false),
+	m_maxDelayMs(0),
+	m_maxAudioDelayChunks(0),
+	m_audioLatencyMs(0),
+	m_hasAudioLatency(false),
+	m_videoLatencyMs(0),
+	m_videoLatencyUpdatedNs(0),
+	m_audioDelayChunks(0),
+	m_videoDelayNs(0),
+	m_avOffsetMs(0),
+	m_mixing(false),
+	m_running(false),
+	m_audioChunksSent(0),
+	m_audioSendFailures(0),
+	m_audioUnderruns(0),
+	m_audioSkippedChunks(0),
+	m_audioSilentChunks(0),
+	m_audioDtxChunks(0),
+	m_audioCorrectionPpm(0)
+{
+	for (MixInputClock& clock : m_mixClocks)
+		clock = MixInputClock{0, false};
+}
+
+AudioSendPath::~AudioSendPath()
+{
+	stop();
+}
+
+bool AudioSendPath::start(int maxDelayMs)
+{
+	if (m_running)
+		return false;
+
+	const float* routingGains = options.audio.routingGains.empty() ? nullptr : options.audio.routingGains.data();
+	if (!options.audio.routingGains.empty() &&
+		options.audio.routingGains.size() != (size_t)options.audio.numOfChannels * options.capture.audioChannels)
+	{
+		printf("Audio routing matrix needs %d x %d gains\n", options.audio.numOfChannels, options.capture.audioChannels);
+		return false;
+	}
+	if (!InitChannelMatrix(&m_channelMatrix, options.capture.audioChannels, options.audio.numOfChannels, routingGains))
+	{
+		printf("Invalid audio routing from %d to %d channels\n", options.capture.audioChannels, options.audio.numOfChannels);
+		return false;
+	}
+
+	// Each published track takes the next run of send channels
+	std::vector<int>	trackChannels = getAudioTrackChannels();
+	int					trackChannelSum = 0;
+	for (int channels : trackChannels)
+		trackChannelSum += channels > 0 ? channels : kMaxAudioChannels + 1;
+	if (trackChannelSum != options.audio.numOfChannels)
+	{
+		printf("Audio tracks must split the %d send channels into runs of at least one\n", options.audio.numOfChannels);
+		return false;
+	}
+
+	// The ring holds audio as captured; conversion and routing happen once
+	// per chunk at the send boundary. Room for twice the latency bound, so the
+	// audio thread rather than the ring decides what to drop when the backlog
+	// grows
+	int sampleBytes = options.capture.audioSampleBits == 32 ? sizeof(int32_t) : sizeof(int16_t);
+	int chunkFrames = options.audio.sampleRate * kAudioChunkMs / 1000;
+	int ringChunks = 2 * options.audio.maxLatencyMs / kAudioChunkMs;
+	if (ringChunks < 4)
+		ringChunks = 4;
+	if (!m_audioRing.Init(options.capture.audioChannels, sampleBytes, options.audio.sampleRate, chunkFrames, ringChunks))
+	{
+		printf("Failed to allocate audio ring for %d channels at %d Hz\n", options.capture.audioChannels, options.audio.sampleRate);
+		return false;
+	}
+	m_audioS16Buffer.assign((size_t)chunkFrames * options.capture.audioChannels, 0);
+	m_audioMixBuffer.assign((size_t)chunkFrames * options.audio.numOfChannels, 0);
+	m_audioResampleBuffer.assign((size_t)chunkFrames * options.audio.numOfChannels, 0);
+	InitAudioDither(&m_audioDither, 1);
+	m_audioDrift.Init(options.audio.sampleRate);
+	m_driftResampler.Init(options.audio.numOfChannels, 3 * chunkFrames);
+	m_audioTracks.resize(trackChannels.size());
+	for (size_t i = 0; i < trackChannels.size(); i++)
+	{
+		AudioTrack& track = m_audioTracks[i];
+
+		track.channels = trackChannels[i];
+		track.buffer.assign(trackChannels.size() > 1 ? (size_t)chunkFrames * track.channels : 0, 0);
+		track.silenceDetector.Init(options.audio.silenceThresholdDbfs, options.audio.silenceHysteresisDb,
+								   options.audio.silenceHoldMs / kAudioChunkMs);
+	}
+	m_comfortNoiseBuffer.assign(options.audio.dtxMode == kDtxComfortNoise ? (size_t)chunkFrames * options.audio.numOfChannels : 0, 0);
+
+	// Mix inputs are summed in the capture layout, ahead of routing. Their
+	// callbacks may still be writing while the program restarts, so the mixer
+	// is only set up when its layout changes
+	int mixInputs = (int)options.audio.mixInputs.size();
+	if (mixInputs > AudioMixer::kMaxInputs)
+		mixInputs = AudioMixer::kMaxInputs;
+	m_mixing = mixInputs > 0;
+	if (m_mixing)
+	{
+		if ((m_audioMixer.inputs() != mixInputs || m_audioMixer.channels() != options.capture.audioChannels) &&
+			!m_audioMixer.Init(options.capture.audioChannels, options.audio.sampleRate, chunkFrames, mixInputs, ringChunks))
+		{
+			printf("Failed to set up mixing of %d audio inputs\n", mixInputs);
+			return false;
+		}
+		m_audioInputMixBuffer.assign((size_t)chunkFrames * options.capture.audioChannels, 0);
+		setMixGain(AudioMixer::kProgramInput, options.audio.mixProgramGain);
+		for (int i = 0; i < mixInputs; i++)
+			setMixGain(i + 1, options.audio.mixInputs[i].gain);
+	}
+
+	// The meter takes the program as mixed, which is 16-bit once anything is
+	// mixed into it
+	int meterSampleBytes = m_mixing ? sizeof(int16_t) : sampleBytes;
+	m_loudness = LoudnessReading{-HUGE_VAL, -HUGE_VAL, -HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+	m_metering = options.audio.loudnessMeter;
+	if (m_metering &&
+		(!m_meterRing.Init(options.capture.audioChannels, meterSampleBytes, options.audio.sampleRate, chunkFrames, kMeterRingMs / kAudioChunkMs) ||
+		 !m_loudnessMeter.Init(options.audio.sampleRate, options.capture.audioChannels)))
+	{
+		printf("Failed to set up loudness metering, continuing without it\n");
+		m_metering = false;
+	}
+	m_audioCorrectionPpm = 0;
+	m_hasStreamToHardware = false;
+
+	// The audio delay line holds formatted send chunks: the longest delay, the
+	// chunk just written and the one handed out last
+	m_maxDelayMs = maxDelayMs > 0 ? maxDelayMs : 0;
+	m_maxAudioDelayChunks = m_maxDelayMs / kAudioChunkMs;
+	if (!m_audioDelayLine.Init(options.audio.numOfChannels, sizeof(int16_t), options.audio.sampleRate, chunkFrames, m_maxAudioDelayChunks + 2))
+	{
+		printf("Failed to allocate audio delay line for %d ms\n", m_maxDelayMs);
+		return false;
+	}
+	m_audioDelayPending = false;
+	m_hasAudioLatency = false;
+	m_videoLatencyUpdatedNs = 0;
+	m_audioDelayChunks = 0;
+	m_videoDelayNs = 0;
+	m_avOffsetMs = 0;
+	if (!options.sync.autoCorrect)
+	{
+		// Fixed trims only, applied from the first chunk
+		int audioDelayMs = options.sync.audioDelayMs < m_maxDelayMs ? options.sync.audioDelayMs : m_maxDelayMs;
+		int videoDelayMs = options.sync.videoDelayMs < m_maxDelayMs ? options.sync.videoDelayMs : m_maxDelayMs;
+		m_audioDelayChunks = audioDelayMs > 0 ? audioDelayMs / kAudioChunkMs : 0;
+		m_videoDelayNs = videoDelayMs > 0 ? (int64_t)videoDelayMs * 1000000 : 0;
+	}
+
+	m_audioChunksSent = 0;
+	m_audioSendFailures = 0;
+	m_audioUnderruns = 0;
+	m_audioSkippedChunks = 0;
+	m_audioSilentChunks = 0;
+	m_audioDtxChunks = 0;
+
+	m_running = true;
+	m_audioThread = std::thread(&AudioSendPath::audioThread, this);
+	if (m_metering)
+		m_meterThread = std::thread(&AudioSendPath::meterThread, this);
+
+	// Named so per-thread CPU time can be told apart (top -H, pipeline_bench)
+	pthread_setname_np(m_audioThread.native_handle(), "audio");
+	if (m_metering)
+		pthread_setname_np(m_meterThread.native_handle(), "meter");
+
+	return true;
+}
+
+void AudioSendPath::stop(void)
+{
+	if (!m_running)
+		return;
+
+	m_running = false;
+	m_audioReady.Set();
+	m_meterReady.Set();
+
+	if (m_audioThread.joinable())
+		m_audioThread.join();
+	if (m_meterThread.joinable())
+		m_meterThread.join();
+}
+
+void AudioSendPath::push(IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket* audioPacket)
+{
+	void*			buffer;
+	long			frameCount;
+	int64_t			timestampMs;
+	BMDTimeValue	hardwareTime;
+	BMDTimeValue	hardwareDuration;
+	BMDTimeValue	streamTime;
+	BMDTimeValue	streamDuration;
+	BMDTimeValue	packetTime;
+
+	if (!m_running)
+		return;
+
+	frameCount = audioPacket->GetSampleFrameCount();
+	if (frameCount <= 0 || audioPacket->GetBytes(&buffer) != S_OK)
+		return;
+
+	// Audio and video stream times share one timeline. Each video frame
+	// refreshes the offset from stream time to the hardware reference clock,
+	// which places audio on the same clock as video even in callbacks that
+	// carry no video frame. Until the first frame after a (re)start, packets
+	// are stamped by arrival on the mapped clock, less their own duration
+	if (videoFrame != nullptr &&
+		videoFrame->GetStreamTime(&streamTime, &streamDuration, kTimestampScale) == S_OK &&
+		videoFrame->GetHardwareReferenceTimestamp(kTimestampScale, &hardwareTime, &hardwareDuration) == S_OK)
+	{
+		m_streamToHardwareMs = hardwareTime - streamTime;
+		m_hasStreamToHardware = true;
+	}
+
+	if (m_hasStreamToHardware && audioPacket->GetPacketTime(&packetTime, kTimestampScale) == S_OK)
+		timestampMs = packetTime + m_streamToHardwareMs;
+	else
+		timestampMs = (m_captureClock->captureNs(CaptureClock::monotonicNowNs()) - (int64_t)frameCount * 1000000000 / m_audioRing.sample_rate()) / 1000000;
+
+	m_audioDrift.AddPacket(timestampMs, (size_t)frameCount);
+	m_audioRing.Write(buffer, (size_t)frameCount, timestampMs);
+	m_audioReady.Set();
+}
+
+void AudioSendPath::pushMix(int input, IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket* audioPacket)
+{
+	int64_t			nowNs = CaptureClock::monotonicNowNs();
+	void*			buffer;
+	long			frameCount;
+	int64_t			timestampMs;
+	BMDTimeValue	streamTime;
+	BMDTimeValue	streamDuration;
+	BMDTimeValue	packetTime;
+
+	if (!m_running || !m_mixing || input < 1 || input > m_audioMixer.inputs())
+		return;
+
+	MixInputClock& clock = m_mixClocks[input - 1];
+
+	// The input's stream time is mapped onto the monotonic clock at the
+	// arrival of each frame, the same point the program's hardware timestamps
+	// are mapped at, so both sides carry the same callback latency
+	if (videoFrame != nullptr && videoFrame->GetStreamTime(&streamTime, &streamDuration, kTimestampScale) == S_OK)
+	{
+		double offsetMs = nowNs * 1e-6 - streamTime;
+
+		if (!clock.valid || offsetMs < clock.streamToMonotonicMs || offsetMs - clock.streamToMonotonicMs > CaptureClock::kResetMs)
+			clock.streamToMonotonicMs = offsetMs;
+		else
+			clock.streamToMonotonicMs += kMixClockSmoothing * (offsetMs - clock.streamToMonotonicMs);
+		clock.valid = true;
+	}
+
+	if (audioPacket == nullptr)
+		return;
+
+	frameCount = audioPacket->GetSampleFrameCount();
+	if (frameCount <= 0 || audioPacket->GetBytes(&buffer) != S_OK)
+		return;
+
+	if (clock.valid && audioPacket->GetPacketTime(&packetTime, kTimestampScale) == S_OK)
+		timestampMs = llround(packetTime + clock.streamToMonotonicMs);
+	else
+		timestampMs = (nowNs - (int64_t)frameCount * 1000000000 / options.audio.sampleRate) / 1000000;
+
+	m_audioMixer.Write(input, (const int16_t*)buffer, (size_t)frameCount, timestampMs);
+}
+
+void AudioSendPath::setMixGain(int input, double gain)
+{
+	m_audioMixer.SetGain(input, gain, options.audio.mixGainRampMs);
+}
+
+void AudioSendPath::updateVideoLatency(double latencyMs, int64_t nowNs)
+{
+	if (m_videoLatencyUpdatedNs != 0)
+		latencyMs = m_videoLatencyMs + kSyncLatencySmoothing * (latencyMs - m_videoLatencyMs);
+	m_videoLatencyMs = latencyMs;
+	m_videoLatencyUpdatedNs = nowNs;
+}
+
+void AudioSendPath::getStats(CaptureQueueStats* stats) const
+{
+	stats->audioChunksSent = m_audioChunksSent;
+	stats->audioSendFailures = m_audioSendFailures;
+	stats->audioUnderruns = m_audioUnderruns;
+	stats->audioSkippedChunks = m_audioSkippedChunks;
+	stats->audioOverrunFrames = m_audioRing.OverrunFrames();
+	stats->audioTracks = m_audioTracks.size();
+	stats->audioSilentChunks = m_audioSilentChunks;
+	stats->audioDtxChunks = m_audioDtxChunks;
+	stats->audioMixInputs = m_mixing ? m_audioMixer.inputs() : 0;
+	stats->audioMixSlips = m_audioMixer.SlippedChunks();
+	stats->audioDriftPpm = m_audioDrift.DriftPpm();
+	stats->audioCorrectionPpm = m_audioCorrectionPpm;
+	{
+		std::lock_guard<std::mutex> lock(m_loudnessMutex);
+		stats->loudness = m_loudness;
+	}
+	stats->avOffsetMs = m_avOffsetMs;
+	stats->audioDelayMs = (double)m_audioDelayChunks * kAudioChunkMs;
+	stats->videoDelayMs = m_videoDelayNs * 1e-6;
+}
+
+const int16_t* AudioSendPath::formatAudioChunk(const void* chunk, int64_t timestampMs)
+{
+	const int16_t*	samples = (const int16_t*)chunk;
+	int				frames = m_audioRing.chunk_frames();
+
+	// 32-bit capture is requantized to what the SDK takes exactly once, here
+	if (m_audioRing.sample_bytes() == sizeof(int32_t))
+	{
+		ConvertS32ToS16((const int32_t*)chunk, m_audioS16Buffer.data(), frames * m_audioRing.channels(),
+						options.capture.ditherAudio ? &m_audioDither : nullptr);
+		samples = m_audioS16Buffer.data();
+	}
+
+	// Mix inputs are stamped on the monotonic clock
+	if (m_mixing)
+	{
+		m_audioMixer.Mix(samples, timestampMs - m_captureClock->monotonicToHardwareNs() / 1000000, m_audioInputMixBuffer.data());
+		samples = m_audioInputMixBuffer.data();
+	}
+
+	// The meter measures every capture channel of the program as mixed, at
+	// full capture resolution when nothing is mixed in. A full meter ring
+	// drops the chunk; the meter thread waking on its own schedule keeps this
+	// a plain copy
+	if (m_metering)
+		m_meterRing.Write(m_mixing ? (const void*)samples : chunk, frames, 0);
+
+	if (!m_channelMatrix.identity)
+	{
+		MixChannels(samples, m_audioMixBuffer.data(), frames, m_channelMatrix);
+		samples = m_audioMixBuffer.data();
+	}
+
+	return samples;
+}
+
+bool AudioSendPath::resampleAudioChunk(double ratio, int64_t* timestampMs)
+{
+	int		chunkFrames = m_audioRing.chunk_frames();
+	int		needed = m_driftResampler.InputFramesNeeded(chunkFrames, ratio);
+
+	while (needed > 0)
+	{
+		int64_t			chunkTimestampMs;
+		const void*		chunk = m_audioRing.PeekChunk(&chunkTimestampMs);
+
+		if (chunk == nullptr)
+			return false;
+
+		m_driftResampler.Push(formatAudioChunk(chunk, chunkTimestampMs), chunkFrames);
+		m_audioRing.ConsumeChunk();
+		m_resampleInputEndMs = chunkTimestampMs + kAudioChunkMs;
+		needed = m_driftResampler.InputFramesNeeded(chunkFrames, ratio);
+	}
+
+	// The first output frame lies the pending input before the end of what
+	// was pushed
+	*timestampMs = m_resampleInputEndMs - llround(m_driftResampler.PendingFrames() * 1000 / m_audioRing.sample_rate());
+	m_driftResampler.Pull(m_audioResampleBuffer.data(), chunkFrames, ratio);
+	return true;
+}
+
+void AudioSendPath::audioThread(void)
+{
+	const std::chrono::milliseconds			chunkPeriod(kAudioChunkMs);
+	const bool								compensateDrift = options.audio.driftCompensation;
+	const int								chunkFrames = m_audioRing.chunk_frames();
+	std::chrono::steady_clock::time_point	nextSend;
+	size_t									prefillChunks;
+	size_t									maxChunks;
+	double									targetFrames;
+	double									levelFrames = 0;
+	bool									playing = false;
+
+	prefillChunks = options.audio.prefillMs / kAudioChunkMs;
+	if (prefillChunks < 1)
+		prefillChunks = 1;
+	maxChunks = options.audio.maxLatencyMs / kAudioChunkMs;
+	if (maxChunks < prefillChunks + 1)
+		maxChunks = prefillChunks + 1;
+	targetFrames = (double)prefillChunks * chunkFrames;
+
+	while (m_running)
+	{
+		size_t	available = m_audioRing.AvailableChunks();
+
+		// Buffer a little before (re)starting, so packets arriving in bursts
+		// at the video frame rate do not leave gaps between them
+		if (!playing)
+		{
+			if (available < prefillChunks)
+			{
+				m_audioReady.Wait(kAudioChunkMs);
+				continue;
+			}
+			playing = true;
+			nextSend = std::chrono::steady_clock::now();
+			m_driftResampler.Reset();
+			for (AudioTrack& track : m_audioTracks)
+				track.silenceDetector.Reset();
+			levelFrames = targetFrames;
+		}
+
+		if (available == 0 && (!compensateDrift || m_driftResampler.InputFramesNeeded(chunkFrames, 1.0) > 0))
+		{
+			++m_audioUnderruns;
+			playing = false;
+			continue;
+		}
+
+		// The capture clock ran ahead of ours; drop back to the prefill level
+		// instead of letting latency grow
+		if (available > maxChunks)
+		{
+			for (; available > prefillChunks; available--)
+			{
+				m_audioRing.ConsumeChunk();
+				++m_audioSkippedChunks;
+			}
+			m_driftResampler.Reset();
+			levelFrames = targetFrames;
+		}
+
+		int64_t			timestampMs;
+		const void*		chunk = nullptr;
+		const int16_t*	samples;
+
+		if (compensateDrift)
+		{
+			// Feed forward the capture clock error measured against the
+			// hardware reference clock, and steer the buffered level back to
+			// the prefill target, which also absorbs any difference between
+			// the reference clock and the clock pacing this thread
+			double	correctionPpm;
+
+			levelFrames += kAudioLevelSmoothing * ((double)available * chunkFrames + m_driftResampler.PendingFrames() - levelFrames);
+			correctionPpm = m_audioDrift.DriftPpm() +
+							(levelFrames - targetFrames) * 1e6 / (m_audioRing.sample_rate() * kAudioLevelCorrectionSeconds);
+			if (correctionPpm > kMaxAudioCorrectionPpm)
+				correctionPpm = kMaxAudioCorrectionPpm;
+			else if (correctionPpm < -kMaxAudioCorrectionPpm)
+				correctionPpm = -kMaxAudioCorrectionPpm;
+			m_audioCorrectionPpm = correctionPpm;
+
+			if (!resampleAudioChunk(1.0 + correctionPpm * 1e-6, &timestampMs))
+			{
+				++m_audioUnderruns;
+				playing = false;
+				continue;
+			}
+			samples = m_audioResampleBuffer.data();
+		}
+		else
+		{
+			chunk = m_audioRing.PeekChunk(&timestampMs);
+			samples = formatAudioChunk(chunk, timestampMs);
+		}
+
+		updateAvSync(timestampMs);
+		const int16_t* delayed = delayAudioChunk(samples, &timestampMs);
+		if (delayed != nullptr)
+			sendAudioChunk(delayed, timestampMs);
+		if (chunk != nullptr)
+			m_audioRing.ConsumeChunk();
+		++m_audioChunksSent;
+
+		// Pace on an absolute schedule; after a stall restart it rather than
+		// sending the missed chunks in a burst
+		nextSend += chunkPeriod;
+		if (std::chrono::steady_clock::now() - nextSend > 4 * chunkPeriod)
+			nextSend = std::chrono::steady_clock::now();
+		std::this_thread::sleep_until(nextSend);
+	}
+}
+
+void AudioSendPath::sendAudioChunk(const int16_t* samples, int64_t timestampMs)
+{
+	const int		chunkFrames = m_audioRing.chunk_frames();
+	const DtxMode	dtxMode = options.audio.dtxMode;
+	const bool		split = m_audioTracks.size() > 1;
+
+	// Several tracks are split out of the send channels in one pass; a single
+	// track goes out straight from |samples|
+	if (split)
+	{
+		int			channels[kMaxAudioChannels];
+		int16_t*	buffers[kMaxAudioChannels];
+
+		for (size_t i = 0; i < m_audioTracks.size(); i++)
+		{
+			channels[i] = m_audioTracks[i].channels;
+			buffers[i] = m_audioTracks[i].buffer.data();
+		}
+		SplitChannels(samples, chunkFrames, options.audio.numOfChannels, channels, (int)m_audioTracks.size(), buffers);
+	}
+
+	for (size_t i = 0; i < m_audioTracks.size(); i++)
+	{
+		AudioTrack&		track = m_audioTracks[i];
+		const int16_t*	trackSamples = split ? track.buffer.data() : samples;
+		int				trackSampleCount = chunkFrames * track.channels;
+		AudioLevel		level;
+		bool			silent;
+
+		// Silence is judged per track on exactly what would go out. Withheld
+		// chunks still take their slot in the schedule, so timestamps stay
+		// continuous
+		MeasureAudioLevel(trackSamples, trackSampleCount, &level);
+		silent = track.silenceDetector.Update(level, trackSampleCount);
+		if (silent)
+			++m_audioSilentChunks;
+
+		if (silent && dtxMode == kDtxComfortNoise)
+		{
+			GenerateComfortNoise(m_comfortNoiseBuffer.data(), trackSampleCount, options.audio.comfortNoiseDbfs, &m_comfortNoiseState);
+			trackSamples = m_comfortNoiseBuffer.data();
+		}
+		if (silent && dtxMode != kDtxOff)
+			++m_audioDtxChunks;
+
+		if ((!silent || dtxMode != kDtxSkip) && sendOnePcmFrame((int)i, trackSamples, timestampMs) != 1)
+			++m_audioSendFailures;
+	}
+}
+
+void AudioSendPath::updateAvSync(int64_t audioTimestampMs)
+{
+	int64_t		nowNs = CaptureClock::monotonicNowNs();
+	double		latencyMs = m_captureClock->captureNs(nowNs) * 1e-6 - audioTimestampMs;
+	double		skewMs;
+	double		audioDelayMs;
+	double		videoDelayMs;
+	int			audioDelayChunks;
+
+	m_audioLatencyMs = m_hasAudioLatency ? m_audioLatencyMs + kSyncLatencySmoothing * (latencyMs - m_audioLatencyMs) : latencyMs;
+	m_hasAudioLatency = true;
+
+	// Nothing to line up with while video is not flowing
+	if (nowNs - m_videoLatencyUpdatedNs > kSyncVideoTimeoutMs * 1000000LL)
+		return;
+
+	// Positive when audio, left undelayed, would reach the sender later
+	// than the video captured with it
+	skewMs = m_audioLatencyMs - m_videoLatencyMs;
+
+	if (options.sync.autoCorrect)
+	{
+		// Hold back whichever stream is ahead, on top of the fixed trims.
+		// Audio moves in whole chunks, and only once it is short of its target
+		// or more than a chunk over, so measurement noise does not keep
+		// adding and dropping audio; video takes up the remainder exactly
+		audioDelayMs = options.sync.audioDelayMs + (skewMs < 0 ? -skewMs : 0);
+		videoDelayMs = options.sync.videoDelayMs + (skewMs > 0 ? skewMs : 0);
+		if (audioDelayMs > m_maxDelayMs)
+			audioDelayMs = m_maxDelayMs;
+
+		audioDelayChunks = m_audioDelayChunks;
+		if (audioDelayChunks * kAudioChunkMs < audioDelayMs || audioDelayChunks * kAudioChunkMs > audioDelayMs + kAudioChunkMs)
+		{
+			audioDelayChunks = (int)ceil(audioDelayMs / kAudioChunkMs);
+			if (audioDelayChunks > m_maxAudioDelayChunks)
+				audioDelayChunks = m_maxAudioDelayChunks;
+			if (audioDelayChunks < 0)
+				audioDelayChunks = 0;
+			m_audioDelayChunks = audioDelayChunks;
+		}
+
+		videoDelayMs += audioDelayChunks * kAudioChunkMs - audioDelayMs;
+		if (videoDelayMs > m_maxDelayMs)
+			videoDelayMs = m_maxDelayMs;
+		if (videoDelayMs < 0)
+			videoDelayMs = 0;
+		m_videoDelayNs = llround(videoDelayMs * 1e6);
+	}
+
+	m_avOffsetMs = skewMs + m_audioDelayChunks * kAudioChunkMs - m_videoDelayNs * 1e-6;
+}
+
+const int16_t* AudioSendPath::delayAudioChunk(const int16_t* samples, int64_t* timestampMs)
+{
+	size_t	delayChunks = (size_t)m_audioDelayChunks;
+
+	// The chunk handed out last time stays at the head of the line until it
+	// has been sent
+	if (m_audioDelayPending)
+	{
+		m_audioDelayLine.ConsumeChunk();
+		m_audioDelayPending = false;
+	}
+
+	// Undelayed, with nothing left over from an earlier delay, the chunk goes
+	// straight through
+	if (delayChunks == 0 && m_audioDelayLine.AvailableChunks() == 0)
+		return samples;
+
+	m_audioDelayLine.Write(samples, (size_t)m_audioDelayLine.chunk_frames(), *timestampMs);
+
+	// A shorter delay drops the oldest chunks; a longer one sends nothing
+	// until the line has filled up to it
+	while (m_audioDelayLine.AvailableChunks() > delayChunks + 1)
+	{
+		m_audioDelayLine.ConsumeChunk();
+		++m_audioSkippedChunks;
+	}
+	if (m_audioDelayLine.AvailableChunks() <= delayChunks)
+		return nullptr;
+
+	m_audioDelayPending = true;
+	return (const int16_t*)m_audioDelayLine.PeekChunk(timestampMs);
+}
+
+void AudioSendPath::meterThread(void)
+{
+	const std::chrono::milliseconds			updatePeriod(kLoudnessUpdateMs);
+	const int								chunkFrames = m_meterRing.chunk_frames();
+	std::chrono::steady_clock::time_point	nextUpdate = std::chrono::steady_clock::now() + updatePeriod;
+
+	while (m_running)
+	{
+		int64_t		timestampMs;
+		const void*	chunk;
+
+		while ((chunk = m_meterRing.PeekChunk(&timestampMs)) != nullptr)
+		{
+			if (m_meterRing.sample_bytes() == sizeof(int32_t))
+				m_loudnessMeter.Process((const int32_t*)chunk, chunkFrames);
+			else
+				m_loudnessMeter.Process((const int16_t*)chunk, chunkFrames);
+			m_meterRing.ConsumeChunk();
+		}
+
+		if (std::chrono::steady_clock::now() >= nextUpdate)
+		{
+			LoudnessReading	reading = m_loudnessMeter.Read();
+
+			{
+				std::lock_guard<std::mutex> lock(m_loudnessMutex);
+				m_loudness = reading;
+			}
+			if (m_loudnessObserver)
+				m_loudnessObserver(reading);
+			nextUpdate = std::chrono::steady_clock::now() + updatePeriod;
+		}
+
+		m_meterReady.Wait(kMeterPollMs);
+	}
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CaptureClock.h"
+#include "DeckLinkAPI.h"
+#include "common/sample_event.h"
+#include "utils/audio_convert.h"
+#include "utils/audio_drift.h"
+#include "utils/audio_mixer.h"
+#include "utils/audio_ring.h"
+#include "utils/drift_resampler.h"
+#include "utils/loudness_meter.h"
+#include "utils/silence_detector.h"
+
+struct CaptureQueueStats;
+
+// The audio half of the capture pipeline, from the DeckLink callback to
+// sendOnePcmFrame().
+//
+// The callback appends each packet, whatever its length and sample size, to
+// an AudioRing, and an audio thread sends exact 10 ms chunks at a steady
+// 10 ms pace. 32-bit capture is dithered to 16 bits and channels are routed
+// once per chunk, on the audio thread; 16-bit audio with identity routing goes
+// to the SDK straight out of the ring.
+//
+// Over long sessions the DeckLink audio clock and the clock pacing the audio
+// thread drift apart. With drift compensation on, the callback feeds every
+// packet to an AudioDriftEstimator and the audio thread resamples by a ratio
+// within a few hundred ppm of 1 that follows the estimate and holds the
+// buffered audio at the prefill level, so latency stays constant instead of
+// creeping up to a skip or down to an underrun.
+//
+// The send channels may be published as several audio tracks, each a run of
+// consecutive channels (e.g. programme on 1-2, clean feed on 3-4). All tracks
+// share the capture, the ring, formatting and drift compensation, so they
+// stay in step; one pass splits each chunk into the tracks' buffers.
+//
+// Every outgoing track chunk is measured for peak and energy and fed to the
+// track's SilenceDetector. During sustained silence the DTX mode decides
+// whether the chunk is sent as is, replaced by comfort noise or not sent at
+// all; pacing and timestamps carry on either way.
+//
+// Audio from a few further inputs, such as an announcer microphone on a
+// second DeckLink device, can be mixed into the program. Each such input's
+// callback writes its 16-bit capture into an AudioMixer, stamped on the
+// monotonic clock through that input's own stream time; the audio thread maps
+// each program chunk onto the same clock and mixes it with the inputs' audio
+// of the same moment, with per-input gain ramps, ahead of routing. The mixer
+// outlives restarts, so inputs keep feeding it across program format changes.
+//
+// The audio thread also copies every program chunk, after mixing and ahead of
+// routing, into a second ring for a meter thread, which measures EBU R128
+// loudness and true peak over all capture channels and publishes a reading a
+// few times a second. A meter that falls behind loses audio, never the
+// sender.
+//
+// A/V sync is decided here. The video send thread reports the latency each
+// frame would go out with undelayed; at send time the audio thread measures
+// its own on the same CaptureClock, and their difference is the A/V offset
+// the receiver would see. A delay line per stream holds back whichever stream
+// is ahead by the measured skew plus any configured trim: audio in whole
+// chunks through a ring of 16-bit chunks, video by the delay the send thread
+// reads back from videoDelayNs(), which also absorbs the rounding of the
+// audio one.
+class AudioSendPath
+{
+	using LoudnessObserver = std::function<void(const LoudnessReading&)>;
+
+public:
+	explicit AudioSendPath(const CaptureClock* captureClock);
+	virtual ~AudioSendPath();
+
+	// Called on the meter thread with every new loudness reading
+	void				onLoudness(const LoudnessObserver& observer) { m_loudnessObserver = observer; }
+
+	// Sets up for options.audio and options.capture and starts the audio and
+	// meter threads. |maxDelayMs| bounds both sync delay lines.
+	bool				start(int maxDelayMs);
+	void				stop(void);
+
+	// DeckLink callback thread. The video frame, if any, only times the audio.
+	void				push(IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket* audioPacket);
+
+	// DeckLink callback thread of mix input |input|, 1 to the number of
+	// options.audio.mixInputs.
+	void				pushMix(int input, IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket* audioPacket);
+
+	// Any thread. Ramps the linear gain of mix input |input|, or of the
+	// program for 0, to |gain| over options.audio.mixGainRampMs.
+	void				setMixGain(int input, double gain);
+
+	// Video send thread: the capture-to-send latency of a frame leaving the
+	// send queue at |nowNs|, before any video delay
+	void				updateVideoLatency(double latencyMs, int64_t nowNs);
+	// Video send thread: how long to hold each frame back after conversion
+	int64_t				videoDelayNs(void) const { return m_videoDelayNs; }
+
+	bool				isMetering(void) const { return m_metering; }
+	// Fills in the audio and A/V sync fields
+	void				getStats(CaptureQueueStats* stats) const;
+
+private:
+	// One published audio track
+	struct AudioTrack
+	{
+		int							channels;
+		std::vector<int16_t>		buffer;			// The track's chunk when there are several tracks
+		SilenceDetector				silenceDetector;
+	};
+
+	// Maps a mix input's stream time onto the monotonic clock
+	struct MixInputClock
+	{
+		double						streamToMonotonicMs;
+		bool						valid;
+	};
+
+	void				audioThread(void);
+	void				meterThread(void);
+	const int16_t*		formatAudioChunk(const void* chunk, int64_t timestampMs);
+	bool				resampleAudioChunk(double ratio, int64_t* timestampMs);
+	void				sendAudioChunk(const int16_t* samples, int64_t timestampMs);
+	void				updateAvSync(int64_t audioTimestampMs);
+	const int16_t*		delayAudioChunk(const int16_t* samples, int64_t* timestampMs);
+
+	const CaptureClock*					m_captureClock;
+	LoudnessObserver					m_loudnessObserver;
+	std::thread							m_audioThread;
+	std::thread							m_meterThread;
+	AudioRing							m_audioRing;
+	ChannelMatrix						m_channelMatrix;
+	AudioDither							m_audioDither;			// Audio thread only
+	std::vector<int16_t>				m_audioS16Buffer;		// Audio thread only
+	std::vector<int16_t>				m_audioMixBuffer;		// Audio thread only
+	std::vector<int16_t>				m_audioResampleBuffer;	// Audio thread only
+	DriftResampler						m_driftResampler;		// Audio thread only
+	int64_t								m_resampleInputEndMs;	// Audio thread only
+	AudioDriftEstimator					m_audioDrift;			// Fed by the callback thread
+	std::vector<AudioTrack>				m_audioTracks;			// Audio thread only
+	std::vector<int16_t>				m_comfortNoiseBuffer;	// Audio thread only
+	uint32_t							m_comfortNoiseState;	// Audio thread only
+	SampleEvent							m_audioReady;
+	bool								m_metering;
+	AudioRing							m_meterRing;			// Audio thread to meter thread
+	LoudnessMeter						m_loudnessMeter;		// Meter thread only
+	SampleEvent							m_meterReady;
+	mutable std::mutex					m_loudnessMutex;
+	LoudnessReading						m_loudness;				// Guarded by m_loudnessMutex
+	int64_t								m_streamToHardwareMs;	// Callback thread only
+	bool								m_hasStreamToHardware;
+	AudioRing							m_audioDelayLine;		// Audio thread only
+	bool								m_audioDelayPending;	// Audio thread only
+	int									m_maxDelayMs;
+	int									m_maxAudioDelayChunks;
+	double								m_audioLatencyMs;		// Audio thread only, smoothed
+	bool								m_hasAudioLatency;		// Audio thread only
+	std::atomic<double>					m_videoLatencyMs;		// Send thread to audio thread, smoothed
+	std::atomic<int64_t>				m_videoLatencyUpdatedNs;
+	std::atomic<int>					m_audioDelayChunks;
+	std::atomic<int64_t>				m_videoDelayNs;
+	std::atomic<double>					m_avOffsetMs;
+	bool								m_mixing;
+	AudioMixer							m_audioMixer;			// Mix input callbacks to audio thread
+	MixInputClock						m_mixClocks[AudioMixer::kMaxInputs];	// Each its input's callback thread
+	std::vector<int16_t>				m_audioInputMixBuffer;	// Audio thread only
+	std::atomic<bool>					m_running;
+
+	std::atomic<uint64_t>				m_audioChunksSent;
+	std::atomic<uint64_t>				m_audioSendFailures;
+	std::atomic<uint64_t>				m_audioUnderruns;
+	std::atomic<uint64_t>				m_audioSkippedChunks;
+	std::atomic<uint64_t>				m_audioSilentChunks;
+	std::atomic<uint64_t>				m_audioDtxChunks;
+	std::atomic<double>					m_audioCorrectionPpm;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+
+// The clock both capture streams are stamped on: the DeckLink hardware
+// reference clock, reached from the monotonic clock through an offset learned
+// from the arrival of every video frame that carries a hardware timestamp.
+// The offset is kept across restarts, so audio captured before the first
+// frame of a new format, and frames without a hardware timestamp, land on the
+// same timeline instead of jumping to the monotonic clock.
+//
+// Arrival only ever lags, so the offset follows a sample with less lag at
+// once and one with more lag at 1/2^kSmoothingShift per frame; a jump beyond
+// kResetMs means the input restarted its streams and is taken as it is.
+//
+// update() is for the video callback thread; the offset may be read from any
+// thread.
+class CaptureClock
+{
+public:
+	static const int	kSmoothingShift = 6;
+	static const int	kResetMs = 100;
+
+	CaptureClock() : m_monotonicToHardwareNs(0), m_hasMapping(false) {}
+
+	// A frame stamped |hardwareNs| by the card arrived at |arrivalNs|
+	void				update(int64_t hardwareNs, int64_t arrivalNs)
+	{
+		int64_t offsetNs = hardwareNs - arrivalNs;
+		int64_t mappedNs = m_monotonicToHardwareNs;
+
+		// Here later arrival means a smaller offset
+		if (!m_hasMapping || offsetNs > mappedNs || mappedNs - offsetNs > kResetMs * 1000000LL)
+			mappedNs = offsetNs;
+		else
+			mappedNs += (offsetNs - mappedNs) >> kSmoothingShift;
+		m_monotonicToHardwareNs = mappedNs;
+		m_hasMapping = true;
+	}
+
+	int64_t				captureNs(int64_t monotonicNs) const { return monotonicNs + m_monotonicToHardwareNs; }
+	int64_t				monotonicToHardwareNs(void) const { return m_monotonicToHardwareNs; }
+
+	static int64_t		monotonicNowNs(void)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	std::atomic<int64_t>	m_monotonicToHardwareNs;
+	bool					m_hasMapping;		// Callback thread only
+};
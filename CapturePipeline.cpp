@@ -0,0 +1,537 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#include <chrono>
+
+#include "CapturePipeline.h"
+#include "com_ptr.h"
+#include "ConnectToAgora.h"
+#include "utils/pixel_convert.h"
+
+// Upper bound for a worker thread to notice stop() without a new frame.
+static const int kQueueWaitMs = 100;
+
+// Media timestamps handed to the SDK are in milliseconds
+static const BMDTimeScale kTimestampScale = 1000;
+
+// Pool frames beyond the send queue depth: one being converted, one being
+// sent and one in transit while the send queue evicts.
+static const int kExtraPoolFrames = 3;
+
+CapturePipeline::CapturePipeline() :
+	m_overflowPolicy(kRingDropOldest),
+	m_audioPath(&m_captureClock),
+	m_running(false),
+	m_framesCaptured(0),
+	m_framesConverted(0),
+	m_framesSent(0),
+	m_captureDrops(0),
+	m_convertDrops(0),
+	m_sendDrops(0),
+	m_sendFailures(0)
+{
+}
+
+CapturePipeline::~CapturePipeline()
+{
+	stop();
+}
+
+bool CapturePipeline::start(int width, int height, double frameRate, I420Buffer::Type outputType, int queueDepth, RingOverflowPolicy overflowPolicy)
+{
+	int		maxDelayMs;
+	int		delayFrames;
+
+	if (m_running || outputType == I420Buffer::kNV12)
+		return false;
+
+	if (queueDepth < 1)
+		queueDepth = 1;
+
+	// Delayed video waits in the send queue, so both the queue and the pool
+	// get room for the longest delay
+	maxDelayMs = options.sync.maxDelayMs > 0 ? options.sync.maxDelayMs : 0;
+	delayFrames = (int)ceil(maxDelayMs * (frameRate > 0 ? frameRate : 60.0) / 1000.0);
+
+	if (!m_framePool.Init(width, height, outputType, queueDepth + delayFrames + kExtraPoolFrames))
+	{
+		printf("Failed to allocate capture frame pool for %dx%d\n", width, height);
+		return false;
+	}
+
+	m_overflowPolicy = overflowPolicy;
+	m_captureQueue.reset(new SpscRing<CapturedFrame>(queueDepth));
+	m_sendQueue.reset(new SpscRing<ConvertedFrame>(queueDepth + delayFrames));
+
+	m_framesCaptured = 0;
+	m_framesConverted = 0;
+	m_framesSent = 0;
+	m_captureDrops = 0;
+	m_convertDrops = 0;
+	m_sendDrops = 0;
+	m_sendFailures = 0;
+	resetLatency();
+
+	// The convert thread takes a share of every frame itself
+	if (!m_convertPool.Start(options.capture.convertThreads - 1, options.capture.pinConvertThreads, "convert"))
+	{
+		m_framePool.Reset();
+		return false;
+	}
+	if (!m_audioPath.start(maxDelayMs))
+	{
+		m_convertPool.Stop();
+		m_framePool.Reset();
+		return false;
+	}
+
+	m_running = true;
+	m_convertThread = std::thread(&CapturePipeline::convertThread, this);
+	m_sendThread = std::thread(&CapturePipeline::sendThread, this);
+
+	// Named so per-thread CPU time can be told apart (top -H, pipeline_bench)
+	pthread_setname_np(m_convertThread.native_handle(), "convert");
+	pthread_setname_np(m_sendThread.native_handle(), "send");
+
+	return true;
+}
+
+void CapturePipeline::stop(void)
+{
+	if (!m_running)
+		return;
+
+	m_running = false;
+	m_captureReady.Set();
+	m_sendReady.Set();
+
+	if (m_convertThread.joinable())
+		m_convertThread.join();
+	if (m_sendThread.joinable())
+		m_sendThread.join();
+	m_convertPool.Stop();
+	m_audioPath.stop();
+
+	// Release whatever is still queued
+	CapturedFrame capturedFrame;
+	while (m_captureQueue->TryPop(&capturedFrame))
+		releaseFrame(capturedFrame);
+
+	ConvertedFrame convertedFrame;
+	while (m_sendQueue->TryPop(&convertedFrame))
+		releaseFrame(convertedFrame);
+
+	CaptureQueueStats stats = getStats();
+	printf("Capture pipeline stopped: captured %llu, converted %llu, sent %llu, capture drops %llu, convert drops %llu, send drops %llu, send failures %llu\n",
+		   (unsigned long long)stats.framesCaptured, (unsigned long long)stats.framesConverted,
+		   (unsigned long long)stats.framesSent, (unsigned long long)stats.captureDrops,
+		   (unsigned long long)stats.convertDrops, (unsigned long long)stats.sendDrops,
+		   (unsigned long long)stats.sendFailures);
+	printf("Audio: sent %llu chunks, send failures %llu, underruns %llu, skipped chunks %llu, overrun frames %llu, clock drift %.1f ppm, correction %.1f ppm\n",
+		   (unsigned long long)stats.audioChunksSent, (unsigned long long)stats.audioSendFailures,
+		   (unsigned long long)stats.audioUnderruns, (unsigned long long)stats.audioSkippedChunks, (unsigned long long)stats.audioOverrunFrames,
+		   stats.audioDriftPpm, stats.audioCorrectionPpm);
+	printf("Audio silence over %zu track(s): %llu track chunks (%.1f%%), %llu handled by DTX\n",
+		   stats.audioTracks, (unsigned long long)stats.audioSilentChunks,
+		   stats.audioChunksSent ? 100.0 * stats.audioSilentChunks / (stats.audioChunksSent * stats.audioTracks) : 0.0,
+		   (unsigned long long)stats.audioDtxChunks);
+	if (stats.audioMixInputs > 0)
+		printf("Audio mix: %d input(s), %llu chunks slipped\n", stats.audioMixInputs, (unsigned long long)stats.audioMixSlips);
+	printf("A/V sync: offset %.1f ms (positive when audio lags), audio delay %.0f ms, video delay %.1f ms\n",
+		   stats.avOffsetMs, stats.audioDelayMs, stats.videoDelayMs);
+	if (m_audioPath.isMetering())
+		printf("Audio loudness: integrated %.1f LUFS, short-term %.1f LUFS, max true peak %.1f dBTP\n",
+			   stats.loudness.integrated_lufs, stats.loudness.short_term_lufs, stats.loudness.max_true_peak_dbtp);
+
+	printf("%-14s %8s %8s %8s %8s %8s (us)\n", "stage", "mean", "p50", "p95", "p99", "max");
+	for (int i = 0; i < kLatencyStageCount; i++)
+	{
+		const LatencyHistogram& latency = m_latency[i];
+		printf("%-14s %8lld %8lld %8lld %8lld %8lld\n", getLatencyStageName((CaptureLatencyStage)i),
+			   (long long)latency.MeanNs() / 1000, (long long)latency.PercentileNs(50) / 1000,
+			   (long long)latency.PercentileNs(95) / 1000, (long long)latency.PercentileNs(99) / 1000,
+			   (long long)latency.MaxNs() / 1000);
+	}
+
+	// Every pooled frame has been returned at this point
+	m_framePool.Reset();
+}
+
+void CapturePipeline::push(IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket* audioPacket)
+{
+	CapturedFrame	frame;
+	CapturedFrame	dropped;
+	bool			hasDropped;
+
+	if (!m_running)
+		return;
+
+	if (audioPacket != nullptr)
+		m_audioPath.push(videoFrame, audioPacket);
+
+	if (videoFrame == nullptr)
+		return;
+
+	frame.videoFrame = videoFrame;
+	frame.timing = getFrameTiming(videoFrame);
+
+	videoFrame->AddRef();
+
+	++m_framesCaptured;
+	if (!m_captureQueue->Push(frame, m_overflowPolicy, &dropped, &hasDropped))
+	{
+		++m_captureDrops;
+		releaseFrame(frame);
+		return;
+	}
+
+	if (hasDropped)
+	{
+		++m_captureDrops;
+		releaseFrame(dropped);
+	}
+
+	m_captureReady.Set();
+}
+
+void CapturePipeline::resetLatency(void)
+{
+	for (int i = 0; i < kLatencyStageCount; i++)
+		m_latency[i].Reset();
+}
+
+const char* CapturePipeline::getLatencyStageName(CaptureLatencyStage stage)
+{
+	switch (stage)
+	{
+		case kLatencyCaptureQueue:
+			return "capture-queue";
+		case kLatencyConvert:
+			return "convert";
+		case kLatencySendQueue:
+			return "send-queue";
+		case kLatencySend:
+			return "send";
+		case kLatencyTotal:
+			return "total";
+		default:
+			return "unknown";
+	}
+}
+
+CapturePipeline::FrameTiming CapturePipeline::getFrameTiming(IDeckLinkVideoInputFrame* videoFrame)
+{
+	FrameTiming		timing;
+	BMDTimeValue	hardwareTime;
+	BMDTimeValue	hardwareDuration;
+
+	timing.arrivalNs = CaptureClock::monotonicNowNs();
+	timing.convertedNs = 0;
+
+	// The hardware reference timestamp is latched by the card when the frame
+	// arrived, so it does not carry the callback scheduling jitter. Each one
+	// also refreshes the mapping from the monotonic clock, which stamps
+	// whatever arrives without one on the same timeline
+	if (videoFrame->GetHardwareReferenceTimestamp(kTimestampScale, &hardwareTime, &hardwareDuration) == S_OK)
+	{
+		m_captureClock.update(hardwareTime * 1000000, timing.arrivalNs);
+		timing.videoTimestampMs = hardwareTime;
+	}
+	else
+	{
+		timing.videoTimestampMs = m_captureClock.captureNs(timing.arrivalNs) / 1000000;
+	}
+
+	return timing;
+}
+
+CaptureQueueStats CapturePipeline::getStats() const
+{
+	CaptureQueueStats stats;
+
+	stats.framesCaptured = m_framesCaptured;
+	stats.framesConverted = m_framesConverted;
+	stats.framesSent = m_framesSent;
+	stats.captureDrops = m_captureDrops;
+	stats.convertDrops = m_convertDrops;
+	stats.sendDrops = m_sendDrops;
+	stats.sendFailures = m_sendFailures;
+	m_audioPath.getStats(&stats);
+	stats.captureQueueDepth = m_captureQueue ? m_captureQueue->Size() : 0;
+	stats.sendQueueDepth = m_sendQueue ? m_sendQueue->Size() : 0;
+	stats.queueCapacity = m_captureQueue ? m_captureQueue->Capacity() : 0;
+	stats.poolAvailable = m_framePool.Available();
+	stats.poolCapacity = m_framePool.Capacity();
+
+	return stats;
+}
+
+void CapturePipeline::convertThread(void)
+{
+	while (m_running)
+	{
+		CapturedFrame	capturedFrame;
+		ConvertedFrame	convertedFrame;
+		ConvertedFrame	dropped;
+		bool			hasDropped;
+
+		if (!m_captureQueue->TryPop(&capturedFrame))
+		{
+			m_captureReady.Wait(kQueueWaitMs);
+			continue;
+		}
+
+		IDeckLinkVideoInputFrame* videoFrame = capturedFrame.videoFrame;
+		int64_t convertStartNs = CaptureClock::monotonicNowNs();
+		m_latency[kLatencyCaptureQueue].Record(convertStartNs - capturedFrame.timing.arrivalNs);
+
+		if (m_frameInspector)
+			m_frameInspector(videoFrame);
+
+		int width = videoFrame->GetWidth();
+		int height = videoFrame->GetHeight();
+
+		convertedFrame.frame = nullptr;
+		if (width == m_framePool.width() && height == m_framePool.height())
+			convertedFrame.frame = m_framePool.Acquire();
+
+		if (convertedFrame.frame == nullptr)
+		{
+			++m_convertDrops;
+			releaseFrame(capturedFrame);
+			continue;
+		}
+
+		convertedFrame.timing = capturedFrame.timing;
+
+		if (!convertFrame(videoFrame, PlanarFrameView(convertedFrame.frame->buffer())))
+		{
+			++m_convertDrops;
+			convertedFrame.frame->Release();
+			releaseFrame(capturedFrame);
+			continue;
+		}
+
+		// The DeckLink frame is no longer needed; return it to the driver early
+		videoFrame->Release();
+		++m_framesConverted;
+		convertedFrame.timing.convertedNs = CaptureClock::monotonicNowNs();
+		m_latency[kLatencyConvert].Record(convertedFrame.timing.convertedNs - convertStartNs);
+
+		if (!m_sendQueue->Push(convertedFrame, m_overflowPolicy, &dropped, &hasDropped))
+		{
+			++m_sendDrops;
+			releaseFrame(convertedFrame);
+			continue;
+		}
+
+		if (hasDropped)
+		{
+			++m_sendDrops;
+			releaseFrame(dropped);
+		}
+
+		m_sendReady.Set();
+	}
+}
+
+YuvColorMatrix CapturePipeline::getColorMatrix(IDeckLinkVideoInputFrame* videoFrame)
+{
+	com_ptr<IDeckLinkVideoFrameMetadataExtensions> metadataExtensions(IID_IDeckLinkVideoFrameMetadataExtensions, com_ptr<IDeckLinkVideoInputFrame>(videoFrame));
+	int64_t colorspace = 0;
+
+	if (metadataExtensions && metadataExtensions->GetInt(bmdDeckLinkFrameMetadataColorspace, &colorspace) == S_OK)
+	{
+		switch (colorspace)
+		{
+			case bmdColorspaceRec601:
+				return kYuvRec601;
+			case bmdColorspaceRec709:
+				return kYuvRec709;
+			case bmdColorspaceRec2020:
+				return kYuvRec2020;
+			default:
+				break;
+		}
+	}
+
+	// No colorspace reported: SD is Rec.601, anything larger Rec.709
+	return videoFrame->GetHeight() > 576 ? kYuvRec709 : kYuvRec601;
+}
+
+// Smallest row in bytes that holds |width| pixels of |pixelFormat|, or 0 for
+// formats the pipeline does not convert
+static long minimumRowBytes(BMDPixelFormat pixelFormat, int width)
+{
+	switch (pixelFormat)
+	{
+		case bmdFormat8BitYUV:
+			return (long)width * 2;
+		case bmdFormat10BitYUV:
+			return (long)(width + 5) / 6 * 16;
+		case bmdFormat8BitBGRA:
+		case bmdFormat10BitRGB:
+			return (long)width * 4;
+		default:
+			return 0;
+	}
+}
+
+bool CapturePipeline::convertFrame(IDeckLinkVideoInputFrame* videoFrame, const FrameView& output)
+{
+	ConvertJob	job;
+	void*		buffer;
+	long		rowBytes;
+	long		minRowBytes;
+	int			slices;
+
+	job.pixelFormat = videoFrame->GetPixelFormat();
+	rowBytes = videoFrame->GetRowBytes();
+	minRowBytes = minimumRowBytes(job.pixelFormat, output.width);
+
+	// Rows are taken at GetRowBytes() pitch, padding included; a pitch too
+	// short for the width would read into the next row
+	if (minRowBytes == 0 || rowBytes < minRowBytes)
+		return false;
+	if (output.layout != kFrameI420 && output.layout != kFrameI422)
+		return false;
+	if (videoFrame->GetBytes(&buffer) != S_OK)
+		return false;
+
+	job.source = PackedFrameView(buffer, (int)rowBytes, (int)videoFrame->GetWidth(), (int)videoFrame->GetHeight());
+	job.output = output;
+	job.dither = options.capture.dither10Bit;
+	job.range = options.capture.fullRangeYuv ? kYuvFullRange : kYuvLimitedRange;
+	job.matrix = kYuvRec709;
+	if (job.pixelFormat == bmdFormat8BitBGRA || job.pixelFormat == bmdFormat10BitRGB)
+		job.matrix = getColorMatrix(videoFrame);
+
+	// Split into horizontal slices of an even number of rows, so 4:2:0 row
+	// pairs and the dither pattern phase stay intact
+	slices = options.capture.convertSlices > 0 ? options.capture.convertSlices : m_convertPool.thread_count() + 1;
+	job.sliceRows = ((output.height + slices - 1) / slices + 1) & ~1;
+	slices = (output.height + job.sliceRows - 1) / job.sliceRows;
+
+	m_convertPool.ParallelFor(slices, [&job](int slice) {
+		int firstRow = slice * job.sliceRows;
+		int rowCount = job.output.height - firstRow;
+		convertRows(job, firstRow, rowCount < job.sliceRows ? rowCount : job.sliceRows);
+	});
+
+	return true;
+}
+
+void CapturePipeline::convertRows(const ConvertJob& job, int firstRow, int rowCount)
+{
+	FrameView			source = SliceFrameView(job.source, firstRow, rowCount);
+	FrameView			output = SliceFrameView(job.output, firstRow, rowCount);
+	bool				i420 = output.layout == kFrameI420;
+
+	const PlaneView&	src = source.planes[0];
+	const PlaneView&	y = output.planes[0];
+	const PlaneView&	u = output.planes[1];
+	const PlaneView&	v = output.planes[2];
+
+	// Pick the unpack kernel from the format of this frame: format detection
+	// switches the input to v210 for 10-bit YUV and to r210 for RGB signals
+	switch (job.pixelFormat)
+	{
+		case bmdFormat8BitYUV:
+			if (i420)
+				UyvyToI420(src.data, src.stride, y.data, y.stride, u.data, u.stride, v.data, v.stride, y.width, y.height);
+			else
+				UyvyToI422(src.data, src.stride, y.data, y.stride, u.data, u.stride, v.data, v.stride, y.width, y.height);
+			break;
+
+		case bmdFormat10BitYUV:
+			if (i420)
+				V210ToI420(src.data, src.stride, y.data, y.stride, u.data, u.stride, v.data, v.stride, y.width, y.height, job.dither);
+			else
+				V210ToI422(src.data, src.stride, y.data, y.stride, u.data, u.stride, v.data, v.stride, y.width, y.height, job.dither);
+			break;
+
+		case bmdFormat8BitBGRA:
+			if (i420)
+				BgraToI420(src.data, src.stride, y.data, y.stride, u.data, u.stride, v.data, v.stride, y.width, y.height, job.matrix, job.range);
+			else
+				BgraToI422(src.data, src.stride, y.data, y.stride, u.data, u.stride, v.data, v.stride, y.width, y.height, job.matrix, job.range);
+			break;
+
+		// r210 carries SMPTE video levels, black at 64 and white at 940
+		case bmdFormat10BitRGB:
+			if (i420)
+				R210ToI420(src.data, src.stride, y.data, y.stride, u.data, u.stride, v.data, v.stride, y.width, y.height, job.matrix, kRgbVideoRange, job.range);
+			else
+				R210ToI422(src.data, src.stride, y.data, y.stride, u.data, u.stride, v.data, v.stride, y.width, y.height, job.matrix, kRgbVideoRange, job.range);
+			break;
+	}
+}
+
+void CapturePipeline::sendThread(void)
+{
+	while (m_running)
+	{
+		ConvertedFrame	frame;
+
+		if (!m_sendQueue->TryPop(&frame))
+		{
+			m_sendReady.Wait(kQueueWaitMs);
+			continue;
+		}
+
+		// Latency the frame would be sent with undelayed, for the A/V sync
+		// measurement on the audio thread. Taken as it leaves the queue, the
+		// same point audio is measured at when it goes to the sender; time
+		// spent queued behind frames held by the video delay does not count
+		int64_t poppedNs = CaptureClock::monotonicNowNs();
+		int64_t videoDelayNs = m_audioPath.videoDelayNs();
+		int64_t undelayedNs = poppedNs - videoDelayNs;
+		if (undelayedNs < frame.timing.convertedNs)
+			undelayedNs = frame.timing.convertedNs;
+		m_audioPath.updateVideoLatency(m_captureClock.captureNs(undelayedNs) * 1e-6 - frame.timing.videoTimestampMs, poppedNs);
+
+		// The video delay line: the frame, and those queued behind it, wait
+		// until the delay has passed since conversion
+		int64_t dueNs = frame.timing.convertedNs + videoDelayNs;
+		int64_t waitNs;
+		while (m_running && (waitNs = dueNs - CaptureClock::monotonicNowNs()) > 0)
+			std::this_thread::sleep_for(std::chrono::nanoseconds(waitNs < kQueueWaitMs * 1000000LL ? waitNs : kQueueWaitMs * 1000000LL));
+		if (!m_running)
+		{
+			releaseFrame(frame);
+			break;
+		}
+
+		int64_t sendStartNs = CaptureClock::monotonicNowNs();
+		m_latency[kLatencySendQueue].Record(sendStartNs - frame.timing.convertedNs);
+
+		bool sent = sendOneYuvFrame(PlanarFrameView(frame.frame->buffer()), frame.timing.videoTimestampMs) == 1;
+
+		int64_t sendEndNs = CaptureClock::monotonicNowNs();
+		m_latency[kLatencySend].Record(sendEndNs - sendStartNs);
+		m_latency[kLatencyTotal].Record(sendEndNs - frame.timing.arrivalNs);
+
+		if (sent)
+			++m_framesSent;
+		else
+			++m_sendFailures;
+		releaseFrame(frame);
+	}
+}
+
+void CapturePipeline::releaseFrame(CapturedFrame& frame)
+{
+	if (frame.videoFrame != nullptr)
+		frame.videoFrame->Release();
+
+	frame.videoFrame = nullptr;
+}
+
+void CapturePipeline::releaseFrame(ConvertedFrame& frame)
+{
+	if (frame.frame != nullptr)
+		frame.frame->Release();
+
+	frame.frame = nullptr;
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "AudioSendPath.h"
+#include "CaptureClock.h"
+#include "DeckLinkAPI.h"
+#include "common/sample_event.h"
+#include "utils/frame_pool.h"
+#include "utils/frame_view.h"
+#include "utils/latency_histogram.h"
+#include "utils/loudness_meter.h"
+#include "utils/pixel_convert.h"
+#include "utils/spsc_ring.h"
+#include "utils/worker_pool.h"
+
+struct CaptureQueueStats
+{
+	uint64_t	framesCaptured;		// Frames handed over by the DeckLink callback
+	uint64_t	framesConverted;
+	uint64_t	framesSent;
+	uint64_t	captureDrops;		// Dropped between callback and convert thread
+	uint64_t	convertDrops;		// No free pool buffer, or frame geometry differs from the pool
+	uint64_t	sendDrops;			// Dropped between convert and send thread
+	uint64_t	sendFailures;		// Handed to the sender but refused by it; not counted as sent
+	uint64_t	audioChunksSent;	// 10 ms chunks paced out, including any withheld by DTX
+	uint64_t	audioSendFailures;	// Track chunks refused by the sender
+	uint64_t	audioUnderruns;		// Audio ran dry and was re-buffered
+	uint64_t	audioSkippedChunks;	// Dropped to bring the audio backlog back down
+	uint64_t	audioOverrunFrames;	// Dropped because the audio ring was full
+	size_t		audioTracks;		// Published audio tracks, each sent every chunk
+	uint64_t	audioSilentChunks;	// Track chunks the silence detector held silent
+	uint64_t	audioDtxChunks;		// Of those, replaced by comfort noise or withheld
+	int			audioMixInputs;		// Extra inputs mixed into the program audio
+	uint64_t	audioMixSlips;		// Mix input chunks dropped to stay aligned with the program
+	double		audioDriftPpm;		// Capture audio clock error against the hardware reference clock
+	double		audioCorrectionPpm;	// Resampling rate correction currently applied
+	LoudnessReading	loudness;		// Latest EBU R128 reading of the captured audio
+	double		avOffsetMs;			// Audio minus video capture-to-send latency as sent; positive when audio lags
+	double		audioDelayMs;		// Lip-sync delay lines currently applied
+	double		videoDelayMs;
+	size_t		captureQueueDepth;
+	size_t		sendQueueDepth;
+	size_t		queueCapacity;
+	size_t		poolAvailable;
+	size_t		poolCapacity;
+};
+
+// Pipeline stages timed per frame, all measured on the monotonic clock from
+// the moment the DeckLink callback handed the frame over
+enum CaptureLatencyStage
+{
+	kLatencyCaptureQueue = 0,		// Callback to start of conversion
+	kLatencyConvert,
+	kLatencySendQueue,				// End of conversion to start of sending
+	kLatencySend,					// Until sendVideoFrame returns
+	kLatencyTotal,					// Callback to send return
+	kLatencyStageCount
+};
+
+// Moves conversion and sending off the DeckLink callback thread.
+//
+// The input callback only AddRefs the frame and audio packet and pushes them
+// into a bounded lock-free ring. A convert thread drains that ring, converts
+// the frame to planar YUV and releases the DeckLink frame as early as possible;
+// a send thread hands the converted frame to the Agora video sender. When a
+// ring is full, frames are dropped according to the overflow policy.
+//
+// Audio is independent of video and goes through an AudioSendPath, which
+// also decides A/V sync: video frames are held in the send queue until the
+// video delay it asks for has passed since conversion. A video frame without
+// audio, or audio without video, is still delivered. Both streams are stamped
+// on one CaptureClock, which the video frames keep up to date.
+//
+// Converted frames live in a FramePool sized for the queue, allocated and
+// prefaulted in start(), so steady-state capture does no heap allocation.
+class CapturePipeline
+{
+	using FrameInspector = std::function<void(IDeckLinkVideoInputFrame*)>;
+
+public:
+	CapturePipeline();
+	virtual ~CapturePipeline();
+
+	// Called on the convert thread for every frame before conversion, e.g. to
+	// extract ancillary data for the UI.
+	void				onFrameInspect(const FrameInspector& inspector) { m_frameInspector = inspector; }
+
+	// Called on the meter thread with every new loudness reading
+	void				onLoudness(const std::function<void(const LoudnessReading&)>& observer) { m_audioPath.onLoudness(observer); }
+
+	// |outputType| is the planar layout handed to the sender (kI420 or kI422).
+	// |frameRate| sizes the video delay line.
+	bool				start(int width, int height, double frameRate, I420Buffer::Type outputType, int queueDepth, RingOverflowPolicy overflowPolicy);
+	void				stop(void);
+	bool				isRunning() const { return m_running; }
+
+	// DeckLink callback thread. Either argument may be null. Takes its own
+	// reference on the video frame; audio is copied into the ring.
+	void				push(IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket* audioPacket);
+
+	// DeckLink callback thread of mix input |input|, 1 to the number of
+	// options.audio.mixInputs. The video frame, if any, only times the audio.
+	void				pushMixAudio(int input, IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket* audioPacket) { m_audioPath.pushMix(input, videoFrame, audioPacket); }
+
+	// Any thread. Ramps the linear gain of mix input |input|, or of the
+	// program for 0, to |gain| over options.audio.mixGainRampMs.
+	void				setMixGain(int input, double gain) { m_audioPath.setMixGain(input, gain); }
+
+	CaptureQueueStats	getStats() const;
+	const LatencyHistogram&	getLatency(CaptureLatencyStage stage) const { return m_latency[stage]; }
+	// Starts the latency histograms afresh, e.g. after a warm-up; start() does too
+	void				resetLatency(void);
+	static const char*	getLatencyStageName(CaptureLatencyStage stage);
+
+private:
+	// Capture timestamps travel with the frame. The media timestamp is on the
+	// DeckLink hardware reference clock in milliseconds, or mapped onto it.
+	struct FrameTiming
+	{
+		int64_t						arrivalNs;
+		int64_t						convertedNs;
+		int64_t						videoTimestampMs;
+	};
+
+	struct CapturedFrame
+	{
+		IDeckLinkVideoInputFrame*	videoFrame;
+		FrameTiming					timing;
+	};
+
+	struct ConvertedFrame
+	{
+		PooledFrame*				frame;
+		FrameTiming					timing;
+	};
+
+	// One frame conversion, split into row slices for the worker pool
+	struct ConvertJob
+	{
+		BMDPixelFormat				pixelFormat;
+		FrameView					source;
+		FrameView					output;
+		YuvColorMatrix				matrix;
+		YuvRange					range;
+		bool						dither;
+		int							sliceRows;
+	};
+
+	void				convertThread(void);
+	void				sendThread(void);
+	bool				convertFrame(IDeckLinkVideoInputFrame* videoFrame, const FrameView& output);
+
+	static void			convertRows(const ConvertJob& job, int firstRow, int rowCount);
+	static YuvColorMatrix	getColorMatrix(IDeckLinkVideoInputFrame* videoFrame);
+	FrameTiming			getFrameTiming(IDeckLinkVideoInputFrame* videoFrame);
+
+	static void			releaseFrame(CapturedFrame& frame);
+	static void			releaseFrame(ConvertedFrame& frame);
+
+	FrameInspector						m_frameInspector;
+	RingOverflowPolicy					m_overflowPolicy;
+	std::unique_ptr<SpscRing<CapturedFrame>>	m_captureQueue;
+	std::unique_ptr<SpscRing<ConvertedFrame>>	m_sendQueue;
+	FramePool							m_framePool;
+	WorkerPool							m_convertPool;
+	SampleEvent							m_captureReady;
+	SampleEvent							m_sendReady;
+	std::thread							m_convertThread;
+	std::thread							m_sendThread;
+	CaptureClock						m_captureClock;			// Kept across restarts
+	AudioSendPath						m_audioPath;
+	std::atomic<bool>					m_running;
+
+	std::atomic<uint64_t>				m_framesCaptured;
+	std::atomic<uint64_t>				m_framesConverted;
+	std::atomic<uint64_t>				m_framesSent;
+	std::atomic<uint64_t>				m_captureDrops;
+	std::atomic<uint64_t>				m_convertDrops;
+	std::atomic<uint64_t>				m_sendDrops;
+	std::atomic<uint64_t>				m_sendFailures;
+	LatencyHistogram					m_latency[kLatencyStageCount];
+};
@@ -1,6 +1,9 @@
 #include <QMessageBox>
 #include <iostream>
+#include <cmath>
 #include "CapturePreview.h"
+#include "ConnectToAgora.h"
+#include "ReplayDeckLinkInput.h"
 #include "ui_CapturePreview.h"
 
 // Video input connector map 
@@ -14,6 +17,11 @@ const QVector<QPair<BMDVideoConnection, QString>> kVideoInputConnections =
 	qMakePair(bmdVideoConnectionSVideo,		QString("S-Video")),
 };
 
+// Loudness and peak values, or a dash while there is nothing to measure
+static QString formatLevel(double value)
+{
+	return std::isfinite(value) ? QString::number(value, 'f', 1) : QString("-");
+}
 
 CapturePreview::CapturePreview(QWidget *parent) :
 	QDialog(parent),
@@ -40,6 +48,7 @@ CapturePreview::CapturePreview(QWidget *parent) :
 	ui->ancillaryTableView->horizontalHeader()->setStretchLastSection(true);
 
 	ui->invalidSignalLabel->setVisible(false);
+	ui->loudnessLabel->clear();
 
 	connect(ui->startButton, &QPushButton::clicked, this, &CapturePreview::toggleStart);
 	connect(ui->inputDevicePopup, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &CapturePreview::inputDeviceChanged);
@@ -59,7 +68,8 @@ void CapturePreview::setup()
 	m_deckLinkDiscovery = make_com_ptr<DeckLinkDeviceDiscovery>(this);
 	if (m_deckLinkDiscovery)
 	{
-		if (!m_deckLinkDiscovery->enable())
+		// A replay device is enough to run without drivers
+		if (!m_deckLinkDiscovery->enable() && options.replay.segments.empty())
 		{
 			QMessageBox::critical(this, "This application requires the DeckLink drivers installed.", "Please install the Blackmagic DeckLink drivers to use the features of this application.");
 		}
@@ -69,6 +79,22 @@ void CapturePreview::setup()
 	m_profileCallback = make_com_ptr<ProfileCallback>(this);
 	if (m_profileCallback)
 		m_profileCallback->onProfileChanging(std::bind(&CapturePreview::haltStreams, this));
+
+	// Add the virtual input replaying recorded captures, if configured
+	if (!options.replay.segments.empty())
+	{
+		com_ptr<ReplayDeckLink> replayDeckLink = make_com_ptr<ReplayDeckLink>();
+
+		if (replayDeckLink->Init())
+		{
+			com_ptr<IDeckLink> deckLink(replayDeckLink.get());
+			addDevice(deckLink);
+		}
+		else
+		{
+			QMessageBox::critical(this, "Replay input initialization error", "Unable to open the recorded capture files to replay.");
+		}
+	}
 }
 
 void CapturePreview::customEvent(QEvent *event)
@@ -98,6 +124,15 @@ void CapturePreview::customEvent(QEvent *event)
 		delete frameArrivedEvent->AncillaryData();
 		delete frameArrivedEvent->Metadata();
 	}
+	else if (event->type() == kAudioLoudnessEvent)
+	{
+		DeckLinkAudioLoudnessEvent* loudnessEvent = dynamic_cast<DeckLinkAudioLoudnessEvent*>(event);
+		const LoudnessReading& reading = loudnessEvent->Loudness();
+		ui->loudnessLabel->setText(QString("Momentary %1  Short-term %2  Integrated %3 LUFS\nTrue peak %4 dBTP (max %5 dBTP)")
+								   .arg(formatLevel(reading.momentary_lufs), formatLevel(reading.short_term_lufs),
+										formatLevel(reading.integrated_lufs), formatLevel(reading.true_peak_dbtp),
+										formatLevel(reading.max_true_peak_dbtp)));
+	}
 	else if (event->type() == kProfileActivatedEvent)
 	{
 		ProfileActivatedEvent* profileEvent = dynamic_cast<ProfileActivatedEvent*>(event);
@@ -145,19 +180,50 @@ void CapturePreview::startCapture()
 	if (m_selectedDevice && 
 		m_selectedDevice->startCapture(displayMode, m_previewView->delegate(), applyDetectedInputMode))
 	{
+		startMixInputs(displayMode);
+
 		// Update UI
 		ui->startButton->setText("Stop");
 		enableInterface(false);
 	}
 }
 
+void CapturePreview::startMixInputs(BMDDisplayMode displayMode)
+{
+	CapturePipeline* program = m_selectedDevice->getCapturePipeline();
+
+	// Mix inputs are matched to the other devices by name, in option order
+	for (size_t i = 0; i < options.audio.mixInputs.size() && i < (size_t)AudioMixer::kMaxInputs; i++)
+	{
+		QString deviceName = QString::fromStdString(options.audio.mixInputs[i].deviceName);
+
+		for (auto& entry : m_inputDevices)
+		{
+			com_ptr<DeckLinkInputDevice>& inputDevice = entry.second;
+
+			if (inputDevice.get() == m_selectedDevice.get() || inputDevice->isCapturing() || inputDevice->getDeviceName() != deviceName)
+				continue;
+
+			if (inputDevice->startMixCapture(displayMode, program, (int)i + 1))
+				m_mixDevices.push_back(inputDevice);
+			break;
+		}
+	}
+}
+
 void CapturePreview::stopCapture()
 {
+	// Mix inputs feed the program pipeline; stop them first
+	for (auto& inputDevice : m_mixDevices)
+		inputDevice->stopCapture();
+	m_mixDevices.clear();
+
 	if (m_selectedDevice)
 		m_selectedDevice->stopCapture();
 
 	// Update UI
 	ui->invalidSignalLabel->setVisible(false);
+	ui->loudnessLabel->clear();
 	ui->startButton->setText("Start");
 	enableInterface(true);
 }
@@ -249,9 +315,24 @@ void CapturePreview::addDevice(com_ptr<IDeckLink>& deckLink)
 
 void CapturePreview::removeDevice(com_ptr<IDeckLink>& deckLink)
 {
+	// A removed mix input simply drops out of the mix
+	for (auto iter = m_mixDevices.begin(); iter != m_mixDevices.end(); ++iter)
+	{
+		if ((*iter)->getDeckLinkInstance().get() == deckLink.get())
+		{
+			(*iter)->stopCapture();
+			m_mixDevices.erase(iter);
+			break;
+		}
+	}
+
 	// If device to remove is selected device, stop capture if active
 	if (m_selectedDevice->getDeckLinkInstance().get() == deckLink.get())
 	{
+		for (auto& inputDevice : m_mixDevices)
+			inputDevice->stopCapture();
+		m_mixDevices.clear();
+
 		if (m_selectedDevice->isCapturing())
 			m_selectedDevice->stopCapture();
 		m_selectedDevice = nullptr;
@@ -27,6 +27,7 @@ public:
 	void enableInterface(bool);
 
 	void startCapture();
+	void startMixInputs(BMDDisplayMode displayMode);
 	void stopCapture();
 	
 	void refreshDisplayModeMenu(void);
@@ -49,6 +50,7 @@ private:
 	BMDVideoConnection					m_selectedInputConnection;
 
 	std::map<intptr_t, com_ptr<DeckLinkInputDevice>>		m_inputDevices;
+	std::vector<com_ptr<DeckLinkInputDevice>>				m_mixDevices;		// Capturing audio for the program mix
 
 public slots:
 	void inputDeviceChanged(int selectedDeviceIndex);
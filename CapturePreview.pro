@@ -11,7 +11,7 @@ QT       += core gui widgets opengl
 TARGET = CapturePreview
 TEMPLATE = app
 CONFIG += c++11
-INCLUDEPATH = ../../include
+INCLUDEPATH = ../../include $$PWD
 LIBS += -ldl
 
 # The following define makes your compiler emit warnings if you use
@@ -31,10 +31,15 @@ SOURCES += \
 	../../include/DeckLinkAPIDispatch.cpp \
 	DeckLinkDeviceDiscovery.cpp \
 	DeckLinkInputDevice.cpp \
+	CapturePipeline.cpp \
+	AudioSendPath.cpp \
+	DeckLinkMemoryAllocator.cpp \
+	ReplayDeckLinkInput.cpp \
 	DeckLinkOpenGLWidget.cpp \
 	CapturePreview.cpp \
 	AncillaryDataTable.cpp \
         ConnectToAgora.cpp \
+        MediaSinkSend.cpp \
         common/sample_common.cpp \
         common/sample_local_user_observer.cpp \
         common/helper.cpp \
@@ -42,12 +47,49 @@ SOURCES += \
         common/write_csvfile.cpp \
         common/opt_parser.cpp \
         common/sample_event.cpp \
+        common/file_parser/helper_audio_parser.cpp \
+        utils/aligned_alloc.cpp \
+        utils/audio_convert.cpp \
+        utils/audio_convert_sse2.cpp \
+        utils/audio_convert_avx2.cpp \
+        utils/audio_drift.cpp \
+        utils/audio_mixer.cpp \
+        utils/audio_resampler.cpp \
+        utils/audio_ring.cpp \
+        utils/I420_buffer.cpp \
+        utils/frame_pool.cpp \
+        utils/frame_view.cpp \
+        utils/hugepage_arena.cpp \
+        utils/latency_histogram.cpp \
+        utils/loudness_meter.cpp \
+        utils/mapped_file.cpp \
+        utils/test_signal.cpp \
+        utils/media_sink.cpp \
+        utils/crc32.cpp \
+        utils/cpu_features.cpp \
+        utils/drift_resampler.cpp \
+        utils/file_parser/aac_file_parser.cpp \
+        utils/file_parser/audio_file_parser_factory.cpp \
+        utils/file_parser/fixed_frame_length_audio_file_parser.cpp \
+        utils/file_parser/wav_pcm_file_parser.cpp \
+        utils/pixel_convert.cpp \
+        utils/pixel_convert_sse2.cpp \
+        utils/pixel_convert_avx2.cpp \
+        utils/pixel_convert_avx512.cpp \
+        utils/silence_detector.cpp \
+        utils/wav_header.cpp \
+        utils/worker_pool.cpp \
     ProfileCallback.cpp
 
 HEADERS += \
 	CapturePreview.h \
 	DeckLinkDeviceDiscovery.h \
 	DeckLinkInputDevice.h \
+	CapturePipeline.h \
+	AudioSendPath.h \
+	CaptureClock.h \
+	DeckLinkMemoryAllocator.h \
+	ReplayDeckLinkInput.h \
 	DeckLinkOpenGLWidget.h \
 	AncillaryDataTable.h \
         ConnectToAgora.h \
@@ -59,7 +101,38 @@ HEADERS += \
         common/write_csvfile.h \
         common/opt_parser.h \
         common/sample_event.h \
+        common/file_parser/helper_audio_parser.h \
         common/switch_video_stream_base.h \
+        utils/aligned_alloc.h \
+        utils/audio_convert.h \
+        utils/audio_convert_row.h \
+        utils/audio_drift.h \
+        utils/audio_mixer.h \
+        utils/audio_resampler.h \
+        utils/audio_ring.h \
+        utils/I420_buffer.h \
+        utils/frame_pool.h \
+        utils/frame_view.h \
+        utils/hugepage_arena.h \
+        utils/latency_histogram.h \
+        utils/loudness_meter.h \
+        utils/mapped_file.h \
+        utils/test_signal.h \
+        utils/media_sink.h \
+        utils/crc32.h \
+        utils/cpu_features.h \
+        utils/drift_resampler.h \
+        utils/file_parser/aac_file_parser.h \
+        utils/file_parser/audio_file_parser_factory.h \
+        utils/file_parser/fixed_frame_length_audio_file_parser.h \
+        utils/file_parser/media_file_parser.h \
+        utils/file_parser/wav_pcm_file_parser.h \
+        utils/pixel_convert.h \
+        utils/pixel_convert_row.h \
+        utils/silence_detector.h \
+        utils/spsc_ring.h \
+        utils/wav_header.h \
+        utils/worker_pool.h \
     ProfileCallback.h
 
 FORMS += \
@@ -8,3 +8,4 @@ static const QEvent::Type kRemoveDeviceEvent		= static_cast<QEvent::Type>(QEvent
 static const QEvent::Type kVideoFormatChangedEvent	= static_cast<QEvent::Type>(QEvent::User + 3);
 static const QEvent::Type kVideoFrameArrivedEvent	= static_cast<QEvent::Type>(QEvent::User + 4);
 static const QEvent::Type kProfileActivatedEvent	= static_cast<QEvent::Type>(QEvent::User + 5);
+static const QEvent::Type kAudioLoudnessEvent		= static_cast<QEvent::Type>(QEvent::User + 6);
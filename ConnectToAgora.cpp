@@ -25,7 +25,6 @@ static void SampleSendVideoTask(const SampleOptions& options,
 }*/
 
 
-SampleOptions options;
 agora::base::IAgoraService *service;
 agora::rtc::RtcConnectionConfiguration ccfg;
 agora::agora_refptr<agora::rtc::IRtcConnection> connection;
@@ -33,8 +32,60 @@ std::shared_ptr<SampleConnectionObserver> connObserver;
 agora::agora_refptr<agora::rtc::IMediaNodeFactory> factory;
 agora::agora_refptr<agora::rtc::IVideoFrameSender> videoFrameSender;
 agora::agora_refptr<agora::rtc::ILocalVideoTrack> customVideoTrack;
-agora::agora_refptr<agora::rtc::IAudioPcmDataSender> audioPcmDataSender;
-agora::agora_refptr<agora::rtc::ILocalAudioTrack> customAudioTrack;
+// 每个音轨一个 PCM 发送器
+std::vector<agora::agora_refptr<agora::rtc::IAudioPcmDataSender>> audioPcmDataSenders;
+std::vector<agora::agora_refptr<agora::rtc::ILocalAudioTrack>> customAudioTracks;
+
+// Publishes through the senders created in connectAgora()
+class AgoraMediaSink : public IMediaSink {
+ public:
+  AgoraMediaSink() : repackBuffer(nullptr, I420Buffer::Release) {}
+
+  bool SendVideoFrame(const FrameView& frame, int64_t timestampMs) override {
+    // ExternalVideoFrame 只有一个缓冲区指针和亮度 stride，SDK 认为色度 stride 为其一半且三个平面首尾相连。
+    // 帧池中的帧就是这种布局，可直接发送；其它布局先拷贝到临时缓冲区
+    FrameView sendFrame = frame;
+    if (!IsContiguousYuv(frame)) {
+      I420Buffer::Type type = frame.layout == kFrameI420 ? I420Buffer::kI420 : I420Buffer::kI422;
+      int stride = (frame.width + 1) & ~1;
+      if (!repackBuffer || repackBuffer->width() != frame.width ||
+          repackBuffer->height() != frame.height || repackBuffer->type() != type) {
+        repackBuffer.reset(I420Buffer::Create(frame.width, frame.height, type, stride, stride / 2,
+                                              stride / 2));
+      }
+      sendFrame = PlanarFrameView(repackBuffer.get());
+      CopyFrameView(frame, sendFrame);
+    }
+
+    agora::media::base::ExternalVideoFrame videoFrame;
+    videoFrame.type = agora::media::base::ExternalVideoFrame::VIDEO_BUFFER_RAW_DATA;
+    videoFrame.format = sendFrame.layout == kFrameI420 ? agora::media::base::VIDEO_PIXEL_I420
+                                                       : agora::media::base::VIDEO_PIXEL_I422;
+    videoFrame.buffer = sendFrame.planes[0].data;
+    videoFrame.stride = sendFrame.planes[0].stride;
+    videoFrame.height = sendFrame.height;
+    videoFrame.cropLeft = 0;
+    videoFrame.cropTop = 0;
+    videoFrame.cropRight = sendFrame.planes[0].stride - sendFrame.width;
+    videoFrame.cropBottom = 0;
+    videoFrame.rotation = 0;
+    videoFrame.timestamp = timestampMs;
+
+    return videoFrameSender->sendVideoFrame(videoFrame) >= 0;
+  }
+
+  bool SendAudioFrame(int track, const int16_t* samples, int samplesPerChannel, int channels,
+                      int sampleRate, int64_t timestampMs) override {
+    return audioPcmDataSenders[track]->sendAudioPcmData(samples, (uint32_t)timestampMs,
+                                                        samplesPerChannel,
+                                                        sizeof(int16_t) * channels, channels,
+                                                        sampleRate) >= 0;
+  }
+
+ private:
+  // Only touched from the video send thread
+  std::unique_ptr<I420Buffer, void (*)(I420Buffer*)> repackBuffer;
+};
 
 int connectAgora()
 {
@@ -44,6 +95,15 @@ int connectAgora()
 
     options.userId = "0";
 
+    if (options.sink.type != kMediaSinkAgora) {
+      mediaSink = createOfflineMediaSink();
+      if (!mediaSink) {
+        printf("Failed to create media sink!\n");
+        return -1;
+      }
+      return 1;
+    }
+
     // Create Agora service
     service = createAndInitAgoraService(false, true, true);
     if (!service) {
@@ -78,20 +138,24 @@ int connectAgora()
       printf("Failed to create media node factory!\n");
     }
 
-    // Create audio data sender
-    audioPcmDataSender =
-        factory->createAudioPcmDataSender();
-    if (!audioPcmDataSender) {
-      printf("Failed to create audio data sender!\n");
-      return -1;
-    }
+    // Create one audio data sender and track per published track
+    std::vector<int> trackChannels = getAudioTrackChannels();
+    for (size_t i = 0; i < trackChannels.size(); i++) {
+      agora::agora_refptr<agora::rtc::IAudioPcmDataSender> audioPcmDataSender =
+          factory->createAudioPcmDataSender();
+      if (!audioPcmDataSender) {
+        printf("Failed to create audio data sender!\n");
+        return -1;
+      }
 
-    // Create audio track
-    customAudioTrack =
-        service->createCustomAudioTrack(audioPcmDataSender);
-    if (!customAudioTrack) {
-      printf("Failed to create audio track!\n");
-      return -1;
+      agora::agora_refptr<agora::rtc::ILocalAudioTrack> customAudioTrack =
+          service->createCustomAudioTrack(audioPcmDataSender);
+      if (!customAudioTrack) {
+        printf("Failed to create audio track!\n");
+        return -1;
+      }
+      audioPcmDataSenders.push_back(audioPcmDataSender);
+      customAudioTracks.push_back(customAudioTrack);
     }
 
     // Create video frame sender
@@ -116,11 +180,15 @@ int connectAgora()
     customVideoTrack->setVideoEncoderConfiguration(encoderConfig);
 
     // Publish audio & video track
-    customAudioTrack->setEnabled(true);
-    connection->getLocalUser()->publishAudio(customAudioTrack);
+    for (auto& customAudioTrack : customAudioTracks) {
+      customAudioTrack->setEnabled(true);
+      connection->getLocalUser()->publishAudio(customAudioTrack);
+    }
     customVideoTrack->setEnabled(true);
     connection->getLocalUser()->publishVideo(customVideoTrack);
 
+    mediaSink.reset(new AgoraMediaSink());
+
     // Wait until connected before sending media stream
     connObserver->waitUntilConnected(DEFAULT_CONNECT_TIMEOUT_MS);
 
@@ -137,8 +205,16 @@ int connectAgora()
 
 int disconnectAgora()
 {
+    // Offline sinks flush their files or report their checks here
+    mediaSink.reset();
+    if (options.sink.type != kMediaSinkAgora) {
+      return 1;
+    }
+
     // Unpublish audio & video track
-    connection->getLocalUser()->unpublishAudio(customAudioTrack);
+    for (auto& customAudioTrack : customAudioTracks) {
+      connection->getLocalUser()->unpublishAudio(customAudioTrack);
+    }
     connection->getLocalUser()->unpublishVideo(customVideoTrack);
 
     // Disconnect from Agora channel
@@ -150,9 +226,9 @@ int disconnectAgora()
 
     // Destroy Agora connection and related resources
     connObserver.reset();
-    audioPcmDataSender = nullptr;
+    audioPcmDataSenders.clear();
     videoFrameSender = nullptr;
-    customAudioTrack = nullptr;
+    customAudioTracks.clear();
     customVideoTrack = nullptr;
     factory = nullptr;
     connection = nullptr;
@@ -163,41 +239,3 @@ int disconnectAgora()
     return 1;
 }
 
-
-int sendOneYuvFrame(void* frameBuf) {
-  agora::media::base::ExternalVideoFrame videoFrame;
-  videoFrame.type = agora::media::base::ExternalVideoFrame::VIDEO_BUFFER_RAW_DATA;
-  videoFrame.format = agora::media::base::VIDEO_PIXEL_I422;
-  videoFrame.buffer = frameBuf;
-  videoFrame.stride = options.video.width;
-  videoFrame.height = options.video.height;
-  videoFrame.cropLeft = 0;
-  videoFrame.cropTop = 0;
-  videoFrame.cropRight = 0;
-  videoFrame.cropBottom = 0;
-  videoFrame.rotation = 0;
-  videoFrame.timestamp = 0;
-
-  if (videoFrameSender->sendVideoFrame(videoFrame) < 0) {
-    printf("Failed to send video frame!\n");
-    return -1;
-  }
-  return 1;
-}
-
-int sendOnePcmFrame(void* frameBuf) {
-  // Calculate byte size for 10ms audio samples
-  int sampleSize = sizeof(int16_t) * options.audio.numOfChannels;
-  int samplesPer10ms = options.audio.sampleRate / 100;
-  int sendBytes = sampleSize * samplesPer10ms;
-
-  // fps = 25   one pcm have 40 ms
-  for (int i=0; i<4; i++){
-      if (audioPcmDataSender->sendAudioPcmData(frameBuf+i*sendBytes, 0, samplesPer10ms, sampleSize,
-                                               options.audio.numOfChannels,
-                                               options.audio.sampleRate) < 0) {
-        return -1;
-      }
-  }
-  return 1;
-}
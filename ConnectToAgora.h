@@ -4,9 +4,11 @@
 #include <csignal>
 #include <stdio.h>
 #include <cstring>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "IAgoraService.h"
 #include "NGIAgoraRtcConnection.h"
@@ -15,6 +17,10 @@
 #include "common/opt_parser.h"
 #include "common/sample_common.h"
 #include "common/sample_connection_observer.h"
+#include "utils/frame_view.h"
+#include "utils/media_sink.h"
+#include "utils/silence_detector.h"
+#include "utils/spsc_ring.h"
 /*#include "utils/log.h"
 */
 
@@ -23,12 +29,81 @@
 #define DEFAULT_CONNECT_TIMEOUT_MS (3000)
 #define DEFAULT_SAMPLE_RATE (48000)
 #define DEFAULT_NUM_OF_CHANNELS (2)
+#define DEFAULT_AUDIO_PREFILL_MS (60)
+#define DEFAULT_AUDIO_MAX_LATENCY_MS (200)
+#define DEFAULT_AUDIO_DRIFT_COMPENSATION (true)
+#define DEFAULT_AUDIO_DTX_MODE (kDtxOff)
+#define DEFAULT_AUDIO_SILENCE_THRESHOLD_DBFS (-60.0)
+#define DEFAULT_AUDIO_SILENCE_HYSTERESIS_DB (6.0)
+#define DEFAULT_AUDIO_SILENCE_HOLD_MS (500)
+#define DEFAULT_AUDIO_COMFORT_NOISE_DBFS (-70.0)
+#define DEFAULT_AUDIO_LOUDNESS_METER (true)
+#define DEFAULT_AUDIO_MIX_PROGRAM_GAIN (1.0)
+#define DEFAULT_AUDIO_MIX_GAIN_RAMP_MS (50)
 #define DEFAULT_TARGET_BITRATE (1 * 1000 * 1000)
 #define DEFAULT_VIDEO_WIDTH (1920)
 #define DEFAULT_VIDEO_HEIGHT (1080)
 #define DEFAULT_FRAME_RATE (25)
+#define DEFAULT_VIDEO_PIXEL_FORMAT (agora::media::base::VIDEO_PIXEL_I422)
 #define DEFAULT_AUDIO_FILE "test_data/audio.raw"
 #define DEFAULT_VIDEO_FILE "test_data/vieo.raw"
+#define DEFAULT_CAPTURE_QUEUE_DEPTH (4)
+#define DEFAULT_CAPTURE_OVERFLOW_POLICY (kRingDropOldest)
+#define DEFAULT_CAPTURE_ALLOCATOR_BUFFERS (16)
+#define DEFAULT_CAPTURE_DITHER_10BIT (true)
+#define DEFAULT_CAPTURE_FULL_RANGE_YUV (false)
+#define DEFAULT_CAPTURE_AUDIO_CHANNELS (2)
+#define DEFAULT_CAPTURE_AUDIO_SAMPLE_BITS (16)
+#define DEFAULT_CAPTURE_DITHER_AUDIO (true)
+#define DEFAULT_CAPTURE_CONVERT_THREADS (1)
+#define DEFAULT_CAPTURE_CONVERT_SLICES (0)
+#define DEFAULT_CAPTURE_PIN_CONVERT_THREADS (false)
+#define DEFAULT_SYNC_AUTO_CORRECT (true)
+#define DEFAULT_SYNC_AUDIO_DELAY_MS (0)
+#define DEFAULT_SYNC_VIDEO_DELAY_MS (0)
+#define DEFAULT_SYNC_MAX_DELAY_MS (120)
+#define DEFAULT_REPLAY_DEVICE_NAME "DeckLink Replay"
+#define DEFAULT_REPLAY_DISPLAY_MODE "1080p25"
+#define DEFAULT_REPLAY_PIXEL_FORMAT "uyvy"
+#define DEFAULT_REPLAY_AUDIO_CHANNELS (2)
+#define DEFAULT_REPLAY_AUDIO_SAMPLE_BITS (16)
+#define DEFAULT_REPLAY_LOOP (true)
+#define DEFAULT_REPLAY_REAL_TIME (true)
+#define DEFAULT_REPLAY_TONE_DBFS (-18.0)
+#define DEFAULT_SINK_TYPE (kMediaSinkAgora)
+#define DEFAULT_SINK_VIDEO_FILE "sink_video.yuv"
+#define DEFAULT_SINK_AUDIO_FILE "sink_audio.pcm"
+#define DEFAULT_SINK_CRC_FILE "sink.crc"
+#define DEFAULT_SINK_CRC_VERIFY (false)
+
+/**
+ * @brief
+ * 混入主输入音频的一路其它 DeckLink 输入
+ */
+struct AudioMixInput {
+  // DeckLink 设备显示名称
+  std::string deviceName;
+  // 线性增益
+  double gain = 1.0;
+};
+
+/**
+ * @brief
+ * 虚拟回放输入的一段录制内容
+ */
+struct ReplaySegment {
+  // 逐帧连续存放、无文件头的原始视频文件，为空表示该段无输入信号
+  std::string videoFile;
+  // 录制时的显示模式，名称与 SDK 一致，例如 "720p50"、"1080p59.94"、"2160p25"
+  std::string displayMode = DEFAULT_REPLAY_DISPLAY_MODE;
+  // 文件的像素格式："uyvy" 或 "v210"
+  std::string pixelFormat = DEFAULT_REPLAY_PIXEL_FORMAT;
+  // 本段的帧数，0 表示整个文件（不足时循环该文件）；无信号段必须指定，测试信号段为 0 时无限输出
+  int frames = 0;
+  // 不读文件，实时生成测试信号：滚动彩条、环形波带片和帧号条码，音频为 1kHz 测试音（各声道依次短暂静音以便识别）。
+  // 只支持 "uyvy"，videoFile 须为空
+  bool testSignal = false;
+};
 
 /**
  * @brief
@@ -44,17 +119,132 @@ struct SampleOptions {
   struct {
     int sampleRate = DEFAULT_SAMPLE_RATE;
     int numOfChannels = DEFAULT_NUM_OF_CHANNELS;
+    // 开始（及断流后重新开始）发送前缓存的音频时长，需大于一帧视频的时长
+    int prefillMs = DEFAULT_AUDIO_PREFILL_MS;
+    // 缓存的音频超过该时长时丢弃多余部分，回到预缓存水平
+    int maxLatencyMs = DEFAULT_AUDIO_MAX_LATENCY_MS;
+    // 估计板卡音频时钟与本机时钟的漂移并自适应重采样，使长时间运行时音频缓存保持在预缓存水平
+    bool driftCompensation = DEFAULT_AUDIO_DRIFT_COMPENSATION;
+    // 持续静音时的处理：kDtxOff 照常发送，kDtxComfortNoise 以舒适噪声替代，kDtxSkip 不发送
+    DtxMode dtxMode = DEFAULT_AUDIO_DTX_MODE;
+    // 每 10 ms 有效值低于该电平（dBFS）视为静音，峰值允许高出 20 dB
+    double silenceThresholdDbfs = DEFAULT_AUDIO_SILENCE_THRESHOLD_DBFS;
+    // 电平需超过静音门限该分贝数才退出静音，避免在门限附近反复切换
+    double silenceHysteresisDb = DEFAULT_AUDIO_SILENCE_HYSTERESIS_DB;
+    // 连续静音超过该时长才进入静音状态
+    int silenceHoldMs = DEFAULT_AUDIO_SILENCE_HOLD_MS;
+    // 舒适噪声电平（dBFS）
+    double comfortNoiseDbfs = DEFAULT_AUDIO_COMFORT_NOISE_DBFS;
+    // 在后台线程按 EBU R128 测量混入其他输入后的节目音频（路由之前）的响度（瞬时/短期/综合）与真峰值，显示在界面和统计中
+    bool loudnessMeter = DEFAULT_AUDIO_LOUDNESS_METER;
+    // 采集声道到发送声道的路由/混音矩阵：numOfChannels 行，每行 capture.audioChannels 个线性增益，
+    // 每个输出声道增益绝对值之和需小于 4.0。为空时按声道号直通（输出第 n 路取输入第 n 路）
+    std::vector<float> routingGains;
+    // 多音轨发布：每个元素为一个音轨的声道数，各音轨依次占用路由后的 numOfChannels 个发送声道，总和须等于 numOfChannels。
+    // 例如 numOfChannels 为 4 且直通路由时，{2, 2} 发布采集 1-2 声道（主节目）和 3-4 声道（clean feed）两个音轨。
+    // 为空时发布一个 numOfChannels 声道的音轨
+    std::vector<int> trackChannels;
+    // 混音：叠加到主输入音频上的其它 DeckLink 输入（例如第二路输入上的解说话筒），最多 4 路。
+    // 这些输入以 16bit、capture.audioChannels 声道采集，按采集时间戳对齐后在路由与多音轨拆分之前逐声道相加
+    std::vector<AudioMixInput> mixInputs;
+    // 主输入在混音中的线性增益
+    double mixProgramGain = DEFAULT_AUDIO_MIX_PROGRAM_GAIN;
+    // 调整混音增益时的线性渐变时长（毫秒）
+    int mixGainRampMs = DEFAULT_AUDIO_MIX_GAIN_RAMP_MS;
   } audio;
   struct {
     int targetBitrate = DEFAULT_TARGET_BITRATE;
     int width = DEFAULT_VIDEO_WIDTH;
     int height = DEFAULT_VIDEO_HEIGHT;
     int frameRate = DEFAULT_FRAME_RATE;
+    // 发送给 SDK 的像素格式：VIDEO_PIXEL_I420 或 VIDEO_PIXEL_I422，I420 可减少三分之一的数据量
+    agora::media::base::VIDEO_PIXEL_FORMAT pixelFormat = DEFAULT_VIDEO_PIXEL_FORMAT;
   } video;
+  struct {
+    // 采集回调与转换/发送线程之间的队列深度（帧），以及队列满时的丢帧策略
+    int queueDepth = DEFAULT_CAPTURE_QUEUE_DEPTH;
+    RingOverflowPolicy overflowPolicy = DEFAULT_CAPTURE_OVERFLOW_POLICY;
+    // 板卡采集缓冲区个数（大页内存池），0 表示使用驱动自带的分配器
+    int allocatorBuffers = DEFAULT_CAPTURE_ALLOCATOR_BUFFERS;
+    // 10bit（v210）输入转 8bit 时使用有序抖动，关闭则直接四舍五入
+    bool dither10Bit = DEFAULT_CAPTURE_DITHER_10BIT;
+    // RGB 输入转 YUV 时输出全范围（0-255），默认为视频范围（16-235）
+    bool fullRangeYuv = DEFAULT_CAPTURE_FULL_RANGE_YUV;
+    // 采集的 SDI 嵌入音频声道数：2、8 或 16
+    int audioChannels = DEFAULT_CAPTURE_AUDIO_CHANNELS;
+    // 采集音频位深：16 或 32。32bit 保留处理余量，发送前统一转换为 16bit
+    int audioSampleBits = DEFAULT_CAPTURE_AUDIO_SAMPLE_BITS;
+    // 32bit 转 16bit 时使用 TPDF 抖动，关闭则直接四舍五入
+    bool ditherAudio = DEFAULT_CAPTURE_DITHER_AUDIO;
+    // 每帧格式转换使用的线程数（含转换线程本身），4K 50/60p 建议 4 以上
+    int convertThreads = DEFAULT_CAPTURE_CONVERT_THREADS;
+    // 每帧按行切分的条带数，0 表示每个线程一条
+    int convertSlices = DEFAULT_CAPTURE_CONVERT_SLICES;
+    // 是否将转换工作线程绑定到固定 CPU
+    bool pinConvertThreads = DEFAULT_CAPTURE_PIN_CONVERT_THREADS;
+  } capture;
+  struct {
+    // 在发送时持续测量音画偏差，并延后先到的一路，使音频与视频的偏差保持在一个音频块（10ms）以内
+    bool autoCorrect = DEFAULT_SYNC_AUTO_CORRECT;
+    // 固定附加的音频/视频延时（毫秒），用于补偿下游已知的音画偏差，叠加在自动校正之上
+    int audioDelayMs = DEFAULT_SYNC_AUDIO_DELAY_MS;
+    int videoDelayMs = DEFAULT_SYNC_VIDEO_DELAY_MS;
+    // 每路延时的上限（毫秒）。延时缓存在启动时按此分配，运行中不再分配内存；视频每毫秒延时需占用帧池的帧
+    int maxDelayMs = DEFAULT_SYNC_MAX_DELAY_MS;
+  } sync;
+  struct {
+    // 非空时增加一个虚拟 DeckLink 输入设备，按录制的显示模式帧率依次回放各段，无需板卡和驱动即可运行完整的采集-转换-发送流程。
+    // 相邻两段显示模式不同时模拟输入格式变化：开启格式检测时回调 VideoInputFormatChanged，否则在信号恢复前输出无信号帧。
+    // CapturePreview 的 --replay 及 --replay-test-signal 选项以单个循环段替换此处的设置
+    std::vector<ReplaySegment> segments;
+    // 循环播放的交织 PCM 文件（48kHz，无文件头），按每帧视频的时长随帧送出；无信号时及为空时输出静音。
+    // 扩展名为 .wav 时按文件头解析声道数和位深（16 或 32bit），16bit 的其他采样率重采样到 48kHz，下面两项不起作用
+    std::string audioFile;
+    int audioChannels = DEFAULT_REPLAY_AUDIO_CHANNELS;
+    int audioSampleBits = DEFAULT_REPLAY_AUDIO_SAMPLE_BITS;
+    // 所有段播放完后从头循环，否则此后一直输出无信号帧
+    bool loop = DEFAULT_REPLAY_LOOP;
+    // 设备列表中显示的名称
+    std::string deviceName = DEFAULT_REPLAY_DEVICE_NAME;
+    // 按显示模式的帧率实时送帧；为 false 时尽快送帧（帧池用尽时等待而不丢帧），用于吞吐量测试
+    bool realTime = DEFAULT_REPLAY_REAL_TIME;
+    // 测试音的峰值电平（dBFS）
+    double toneDbfs = DEFAULT_REPLAY_TONE_DBFS;
+  } replay;
+  struct {
+    // 发送目标，启动时选定：kMediaSinkAgora 发布到声网频道；以下三种不连接声网，用于单独测量本程序流水线的吞吐量和延时：
+    // kMediaSinkNull 直接丢弃，kMediaSinkRawFile 写入原始文件，kMediaSinkCrc 计算每帧 CRC 并记录或校验
+    MediaSinkType type = DEFAULT_SINK_TYPE;
+    // kMediaSinkRawFile：视频按帧连续写入（无行填充的 I420/I422）；音轨 0 写入 audioFile，音轨 n 写入 audioFile.n（交织 16bit PCM）
+    std::string videoFile = DEFAULT_SINK_VIDEO_FILE;
+    std::string audioFile = DEFAULT_SINK_AUDIO_FILE;
+    // kMediaSinkCrc：每帧视频和每块音频的 CRC 列表文件。crcVerify 为 false 时记录到该文件，为 true 时与之逐帧比对，退出时输出不一致的帧数
+    std::string crcFile = DEFAULT_SINK_CRC_FILE;
+    bool crcVerify = DEFAULT_SINK_CRC_VERIFY;
+  } sink;
 };
 
+extern SampleOptions options;
+
+// 以下 options、mediaSink 及 sendOneYuvFrame() 等发送函数在 MediaSinkSend.cpp 中实现，不依赖声网 SDK 库，
+// 单独测量流水线的工具只需链接该文件；connectAgora()/disconnectAgora() 在 ConnectToAgora.cpp 中
+
+// sendOneYuvFrame()/sendOnePcmFrame() 的发送目标，由 connectAgora() 或 createOfflineMediaSink() 的调用者设置
+extern std::unique_ptr<IMediaSink> mediaSink;
+
 /*!
-    用于连接至声网服务器，配置token以及channel等参数，并创建yuvsender用于发送yuv
+    按 options.sink 创建不连接声网的发送目标（kMediaSinkNull、kMediaSinkRawFile 或 kMediaSinkCrc），
+    用于单独测量流水线的吞吐量和延时。释放时离线目标写完文件或输出校验结果
+
+    \param 无
+
+    \return 新建的发送目标，kMediaSinkAgora 或文件打开失败时为空
+*/
+std::unique_ptr<IMediaSink> createOfflineMediaSink();
+
+/*!
+    用于连接至声网服务器，配置token以及channel等参数，并创建yuvsender用于发送yuv。
+    options.sink.type 不是 kMediaSinkAgora 时不连接声网，只创建对应的发送目标
 
     \param 无
 
@@ -76,14 +266,34 @@ int connectAgora();
 int disconnectAgora();
 
 /*!
-    用于发送将单帧yuv数据发送至声网服务器的指定token和channel下,blackmagic每采集一帧数据便会调用该函数
+    用于发送将单帧yuv数据发送至声网服务器的指定token和channel下,blackmagic每采集一帧数据便会调用该函数。
+    实际交给启动时选定的发送目标（options.sink）
 
-    \param frameBuf 指向需要发送的单帧yuv数据的指针
+    \param frame 需要发送的单帧yuv数据（I420 或 I422），各平面按自身 stride 描述
+    \param timestampMs 采集时间戳（毫秒，板卡硬件参考时钟）
 
     \return 错误码，1表示成功，其它表示失败
 
     \todo
 */
-int sendOneYuvFrame(void* frameBuf);
+int sendOneYuvFrame(const FrameView& frame, int64_t timestampMs);
+
+/*!
+    返回发布的各音轨的声道数：options.audio.trackChannels，为空时为一个 numOfChannels 声道的音轨
 
-int sendOnePcmFrame(void* frameBuf);
+    \param 无
+
+    \return 每个音轨一个元素
+*/
+std::vector<int> getAudioTrackChannels();
+
+/*!
+    向一个音轨发送 10ms 的交织 PCM 数据（options.audio 的采样率，该音轨的声道数）
+
+    \param track 音轨序号，与 getAudioTrackChannels() 的顺序一致
+    \param samples 指向 PCM 数据的指针
+    \param timestampMs 第一个采样的采集时间戳（毫秒，与视频时间戳同一时钟）
+
+    \return 错误码，1表示成功，其它表示失败
+*/
+int sendOnePcmFrame(int track, const int16_t* samples, int64_t timestampMs);
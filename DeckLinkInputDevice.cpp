@@ -19,9 +19,13 @@ DeckLinkInputDevice::DeckLinkInputDevice(QObject* owner, com_ptr<IDeckLink>& dev
 	m_supportsFormatDetection(false),
 	m_currentlyCapturing(false),
 	m_applyDetectedInputMode(false),
-	m_supportedInputConnections(0)
+	m_supportedInputConnections(0),
+	m_mixTarget(nullptr),
+	m_mixInput(0)
 {
 	m_deckLink->AddRef();
+	m_capturePipeline.onFrameInspect(std::bind(&DeckLinkInputDevice::postFrameArrivedEvent, this, std::placeholders::_1));
+	m_capturePipeline.onLoudness(std::bind(&DeckLinkInputDevice::postLoudnessEvent, this, std::placeholders::_1));
 }
 
 HRESULT	DeckLinkInputDevice::QueryInterface(REFIID iid, LPVOID *ppv)
@@ -152,6 +156,16 @@ bool DeckLinkInputDevice::startCapture(BMDDisplayMode displayMode, IDeckLinkScre
 	// Set capture callback
 	m_deckLinkInput->SetCallback(this);
 
+	// Capture into a hugepage arena rather than driver-allocated buffers
+	if (options.capture.allocatorBuffers > 0)
+	{
+		if (!m_memoryAllocator)
+			m_memoryAllocator = make_com_ptr<DeckLinkMemoryAllocator>(options.capture.allocatorBuffers);
+
+		if (m_deckLinkInput->SetVideoInputFrameMemoryAllocator(m_memoryAllocator.get()) != S_OK)
+			printf("Unable to install capture buffer allocator, using driver buffers\n");
+	}
+
 	// Set the video input mode
 	result = m_deckLinkInput->EnableVideoInput(displayMode, bmdFormat8BitYUV, videoInputFlags);
 	if (result != S_OK)
@@ -162,7 +176,9 @@ bool DeckLinkInputDevice::startCapture(BMDDisplayMode displayMode, IDeckLinkScre
 
 
     //add
-    result = m_deckLinkInput->EnableAudioInput(bmdAudioSampleRate48kHz, bmdAudioSampleType16bitInteger, 2);
+    result = m_deckLinkInput->EnableAudioInput(bmdAudioSampleRate48kHz,
+                                               options.capture.audioSampleBits == 32 ? bmdAudioSampleType32bitInteger : bmdAudioSampleType16bitInteger,
+                                               options.capture.audioChannels);
     if (result != S_OK)
     {
         //QMessageBox::critical(qobject_cast<QWidget*>(m_owner), "Error starting the capture", "This application was unable to select the chosen video mode. Perhaps, the selected device is currently in-use.");
@@ -170,10 +186,18 @@ bool DeckLinkInputDevice::startCapture(BMDDisplayMode displayMode, IDeckLinkScre
     }
     //addend
 
+	// Convert and send on dedicated threads, away from the DeckLink callback
+	if (!startCapturePipeline(displayMode))
+	{
+		QMessageBox::critical(qobject_cast<QWidget*>(m_owner), "Error starting the capture", "This application was unable to allocate capture buffers for the chosen video mode.");
+		return false;
+	}
+
 	// Start the capture
 	result = m_deckLinkInput->StartStreams();
 	if (result != S_OK)
 	{
+		m_capturePipeline.stop();
 		QMessageBox::critical(qobject_cast<QWidget*>(m_owner), "Error starting the capture", "This application was unable to start the capture. Perhaps, the selected device is currently in-use.");
 		return false;
 	}
@@ -183,6 +207,39 @@ bool DeckLinkInputDevice::startCapture(BMDDisplayMode displayMode, IDeckLinkScre
 	return true;
 }
 
+bool DeckLinkInputDevice::startMixCapture(BMDDisplayMode displayMode, CapturePipeline* program, int input)
+{
+	HRESULT				result;
+	BMDVideoInputFlags	videoInputFlags = bmdVideoInputFlagDefault;
+
+	// Audio only arrives with video enabled; the frames just time the audio
+	m_applyDetectedInputMode = m_supportsFormatDetection;
+	if (m_supportsFormatDetection)
+		videoInputFlags |= bmdVideoInputEnableFormatDetection;
+
+	m_mixTarget = program;
+	m_mixInput = input;
+	m_deckLinkInput->SetCallback(this);
+
+	result = m_deckLinkInput->EnableVideoInput(displayMode, bmdFormat8BitYUV, videoInputFlags);
+	if (result == S_OK)
+		result = m_deckLinkInput->EnableAudioInput(bmdAudioSampleRate48kHz, bmdAudioSampleType16bitInteger, options.capture.audioChannels);
+	if (result == S_OK)
+		result = m_deckLinkInput->StartStreams();
+
+	if (result != S_OK)
+	{
+		printf("Unable to capture audio from %s for mixing\n", m_deviceName.toUtf8().constData());
+		m_deckLinkInput->SetCallback(nullptr);
+		m_mixTarget = nullptr;
+		return false;
+	}
+
+	m_currentlyCapturing = true;
+
+	return true;
+}
+
 void DeckLinkInputDevice::stopCapture()
 {
 	if (m_deckLinkInput)
@@ -197,9 +254,44 @@ void DeckLinkInputDevice::stopCapture()
 		m_deckLinkInput->SetCallback(nullptr);
 	}
 
+	m_capturePipeline.stop();
+
+	m_mixTarget = nullptr;
 	m_currentlyCapturing = false;
 }
 
+HugePageArenaStats DeckLinkInputDevice::getCaptureBufferStats() const
+{
+	HugePageArenaStats stats;
+
+	if (m_memoryAllocator)
+		return m_memoryAllocator->getStats();
+
+	memset(&stats, 0, sizeof(stats));
+	return stats;
+}
+
+bool DeckLinkInputDevice::startCapturePipeline(BMDDisplayMode displayMode)
+{
+	com_ptr<IDeckLinkDisplayMode>	deckLinkDisplayMode;
+	I420Buffer::Type				outputType;
+	BMDTimeValue					frameDuration;
+	BMDTimeScale					timeScale;
+	double							frameRate = 0;
+
+	if (m_deckLinkInput->GetDisplayMode(displayMode, deckLinkDisplayMode.releaseAndGetAddressOf()) != S_OK)
+		return false;
+
+	if (deckLinkDisplayMode->GetFrameRate(&frameDuration, &timeScale) == S_OK && frameDuration > 0)
+		frameRate = (double)timeScale / frameDuration;
+
+	// The sender takes I420 or I422; convert straight into that layout
+	outputType = (options.video.pixelFormat == agora::media::base::VIDEO_PIXEL_I420) ? I420Buffer::kI420 : I420Buffer::kI422;
+
+	return m_capturePipeline.start(deckLinkDisplayMode->GetWidth(), deckLinkDisplayMode->GetHeight(), frameRate, outputType,
+								   options.capture.queueDepth, options.capture.overflowPolicy);
+}
+
 HRESULT DeckLinkInputDevice::VideoInputFormatChanged (BMDVideoInputFormatChangedEvents notificationEvents, IDeckLinkDisplayMode *newMode, BMDDetectedVideoInputFormatFlags detectedSignalFlags)
 {
 	HRESULT 		result;
@@ -215,6 +307,19 @@ HRESULT DeckLinkInputDevice::VideoInputFormatChanged (BMDVideoInputFormatChanged
 	// Stop the capture
 	m_deckLinkInput->StopStreams();
 
+	// A mix input has no pipeline of its own and no UI to update
+	if (m_mixTarget != nullptr)
+	{
+		result = m_deckLinkInput->EnableVideoInput(newMode->GetDisplayMode(), pixelFormat, bmdVideoInputEnableFormatDetection);
+		if (result == S_OK)
+			result = m_deckLinkInput->StartStreams();
+		if (result != S_OK)
+			printf("Unable to restart mix capture from %s\n", m_deviceName.toUtf8().constData());
+		return result;
+	}
+
+	m_capturePipeline.stop();
+
 	// Set the video input mode
 	result = m_deckLinkInput->EnableVideoInput(newMode->GetDisplayMode(), pixelFormat, bmdVideoInputEnableFormatDetection);
 	if (result != S_OK)
@@ -223,6 +328,13 @@ HRESULT DeckLinkInputDevice::VideoInputFormatChanged (BMDVideoInputFormatChanged
 		return result;
 	}
 
+	// Reallocate the frame pool for the new geometry
+	if (!startCapturePipeline(newMode->GetDisplayMode()))
+	{
+		QMessageBox::critical(qobject_cast<QWidget*>(m_owner), "Error restarting the capture", "This application was unable to allocate capture buffers for the new display mode");
+		return E_OUTOFMEMORY;
+	}
+
 	// Start the capture
 	result = m_deckLinkInput->StartStreams();
 	if (result != S_OK)
@@ -238,59 +350,26 @@ HRESULT DeckLinkInputDevice::VideoInputFormatChanged (BMDVideoInputFormatChanged
 	return S_OK;
 }
 
-int yuyv_to_yuv420p(const unsigned char *in, unsigned char *out, unsigned int width, unsigned int height)
+HRESULT DeckLinkInputDevice::VideoInputFrameArrived (IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket*  audioPacket)
 {
-    unsigned char *y = out;
-    unsigned char *u = out + width*height;
-    unsigned char *v = out + width*height + width*height/4;
-
-    unsigned int i,j;
-    unsigned int base_h;
-    unsigned int is_y = 1, is_u = 1;
-    unsigned int y_index = 0, u_index = 0, v_index = 0;
-
-    unsigned long yuv422_length = 2 * width * height;
-
-    //序列为YU YV YU YV，一个yuv422帧的长度 width * height * 2 个字节
-    //丢弃偶数行 u v
-    for(i=0; i<yuv422_length; i+=2){
-
-        *(y+y_index) = *(in+i);
-
-        y_index++;
-
-    }
+	// Conversion, sending and UI updates happen on the capture pipeline threads.
+	// Either pointer may be null; video and audio are handled independently
+	if (m_mixTarget != nullptr)
+		m_mixTarget->pushMixAudio(m_mixInput, videoFrame, audioPacket);
+	else
+		m_capturePipeline.push(videoFrame, audioPacket);
 
-    for(i=0; i<height; i+=2){
-        base_h = i*width*2;
-        for(j=base_h+1; j<base_h+width*2; j+=2){
-            if(is_u){
-                *(u+u_index) = *(in+j);
-                u_index++;
-                is_u = 0;
-            }
-
-            else{
-                *(v+v_index) = *(in+j);
-                v_index++;
-                is_u = 1;
-            }
-        }
-    }
-    return 1;
+	return S_OK;
 }
 
-
-HRESULT DeckLinkInputDevice::VideoInputFrameArrived (IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket*  audioPacket)
+void DeckLinkInputDevice::postFrameArrivedEvent(IDeckLinkVideoInputFrame* videoFrame)
 {
 	bool					validFrame;
 	AncillaryDataStruct*	ancillaryData;
 	MetadataStruct*			metadata;
 
-	if (videoFrame == nullptr)
-		return S_OK;
-    if (audioPacket == nullptr)
-        return S_OK;
+	if (m_owner == nullptr)
+		return;
 
 	validFrame = (videoFrame->GetFlags() & bmdFrameHasNoInputSource) == 0;
 
@@ -306,65 +385,14 @@ HRESULT DeckLinkInputDevice::VideoInputFrameArrived (IDeckLinkVideoInputFrame* v
 	metadata = new MetadataStruct();
 	GetMetadataFromFrame(videoFrame, metadata);
 
-    //begin*****************************************************************
-    int frameSize = videoFrame->GetRowBytes() * videoFrame->GetHeight();
-
-    void* buffer;
-    unsigned char* mbuf = new unsigned char[frameSize];
-    unsigned char* buf = new unsigned char[frameSize];
-    HRESULT getBytes = videoFrame->GetBytes(&buffer);
-
-    //uyvy422 to yuv422p
-    for (int i=0; i<frameSize/2; i++){
-        mbuf[i] = *(unsigned char*)(buffer+i*2+1);
-    }
-    for (int i=0; i<frameSize/4; i++){
-        mbuf[i+frameSize/2] = *(unsigned char*)(buffer+i*4);
-        mbuf[i+frameSize/4*3] = *(unsigned char*)(buffer+i*4+2);
-    }
-
-    //uyvy422 to yuyv422
-    /*for (int i=0; i<frameSize; i++){
-        if (i&1) mbuf[i] = *(unsigned char*)(buffer+i-1);
-        else mbuf[i] = *(unsigned char*)(buffer+i+1);
-    }
-
-    yuyv_to_yuv420p(mbuf, buf, 1920, 1080);*/
-    if (sendOneYuvFrame((void*)mbuf) > 0);  //printf("send one yuv frame success")
-
-
-    //std::cout << audioPacket->GetSampleFrameCount() << std::endl;
-    // 40ms numofchannel=2 detph=16
-    audioPacket->GetBytes(&buffer);
-    if (sendOnePcmFrame(buffer) > 0);  //printf("send one pcm frame success")
-
-
-    /*FILE *out;
-    out = fopen("test.yuv", "wb");
-    fwrite(mbuf, 1, frameSize, out);
-    fclose(out);
-    std::cout << std::endl;*/
-
-    delete[] mbuf;
-    mbuf = nullptr;
-    delete[] buf;
-    buf = nullptr;
-
-    //std::cout << "***********************************************" << std::endl;
-    //end ***********************************************************
-
-
-
 	// Update the UI with new Ancillary data
-	if (m_owner != nullptr)
-		QCoreApplication::postEvent(m_owner, new DeckLinkInputFrameArrivedEvent(ancillaryData, metadata, validFrame));
-	else
-	{
-		delete ancillaryData;
-		delete metadata;
-	}
+	QCoreApplication::postEvent(m_owner, new DeckLinkInputFrameArrivedEvent(ancillaryData, metadata, validFrame));
+}
 
-	return S_OK;
+void DeckLinkInputDevice::postLoudnessEvent(const LoudnessReading& reading)
+{
+	if (m_owner != nullptr)
+		QCoreApplication::postEvent(m_owner, new DeckLinkAudioLoudnessEvent(reading));
 }
 
 void DeckLinkInputDevice::GetAncillaryDataFromFrame(IDeckLinkVideoInputFrame* videoFrame, BMDTimecodeFormat timecodeFormat, QString* timecodeString, QString* userBitsString)
@@ -512,4 +540,7 @@ DeckLinkInputFrameArrivedEvent::DeckLinkInputFrameArrivedEvent(AncillaryDataStru
 {
 }
 
-
+DeckLinkAudioLoudnessEvent::DeckLinkAudioLoudnessEvent(const LoudnessReading& reading)
+	: QEvent(kAudioLoudnessEvent), m_reading(reading)
+{
+}
@@ -8,6 +8,8 @@
 #include "com_ptr.h"
 #include "CapturePreviewEvents.h"
 #include "AncillaryDataTable.h"
+#include "CapturePipeline.h"
+#include "DeckLinkMemoryAllocator.h"
 
 class DeckLinkInputDevice : public IDeckLinkInputCallback
 {
@@ -26,12 +28,18 @@ public:
 	void						queryDisplayModes(DisplayModeQueryFunc func);
 
 	bool						startCapture(BMDDisplayMode displayMode, IDeckLinkScreenPreviewCallback* screenPreviewCallback, bool applyDetectedInputMode);
+	// Captures audio only, for mixing into |program| as its mix input |input|;
+	// follows the incoming video format where the device can detect it
+	bool						startMixCapture(BMDDisplayMode displayMode, CapturePipeline* program, int input);
 	void						stopCapture(void);
 
 	com_ptr<IDeckLink>					getDeckLinkInstance() const { return m_deckLink; }
 	com_ptr<IDeckLinkInput>				getDeckLinkInput() const { return m_deckLinkInput; }
 	com_ptr<IDeckLinkConfiguration>		getDeckLinkConfiguration() const { return m_deckLinkConfig; }
 	com_ptr<IDeckLinkProfileManager>	getProfileManager() const { return m_deckLinkProfileManager; }
+	CaptureQueueStats					getCaptureQueueStats() const { return m_capturePipeline.getStats(); }
+	CapturePipeline*					getCapturePipeline() { return &m_capturePipeline; }
+	HugePageArenaStats					getCaptureBufferStats() const;
 
 	// IUnknown interface
 	HRESULT		QueryInterface (REFIID iid, LPVOID *ppv) override;
@@ -57,7 +65,14 @@ private:
 	bool								m_currentlyCapturing;
 	bool								m_applyDetectedInputMode;
 	int64_t								m_supportedInputConnections;
+	CapturePipeline						m_capturePipeline;
+	CapturePipeline*					m_mixTarget;		// Set while capturing for another device's mix
+	int									m_mixInput;
+	com_ptr<DeckLinkMemoryAllocator>	m_memoryAllocator;
 	//
+	bool		startCapturePipeline(BMDDisplayMode displayMode);
+	void		postFrameArrivedEvent(IDeckLinkVideoInputFrame* videoFrame);
+	void		postLoudnessEvent(const LoudnessReading& reading);
 	static void	GetAncillaryDataFromFrame(IDeckLinkVideoInputFrame* frame, BMDTimecodeFormat format, QString* timecodeString, QString* userBitsString);
 	static void	GetMetadataFromFrame(IDeckLinkVideoInputFrame* videoFrame, MetadataStruct* metadata);
 };
@@ -90,3 +105,14 @@ private:
 	bool					m_signalValid;
 };
 
+class DeckLinkAudioLoudnessEvent : public QEvent
+{
+public:
+	DeckLinkAudioLoudnessEvent(const LoudnessReading& reading);
+	virtual ~DeckLinkAudioLoudnessEvent() {}
+
+	const LoudnessReading&	Loudness(void) const { return m_reading; }
+
+private:
+	LoudnessReading			m_reading;
+};
@@ -0,0 +1,110 @@
+#include <stdio.h>
+
+#include "DeckLinkMemoryAllocator.h"
+#include "utils/aligned_alloc.h"
+
+DeckLinkMemoryAllocator::DeckLinkMemoryAllocator(int bufferCount) :
+	m_refCount(1),
+	m_bufferCount(bufferCount > 0 ? bufferCount : 1)
+{
+}
+
+DeckLinkMemoryAllocator::~DeckLinkMemoryAllocator()
+{
+	m_arena.Release();
+}
+
+/// IUnknown methods
+
+HRESULT DeckLinkMemoryAllocator::QueryInterface(REFIID iid, LPVOID *ppv)
+{
+	CFUUIDBytes		iunknown;
+	HRESULT			result = E_NOINTERFACE;
+
+	if (ppv == nullptr)
+		return E_INVALIDARG;
+
+	// Initialise the return result
+	*ppv = nullptr;
+
+	// Obtain the IUnknown interface and compare it the provided REFIID
+	iunknown = CFUUIDGetUUIDBytes(IUnknownUUID);
+	if (memcmp(&iid, &iunknown, sizeof(REFIID)) == 0)
+	{
+		*ppv = this;
+		AddRef();
+		result = S_OK;
+	}
+	else if (memcmp(&iid, &IID_IDeckLinkMemoryAllocator, sizeof(REFIID)) == 0)
+	{
+		*ppv = (IDeckLinkMemoryAllocator*)this;
+		AddRef();
+		result = S_OK;
+	}
+
+	return result;
+}
+
+ULONG DeckLinkMemoryAllocator::AddRef(void)
+{
+	return ++m_refCount;
+}
+
+ULONG DeckLinkMemoryAllocator::Release(void)
+{
+	ULONG newRefValue = --m_refCount;
+	if (newRefValue == 0)
+		delete this;
+
+	return newRefValue;
+}
+
+/// IDeckLinkMemoryAllocator methods
+
+HRESULT DeckLinkMemoryAllocator::AllocateBuffer(uint32_t bufferSize, void** allocatedBuffer)
+{
+	if (allocatedBuffer == nullptr)
+		return E_POINTER;
+
+	// Size the arena on first use, or grow it if the frame size changed and
+	// nothing is outstanding
+	if (!m_arena.IsInitialized() || bufferSize > m_arena.block_size())
+	{
+		if (m_arena.Init(bufferSize, m_bufferCount))
+		{
+			HugePageArenaStats stats = m_arena.GetStats();
+			printf("Capture buffer arena: %d x %zu bytes, %s%s\n", m_bufferCount, stats.block_size,
+				   stats.huge_pages ? "2MB hugepages" : (stats.transparent_huge_pages ? "transparent hugepages" : "normal pages"),
+				   stats.locked ? ", locked" : "");
+		}
+	}
+
+	*allocatedBuffer = m_arena.Allocate(bufferSize);
+	if (*allocatedBuffer == nullptr)
+	{
+		m_arena.RecordFallback();
+		*allocatedBuffer = AlignedMalloc(bufferSize, HugePageArena::kBlockAlignment);
+	}
+
+	return (*allocatedBuffer != nullptr) ? S_OK : E_OUTOFMEMORY;
+}
+
+HRESULT DeckLinkMemoryAllocator::ReleaseBuffer(void* buffer)
+{
+	if (!m_arena.Free(buffer))
+		AlignedFree(buffer);
+
+	return S_OK;
+}
+
+HRESULT DeckLinkMemoryAllocator::Commit()
+{
+	return S_OK;
+}
+
+HRESULT DeckLinkMemoryAllocator::Decommit()
+{
+	// Keep the arena mapped across stream restarts; it is only unmapped if no
+	// buffer is outstanding and a different size is requested, or on destruction
+	return S_OK;
+}
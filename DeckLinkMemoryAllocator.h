@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+
+#include "DeckLinkAPI.h"
+#include "utils/hugepage_arena.h"
+
+// Video input frame allocator handed to the DeckLink driver, so captured
+// frames land directly in hugepage-backed, locked and prefaulted memory.
+//
+// The arena is sized on the first AllocateBuffer() call after Commit(), from
+// the buffer size the driver asks for. Requests the arena cannot serve (it is
+// exhausted, or the frame size grew while buffers are outstanding) fall back
+// to ordinary aligned heap memory and are counted in the statistics.
+class DeckLinkMemoryAllocator : public IDeckLinkMemoryAllocator
+{
+public:
+	explicit DeckLinkMemoryAllocator(int bufferCount);
+	virtual ~DeckLinkMemoryAllocator();
+
+	HugePageArenaStats	getStats() const { return m_arena.GetStats(); }
+
+	// IUnknown interface
+	HRESULT		QueryInterface(REFIID iid, LPVOID *ppv) override;
+	ULONG		AddRef() override;
+	ULONG		Release() override;
+
+	// IDeckLinkMemoryAllocator interface
+	HRESULT		AllocateBuffer(uint32_t bufferSize, void** allocatedBuffer) override;
+	HRESULT		ReleaseBuffer(void* buffer) override;
+	HRESULT		Commit() override;
+	HRESULT		Decommit() override;
+
+private:
+	std::atomic<ULONG>	m_refCount;
+	int					m_bufferCount;
+	HugePageArena		m_arena;
+};
@@ -0,0 +1,60 @@
+#include "ConnectToAgora.h"
+
+// Nothing here calls into the SDK library, so tools that measure the pipeline
+// alone (bench/pipeline_bench) link this file instead of ConnectToAgora.cpp.
+
+SampleOptions options;
+// sendOneYuvFrame()/sendOnePcmFrame() 的发送目标
+std::unique_ptr<IMediaSink> mediaSink;
+
+std::unique_ptr<IMediaSink> createOfflineMediaSink() {
+  int trackCount = (int)getAudioTrackChannels().size();
+
+  switch (options.sink.type) {
+    case kMediaSinkNull:
+      return std::unique_ptr<IMediaSink>(new NullMediaSink());
+    case kMediaSinkRawFile: {
+      std::unique_ptr<RawFileMediaSink> sink(new RawFileMediaSink());
+      if (!sink->Open(options.sink.videoFile, options.sink.audioFile, trackCount)) {
+        return nullptr;
+      }
+      return std::move(sink);
+    }
+    case kMediaSinkCrc: {
+      std::unique_ptr<CrcMediaSink> sink(new CrcMediaSink());
+      if (!sink->Open(options.sink.crcFile, options.sink.crcVerify, trackCount)) {
+        return nullptr;
+      }
+      return std::move(sink);
+    }
+    default:
+      return nullptr;
+  }
+}
+
+int sendOneYuvFrame(const FrameView& frame, int64_t timestampMs) {
+  if (!mediaSink || !mediaSink->SendVideoFrame(frame, timestampMs)) {
+    return -1;
+  }
+  return 1;
+}
+
+std::vector<int> getAudioTrackChannels() {
+  if (options.audio.trackChannels.empty()) {
+    return std::vector<int>(1, options.audio.numOfChannels);
+  }
+  return options.audio.trackChannels;
+}
+
+int sendOnePcmFrame(int track, const int16_t* samples, int64_t timestampMs) {
+  // 每次发送 10ms 的 PCM 数据
+  int numOfChannels = options.audio.trackChannels.empty() ? options.audio.numOfChannels
+                                                          : options.audio.trackChannels[track];
+  int samplesPer10ms = options.audio.sampleRate / 100;
+
+  if (!mediaSink || !mediaSink->SendAudioFrame(track, samples, samplesPer10ms, numOfChannels,
+                                               options.audio.sampleRate, timestampMs)) {
+    return -1;
+  }
+  return 1;
+}
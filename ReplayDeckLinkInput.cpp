@@ -0,0 +1,1365 @@
+#include <algorithm>
+#include <chrono>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "ReplayDeckLinkInput.h"
+#include "ConnectToAgora.h"
+#include "utils/aligned_alloc.h"
+#include "utils/file_parser/audio_file_parser_factory.h"
+
+static const int64_t	kNanosecondsPerSecond	= 1000000000LL;
+static const int		kAudioSampleRate		= 48000;
+static const long		kMaxAudioSampleFrames	= 2048;		// More than one frame's worth at 23.98 fps
+static const int		kFramePoolSize			= 16;		// Frames outstanding at once, like a card's own buffers
+static const size_t		kFrameAlignment			= 64;
+static const int		kFrameWaitMs			= 1;		// Unpaced, how long to wait for a pooled frame before checking for stop
+
+// v210 black: Cb, Cr at 512 and Y at 64, in the two alternating word layouts
+static const uint32_t	kV210BlackEven			= 512 | (64 << 10) | (512 << 20);
+static const uint32_t	kV210BlackOdd			= 64 | (512 << 10) | (64 << 20);
+
+struct ReplayModeInfo
+{
+	BMDDisplayMode		displayMode;
+	const char*			name;
+	long				width;
+	long				height;
+	BMDTimeValue		frameDuration;
+	BMDTimeScale		timeScale;
+	BMDFieldDominance	fieldDominance;
+};
+
+static const ReplayModeInfo kReplayModes[] =
+{
+	{ bmdModeHD720p50,		"720p50",		1280,	720,	1000,	50000,	bmdProgressiveFrame },
+	{ bmdModeHD720p5994,	"720p59.94",	1280,	720,	1001,	60000,	bmdProgressiveFrame },
+	{ bmdModeHD720p60,		"720p60",		1280,	720,	1000,	60000,	bmdProgressiveFrame },
+	{ bmdModeHD1080p2398,	"1080p23.98",	1920,	1080,	1001,	24000,	bmdProgressiveFrame },
+	{ bmdModeHD1080p24,		"1080p24",		1920,	1080,	1000,	24000,	bmdProgressiveFrame },
+	{ bmdModeHD1080p25,		"1080p25",		1920,	1080,	1000,	25000,	bmdProgressiveFrame },
+	{ bmdModeHD1080p2997,	"1080p29.97",	1920,	1080,	1001,	30000,	bmdProgressiveFrame },
+	{ bmdModeHD1080p30,		"1080p30",		1920,	1080,	1000,	30000,	bmdProgressiveFrame },
+	{ bmdModeHD1080i50,		"1080i50",		1920,	1080,	1000,	25000,	bmdUpperFieldFirst },
+	{ bmdModeHD1080i5994,	"1080i59.94",	1920,	1080,	1001,	30000,	bmdUpperFieldFirst },
+	{ bmdModeHD1080p50,		"1080p50",		1920,	1080,	1000,	50000,	bmdProgressiveFrame },
+	{ bmdModeHD1080p5994,	"1080p59.94",	1920,	1080,	1001,	60000,	bmdProgressiveFrame },
+	{ bmdModeHD1080p6000,	"1080p60",		1920,	1080,	1000,	60000,	bmdProgressiveFrame },
+	{ bmdMode4K2160p2398,	"2160p23.98",	3840,	2160,	1001,	24000,	bmdProgressiveFrame },
+	{ bmdMode4K2160p24,		"2160p24",		3840,	2160,	1000,	24000,	bmdProgressiveFrame },
+	{ bmdMode4K2160p25,		"2160p25",		3840,	2160,	1000,	25000,	bmdProgressiveFrame },
+	{ bmdMode4K2160p2997,	"2160p29.97",	3840,	2160,	1001,	30000,	bmdProgressiveFrame },
+	{ bmdMode4K2160p30,		"2160p30",		3840,	2160,	1000,	30000,	bmdProgressiveFrame },
+	{ bmdMode4K2160p50,		"2160p50",		3840,	2160,	1000,	50000,	bmdProgressiveFrame },
+	{ bmdMode4K2160p5994,	"2160p59.94",	3840,	2160,	1001,	60000,	bmdProgressiveFrame },
+	{ bmdMode4K2160p60,		"2160p60",		3840,	2160,	1000,	60000,	bmdProgressiveFrame },
+};
+
+static const ReplayModeInfo* findMode(BMDDisplayMode displayMode)
+{
+	for (const ReplayModeInfo& mode : kReplayModes)
+	{
+		if (mode.displayMode == displayMode)
+			return &mode;
+	}
+	return nullptr;
+}
+
+static const ReplayModeInfo* findMode(const std::string& name)
+{
+	for (const ReplayModeInfo& mode : kReplayModes)
+	{
+		if (name == mode.name)
+			return &mode;
+	}
+	return nullptr;
+}
+
+// Raw PCM has no header to tell it apart, so WAV goes by its extension
+static bool isWavFile(const std::string& path)
+{
+	return path.size() > 4 && strcasecmp(path.c_str() + path.size() - 4, ".wav") == 0;
+}
+
+static long rowBytesFor(BMDPixelFormat pixelFormat, long width)
+{
+	// v210 packs 48 pixels into 128 bytes, rows padded to a whole group
+	return (pixelFormat == bmdFormat10BitYUV) ? ((width + 47) / 48) * 128 : width * 2;
+}
+
+// Converts between time scales without overflowing for long streams
+static int64_t scaleTime(int64_t value, int64_t fromScale, int64_t toScale)
+{
+	return value / fromScale * toScale + value % fromScale * toScale / fromScale;
+}
+
+static int64_t monotonicNowNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::shared_ptr<std::vector<uint8_t>> makeBlackFrame(BMDPixelFormat pixelFormat, long rowBytes, long height)
+{
+	std::shared_ptr<std::vector<uint8_t>>	frame = std::make_shared<std::vector<uint8_t>>((size_t)rowBytes * height);
+	uint8_t*								row = frame->data();
+
+	if (pixelFormat == bmdFormat10BitYUV)
+	{
+		for (long i = 0; i < rowBytes / 4; i++)
+		{
+			uint32_t word = (i & 1) ? kV210BlackOdd : kV210BlackEven;
+			memcpy(row + i * 4, &word, sizeof(word));
+		}
+	}
+	else
+	{
+		for (long i = 0; i < rowBytes; i += 2)
+		{
+			row[i] = 0x80;
+			row[i + 1] = 0x10;
+		}
+	}
+
+	for (long y = 1; y < height; y++)
+		memcpy(frame->data() + (size_t)y * rowBytes, row, rowBytes);
+
+	return frame;
+}
+
+static bool matchesIID(REFIID iid, REFIID other)
+{
+	return memcmp(&iid, &other, sizeof(REFIID)) == 0;
+}
+
+static bool isIUnknown(REFIID iid)
+{
+	CFUUIDBytes iunknown = CFUUIDGetUUIDBytes(IUnknownUUID);
+	return memcmp(&iid, &iunknown, sizeof(REFIID)) == 0;
+}
+
+/// Display modes
+
+class ReplayDisplayMode : public IDeckLinkDisplayMode
+{
+public:
+	explicit ReplayDisplayMode(const ReplayModeInfo* mode) : m_refCount(1), m_mode(mode) { }
+	virtual ~ReplayDisplayMode() = default;
+
+	HRESULT QueryInterface(REFIID iid, LPVOID *ppv) override
+	{
+		if (ppv == nullptr)
+			return E_INVALIDARG;
+
+		*ppv = nullptr;
+		if (!isIUnknown(iid) && !matchesIID(iid, IID_IDeckLinkDisplayMode))
+			return E_NOINTERFACE;
+
+		*ppv = (IDeckLinkDisplayMode*)this;
+		AddRef();
+		return S_OK;
+	}
+
+	ULONG AddRef() override { return ++m_refCount; }
+
+	ULONG Release() override
+	{
+		ULONG newRefValue = --m_refCount;
+		if (newRefValue == 0)
+			delete this;
+		return newRefValue;
+	}
+
+	HRESULT GetName(const char** name) override
+	{
+		*name = strdup(m_mode->name);
+		return (*name != nullptr) ? S_OK : E_OUTOFMEMORY;
+	}
+
+	BMDDisplayMode		GetDisplayMode() override { return m_mode->displayMode; }
+	long				GetWidth() override { return m_mode->width; }
+	long				GetHeight() override { return m_mode->height; }
+	BMDFieldDominance	GetFieldDominance() override { return m_mode->fieldDominance; }
+	BMDDisplayModeFlags	GetFlags() override { return bmdDisplayModeColorspaceRec709; }
+
+	HRESULT GetFrameRate(BMDTimeValue* frameDuration, BMDTimeScale* timeScale) override
+	{
+		*frameDuration = m_mode->frameDuration;
+		*timeScale = m_mode->timeScale;
+		return S_OK;
+	}
+
+private:
+	std::atomic<ULONG>		m_refCount;
+	const ReplayModeInfo*	m_mode;
+};
+
+class ReplayDisplayModeIterator : public IDeckLinkDisplayModeIterator
+{
+public:
+	ReplayDisplayModeIterator() : m_refCount(1), m_index(0) { }
+	virtual ~ReplayDisplayModeIterator() = default;
+
+	HRESULT QueryInterface(REFIID iid, LPVOID *ppv) override
+	{
+		if (ppv == nullptr)
+			return E_INVALIDARG;
+
+		*ppv = nullptr;
+		if (!isIUnknown(iid))
+			return E_NOINTERFACE;
+
+		*ppv = this;
+		AddRef();
+		return S_OK;
+	}
+
+	ULONG AddRef() override { return ++m_refCount; }
+
+	ULONG Release() override
+	{
+		ULONG newRefValue = --m_refCount;
+		if (newRefValue == 0)
+			delete this;
+		return newRefValue;
+	}
+
+	HRESULT Next(IDeckLinkDisplayMode** displayMode) override
+	{
+		if (m_index >= sizeof(kReplayModes) / sizeof(kReplayModes[0]))
+		{
+			*displayMode = nullptr;
+			return S_FALSE;
+		}
+
+		*displayMode = new ReplayDisplayMode(&kReplayModes[m_index++]);
+		return S_OK;
+	}
+
+private:
+	std::atomic<ULONG>		m_refCount;
+	size_t					m_index;
+};
+
+/// Frames and audio packets
+
+// Pooled by the input: the last Release() hands the frame back rather than
+// deleting it. Outstanding frames hold a reference on the input.
+class ReplayVideoFrame : public IDeckLinkVideoInputFrame
+{
+	friend class ReplayDeckLinkInput;
+
+public:
+	explicit ReplayVideoFrame(ReplayDeckLinkInput* owner) :
+		m_owner(owner), m_refCount(0), m_width(0), m_height(0), m_rowBytes(0), m_pixelFormat(bmdFormat8BitYUV),
+		m_flags(bmdFrameFlagDefault), m_bytes(nullptr), m_buffer(nullptr), m_ownBufferSize(0), m_renderedPattern(nullptr),
+		m_streamTime(0), m_frameDuration(0), m_timeScale(1), m_hardwareTimeNs(0) { }
+	virtual ~ReplayVideoFrame() = default;
+
+	HRESULT QueryInterface(REFIID iid, LPVOID *ppv) override
+	{
+		if (ppv == nullptr)
+			return E_INVALIDARG;
+
+		*ppv = nullptr;
+		if (!isIUnknown(iid) && !matchesIID(iid, IID_IDeckLinkVideoInputFrame) && !matchesIID(iid, IID_IDeckLinkVideoFrame))
+			return E_NOINTERFACE;
+
+		*ppv = (IDeckLinkVideoInputFrame*)this;
+		AddRef();
+		return S_OK;
+	}
+
+	ULONG AddRef() override { return ++m_refCount; }
+
+	ULONG Release() override
+	{
+		ULONG newRefValue = --m_refCount;
+		if (newRefValue == 0)
+			m_owner->recycleFrame(this);
+		return newRefValue;
+	}
+
+	long			GetWidth() override { return m_width; }
+	long			GetHeight() override { return m_height; }
+	long			GetRowBytes() override { return m_rowBytes; }
+	BMDPixelFormat	GetPixelFormat() override { return m_pixelFormat; }
+	BMDFrameFlags	GetFlags() override { return m_flags; }
+
+	HRESULT GetBytes(void** buffer) override
+	{
+		*buffer = m_bytes;
+		return S_OK;
+	}
+
+	HRESULT GetTimecode(BMDTimecodeFormat, IDeckLinkTimecode** timecode) override
+	{
+		*timecode = nullptr;
+		return S_FALSE;
+	}
+
+	HRESULT GetAncillaryData(IDeckLinkVideoFrameAncillary** ancillary) override
+	{
+		*ancillary = nullptr;
+		return S_FALSE;
+	}
+
+	HRESULT GetStreamTime(BMDTimeValue* frameTime, BMDTimeValue* frameDuration, BMDTimeScale timeScale) override
+	{
+		*frameTime = scaleTime(m_streamTime, m_timeScale, timeScale);
+		*frameDuration = scaleTime(m_frameDuration, m_timeScale, timeScale);
+		return S_OK;
+	}
+
+	HRESULT GetHardwareReferenceTimestamp(BMDTimeScale timeScale, BMDTimeValue* frameTime, BMDTimeValue* frameDuration) override
+	{
+		*frameTime = scaleTime(m_hardwareTimeNs, kNanosecondsPerSecond, timeScale);
+		*frameDuration = scaleTime(m_frameDuration, m_timeScale, timeScale);
+		return S_OK;
+	}
+
+private:
+	ReplayDeckLinkInput*					m_owner;
+	std::atomic<ULONG>						m_refCount;
+	long									m_width;
+	long									m_height;
+	long									m_rowBytes;
+	BMDPixelFormat							m_pixelFormat;
+	BMDFrameFlags							m_flags;
+	void*									m_bytes;			// Read only unless from the allocator
+	void*									m_buffer;			// From m_allocator, if any
+	com_ptr<IDeckLinkMemoryAllocator>		m_allocator;
+	std::shared_ptr<std::vector<uint8_t>>	m_blackFrame;		// Keeps a no-signal frame's bytes alive
+	std::unique_ptr<uint8_t, AlignedFreeDeleter>	m_ownBuffer;	// Test signal frames, kept across uses
+	size_t									m_ownBufferSize;
+	const TestPatternGenerator*				m_renderedPattern;	// Whose static parts m_ownBuffer holds
+	BMDTimeValue							m_streamTime;
+	BMDTimeValue							m_frameDuration;
+	BMDTimeScale							m_timeScale;
+	int64_t									m_hardwareTimeNs;
+};
+
+// One per input and reused for every frame, so like the driver's packets its
+// bytes are only valid during the VideoInputFrameArrived() call.
+class ReplayAudioPacket : public IDeckLinkAudioInputPacket
+{
+	friend class ReplayDeckLinkInput;
+
+public:
+	ReplayAudioPacket() : m_refCount(1), m_bytes(nullptr), m_sampleFrames(0), m_packetTime(0) { }
+	virtual ~ReplayAudioPacket() = default;
+
+	HRESULT QueryInterface(REFIID iid, LPVOID *ppv) override
+	{
+		if (ppv == nullptr)
+			return E_INVALIDARG;
+
+		*ppv = nullptr;
+		if (!isIUnknown(iid) && !matchesIID(iid, IID_IDeckLinkAudioInputPacket))
+			return E_NOINTERFACE;
+
+		*ppv = (IDeckLinkAudioInputPacket*)this;
+		AddRef();
+		return S_OK;
+	}
+
+	// Owned by the input; references are counted but never free it
+	ULONG AddRef() override { return ++m_refCount; }
+	ULONG Release() override { return --m_refCount; }
+
+	long GetSampleFrameCount() override { return m_sampleFrames; }
+
+	HRESULT GetBytes(void** buffer) override
+	{
+		*buffer = m_bytes;
+		return S_OK;
+	}
+
+	HRESULT GetPacketTime(BMDTimeValue* packetTime, BMDTimeScale timeScale) override
+	{
+		*packetTime = scaleTime(m_packetTime, kAudioSampleRate, timeScale);
+		return S_OK;
+	}
+
+private:
+	std::atomic<ULONG>		m_refCount;
+	void*					m_bytes;
+	long					m_sampleFrames;
+	int64_t					m_packetTime;		// In sample frames since the streams started
+};
+
+/// Attributes and configuration
+
+class ReplayDeckLinkAttributes : public IDeckLinkProfileAttributes
+{
+public:
+	ReplayDeckLinkAttributes() : m_refCount(1) { }
+	virtual ~ReplayDeckLinkAttributes() = default;
+
+	HRESULT QueryInterface(REFIID iid, LPVOID *ppv) override
+	{
+		if (ppv == nullptr)
+			return E_INVALIDARG;
+
+		*ppv = nullptr;
+		if (!isIUnknown(iid) && !matchesIID(iid, IID_IDeckLinkProfileAttributes))
+			return E_NOINTERFACE;
+
+		*ppv = (IDeckLinkProfileAttributes*)this;
+		AddRef();
+		return S_OK;
+	}
+
+	ULONG AddRef() override { return ++m_refCount; }
+
+	ULONG Release() override
+	{
+		ULONG newRefValue = --m_refCount;
+		if (newRefValue == 0)
+			delete this;
+		return newRefValue;
+	}
+
+	HRESULT GetFlag(BMDDeckLinkAttributeID cfgID, bool* value) override
+	{
+		if (cfgID != BMDDeckLinkSupportsInputFormatDetection)
+			return E_INVALIDARG;
+
+		*value = true;
+		return S_OK;
+	}
+
+	HRESULT GetInt(BMDDeckLinkAttributeID cfgID, int64_t* value) override
+	{
+		switch (cfgID)
+		{
+			case BMDDeckLinkVideoInputConnections:
+				*value = bmdVideoConnectionSDI;
+				return S_OK;
+			case BMDDeckLinkDuplex:
+				*value = bmdDuplexSimplex;
+				return S_OK;
+			case BMDDeckLinkMaximumAudioChannels:
+				*value = 16;
+				return S_OK;
+			default:
+				return E_INVALIDARG;
+		}
+	}
+
+	HRESULT GetFloat(BMDDeckLinkAttributeID, double*) override { return E_INVALIDARG; }
+	HRESULT GetString(BMDDeckLinkAttributeID, const char**) override { return E_INVALIDARG; }
+
+private:
+	std::atomic<ULONG>		m_refCount;
+};
+
+class ReplayDeckLinkConfiguration : public IDeckLinkConfiguration
+{
+public:
+	ReplayDeckLinkConfiguration() : m_refCount(1) { }
+	virtual ~ReplayDeckLinkConfiguration() = default;
+
+	HRESULT QueryInterface(REFIID iid, LPVOID *ppv) override
+	{
+		if (ppv == nullptr)
+			return E_INVALIDARG;
+
+		*ppv = nullptr;
+		if (!isIUnknown(iid) && !matchesIID(iid, IID_IDeckLinkConfiguration))
+			return E_NOINTERFACE;
+
+		*ppv = (IDeckLinkConfiguration*)this;
+		AddRef();
+		return S_OK;
+	}
+
+	ULONG AddRef() override { return ++m_refCount; }
+
+	ULONG Release() override
+	{
+		ULONG newRefValue = --m_refCount;
+		if (newRefValue == 0)
+			delete this;
+		return newRefValue;
+	}
+
+	// The only setting is the input connection, and SDI is the only one there is
+	HRESULT SetInt(BMDDeckLinkConfigurationID cfgID, int64_t value) override
+	{
+		if (cfgID != bmdDeckLinkConfigVideoInputConnection || value != bmdVideoConnectionSDI)
+			return E_INVALIDARG;
+		return S_OK;
+	}
+
+	HRESULT GetInt(BMDDeckLinkConfigurationID cfgID, int64_t* value) override
+	{
+		if (cfgID != bmdDeckLinkConfigVideoInputConnection)
+			return E_INVALIDARG;
+
+		*value = bmdVideoConnectionSDI;
+		return S_OK;
+	}
+
+	HRESULT SetFlag(BMDDeckLinkConfigurationID, bool) override { return E_INVALIDARG; }
+	HRESULT GetFlag(BMDDeckLinkConfigurationID, bool*) override { return E_INVALIDARG; }
+	HRESULT SetFloat(BMDDeckLinkConfigurationID, double) override { return E_INVALIDARG; }
+	HRESULT GetFloat(BMDDeckLinkConfigurationID, double*) override { return E_INVALIDARG; }
+	HRESULT SetString(BMDDeckLinkConfigurationID, const char*) override { return E_INVALIDARG; }
+	HRESULT GetString(BMDDeckLinkConfigurationID, const char**) override { return E_INVALIDARG; }
+	HRESULT WriteConfigurationToPreferences() override { return S_OK; }
+
+private:
+	std::atomic<ULONG>		m_refCount;
+};
+
+/// ReplayDeckLinkInput
+
+ReplayDeckLinkInput::ReplayDeckLinkInput() :
+	m_refCount(1),
+	m_audioFileData(nullptr),
+	m_audioFileChannels(0),
+	m_audioFileSampleBytes(0),
+	m_audioFileFrames(0),
+	m_realTime(true),
+	m_streaming(false),
+	m_exitThread(false),
+	m_videoEnabled(false),
+	m_enabledMode(nullptr),
+	m_enabledPixelFormat(bmdFormat8BitYUV),
+	m_enabledRowBytes(0),
+	m_formatDetection(false),
+	m_audioEnabled(false),
+	m_audioChannels(0),
+	m_audioSampleBytes(0),
+	m_segmentIndex(0),
+	m_segmentFrame(0),
+	m_ended(false),
+	m_signalMode(nullptr),
+	m_audioFramePosition(0),
+	m_tonePosition(0),
+	m_patternFrame(0),
+	m_streamStartNs(0),
+	m_streamFrame(0),
+	m_streamAudioFrames(0),
+	m_droppedFrames(0),
+	m_audioPacket(new ReplayAudioPacket())
+{
+	for (int i = 0; i < kFramePoolSize; i++)
+	{
+		m_frames.emplace_back(new ReplayVideoFrame(this));
+		m_freeFrames.push_back(m_frames.back().get());
+	}
+}
+
+ReplayDeckLinkInput::~ReplayDeckLinkInput()
+{
+	// The stream thread holds a reference while it runs, and every frame
+	// while it is outstanding, so by now both are done with this object
+}
+
+bool ReplayDeckLinkInput::Init()
+{
+	for (const ReplaySegment& replaySegment : options.replay.segments)
+	{
+		Segment		segment;
+
+		segment.mode = findMode(replaySegment.displayMode);
+		if (segment.mode == nullptr)
+		{
+			printf("Replay: unknown display mode %s\n", replaySegment.displayMode.c_str());
+			return false;
+		}
+
+		if (replaySegment.pixelFormat == "uyvy")
+			segment.pixelFormat = bmdFormat8BitYUV;
+		else if (replaySegment.pixelFormat == "v210")
+			segment.pixelFormat = bmdFormat10BitYUV;
+		else
+		{
+			printf("Replay: unsupported pixel format %s, use uyvy or v210\n", replaySegment.pixelFormat.c_str());
+			return false;
+		}
+
+		segment.rowBytes = rowBytesFor(segment.pixelFormat, segment.mode->width);
+		segment.frameBytes = (size_t)segment.rowBytes * segment.mode->height;
+		segment.fileFrames = 0;
+		segment.frames = replaySegment.frames;
+
+		if (replaySegment.testSignal)
+		{
+			if (!replaySegment.videoFile.empty() || segment.pixelFormat != bmdFormat8BitYUV)
+			{
+				printf("Replay: a test signal segment is uyvy and has no video file\n");
+				return false;
+			}
+
+			segment.pattern.reset(new TestPatternGenerator());
+			if (!segment.pattern->Init((int)segment.mode->width, (int)segment.mode->height))
+				return false;
+
+			if (segment.frames < 0)
+				segment.frames = 0;
+		}
+		else if (!replaySegment.videoFile.empty())
+		{
+			segment.videoFile.reset(new MappedFile());
+			if (!segment.videoFile->Open(replaySegment.videoFile))
+				return false;
+
+			segment.fileFrames = (int)(segment.videoFile->size() / segment.frameBytes);
+			if (segment.fileFrames == 0)
+			{
+				printf("Replay: %s holds no complete %s %s frame\n", replaySegment.videoFile.c_str(), segment.mode->name, replaySegment.pixelFormat.c_str());
+				return false;
+			}
+
+			if (segment.frames <= 0)
+				segment.frames = segment.fileFrames;
+		}
+		else if (segment.frames <= 0)
+		{
+			printf("Replay: a segment without a video file needs a frame count\n");
+			return false;
+		}
+
+		m_segments.push_back(std::move(segment));
+	}
+
+	if (m_segments.empty())
+		return false;
+
+	m_realTime = options.replay.realTime;
+	m_tone.Init(options.replay.toneDbfs);
+
+	if (isWavFile(options.replay.audioFile))
+	{
+		if (!loadWavAudio(options.replay.audioFile))
+			return false;
+	}
+	else if (!options.replay.audioFile.empty())
+	{
+		if (options.replay.audioChannels < 1 || (options.replay.audioSampleBits != 16 && options.replay.audioSampleBits != 32))
+		{
+			printf("Replay: audio must be 16 or 32-bit with at least one channel\n");
+			return false;
+		}
+
+		if (!m_audioFile.Open(options.replay.audioFile))
+			return false;
+
+		m_audioFileChannels = options.replay.audioChannels;
+		m_audioFileSampleBytes = options.replay.audioSampleBits / 8;
+		m_audioFileData = m_audioFile.data();
+		m_audioFileFrames = m_audioFile.size() / (m_audioFileChannels * m_audioFileSampleBytes);
+	}
+
+	return true;
+}
+
+// Decodes a WAV file whole through the file parser, which resamples 16-bit
+// files at another rate to the replay's 48 kHz. Its header overrides
+// options.replay.audioChannels and audioSampleBits.
+bool ReplayDeckLinkInput::loadWavAudio(const std::string& path)
+{
+	AudioFileParserFactory::ParserConfig	config;
+	std::unique_ptr<AudioFileParser>		parser;
+	std::vector<char>						chunk;
+	int										sampleBits;
+
+	config.filePath = path.c_str();
+	config.fileType = AUDIO_FILE_TYPE::AUDIO_FILE_PCM;
+	config.outputSampleRateHz = kAudioSampleRate;
+	parser = AudioFileParserFactory::Instance().createAudioFileParser(config);
+	if (!parser || !parser->open())
+		return false;
+
+	sampleBits = parser->getBitsPerSample();
+	if (sampleBits != 16 && sampleBits != 32)
+	{
+		printf("Replay: %s must hold 16 or 32-bit PCM, not %d-bit\n", path.c_str(), sampleBits);
+		return false;
+	}
+
+	m_audioFileChannels = parser->getNumberOfChannels();
+	m_audioFileSampleBytes = sampleBits / 8;
+	chunk.resize((size_t)(kAudioSampleRate / 100) * m_audioFileChannels * m_audioFileSampleBytes);
+
+	m_wavAudio.clear();
+	while (parser->hasNext())
+	{
+		int length = (int)chunk.size();
+
+		parser->getNext(chunk.data(), &length);
+		m_wavAudio.insert(m_wavAudio.end(), chunk.begin(), chunk.begin() + length);
+	}
+
+	m_audioFileData = m_wavAudio.data();
+	m_audioFileFrames = m_wavAudio.size() / (m_audioFileChannels * m_audioFileSampleBytes);
+	printf("Replay: %s holds %zu frames of %d-channel %d-bit audio at %d Hz\n", path.c_str(), m_audioFileFrames, m_audioFileChannels, sampleBits, kAudioSampleRate);
+	return true;
+}
+
+/// IUnknown methods
+
+HRESULT ReplayDeckLinkInput::QueryInterface(REFIID iid, LPVOID *ppv)
+{
+	HRESULT			result = E_NOINTERFACE;
+
+	if (ppv == nullptr)
+		return E_INVALIDARG;
+
+	// Initialise the return result
+	*ppv = nullptr;
+
+	if (isIUnknown(iid) || matchesIID(iid, IID_IDeckLinkInput))
+	{
+		*ppv = (IDeckLinkInput*)this;
+		AddRef();
+		result = S_OK;
+	}
+
+	return result;
+}
+
+ULONG ReplayDeckLinkInput::AddRef(void)
+{
+	return ++m_refCount;
+}
+
+ULONG ReplayDeckLinkInput::Release(void)
+{
+	ULONG newRefValue = --m_refCount;
+	if (newRefValue == 0)
+		delete this;
+
+	return newRefValue;
+}
+
+/// IDeckLinkInput methods
+
+HRESULT ReplayDeckLinkInput::DoesSupportVideoMode(BMDVideoConnection connection, BMDDisplayMode requestedMode, BMDPixelFormat requestedPixelFormat, BMDVideoInputConversionMode /* conversionMode */, BMDSupportedVideoModeFlags /* flags */, BMDDisplayMode* actualMode, bool* supported)
+{
+	const ReplayModeInfo*	mode = findMode(requestedMode);
+
+	if (supported == nullptr)
+		return E_POINTER;
+
+	*supported = (mode != nullptr)
+		&& (connection == bmdVideoConnectionUnspecified || connection == bmdVideoConnectionSDI)
+		&& (requestedPixelFormat == bmdFormat8BitYUV || requestedPixelFormat == bmdFormat10BitYUV);
+
+	if (actualMode != nullptr)
+		*actualMode = *supported ? requestedMode : bmdModeUnknown;
+
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::GetDisplayMode(BMDDisplayMode displayMode, IDeckLinkDisplayMode** resultDisplayMode)
+{
+	const ReplayModeInfo*	mode = findMode(displayMode);
+
+	if (resultDisplayMode == nullptr)
+		return E_POINTER;
+
+	*resultDisplayMode = nullptr;
+	if (mode == nullptr)
+		return E_INVALIDARG;
+
+	*resultDisplayMode = new ReplayDisplayMode(mode);
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::GetDisplayModeIterator(IDeckLinkDisplayModeIterator** iterator)
+{
+	if (iterator == nullptr)
+		return E_POINTER;
+
+	*iterator = new ReplayDisplayModeIterator();
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::SetScreenPreviewCallback(IDeckLinkScreenPreviewCallback* previewCallback)
+{
+	std::lock_guard<std::mutex>	lock(m_mutex);
+
+	m_previewCallback = previewCallback;
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::EnableVideoInput(BMDDisplayMode displayMode, BMDPixelFormat pixelFormat, BMDVideoInputFlags flags)
+{
+	const ReplayModeInfo*			mode = findMode(displayMode);
+	std::lock_guard<std::mutex>		lock(m_mutex);
+
+	if (mode == nullptr || (pixelFormat != bmdFormat8BitYUV && pixelFormat != bmdFormat10BitYUV))
+		return E_INVALIDARG;
+
+	if (m_streaming)
+		return E_ACCESSDENIED;
+
+	// Frames still holding the previous black frame keep it alive
+	m_enabledMode = mode;
+	m_enabledPixelFormat = pixelFormat;
+	m_enabledRowBytes = rowBytesFor(pixelFormat, mode->width);
+	m_formatDetection = (flags & bmdVideoInputEnableFormatDetection) != 0;
+	m_blackFrame = makeBlackFrame(pixelFormat, m_enabledRowBytes, mode->height);
+	m_videoEnabled = true;
+
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::DisableVideoInput()
+{
+	std::lock_guard<std::mutex>	lock(m_mutex);
+
+	if (m_streaming)
+		return E_ACCESSDENIED;
+
+	m_videoEnabled = false;
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::GetAvailableVideoFrameCount(uint32_t* availableFrameCount)
+{
+	// Frames go straight to the callback; nothing is buffered
+	*availableFrameCount = 0;
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::SetVideoInputFrameMemoryAllocator(IDeckLinkMemoryAllocator* theAllocator)
+{
+	std::lock_guard<std::mutex>	lock(m_mutex);
+
+	if (m_streaming)
+		return E_ACCESSDENIED;
+
+	m_allocator = theAllocator;
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::EnableAudioInput(BMDAudioSampleRate sampleRate, BMDAudioSampleType sampleType, uint32_t channelCount)
+{
+	std::lock_guard<std::mutex>	lock(m_mutex);
+
+	if (sampleRate != bmdAudioSampleRate48kHz
+		|| (sampleType != bmdAudioSampleType16bitInteger && sampleType != bmdAudioSampleType32bitInteger)
+		|| (channelCount != 2 && channelCount != 8 && channelCount != 16))
+		return E_INVALIDARG;
+
+	if (m_streaming)
+		return E_ACCESSDENIED;
+
+	m_audioChannels = (int)channelCount;
+	m_audioSampleBytes = (sampleType == bmdAudioSampleType32bitInteger) ? 4 : 2;
+	m_audioScratch.assign((size_t)kMaxAudioSampleFrames * m_audioChannels * m_audioSampleBytes, 0);
+	m_audioEnabled = true;
+
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::DisableAudioInput()
+{
+	std::lock_guard<std::mutex>	lock(m_mutex);
+
+	if (m_streaming)
+		return E_ACCESSDENIED;
+
+	m_audioEnabled = false;
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::GetAvailableAudioSampleFrameCount(uint32_t* availableSampleFrameCount)
+{
+	*availableSampleFrameCount = 0;
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::StartStreams()
+{
+	std::lock_guard<std::mutex>	lock(m_mutex);
+
+	if (!m_videoEnabled || m_streaming)
+		return E_ACCESSDENIED;
+
+	if (m_allocator)
+		m_allocator->Commit();
+
+	// Stream time restarts; the position in the recording carries on
+	m_streaming = true;
+	m_streamStartNs = monotonicNowNs();
+	m_streamFrame = 0;
+	m_streamAudioFrames = 0;
+	m_droppedFrames = 0;
+
+	// Called from a callback on the stream thread, which just carries on
+	if (!m_thread.joinable())
+	{
+		AddRef();
+		m_thread = std::thread(&ReplayDeckLinkInput::streamThread, this);
+		pthread_setname_np(m_thread.native_handle(), "replay");
+	}
+
+	m_wake.notify_all();
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::StopStreams()
+{
+	std::unique_lock<std::mutex>	lock(m_mutex);
+
+	if (m_streaming)
+	{
+		if (m_droppedFrames > 0)
+			printf("Replay: %llu frames dropped with all frame buffers held\n", (unsigned long long)m_droppedFrames);
+
+		if (m_allocator)
+			m_allocator->Decommit();
+	}
+	m_streaming = false;
+
+	// From a callback the thread cannot join itself; it idles until started again or stopped from outside
+	if (!m_thread.joinable() || m_thread.get_id() == std::this_thread::get_id())
+		return S_OK;
+
+	m_exitThread = true;
+	m_wake.notify_all();
+	lock.unlock();
+
+	m_thread.join();
+
+	lock.lock();
+	m_exitThread = false;
+
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::PauseStreams()
+{
+	return E_NOTIMPL;
+}
+
+HRESULT ReplayDeckLinkInput::FlushStreams()
+{
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::SetCallback(IDeckLinkInputCallback* theCallback)
+{
+	std::lock_guard<std::mutex>	lock(m_mutex);
+
+	m_callback = theCallback;
+	return S_OK;
+}
+
+HRESULT ReplayDeckLinkInput::GetHardwareReferenceClock(BMDTimeScale desiredTimeScale, BMDTimeValue* hardwareTime, BMDTimeValue* timeInFrame, BMDTimeValue* ticksPerFrame)
+{
+	int64_t							nowNs = monotonicNowNs();
+	std::lock_guard<std::mutex>		lock(m_mutex);
+
+	if (hardwareTime == nullptr || timeInFrame == nullptr || ticksPerFrame == nullptr)
+		return E_POINTER;
+
+	*hardwareTime = scaleTime(nowNs, kNanosecondsPerSecond, desiredTimeScale);
+	*timeInFrame = 0;
+	*ticksPerFrame = 0;
+
+	if (m_enabledMode != nullptr)
+		*ticksPerFrame = scaleTime(m_enabledMode->frameDuration, m_enabledMode->timeScale, desiredTimeScale);
+
+	if (m_streaming && nowNs >= m_streamStartNs)
+	{
+		int64_t frame = scaleTime(nowNs - m_streamStartNs, kNanosecondsPerSecond, m_enabledMode->timeScale) / m_enabledMode->frameDuration;
+		*timeInFrame = scaleTime(nowNs - frameTimeNs(frame), kNanosecondsPerSecond, desiredTimeScale);
+	}
+
+	return S_OK;
+}
+
+/// Replay
+
+void ReplayDeckLinkInput::recycleFrame(ReplayVideoFrame* frame)
+{
+	if (frame->m_allocator)
+	{
+		frame->m_allocator->ReleaseBuffer(frame->m_buffer);
+		frame->m_allocator = nullptr;
+		frame->m_buffer = nullptr;
+	}
+	frame->m_blackFrame.reset();
+
+	{
+		std::lock_guard<std::mutex>	lock(m_poolMutex);
+		m_freeFrames.push_back(frame);
+	}
+	m_frameFree.notify_one();
+
+	// Taken when the frame was handed out
+	Release();
+}
+
+ReplayVideoFrame* ReplayDeckLinkInput::takeFrame()
+{
+	std::lock_guard<std::mutex>	lock(m_poolMutex);
+	ReplayVideoFrame*			frame;
+
+	if (m_freeFrames.empty())
+		return nullptr;
+
+	frame = m_freeFrames.back();
+	m_freeFrames.pop_back();
+	frame->m_refCount = 1;
+
+	return frame;
+}
+
+int64_t ReplayDeckLinkInput::frameTimeNs(int64_t frame) const
+{
+	return m_streamStartNs + scaleTime(frame * m_enabledMode->frameDuration, m_enabledMode->timeScale, kNanosecondsPerSecond);
+}
+
+void ReplayDeckLinkInput::advanceSegment()
+{
+	if (m_segments[m_segmentIndex].frames == 0 || ++m_segmentFrame < m_segments[m_segmentIndex].frames)
+		return;
+
+	m_segmentFrame = 0;
+	if (++m_segmentIndex < m_segments.size())
+		return;
+
+	m_segmentIndex = 0;
+	m_ended = !options.replay.loop;
+}
+
+long ReplayDeckLinkInput::fillAudioPacket(bool signalValid, bool testSignal)
+{
+	int64_t			packetEnd;
+	long			sampleFrames;
+	size_t			frameBytes = (size_t)m_audioChannels * m_audioSampleBytes;
+	size_t			fileFrameBytes = (size_t)m_audioFileChannels * m_audioFileSampleBytes;
+	uint8_t*		bytes = m_audioScratch.data();
+
+	// Whole samples up to the end of this frame, so fractional rates like 29.97 never drift
+	packetEnd = scaleTime((m_streamFrame + 1) * m_enabledMode->frameDuration, m_enabledMode->timeScale, kAudioSampleRate);
+	sampleFrames = (long)std::min<int64_t>(packetEnd - m_streamAudioFrames, kMaxAudioSampleFrames);
+
+	if (signalValid && testSignal)
+	{
+		m_tone.Render(m_tonePosition, m_audioChannels, m_audioSampleBytes, bytes, sampleFrames);
+		m_tonePosition += sampleFrames;
+	}
+	else if (!signalValid || m_audioFileFrames == 0)
+	{
+		memset(bytes, 0, sampleFrames * frameBytes);
+	}
+	else if (m_audioFileChannels == m_audioChannels && m_audioFileSampleBytes == m_audioSampleBytes
+			 && m_audioFramePosition + sampleFrames <= m_audioFileFrames)
+	{
+		bytes = (uint8_t*)m_audioFileData + m_audioFramePosition * frameBytes;
+	}
+	else
+	{
+		// Wrap around the end of the file, matching the enabled channel count and sample type
+		uint8_t* dst = bytes;
+
+		for (long i = 0; i < sampleFrames; i++)
+		{
+			const uint8_t* src = m_audioFileData + ((m_audioFramePosition + i) % m_audioFileFrames) * fileFrameBytes;
+
+			for (int channel = 0; channel < m_audioChannels; channel++)
+			{
+				int32_t		sample = 0;
+				int16_t		sample16;
+
+				if (channel < m_audioFileChannels && m_audioFileSampleBytes == 2)
+				{
+					memcpy(&sample16, src + channel * 2, 2);
+					sample = (int32_t)sample16 * 65536;
+				}
+				else if (channel < m_audioFileChannels)
+				{
+					memcpy(&sample, src + channel * 4, 4);
+				}
+
+				if (m_audioSampleBytes == 2)
+				{
+					sample16 = (int16_t)(sample >> 16);
+					memcpy(dst, &sample16, 2);
+				}
+				else
+				{
+					memcpy(dst, &sample, 4);
+				}
+				dst += m_audioSampleBytes;
+			}
+		}
+	}
+
+	if (signalValid && !testSignal && m_audioFileFrames > 0)
+		m_audioFramePosition = (m_audioFramePosition + sampleFrames) % m_audioFileFrames;
+
+	m_audioPacket->m_bytes = bytes;
+	m_audioPacket->m_sampleFrames = sampleFrames;
+	m_audioPacket->m_packetTime = m_streamAudioFrames;
+	m_streamAudioFrames += sampleFrames;
+
+	return sampleFrames;
+}
+
+void ReplayDeckLinkInput::streamThread()
+{
+	std::unique_lock<std::mutex>	lock(m_mutex);
+
+	while (!m_exitThread)
+	{
+		com_ptr<IDeckLinkInputCallback>				callback;
+		com_ptr<IDeckLinkScreenPreviewCallback>		previewCallback;
+		IDeckLinkAudioInputPacket*					audioPacket = nullptr;
+		ReplayVideoFrame*							frame;
+		const Segment*								segment;
+		const TestPatternGenerator*					pattern = nullptr;
+		const uint8_t*								bytes = nullptr;
+		size_t										frameBytes = 0;
+		uint32_t									patternFrame = 0;
+		bool										signalValid;
+		int64_t										dueNs;
+
+		if (!m_streaming)
+		{
+			m_wake.wait(lock);
+			continue;
+		}
+
+		// Each frame is due on the recorded cadence from the stream start; a late thread catches up back to back
+		dueNs = frameTimeNs(m_streamFrame);
+		if (m_realTime && m_wake.wait_until(lock, std::chrono::steady_clock::time_point(std::chrono::nanoseconds(dueNs)),
+											[this, dueNs] { return m_exitThread || !m_streaming || frameTimeNs(m_streamFrame) != dueNs; }))
+			continue;
+
+		segment = m_ended ? nullptr : &m_segments[m_segmentIndex];
+
+		// A new signal on the "cable" is reported like the card's format detection does,
+		// and the callback usually restarts the streams in the new mode from within it
+		if (segment == nullptr || (!segment->videoFile && !segment->pattern))
+		{
+			m_signalMode = nullptr;
+		}
+		else if (segment->mode != m_signalMode)
+		{
+			m_signalMode = segment->mode;
+			if (m_formatDetection && m_callback && m_signalMode != m_enabledMode)
+			{
+				com_ptr<ReplayDisplayMode>			displayMode = make_com_ptr<ReplayDisplayMode>(m_signalMode);
+				BMDDetectedVideoInputFormatFlags	detectedFlags = bmdDetectedVideoInputYCbCr422;
+
+				detectedFlags |= (segment->pixelFormat == bmdFormat10BitYUV) ? bmdDetectedVideoInput10BitDepth : bmdDetectedVideoInput8BitDepth;
+				callback = m_callback;
+
+				lock.unlock();
+				callback->VideoInputFormatChanged(bmdVideoInputDisplayModeChanged, displayMode.get(), detectedFlags);
+				lock.lock();
+				continue;
+			}
+		}
+
+		signalValid = (m_signalMode != nullptr) && (m_signalMode == m_enabledMode);
+
+		frame = takeFrame();
+		if (frame == nullptr && !m_realTime)
+		{
+			// Unpaced, the callback sets the rate: wait for it to give a frame back
+			lock.unlock();
+			{
+				std::unique_lock<std::mutex>	poolLock(m_poolMutex);
+				m_frameFree.wait_for(poolLock, std::chrono::milliseconds(kFrameWaitMs), [this] { return !m_freeFrames.empty(); });
+			}
+			lock.lock();
+			continue;
+		}
+
+		if (signalValid && segment->pattern)
+		{
+			pattern = segment->pattern.get();
+			patternFrame = m_patternFrame++;
+		}
+
+		if (frame != nullptr)
+		{
+			if (signalValid)
+			{
+				if (pattern == nullptr)
+					bytes = segment->videoFile->data() + (size_t)(m_segmentFrame % segment->fileFrames) * segment->frameBytes;
+				frameBytes = segment->frameBytes;
+				frame->m_rowBytes = segment->rowBytes;
+				frame->m_pixelFormat = segment->pixelFormat;
+				frame->m_flags = bmdFrameFlagDefault;
+			}
+			else
+			{
+				frame->m_blackFrame = m_blackFrame;
+				bytes = m_blackFrame->data();
+				frameBytes = m_blackFrame->size();
+				frame->m_rowBytes = m_enabledRowBytes;
+				frame->m_pixelFormat = m_enabledPixelFormat;
+				frame->m_flags = bmdFrameHasNoInputSource;
+			}
+
+			frame->m_width = m_enabledMode->width;
+			frame->m_height = m_enabledMode->height;
+			frame->m_bytes = (void*)bytes;
+
+			// What the card's DMA does into application buffers, filled below
+			if (m_allocator && m_allocator->AllocateBuffer((uint32_t)frameBytes, &frame->m_buffer) == S_OK)
+				frame->m_allocator = m_allocator;
+
+			frame->m_streamTime = m_streamFrame * m_enabledMode->frameDuration;
+			frame->m_frameDuration = m_enabledMode->frameDuration;
+			frame->m_timeScale = m_enabledMode->timeScale;
+			frame->m_hardwareTimeNs = m_realTime ? dueNs : monotonicNowNs();
+
+			// Released in recycleFrame()
+			AddRef();
+		}
+		else
+		{
+			++m_droppedFrames;
+		}
+
+		if (m_audioEnabled)
+		{
+			fillAudioPacket(signalValid, pattern != nullptr);
+			audioPacket = m_audioPacket.get();
+		}
+
+		++m_streamFrame;
+		if (segment != nullptr)
+			advanceSegment();
+
+		callback = m_callback;
+		previewCallback = m_previewCallback;
+		lock.unlock();
+
+		// Rendering and copying need none of the stream state
+		if (frame != nullptr && pattern != nullptr)
+		{
+			uint8_t*	dst = (uint8_t*)frame->m_buffer;
+			bool		staticValid = false;
+
+			if (dst == nullptr)
+			{
+				// Only grows the first time a frame is used in a larger mode
+				if (frame->m_ownBufferSize < frameBytes)
+				{
+					frame->m_ownBuffer.reset(AlignedMalloc<uint8_t>(frameBytes, kFrameAlignment));
+					frame->m_ownBufferSize = frameBytes;
+					frame->m_renderedPattern = nullptr;
+				}
+				dst = frame->m_ownBuffer.get();
+				staticValid = (frame->m_renderedPattern == pattern);
+				frame->m_renderedPattern = pattern;
+			}
+
+			pattern->RenderUyvy(patternFrame, dst, frame->m_rowBytes, staticValid);
+			frame->m_bytes = dst;
+		}
+		else if (frame != nullptr && frame->m_buffer != nullptr)
+		{
+			memcpy(frame->m_buffer, bytes, frameBytes);
+			frame->m_bytes = frame->m_buffer;
+		}
+
+		if (frame != nullptr && previewCallback)
+			previewCallback->DrawFrame(frame);
+
+		if (callback)
+			callback->VideoInputFrameArrived(frame, audioPacket);
+
+		if (frame != nullptr)
+			frame->Release();
+
+		lock.lock();
+	}
+
+	lock.unlock();
+
+	// Taken in StartStreams()
+	Release();
+}
+
+/// ReplayDeckLink
+
+ReplayDeckLink::ReplayDeckLink() :
+	m_refCount(1),
+	m_deckLinkInput(make_com_ptr<ReplayDeckLinkInput>()),
+	m_deckLinkAttributes(make_com_ptr<ReplayDeckLinkAttributes>()),
+	m_deckLinkConfig(make_com_ptr<ReplayDeckLinkConfiguration>())
+{
+}
+
+ReplayDeckLink::~ReplayDeckLink()
+{
+}
+
+bool ReplayDeckLink::Init()
+{
+	return m_deckLinkInput->Init();
+}
+
+HRESULT ReplayDeckLink::QueryInterface(REFIID iid, LPVOID *ppv)
+{
+	HRESULT			result = E_NOINTERFACE;
+
+	if (ppv == nullptr)
+		return E_INVALIDARG;
+
+	// Initialise the return result
+	*ppv = nullptr;
+
+	if (isIUnknown(iid) || matchesIID(iid, IID_IDeckLink))
+	{
+		*ppv = (IDeckLink*)this;
+		AddRef();
+		result = S_OK;
+	}
+	else if (matchesIID(iid, IID_IDeckLinkInput))
+	{
+		result = m_deckLinkInput->QueryInterface(iid, ppv);
+	}
+	else if (matchesIID(iid, IID_IDeckLinkProfileAttributes))
+	{
+		result = m_deckLinkAttributes->QueryInterface(iid, ppv);
+	}
+	else if (matchesIID(iid, IID_IDeckLinkConfiguration))
+	{
+		result = m_deckLinkConfig->QueryInterface(iid, ppv);
+	}
+
+	return result;
+}
+
+ULONG ReplayDeckLink::AddRef(void)
+{
+	return ++m_refCount;
+}
+
+ULONG ReplayDeckLink::Release(void)
+{
+	ULONG newRefValue = --m_refCount;
+	if (newRefValue == 0)
+		delete this;
+
+	return newRefValue;
+}
+
+HRESULT ReplayDeckLink::GetModelName(const char** modelName)
+{
+	*modelName = strdup("DeckLink Replay");
+	return (*modelName != nullptr) ? S_OK : E_OUTOFMEMORY;
+}
+
+HRESULT ReplayDeckLink::GetDisplayName(const char** displayName)
+{
+	*displayName = strdup(options.replay.deviceName.c_str());
+	return (*displayName != nullptr) ? S_OK : E_OUTOFMEMORY;
+}
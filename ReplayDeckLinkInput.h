@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "DeckLinkAPI.h"
+#include "utils/mapped_file.h"
+#include "utils/test_signal.h"
+#include "com_ptr.h"
+
+struct ReplayModeInfo;
+class ReplayVideoFrame;
+class ReplayAudioPacket;
+class ReplayDeckLinkAttributes;
+class ReplayDeckLinkConfiguration;
+
+// Software stand-in for a DeckLink input that replays raw captures from disk,
+// as configured in options.replay, so the whole capture, convert and send
+// path can be run and profiled on a host without a card or driver.
+//
+// A timer thread delivers frames at the cadence of the recorded display mode,
+// each with the audio recorded over its duration and stamped with its
+// scheduled capture time as the hardware reference timestamp. Without a frame
+// memory allocator frames point straight into the mapped file; with one, each
+// is copied into an allocator buffer as the card's DMA would. Frames keep the
+// pixel format they were recorded in.
+//
+// Segments in different display modes simulate input format changes: with
+// format detection enabled the callback gets VideoInputFormatChanged and may
+// restart the streams from within it, as with hardware. Until the enabled mode
+// matches the signal again, and during segments without a file, frames are
+// black and flagged bmdFrameHasNoInputSource.
+//
+// Test signal segments need no file: each frame is rendered from a
+// TestPatternGenerator into the frame's own reusable buffer (or the allocator
+// buffer) with line-up tone as audio, indefinitely if no frame count is set.
+// With options.replay.realTime off, frames are delivered as fast as the
+// callback takes them, waiting for a pooled frame rather than dropping one,
+// and stamped with the time they were made.
+class ReplayDeckLinkInput : public IDeckLinkInput
+{
+public:
+	ReplayDeckLinkInput();
+	virtual ~ReplayDeckLinkInput();
+
+	// Maps the files in options.replay
+	bool		Init();
+
+	// Frames come back here when their last reference is released
+	void		recycleFrame(ReplayVideoFrame* frame);
+
+	// IUnknown interface
+	HRESULT		QueryInterface(REFIID iid, LPVOID *ppv) override;
+	ULONG		AddRef() override;
+	ULONG		Release() override;
+
+	// IDeckLinkInput interface
+	HRESULT		DoesSupportVideoMode(BMDVideoConnection connection, BMDDisplayMode requestedMode, BMDPixelFormat requestedPixelFormat, BMDVideoInputConversionMode conversionMode, BMDSupportedVideoModeFlags flags, BMDDisplayMode* actualMode, bool* supported) override;
+	HRESULT		GetDisplayMode(BMDDisplayMode displayMode, IDeckLinkDisplayMode** resultDisplayMode) override;
+	HRESULT		GetDisplayModeIterator(IDeckLinkDisplayModeIterator** iterator) override;
+	HRESULT		SetScreenPreviewCallback(IDeckLinkScreenPreviewCallback* previewCallback) override;
+	HRESULT		EnableVideoInput(BMDDisplayMode displayMode, BMDPixelFormat pixelFormat, BMDVideoInputFlags flags) override;
+	HRESULT		DisableVideoInput() override;
+	HRESULT		GetAvailableVideoFrameCount(uint32_t* availableFrameCount) override;
+	HRESULT		SetVideoInputFrameMemoryAllocator(IDeckLinkMemoryAllocator* theAllocator) override;
+	HRESULT		EnableAudioInput(BMDAudioSampleRate sampleRate, BMDAudioSampleType sampleType, uint32_t channelCount) override;
+	HRESULT		DisableAudioInput() override;
+	HRESULT		GetAvailableAudioSampleFrameCount(uint32_t* availableSampleFrameCount) override;
+	HRESULT		StartStreams() override;
+	HRESULT		StopStreams() override;
+	HRESULT		PauseStreams() override;
+	HRESULT		FlushStreams() override;
+	HRESULT		SetCallback(IDeckLinkInputCallback* theCallback) override;
+	HRESULT		GetHardwareReferenceClock(BMDTimeScale desiredTimeScale, BMDTimeValue* hardwareTime, BMDTimeValue* timeInFrame, BMDTimeValue* ticksPerFrame) override;
+
+private:
+	struct Segment
+	{
+		std::unique_ptr<MappedFile>		videoFile;			// Null for no signal or a test signal
+		std::unique_ptr<TestPatternGenerator>	pattern;		// Test signal, if set
+		const ReplayModeInfo*			mode;
+		BMDPixelFormat					pixelFormat;
+		long							rowBytes;
+		size_t							frameBytes;
+		int								fileFrames;
+		int								frames;				// 0 runs for ever
+	};
+
+	std::atomic<ULONG>							m_refCount;
+	std::vector<Segment>						m_segments;
+	MappedFile									m_audioFile;
+	std::vector<uint8_t>						m_wavAudio;			// A WAV --replay-audio, decoded at the replay rate
+	const uint8_t*								m_audioFileData;	// In m_audioFile or m_wavAudio
+	int											m_audioFileChannels;
+	int											m_audioFileSampleBytes;
+	size_t										m_audioFileFrames;
+	TestToneGenerator							m_tone;
+	bool										m_realTime;
+
+	std::mutex									m_mutex;			// Guards the stream state below
+	std::condition_variable						m_wake;
+	std::thread									m_thread;
+	bool										m_streaming;
+	bool										m_exitThread;
+	com_ptr<IDeckLinkInputCallback>				m_callback;
+	com_ptr<IDeckLinkScreenPreviewCallback>		m_previewCallback;
+	com_ptr<IDeckLinkMemoryAllocator>			m_allocator;
+	bool										m_videoEnabled;
+	const ReplayModeInfo*						m_enabledMode;
+	BMDPixelFormat								m_enabledPixelFormat;
+	long										m_enabledRowBytes;
+	bool										m_formatDetection;
+	std::shared_ptr<std::vector<uint8_t>>		m_blackFrame;		// No-signal frame in the enabled mode
+	bool										m_audioEnabled;
+	int											m_audioChannels;
+	int											m_audioSampleBytes;
+	std::vector<uint8_t>						m_audioScratch;
+	size_t										m_segmentIndex;
+	int											m_segmentFrame;
+	bool										m_ended;
+	const ReplayModeInfo*						m_signalMode;		// What the "cable" carries, null for no signal
+	size_t										m_audioFramePosition;
+	int64_t										m_tonePosition;
+	uint32_t									m_patternFrame;		// Counts every test signal slot, dropped or not
+	int64_t										m_streamStartNs;
+	int64_t										m_streamFrame;
+	int64_t										m_streamAudioFrames;
+	uint64_t									m_droppedFrames;
+
+	std::mutex									m_poolMutex;
+	std::vector<std::unique_ptr<ReplayVideoFrame>>	m_frames;
+	std::vector<ReplayVideoFrame*>				m_freeFrames;
+	std::condition_variable						m_frameFree;
+	std::unique_ptr<ReplayAudioPacket>			m_audioPacket;
+
+	bool		loadWavAudio(const std::string& path);
+	void		streamThread();
+	void		advanceSegment();
+	ReplayVideoFrame*	takeFrame();
+	long		fillAudioPacket(bool signalValid, bool testSignal);
+	int64_t		frameTimeNs(int64_t frame) const;
+};
+
+// Virtual DeckLink device exposing a ReplayDeckLinkInput, with just enough of
+// the attribute and configuration interfaces for DeckLinkInputDevice and the
+// capture dialog to treat it like a single-input SDI card.
+class ReplayDeckLink : public IDeckLink
+{
+public:
+	ReplayDeckLink();
+	virtual ~ReplayDeckLink();
+
+	bool		Init();
+
+	// IUnknown interface
+	HRESULT		QueryInterface(REFIID iid, LPVOID *ppv) override;
+	ULONG		AddRef() override;
+	ULONG		Release() override;
+
+	// IDeckLink interface
+	HRESULT		GetModelName(const char** modelName) override;
+	HRESULT		GetDisplayName(const char** displayName) override;
+
+private:
+	std::atomic<ULONG>						m_refCount;
+	com_ptr<ReplayDeckLinkInput>			m_deckLinkInput;
+	com_ptr<ReplayDeckLinkAttributes>		m_deckLinkAttributes;
+	com_ptr<ReplayDeckLinkConfiguration>	m_deckLinkConfig;
+};
@@ -0,0 +1,1002 @@
+// Microbenchmark for the capture path pixel, audio and stream kernels.
+//
+// Runs every ISA variant supported by the CPU, checks each against the
+// scalar kernels and reports time, throughput and cycles per pixel, audio
+// frame or byte. Every kernel is timed twice:
+//   - warm: iterations back to back, so each one finds whatever of its
+//     buffers the previous one left in cache,
+//   - cold: the kernel's buffers are flushed from every cache level before
+//     each iteration (outside the timed region), as for a frame the card has
+//     just written to memory.
+//
+// Pixel kernels run at 720p, 1080p and 2160p:
+//   - UYVY -> I422 against the scalar loop that used to live in
+//     DeckLinkInputDevice::VideoInputFrameArrived,
+//   - UYVY -> I420 (fused, chroma averaged) against the row-dropping helper
+//     it replaced,
+//   - v210 -> I422 (dithered), v210 -> I010 and v210 -> P010,
+//   - BGRA -> I420 and r210 -> I420 (Rec.709),
+//   - the row by row I420 plane copy of CopyFrameView(), which is also what
+//     YuvFileParser::getNext() does out of the stdio buffer.
+// Audio kernels run on one second of 48 kHz audio:
+//   - 16 -> 2 channel downmix,
+//   - splitting 16 send channels into four tracks,
+//   - stereo 32-bit -> 16-bit with TPDF dither, 32-bit -> float and back,
+//   - peak/energy measurement and the two-input mix,
+//   - 44.1 -> 48 kHz polyphase resampling of stereo 16-bit and float, timed
+//     per channel-second of output,
+//   - drift compensation of stereo 16-bit in 10 ms chunks (DriftResampler),
+//   - EBU R128 metering of 16-channel 32-bit and 16-bit capture, reported as
+//     the share of one core it takes in real time,
+//   - re-chunking 16-channel capture packets into 10 ms chunks (AudioRing).
+// And the H.264 start code scanner, find_nal_unit(), over an 8 MB Annex B
+// stream.
+//
+// The plane copy, the track split, the drift resampler, the ring and the
+// scanner have no SIMD variants; they show one row each, or one per ratio.
+//
+//   ./kernel_bench [iterations] [title-filter]
+//
+// |iterations| (default 200) applies at 1080p and scales with the frame area
+// at the other sizes. Only kernels whose title contains |title-filter| run,
+// e.g. "v210"; a filter needs the iteration count before it.
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <x86intrin.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/file_parser/helper_h264_parser.h"
+#include "utils/I420_buffer.h"
+#include "utils/aligned_alloc.h"
+#include "utils/audio_convert.h"
+#include "utils/audio_convert_row.h"
+#include "utils/audio_resampler.h"
+#include "utils/audio_ring.h"
+#include "utils/drift_resampler.h"
+#include "utils/loudness_meter.h"
+#include "utils/cpu_features.h"
+#include "utils/frame_view.h"
+#include "utils/pixel_convert.h"
+#include "utils/pixel_convert_row.h"
+
+struct FrameSize {
+  const char* name;
+  int width;
+  int height;
+};
+
+static const FrameSize kFrameSizes[] = {
+    {"720p", 1280, 720},
+    {"1080p", 1920, 1080},
+    {"2160p", 3840, 2160},
+};
+static const int kAlignment = 64;
+static const int kCacheLineBytes = 64;
+static const int kAudioFrames = 48000;
+static const int kStreamBytes = 8 << 20;
+
+typedef std::unique_ptr<uint8_t, AlignedFreeDeleter> Buffer;
+
+// Buffers a kernel reads or writes, flushed before each cold iteration.
+typedef std::vector<std::pair<const void*, size_t>> Footprint;
+
+struct Timing {
+  double seconds;
+  uint64_t cycles;
+};
+
+static const char* g_filter = nullptr;
+
+// DeckLink pads v210 rows to 128 bytes (48 pixels).
+static int V210Stride(int width) { return (width + 47) / 48 * 128; }
+
+// The original flat conversion over a tightly packed UYVY frame.
+static void ReferenceUyvyToI422(const uint8_t* src, uint8_t* dst, int frameSize) {
+  for (int i = 0; i < frameSize / 2; i++) {
+    dst[i] = src[i * 2 + 1];
+  }
+  for (int i = 0; i < frameSize / 4; i++) {
+    dst[i + frameSize / 2] = src[i * 4];
+    dst[i + frameSize / 4 * 3] = src[i * 4 + 2];
+  }
+}
+
+// The row-dropping yuyv_to_yuv420p() DeckLinkInputDevice carried until the
+// fused kernel replaced it, with its byte offsets moved from YUYV to the UYVY
+// the card delivers: luma is copied out and chroma taken from even rows only.
+static void DroppingUyvyToI420(const uint8_t* in, uint8_t* out, int width, int height) {
+  uint8_t* y = out;
+  uint8_t* u = out + width * height;
+  uint8_t* v = out + width * height + width * height / 4;
+  int yIndex = 0;
+  int uIndex = 0;
+  int vIndex = 0;
+  bool isU = true;
+
+  const long uyvyLength = 2L * width * height;
+  for (long i = 1; i < uyvyLength; i += 2) y[yIndex++] = in[i];
+
+  for (int i = 0; i < height; i += 2) {
+    long base = static_cast<long>(i) * width * 2;
+    for (long j = base; j < base + width * 2; j += 2) {
+      if (isU) {
+        u[uIndex++] = in[j];
+      } else {
+        v[vIndex++] = in[j];
+      }
+      isU = !isU;
+    }
+  }
+}
+
+static Buffer RandomBuffer(int size) {
+  Buffer buffer(AlignedMalloc<uint8_t>(size, kAlignment));
+  for (int i = 0; i < size; i++) buffer.get()[i] = static_cast<uint8_t>(rand());
+  return buffer;
+}
+
+static void FlushCaches(const Footprint& footprint) {
+  for (const auto& buffer : footprint) {
+    const char* data = static_cast<const char*>(buffer.first);
+    for (size_t i = 0; i < buffer.second; i += kCacheLineBytes) _mm_clflush(data + i);
+  }
+  _mm_mfence();
+}
+
+// Times |iterations| calls of |convert|; with |cold|, flushes it before each.
+template <typename Convert>
+static Timing Time(int iterations, const Footprint* cold, Convert convert) {
+  Timing timing = {0, 0};
+  if (!cold) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t startTsc = __rdtsc();
+    for (int n = 0; n < iterations; n++) convert();
+    timing.cycles = __rdtsc() - startTsc;
+    timing.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return timing;
+  }
+
+  for (int n = 0; n < iterations; n++) {
+    FlushCaches(*cold);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t startTsc = __rdtsc();
+    convert();
+    timing.cycles += __rdtsc() - startTsc;
+    timing.seconds +=
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  return timing;
+}
+
+static bool Selected(const char* title) { return !g_filter || strstr(title, g_filter); }
+
+// Returns false, printing nothing, if the kernel is filtered out.
+static bool PrintHeader(const char* title, const char* subject, int iterations,
+                        const char* timeUnit, const char* cycleUnit) {
+  if (!Selected(title)) return false;
+  printf("\n%s, %s, %d iterations, dispatched isa: %s\n", title, subject, iterations,
+         CpuIsaName(GetBestCpuIsa()));
+  printf("%-8s %-5s %10s %10s %12s %8s\n", "isa", "cache", timeUnit, "GB/s", cycleUnit, "exact");
+  return true;
+}
+
+static bool PrintFrameHeader(const char* title, const FrameSize& size, int iterations) {
+  std::string subject =
+      std::string(size.name) + " " + std::to_string(size.width) + "x" + std::to_string(size.height);
+  return PrintHeader(title, subject.c_str(), iterations, "ms/frame", "cycles/px");
+}
+
+static void PrintAudioHeader(const char* title, int iterations, const char* timeUnit = "us/s") {
+  std::string subject = std::to_string(kAudioFrames) + " frames";
+  PrintHeader(title, subject.c_str(), iterations, timeUnit, "cycles/frame");
+}
+
+static void PrintUnavailable(CpuIsa isa) { printf("%-8s %-5s %10s\n", CpuIsaName(isa), "", "n/a"); }
+
+// Each iteration processes |units| pixels or bytes and reads plus writes
+// |bytes|; times are per iteration.
+template <typename Convert>
+static void Run(const char* name, int iterations, double units, double bytes, bool exact,
+                const Footprint& footprint, Convert convert) {
+  for (int cold = 0; cold < 2; cold++) {
+    Timing timing = Time(iterations, cold ? &footprint : nullptr, convert);
+    printf("%-8s %-5s %10.3f %10.2f %12.3f %8s\n", name, cold ? "cold" : "warm",
+           timing.seconds * 1000 / iterations, bytes * iterations / timing.seconds / 1e9,
+           timing.cycles / (units * iterations), exact ? "yes" : "NO");
+  }
+}
+
+// Audio results are per second of 48 kHz audio, or per channel-second when
+// |channels| is given.
+template <typename Convert>
+static void RunAudio(const char* name, int iterations, double bytes, bool exact,
+                     const Footprint& footprint, Convert convert, int channels = 1) {
+  for (int cold = 0; cold < 2; cold++) {
+    Timing timing = Time(iterations, cold ? &footprint : nullptr, convert);
+    printf("%-8s %-5s %10.1f %10.2f %12.3f %8s\n", name, cold ? "cold" : "warm",
+           timing.seconds * 1e6 / iterations / channels, bytes * iterations / timing.seconds / 1e9,
+           static_cast<double>(timing.cycles) / (static_cast<double>(kAudioFrames) * iterations),
+           exact ? "yes" : "NO");
+  }
+}
+
+// Runs |convert(dst, kernels)| over |src| with every ISA the CPU has and
+// checks the |dstSize| bytes it writes against the scalar kernels.
+template <typename Convert>
+static void RunPixelKernels(const FrameSize& size, int iterations, const uint8_t* src,
+                            int srcSize, int dstSize, Convert convert) {
+  Buffer ref(AlignedMalloc<uint8_t>(dstSize, kAlignment));
+  Buffer dst(AlignedMalloc<uint8_t>(dstSize, kAlignment));
+  memset(ref.get(), 0, dstSize);
+  convert(ref.get(), GetPixelRowKernels(kIsaC));
+
+  const Footprint footprint = {{src, srcSize}, {dst.get(), dstSize}};
+  const double pixels = static_cast<double>(size.width) * size.height;
+  const double bytes = static_cast<double>(srcSize) + dstSize;
+  for (int i = kIsaC; i < kIsaCount; i++) {
+    const PixelRowKernels* kernels = GetPixelRowKernels(static_cast<CpuIsa>(i));
+    if (!kernels) {
+      PrintUnavailable(static_cast<CpuIsa>(i));
+      continue;
+    }
+    memset(dst.get(), 0, dstSize);
+    convert(dst.get(), kernels);
+    bool exact = memcmp(dst.get(), ref.get(), dstSize) == 0;
+    Run(CpuIsaName(kernels->isa), iterations, pixels, bytes, exact, footprint,
+        [&] { convert(dst.get(), kernels); });
+  }
+}
+
+static void BenchUyvyToI422(const FrameSize& size, int iterations) {
+  if (!PrintFrameHeader("UYVY -> I422", size, iterations)) return;
+  const int width = size.width;
+  const int height = size.height;
+  const int frameSize = width * height * 2;
+  Buffer src = RandomBuffer(frameSize);
+  auto convert = [&](uint8_t* dst, const PixelRowKernels* kernels) {
+    uint8_t* dst_y = dst;
+    uint8_t* dst_u = dst_y + width * height;
+    uint8_t* dst_v = dst_u + width * height / 2;
+    UyvyToI422(src.get(), width * 2, dst_y, width, dst_u, width / 2, dst_v, width / 2, width,
+               height, kernels);
+  };
+
+  Buffer ref(AlignedMalloc<uint8_t>(frameSize, kAlignment));
+  Buffer dst(AlignedMalloc<uint8_t>(frameSize, kAlignment));
+  convert(ref.get(), GetPixelRowKernels(kIsaC));
+  ReferenceUyvyToI422(src.get(), dst.get(), frameSize);
+  bool exact = memcmp(dst.get(), ref.get(), frameSize) == 0;
+  Run("loop", iterations, static_cast<double>(width) * height, 2.0 * frameSize, exact,
+      {{src.get(), frameSize}, {dst.get(), frameSize}},
+      [&] { ReferenceUyvyToI422(src.get(), dst.get(), frameSize); });
+
+  RunPixelKernels(size, iterations, src.get(), frameSize, frameSize, convert);
+}
+
+static void BenchUyvyToI420(const FrameSize& size, int iterations) {
+  if (!PrintFrameHeader("UYVY -> I420", size, iterations)) return;
+  const int width = size.width;
+  const int height = size.height;
+  const int srcSize = width * height * 2;
+  const int dstSize = width * height * 3 / 2;
+  Buffer src = RandomBuffer(srcSize);
+
+  // The dropping helper averages nothing, so it is checked against the even
+  // chroma rows of the scalar I422 conversion instead.
+  Buffer i422(AlignedMalloc<uint8_t>(srcSize, kAlignment));
+  Buffer ref(AlignedMalloc<uint8_t>(dstSize, kAlignment));
+  Buffer dst(AlignedMalloc<uint8_t>(dstSize, kAlignment));
+  uint8_t* i422U = i422.get() + width * height;
+  uint8_t* i422V = i422U + width * height / 2;
+  UyvyToI422(src.get(), width * 2, i422.get(), width, i422U, width / 2, i422V, width / 2, width,
+             height, GetPixelRowKernels(kIsaC));
+  memcpy(ref.get(), i422.get(), width * height);
+  for (int row = 0; row < height / 2; row++) {
+    memcpy(ref.get() + width * height + row * width / 2, i422U + row * width, width / 2);
+    memcpy(ref.get() + width * height * 5 / 4 + row * width / 2, i422V + row * width, width / 2);
+  }
+  DroppingUyvyToI420(src.get(), dst.get(), width, height);
+  bool exact = memcmp(dst.get(), ref.get(), dstSize) == 0;
+  Run("drop", iterations, static_cast<double>(width) * height, srcSize + dstSize, exact,
+      {{src.get(), srcSize}, {dst.get(), dstSize}},
+      [&] { DroppingUyvyToI420(src.get(), dst.get(), width, height); });
+
+  RunPixelKernels(size, iterations, src.get(), srcSize, dstSize,
+                  [&](uint8_t* dst, const PixelRowKernels* kernels) {
+                    uint8_t* dst_y = dst;
+                    uint8_t* dst_u = dst_y + width * height;
+                    uint8_t* dst_v = dst_u + width * height / 4;
+                    UyvyToI420(src.get(), width * 2, dst_y, width, dst_u, width / 2, dst_v,
+                               width / 2, width, height, kernels);
+                  });
+}
+
+static void BenchV210ToI422(const FrameSize& size, int iterations) {
+  if (!PrintFrameHeader("v210 -> I422 (dithered)", size, iterations)) return;
+  const int width = size.width;
+  const int height = size.height;
+  const int srcStride = V210Stride(width);
+  Buffer src = RandomBuffer(srcStride * height);
+  RunPixelKernels(size, iterations, src.get(), srcStride * height, width * height * 2,
+                  [&](uint8_t* dst, const PixelRowKernels* kernels) {
+                    uint8_t* dst_y = dst;
+                    uint8_t* dst_u = dst_y + width * height;
+                    uint8_t* dst_v = dst_u + width * height / 2;
+                    V210ToI422(src.get(), srcStride, dst_y, width, dst_u, width / 2, dst_v,
+                               width / 2, width, height, true, kernels);
+                  });
+}
+
+static void BenchV210ToI010(const FrameSize& size, int iterations) {
+  if (!PrintFrameHeader("v210 -> I010", size, iterations)) return;
+  const int width = size.width;
+  const int height = size.height;
+  const int srcStride = V210Stride(width);
+  Buffer src = RandomBuffer(srcStride * height);
+  RunPixelKernels(size, iterations, src.get(), srcStride * height, width * height * 3,
+                  [&](uint8_t* dst, const PixelRowKernels* kernels) {
+                    uint16_t* dst_y = reinterpret_cast<uint16_t*>(dst);
+                    uint16_t* dst_u = dst_y + width * height;
+                    uint16_t* dst_v = dst_u + width * height / 4;
+                    V210ToI010(src.get(), srcStride, dst_y, width, dst_u, width / 2, dst_v,
+                               width / 2, width, height, kernels);
+                  });
+}
+
+static void BenchV210ToP010(const FrameSize& size, int iterations) {
+  if (!PrintFrameHeader("v210 -> P010", size, iterations)) return;
+  const int width = size.width;
+  const int height = size.height;
+  const int srcStride = V210Stride(width);
+  Buffer src = RandomBuffer(srcStride * height);
+  RunPixelKernels(size, iterations, src.get(), srcStride * height, width * height * 3,
+                  [&](uint8_t* dst, const PixelRowKernels* kernels) {
+                    uint16_t* dst_y = reinterpret_cast<uint16_t*>(dst);
+                    uint16_t* dst_uv = dst_y + width * height;
+                    V210ToP010(src.get(), srcStride, dst_y, width, dst_uv, width, width, height,
+                               kernels);
+                  });
+}
+
+static void BenchBgraToI420(const FrameSize& size, int iterations) {
+  if (!PrintFrameHeader("BGRA -> I420 (Rec.709)", size, iterations)) return;
+  const int width = size.width;
+  const int height = size.height;
+  const int srcStride = width * 4;
+  Buffer src = RandomBuffer(srcStride * height);
+  RunPixelKernels(size, iterations, src.get(), srcStride * height, width * height * 3 / 2,
+                  [&](uint8_t* dst, const PixelRowKernels* kernels) {
+                    uint8_t* dst_y = dst;
+                    uint8_t* dst_u = dst_y + width * height;
+                    uint8_t* dst_v = dst_u + width * height / 4;
+                    BgraToI420(src.get(), srcStride, dst_y, width, dst_u, width / 2, dst_v,
+                               width / 2, width, height, kYuvRec709, kYuvLimitedRange, kernels);
+                  });
+}
+
+static void BenchR210ToI420(const FrameSize& size, int iterations) {
+  if (!PrintFrameHeader("r210 -> I420 (Rec.709)", size, iterations)) return;
+  const int width = size.width;
+  const int height = size.height;
+  const int srcStride = width * 4;
+  Buffer src = RandomBuffer(srcStride * height);
+  RunPixelKernels(size, iterations, src.get(), srcStride * height, width * height * 3 / 2,
+                  [&](uint8_t* dst, const PixelRowKernels* kernels) {
+                    uint8_t* dst_y = dst;
+                    uint8_t* dst_u = dst_y + width * height;
+                    uint8_t* dst_v = dst_u + width * height / 4;
+                    R210ToI420(src.get(), srcStride, dst_y, width, dst_u, width / 2, dst_v,
+                               width / 2, width, height, kYuvRec709, kRgbVideoRange,
+                               kYuvLimitedRange, kernels);
+                  });
+}
+
+// A tightly packed I420 frame, as read from a .yuv file, into a frame pool
+// buffer plane by plane, against a byte loop.
+static void BenchCopyI420(const FrameSize& size, int iterations) {
+  if (!PrintFrameHeader("I420 plane copy", size, iterations)) return;
+  const int width = size.width;
+  const int height = size.height;
+  const int frameSize = width * height * 3 / 2;
+  typedef std::unique_ptr<I420Buffer, void (*)(I420Buffer*)> FrameBuffer;
+  FrameBuffer srcFrame(I420Buffer::Create(width, height, I420Buffer::kI420), I420Buffer::Release);
+  FrameBuffer refFrame(I420Buffer::Create(width, height, I420Buffer::kI420), I420Buffer::Release);
+  FrameBuffer dstFrame(I420Buffer::Create(width, height, I420Buffer::kI420), I420Buffer::Release);
+  const FrameView src = PlanarFrameView(srcFrame.get());
+  const FrameView ref = PlanarFrameView(refFrame.get());
+  const FrameView dst = PlanarFrameView(dstFrame.get());
+
+  Footprint footprint;
+  for (int p = 0; p < src.plane_count; p++) {
+    const PlaneView& plane = src.planes[p];
+    for (int y = 0; y < plane.height; y++) {
+      uint8_t* row = plane.data + static_cast<size_t>(plane.stride) * y;
+      for (int x = 0; x < plane.width; x++) row[x] = static_cast<uint8_t>(rand());
+    }
+    footprint.push_back({plane.data, static_cast<size_t>(plane.stride) * plane.height});
+    footprint.push_back(
+        {dst.planes[p].data, static_cast<size_t>(dst.planes[p].stride) * dst.planes[p].height});
+  }
+
+  auto loop = [&](const FrameView& out) {
+    for (int p = 0; p < src.plane_count; p++) {
+      for (int y = 0; y < src.planes[p].height; y++) {
+        const uint8_t* from = src.planes[p].data + static_cast<size_t>(src.planes[p].stride) * y;
+        uint8_t* to = out.planes[p].data + static_cast<size_t>(out.planes[p].stride) * y;
+        for (int x = 0; x < src.planes[p].width; x++) to[x] = from[x];
+      }
+    }
+  };
+  loop(ref);
+  CopyFrameView(src, dst);
+  bool exact = true;
+  for (int p = 0; p < dst.plane_count; p++) {
+    for (int y = 0; y < dst.planes[p].height; y++) {
+      exact = exact && memcmp(dst.planes[p].data + static_cast<size_t>(dst.planes[p].stride) * y,
+                              ref.planes[p].data + static_cast<size_t>(ref.planes[p].stride) * y,
+                              dst.planes[p].width) == 0;
+    }
+  }
+
+  const double pixels = static_cast<double>(width) * height;
+  Run("loop", iterations, pixels, 2.0 * frameSize, true, footprint, [&] { loop(dst); });
+  Run("memcpy", iterations, pixels, 2.0 * frameSize, exact, footprint,
+      [&] { CopyFrameView(src, dst); });
+}
+
+static void BenchMixChannels(int iterations) {
+  const char* title = "Mix 16 -> 2 channels";
+  if (!Selected(title)) return;
+  const int srcChannels = 16;
+  const int dstChannels = 2;
+  const int srcSize = kAudioFrames * srcChannels * 2;
+  const int dstSize = kAudioFrames * dstChannels * 2;
+  Buffer src = RandomBuffer(srcSize);
+  Buffer ref(AlignedMalloc<uint8_t>(dstSize, kAlignment));
+  Buffer dst(AlignedMalloc<uint8_t>(dstSize, kAlignment));
+  const int16_t* samples = reinterpret_cast<const int16_t*>(src.get());
+  const Footprint footprint = {{src.get(), srcSize}, {dst.get(), dstSize}};
+  double bytes = srcSize + dstSize;
+
+  // Program pair to L/R plus a centre-like channel and two commentary
+  // channels folded in at lower gain.
+  float gains[dstChannels * srcChannels] = {0};
+  gains[0] = 1.0f;
+  gains[srcChannels + 1] = 1.0f;
+  gains[2] = gains[srcChannels + 2] = 0.707f;
+  gains[8] = 0.5f;
+  gains[srcChannels + 9] = 0.5f;
+  ChannelMatrix matrix;
+  InitChannelMatrix(&matrix, srcChannels, dstChannels, gains);
+  MixChannels(samples, reinterpret_cast<int16_t*>(ref.get()), kAudioFrames, matrix,
+              GetAudioKernels(kIsaC));
+
+  PrintAudioHeader(title, iterations);
+  for (int i = kIsaC; i < kIsaCount; i++) {
+    const AudioKernels* kernels = GetAudioKernels(static_cast<CpuIsa>(i));
+    if (!kernels) {
+      PrintUnavailable(static_cast<CpuIsa>(i));
+      continue;
+    }
+    auto convert = [&] {
+      MixChannels(samples, reinterpret_cast<int16_t*>(dst.get()), kAudioFrames, matrix, kernels);
+    };
+    memset(dst.get(), 0, dstSize);
+    convert();
+    bool exact = memcmp(dst.get(), ref.get(), dstSize) == 0;
+    RunAudio(CpuIsaName(kernels->isa), iterations, bytes, exact, footprint, convert);
+  }
+}
+
+// 16 send channels published as four tracks: two stereo pairs, a 4-channel
+// and an 8-channel group.
+static void BenchSplitChannels(int iterations) {
+  const char* title = "Split 16 channels into 2+2+4+8 tracks";
+  if (!Selected(title)) return;
+  const int srcChannels = 16;
+  const int runs = 4;
+  const int runChannels[runs] = {2, 2, 4, 8};
+  const int size = kAudioFrames * srcChannels * 2;
+  Buffer src = RandomBuffer(size);
+  Buffer dst(AlignedMalloc<uint8_t>(size, kAlignment));
+  const int16_t* samples = reinterpret_cast<const int16_t*>(src.get());
+  int16_t* buffers[runs];
+  int16_t* next = reinterpret_cast<int16_t*>(dst.get());
+  for (int r = 0; r < runs; r++) {
+    buffers[r] = next;
+    next += kAudioFrames * runChannels[r];
+  }
+  auto split = [&] {
+    SplitChannels(samples, kAudioFrames, srcChannels, runChannels, runs, buffers);
+  };
+  memset(dst.get(), 0, size);
+  split();
+
+  bool exact = true;
+  for (int f = 0; f < kAudioFrames; f++) {
+    const int16_t* frame = samples + f * srcChannels;
+    for (int r = 0; r < runs; r++) {
+      exact = exact && memcmp(buffers[r] + f * runChannels[r], frame,
+                              runChannels[r] * sizeof(int16_t)) == 0;
+      frame += runChannels[r];
+    }
+  }
+
+  PrintAudioHeader(title, iterations);
+  RunAudio("c", iterations, 2.0 * size, exact, {{src.get(), size}, {dst.get(), size}}, split);
+}
+
+static void BenchS32ToS16(int iterations) {
+  const char* title = "Stereo S32 -> S16 dithered";
+  if (!Selected(title)) return;
+  const int count = kAudioFrames * 2;
+  Buffer src = RandomBuffer(count * 4);
+  Buffer ref(AlignedMalloc<uint8_t>(count * 2, kAlignment));
+  Buffer dst(AlignedMalloc<uint8_t>(count * 2, kAlignment));
+  const int32_t* samples = reinterpret_cast<const int32_t*>(src.get());
+  const Footprint footprint = {{src.get(), count * 4}, {dst.get(), count * 2}};
+  double bytes = count * 6.0;
+  AudioDither dither;
+  InitAudioDither(&dither, 1);
+  ConvertS32ToS16(samples, reinterpret_cast<int16_t*>(ref.get()), count, &dither,
+                  GetAudioKernels(kIsaC));
+
+  PrintAudioHeader(title, iterations);
+  for (int i = kIsaC; i < kIsaCount; i++) {
+    const AudioKernels* kernels = GetAudioKernels(static_cast<CpuIsa>(i));
+    if (!kernels) {
+      PrintUnavailable(static_cast<CpuIsa>(i));
+      continue;
+    }
+    auto convert = [&] {
+      ConvertS32ToS16(samples, reinterpret_cast<int16_t*>(dst.get()), count, &dither, kernels);
+    };
+    // Same seed as the reference, so the dither noise must match too.
+    InitAudioDither(&dither, 1);
+    convert();
+    bool exact = memcmp(dst.get(), ref.get(), count * 2) == 0;
+    RunAudio(CpuIsaName(kernels->isa), iterations, bytes, exact, footprint, convert);
+  }
+}
+
+static void BenchS32ToFloat(int iterations) {
+  const char* title = "Stereo S32 -> float";
+  if (!Selected(title)) return;
+  const int count = kAudioFrames * 2;
+  Buffer src = RandomBuffer(count * 4);
+  Buffer ref(AlignedMalloc<uint8_t>(count * 4, kAlignment));
+  Buffer dst(AlignedMalloc<uint8_t>(count * 4, kAlignment));
+  const int32_t* samples = reinterpret_cast<const int32_t*>(src.get());
+  const Footprint footprint = {{src.get(), count * 4}, {dst.get(), count * 4}};
+  double bytes = count * 8.0;
+  ConvertS32ToFloat(samples, reinterpret_cast<float*>(ref.get()), count, GetAudioKernels(kIsaC));
+
+  PrintAudioHeader(title, iterations);
+  for (int i = kIsaC; i < kIsaCount; i++) {
+    const AudioKernels* kernels = GetAudioKernels(static_cast<CpuIsa>(i));
+    if (!kernels) {
+      PrintUnavailable(static_cast<CpuIsa>(i));
+      continue;
+    }
+    auto convert = [&] {
+      ConvertS32ToFloat(samples, reinterpret_cast<float*>(dst.get()), count, kernels);
+    };
+    memset(dst.get(), 0, count * 4);
+    convert();
+    bool exact = memcmp(dst.get(), ref.get(), count * 4) == 0;
+    RunAudio(CpuIsaName(kernels->isa), iterations, bytes, exact, footprint, convert);
+  }
+}
+
+// Full-scale tones with peaks past 1.0, so saturation is exercised too.
+static void BenchFloatToS32(int iterations) {
+  const char* title = "Stereo float -> S32";
+  if (!Selected(title)) return;
+  const int count = kAudioFrames * 2;
+  Buffer src(AlignedMalloc<uint8_t>(count * 4, kAlignment));
+  Buffer ref(AlignedMalloc<uint8_t>(count * 4, kAlignment));
+  Buffer dst(AlignedMalloc<uint8_t>(count * 4, kAlignment));
+  float* samples = reinterpret_cast<float*>(src.get());
+  for (int i = 0; i < count; i++) {
+    samples[i] = static_cast<float>(0.8 * sin(i * 0.0713) + 0.3 * sin(i * 1.37));
+  }
+  const Footprint footprint = {{src.get(), count * 4}, {dst.get(), count * 4}};
+  double bytes = count * 8.0;
+  ConvertFloatToS32(samples, reinterpret_cast<int32_t*>(ref.get()), count, GetAudioKernels(kIsaC));
+
+  PrintAudioHeader(title, iterations);
+  for (int i = kIsaC; i < kIsaCount; i++) {
+    const AudioKernels* kernels = GetAudioKernels(static_cast<CpuIsa>(i));
+    if (!kernels) {
+      PrintUnavailable(static_cast<CpuIsa>(i));
+      continue;
+    }
+    auto convert = [&] {
+      ConvertFloatToS32(samples, reinterpret_cast<int32_t*>(dst.get()), count, kernels);
+    };
+    memset(dst.get(), 0, count * 4);
+    convert();
+    bool exact = memcmp(dst.get(), ref.get(), count * 4) == 0;
+    RunAudio(CpuIsaName(kernels->isa), iterations, bytes, exact, footprint, convert);
+  }
+}
+
+static void BenchMeasureLevel(int iterations) {
+  const char* title = "Stereo S16 peak/energy";
+  if (!Selected(title)) return;
+  const int count = kAudioFrames * 2;
+  Buffer src = RandomBuffer(count * 2);
+  const int16_t* samples = reinterpret_cast<const int16_t*>(src.get());
+  const Footprint footprint = {{src.get(), count * 2}};
+  double bytes = count * 2.0;
+  AudioLevel ref;
+  MeasureAudioLevel(samples, count, &ref, GetAudioKernels(kIsaC));
+
+  PrintAudioHeader(title, iterations);
+  for (int i = kIsaC; i < kIsaCount; i++) {
+    const AudioKernels* kernels = GetAudioKernels(static_cast<CpuIsa>(i));
+    if (!kernels) {
+      PrintUnavailable(static_cast<CpuIsa>(i));
+      continue;
+    }
+    AudioLevel level;
+    auto convert = [&] { MeasureAudioLevel(samples, count, &level, kernels); };
+    convert();
+    bool exact = level.peak == ref.peak && level.sum_squares == ref.sum_squares;
+    RunAudio(CpuIsaName(kernels->isa), iterations, bytes, exact, footprint, convert);
+  }
+}
+
+// Two stereo inputs summed with a gain ramp each, then packed.
+static void BenchMixInputs(int iterations) {
+  const char* title = "Stereo S16 two-input mix with gain ramp";
+  if (!Selected(title)) return;
+  const int count = kAudioFrames * 2;
+  const int32_t step = -kAudioGainUnity / 2 / count;
+  Buffer src = RandomBuffer(count * 4);
+  Buffer acc(AlignedMalloc<uint8_t>(count * 4, kAlignment));
+  Buffer ref(AlignedMalloc<uint8_t>(count * 2, kAlignment));
+  Buffer dst(AlignedMalloc<uint8_t>(count * 2, kAlignment));
+  const int16_t* first = reinterpret_cast<const int16_t*>(src.get());
+  const int16_t* second = first + count;
+  int32_t* sum = reinterpret_cast<int32_t*>(acc.get());
+  const Footprint footprint = {
+      {src.get(), count * 4}, {acc.get(), count * 4}, {dst.get(), count * 2}};
+  double bytes = count * 6.0;
+  auto mix = [&](int16_t* out, const AudioKernels* kernels) {
+    memset(sum, 0, count * 4);
+    AccumulateAudio(first, sum, count, kAudioGainUnity, 0, kernels);
+    AccumulateAudio(second, sum, count, kAudioGainUnity, step, kernels);
+    PackAudioAccumulator(sum, out, count, kernels);
+  };
+  mix(reinterpret_cast<int16_t*>(ref.get()), GetAudioKernels(kIsaC));
+
+  PrintAudioHeader(title, iterations);
+  for (int i = kIsaC; i < kIsaCount; i++) {
+    const AudioKernels* kernels = GetAudioKernels(static_cast<CpuIsa>(i));
+    if (!kernels) {
+      PrintUnavailable(static_cast<CpuIsa>(i));
+      continue;
+    }
+    auto convert = [&] { mix(reinterpret_cast<int16_t*>(dst.get()), kernels); };
+    memset(dst.get(), 0, count * 2);
+    convert();
+    bool exact = memcmp(dst.get(), ref.get(), count * 2) == 0;
+    RunAudio(CpuIsaName(kernels->isa), iterations, bytes, exact, footprint, convert);
+  }
+}
+
+// One second of 44.1 kHz stereo in, kAudioFrames frames out.
+template <typename Sample>
+static void BenchResample(const char* title, int iterations) {
+  if (!Selected(title)) return;
+  const int channels = 2;
+  const int inputFrames = 44100;
+  Buffer src = RandomBuffer(inputFrames * channels * sizeof(Sample));
+  Sample* input = reinterpret_cast<Sample*>(src.get());
+  // Random bits are not valid floats; use a sum of tones
+  if (sizeof(Sample) == sizeof(float)) {
+    for (int i = 0; i < inputFrames * channels; i++) {
+      input[i] = static_cast<Sample>(0.4 * sin(i * 0.0713) + 0.3 * sin(i * 1.37));
+    }
+  }
+  PolyphaseResampler resampler;
+  resampler.Init(44100, kAudioFrames, channels, 64, GetAudioKernels(kIsaC));
+  const int dstSize = resampler.MaxOutputFrames(inputFrames) * channels * sizeof(Sample);
+  Buffer ref(AlignedMalloc<uint8_t>(dstSize, kAlignment));
+  Buffer dst(AlignedMalloc<uint8_t>(dstSize, kAlignment));
+  int refFrames = resampler.Process(input, inputFrames, reinterpret_cast<Sample*>(ref.get()));
+  const Footprint footprint = {{src.get(), inputFrames * channels * sizeof(Sample)},
+                               {dst.get(), dstSize}};
+  double bytes = (inputFrames + refFrames) * channels * sizeof(Sample);
+
+  PrintAudioHeader(title, iterations, "us/ch-s");
+  for (int i = kIsaC; i < kIsaCount; i++) {
+    const AudioKernels* kernels = GetAudioKernels(static_cast<CpuIsa>(i));
+    if (!kernels) {
+      PrintUnavailable(static_cast<CpuIsa>(i));
+      continue;
+    }
+    resampler.Init(44100, kAudioFrames, channels, 64, kernels);
+    int frames = 0;
+    auto convert = [&] {
+      frames = resampler.Process(input, inputFrames, reinterpret_cast<Sample*>(dst.get()));
+    };
+    convert();
+    bool exact = frames == refFrames &&
+                 memcmp(dst.get(), ref.get(), refFrames * channels * sizeof(Sample)) == 0;
+    RunAudio(CpuIsaName(kernels->isa), iterations, bytes, exact, footprint, convert, channels);
+  }
+}
+
+// One second of stereo output pulled in 10 ms chunks, pushing input as the
+// audio thread does, once at a ratio of exactly 1 and once 500 ppm off. The
+// input is a ramp, which cubic Hermite interpolation reproduces: at ratio 1
+// the output must be the input, otherwise the ramp at each read position to
+// within rounding.
+static void BenchDriftResampler(int iterations) {
+  const char* title = "Drift resample stereo S16 in 10 ms chunks";
+  if (!Selected(title)) return;
+  const int channels = 2;
+  const int chunkFrames = kAudioFrames / 100;
+  const int inputFrames = kAudioFrames + 2 * chunkFrames;
+  const int srcSize = inputFrames * channels * 2;
+  const int dstSize = kAudioFrames * channels * 2;
+  Buffer src(AlignedMalloc<uint8_t>(srcSize, kAlignment));
+  Buffer dst(AlignedMalloc<uint8_t>(dstSize, kAlignment));
+  int16_t* input = reinterpret_cast<int16_t*>(src.get());
+  int16_t* output = reinterpret_cast<int16_t*>(dst.get());
+  for (int f = 0; f < inputFrames; f++) {
+    for (int c = 0; c < channels; c++) input[f * channels + c] = f - inputFrames / 2;
+  }
+  DriftResampler resampler;
+  resampler.Init(channels, 3 * chunkFrames);
+  const Footprint footprint = {{src.get(), srcSize}, {dst.get(), dstSize}};
+  double ratio = 1.0;
+
+  auto resample = [&] {
+    int pushed = 0;
+    resampler.Reset();
+    for (int offset = 0; offset < kAudioFrames; offset += chunkFrames) {
+      while (resampler.InputFramesNeeded(chunkFrames, ratio) > 0) {
+        resampler.Push(input + pushed * channels, chunkFrames);
+        pushed += chunkFrames;
+      }
+      resampler.Pull(output + offset * channels, chunkFrames, ratio);
+    }
+  };
+
+  PrintAudioHeader(title, iterations);
+  const double ratios[] = {1.0, 1.0005};
+  const char* names[] = {"1.0", "+500ppm"};
+  for (int r = 0; r < 2; r++) {
+    ratio = ratios[r];
+    memset(dst.get(), 0, dstSize);
+    resample();
+    // The read position advances in 32.32 fixed point
+    const double step = static_cast<double>(llrint(ratio * 4294967296.0)) / 4294967296.0;
+    const int tolerance = ratio == 1.0 ? 0 : 1;
+    bool exact = true;
+    for (int f = 0; f < kAudioFrames; f++) {
+      long expected = lrint(f * step) - inputFrames / 2;
+      for (int c = 0; c < channels; c++) {
+        exact = exact && labs(output[f * channels + c] - expected) <= tolerance;
+      }
+    }
+    RunAudio(names[r], iterations, srcSize + dstSize, exact, footprint, resample);
+  }
+}
+
+// One second of 16-channel capture fed to the loudness meter in 10 ms chunks,
+// as the meter thread does. Every channel carries a -20 dBFS 997 Hz tone,
+// which BS.1770 puts at -3.01 - 20 + 10 log10(16) LUFS; the reading must be
+// within 0.1 LU of that. Time is the share of one core metering takes in
+// real time.
+static void BenchLoudnessMeter(int iterations) {
+  const char* title = "Loudness meter 16 channels";
+  if (!Selected(title)) return;
+  const int channels = 16;
+  const int chunkFrames = kAudioFrames / 100;
+  const int count = kAudioFrames * channels;
+  const double expectedLufs = -3.01 - 20.0 + 10.0 * log10(static_cast<double>(channels));
+  Buffer src32(AlignedMalloc<uint8_t>(count * 4, kAlignment));
+  Buffer src16(AlignedMalloc<uint8_t>(count * 2, kAlignment));
+  int32_t* samples32 = reinterpret_cast<int32_t*>(src32.get());
+  int16_t* samples16 = reinterpret_cast<int16_t*>(src16.get());
+  for (int f = 0; f < kAudioFrames; f++) {
+    double tone = 0.1 * sin(2.0 * M_PI * 997.0 * f / kAudioFrames);
+    for (int c = 0; c < channels; c++) {
+      samples32[f * channels + c] = static_cast<int32_t>(lrint(tone * 2147483648.0));
+      samples16[f * channels + c] = static_cast<int16_t>(lrint(tone * 32768.0));
+    }
+  }
+  LoudnessMeter meter;
+  meter.Init(kAudioFrames, channels);
+
+  std::string subject = std::to_string(kAudioFrames) + " frames";
+  if (!PrintHeader(title, subject.c_str(), iterations, "% core", "cycles/frame")) return;
+  for (int bits = 32; bits >= 16; bits -= 16) {
+    auto process = [&] {
+      for (int offset = 0; offset < kAudioFrames; offset += chunkFrames) {
+        if (bits == 32) {
+          meter.Process(samples32 + offset * channels, chunkFrames);
+        } else {
+          meter.Process(samples16 + offset * channels, chunkFrames);
+        }
+      }
+    };
+    meter.Reset();
+    process();
+    bool exact = fabs(meter.Read().momentary_lufs - expectedLufs) < 0.1;
+    const int bytes = count * bits / 8;
+    const Footprint footprint = {{bits == 32 ? src32.get() : src16.get(), bytes}};
+    for (int cold = 0; cold < 2; cold++) {
+      Timing timing = Time(iterations, cold ? &footprint : nullptr, process);
+      printf("%-8s %-5s %10.3f %10.2f %12.3f %8s\n", bits == 32 ? "s32" : "s16",
+             cold ? "cold" : "warm", timing.seconds * 100 / iterations,
+             static_cast<double>(bytes) * iterations / timing.seconds / 1e9,
+             static_cast<double>(timing.cycles) / (static_cast<double>(kAudioFrames) * iterations),
+             exact ? "yes" : "NO");
+    }
+  }
+}
+
+// One second of 16-channel 32-bit capture audio written to the ring one 50p
+// frame's packet at a time and read back as 10 ms chunks. Write() copies in
+// and the consumer copies each chunk out, so the bytes count both copies.
+static void BenchAudioRing(int iterations) {
+  const char* title = "PCM 16 x S32 packets -> 10 ms chunks";
+  if (!Selected(title)) return;
+  const int channels = 16;
+  const int sampleBytes = 4;
+  const int frameBytes = channels * sampleBytes;
+  const int packetFrames = kAudioFrames / 50;
+  const int chunkFrames = kAudioFrames / 100;
+  const int size = kAudioFrames * frameBytes;
+  Buffer src = RandomBuffer(size);
+  Buffer dst(AlignedMalloc<uint8_t>(size, kAlignment));
+  AudioRing ring;
+  ring.Init(channels, sampleBytes, kAudioFrames, chunkFrames, 8);
+  const Footprint footprint = {{src.get(), size}, {dst.get(), size}};
+
+  auto rechunk = [&] {
+    uint8_t* out = dst.get();
+    for (int offset = 0; offset < kAudioFrames; offset += packetFrames) {
+      ring.Write(src.get() + static_cast<size_t>(offset) * frameBytes, packetFrames,
+                 offset * 1000 / kAudioFrames);
+      int64_t timestamp;
+      while (const void* chunk = ring.PeekChunk(&timestamp)) {
+        memcpy(out, chunk, chunkFrames * frameBytes);
+        out += chunkFrames * frameBytes;
+        ring.ConsumeChunk();
+      }
+    }
+  };
+  memset(dst.get(), 0, size);
+  rechunk();
+  bool exact = memcmp(dst.get(), src.get(), size) == 0 && ring.OverrunFrames() == 0;
+
+  PrintAudioHeader(title, iterations);
+  RunAudio("c", iterations, 4.0 * size, exact, footprint, rechunk);
+}
+
+// Annex B stream of random NAL units with emulation prevention, so start
+// codes occur only where NAL units begin. Returns the stream length and
+// records the offset and type of each NAL unit.
+static int RandomAnnexB(uint8_t* stream, int size, std::vector<std::pair<int, uint8_t>>* nals) {
+  static const uint8_t kTypes[] = {1, 1, 1, 5, 6, 7, 8};
+  const int maxPayload = 32768;
+  int length = 0;
+  while (length + 5 + maxPayload * 3 / 2 < size) {
+    nals->push_back({length, kTypes[rand() % sizeof(kTypes)]});
+    if (rand() % 2) stream[length++] = 0;  // Four-byte start code
+    stream[length++] = 0;
+    stream[length++] = 0;
+    stream[length++] = 1;
+    stream[length++] = static_cast<uint8_t>(0x60 | nals->back().second);
+
+    int zeros = 0;
+    for (int payload = 16 + rand() % maxPayload; payload > 0; payload--) {
+      uint8_t byte = static_cast<uint8_t>(rand());
+      if (zeros >= 2 && byte <= 3) {
+        stream[length++] = 3;
+        zeros = 0;
+      }
+      stream[length++] = byte;
+      zeros = byte == 0 ? zeros + 1 : 0;
+    }
+    // RBSP trailing bits: the last byte is never zero
+    if (zeros) stream[length++] = 0x80;
+  }
+  return length;
+}
+
+// find_nal_unit() walking the stream NAL unit by NAL unit, as the H.264 file
+// sources do; checked against the NAL units the stream was built from.
+static void BenchFindNalUnits(int iterations) {
+  const char* title = "H.264 start code scan";
+  if (!Selected(title)) return;
+  Buffer stream(AlignedMalloc<uint8_t>(kStreamBytes, kAlignment));
+  std::vector<std::pair<int, uint8_t>> nals;
+  const int length = RandomAnnexB(stream.get(), kStreamBytes, &nals);
+  std::vector<std::pair<int, uint8_t>> found(nals.size() + 1);
+  size_t count = 0;
+
+  auto scan = [&] {
+    int offset = 0;
+    count = 0;
+    while (count < found.size()) {
+      uint8_t type;
+      int start;
+      int end;
+      int nalLength = find_nal_unit(stream.get() + offset, length - offset, type, start, end);
+      if (nalLength == 0) break;
+      found[count++] = {offset + start, type};
+      if (nalLength < 0) break;  // The last one runs to the end of the stream
+      offset += end + 1;
+    }
+  };
+  scan();
+  bool exact = count == nals.size() && std::equal(nals.begin(), nals.end(), found.begin());
+
+  std::string subject = std::to_string(length >> 20) + " MB, " + std::to_string(nals.size()) +
+                        " NAL units";
+  if (!PrintHeader(title, subject.c_str(), iterations, "ms/stream", "cycles/byte")) return;
+  Run("c", iterations, length, length, exact, {{stream.get(), length}}, scan);
+}
+
+int main(int argc, char* argv[]) {
+  int iterations = 200;
+  if (argc > 1) {
+    char* end;
+    long value = strtol(argv[1], &end, 10);
+    if (end == argv[1] || *end != '\0' || value <= 0 || value > INT_MAX || argc > 3) {
+      fprintf(stderr, "usage: kernel_bench [iterations] [title-filter]\n");
+      return 1;
+    }
+    iterations = static_cast<int>(value);
+  }
+  if (argc > 2) g_filter = argv[2];
+
+  srand(1);
+  for (const FrameSize& size : kFrameSizes) {
+    // The same total number of pixels at every size
+    int frameIterations = static_cast<int>(static_cast<int64_t>(iterations) * 1920 * 1080 /
+                                           (static_cast<int64_t>(size.width) * size.height));
+    if (frameIterations < 1) frameIterations = 1;
+
+    BenchUyvyToI422(size, frameIterations);
+    BenchUyvyToI420(size, frameIterations);
+    BenchV210ToI422(size, frameIterations);
+    BenchV210ToI010(size, frameIterations);
+    BenchV210ToP010(size, frameIterations);
+    BenchBgraToI420(size, frameIterations);
+    BenchR210ToI420(size, frameIterations);
+    BenchCopyI420(size, frameIterations);
+  }
+  BenchMixChannels(iterations);
+  BenchSplitChannels(iterations);
+  BenchS32ToS16(iterations);
+  BenchS32ToFloat(iterations);
+  BenchFloatToS32(iterations);
+  BenchMeasureLevel(iterations);
+  BenchMixInputs(iterations);
+  BenchResample<int16_t>("Resample 44.1 -> 48 kHz stereo S16", iterations);
+  BenchResample<float>("Resample 44.1 -> 48 kHz stereo float", iterations);
+  BenchDriftResampler(iterations);
+  BenchLoudnessMeter(iterations);
+  BenchAudioRing(iterations);
+  BenchFindNalUnits(iterations);
+  return 0;
+}
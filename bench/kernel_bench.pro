@@ -0,0 +1,34 @@
+#-------------------------------------------------
+#
+# Pixel/audio/stream kernel microbenchmark, no Qt or SDK dependencies.
+#   cd bench && qmake kernel_bench.pro && make && ./kernel_bench [iterations] [title-filter]
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = kernel_bench
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+INCLUDEPATH += ..
+QMAKE_CXXFLAGS_RELEASE += -O3
+
+SOURCES += \
+        kernel_bench.cpp \
+        ../common/file_parser/helper_h264_parser.cpp \
+        ../utils/aligned_alloc.cpp \
+        ../utils/audio_convert.cpp \
+        ../utils/audio_convert_sse2.cpp \
+        ../utils/audio_convert_avx2.cpp \
+        ../utils/audio_resampler.cpp \
+        ../utils/audio_ring.cpp \
+        ../utils/cpu_features.cpp \
+        ../utils/drift_resampler.cpp \
+        ../utils/frame_view.cpp \
+        ../utils/I420_buffer.cpp \
+        ../utils/loudness_meter.cpp \
+        ../utils/pixel_convert.cpp \
+        ../utils/pixel_convert_sse2.cpp \
+        ../utils/pixel_convert_avx2.cpp \
+        ../utils/pixel_convert_avx512.cpp
@@ -0,0 +1,477 @@
+// End-to-end benchmark of the capture pipeline, without a card or a live
+// service.
+//
+// The virtual replay input feeds CapturePipeline the way DeckLinkInputDevice
+// does, from its synthetic test signal or from a raw recording. Frames go
+// through the memory allocator, conversion on the configured number of
+// threads, both queues and the A/V delay lines. sendOneYuvFrame() and
+// sendOnePcmFrame() then hand them to the IMediaSink chosen with --sink.
+//
+// After a warm-up the benchmark measures for a fixed time and reports:
+//   - sustained fps and every kind of drop, including frames a paced source
+//     should have delivered but did not,
+//   - mean/p50/p95/p99/max latency of each pipeline stage,
+//   - CPU time of every thread of the process, by thread name.
+// The report is printed as a table and written as JSON.
+//
+//   ./pipeline_bench --mode 1080p59.94 --seconds 30 --threads 4 --sink null
+//   ./pipeline_bench --mode 2160p25 --replay capture.v210 --pixel-format v210 --paced 0
+//
+// Run with --help 1 for every option.
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CapturePipeline.h"
+#include "ConnectToAgora.h"
+#include "DeckLinkMemoryAllocator.h"
+#include "ReplayDeckLinkInput.h"
+#include "com_ptr.h"
+
+namespace {
+
+struct BenchConfig {
+  std::string mode = "1080p50";
+  std::string replay;  // Empty for the test signal
+  std::string replayAudio;
+  std::string pixelFormat = "uyvy";
+  std::string output = "i422";
+  std::string sink = "null";
+  std::string json = "pipeline_bench.json";
+  double seconds = 10.0;
+  double warmupSeconds = 2.0;
+  int32_t threads = 1;
+  int32_t slices = 0;
+  int32_t queueDepth = DEFAULT_CAPTURE_QUEUE_DEPTH;
+  int32_t allocatorBuffers = DEFAULT_CAPTURE_ALLOCATOR_BUFFERS;
+  bool paced = true;
+  bool sync = DEFAULT_SYNC_AUTO_CORRECT;
+  bool pin = false;
+  bool verify = false;
+};
+
+struct ThreadCpu {
+  std::string name;
+  double seconds;
+};
+
+// Forwards capture callbacks to the pipeline, as DeckLinkInputDevice does.
+class BenchCallback : public IDeckLinkInputCallback {
+ public:
+  explicit BenchCallback(CapturePipeline* pipeline) : pipeline_(pipeline) {}
+
+  HRESULT QueryInterface(REFIID, LPVOID* ppv) override {
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+  }
+  // Lives on the stack of main() for longer than the input uses it
+  ULONG AddRef() override { return 1; }
+  ULONG Release() override { return 1; }
+
+  HRESULT VideoInputFormatChanged(BMDVideoInputFormatChangedEvents, IDeckLinkDisplayMode*,
+                                  BMDDetectedVideoInputFormatFlags) override {
+    // Format detection is not enabled; the source never changes mode
+    return S_OK;
+  }
+
+  HRESULT VideoInputFrameArrived(IDeckLinkVideoInputFrame* videoFrame,
+                                 IDeckLinkAudioInputPacket* audioPacket) override {
+    pipeline_->push(videoFrame, audioPacket);
+    return S_OK;
+  }
+
+ private:
+  CapturePipeline* pipeline_;
+};
+
+// The bench does not link the SDK, so there is no agora sink.
+bool ParseSink(const std::string& name, MediaSinkType* type) {
+  return ParseMediaSinkType(name, type) && *type != kMediaSinkAgora;
+}
+
+// User plus system CPU time of every thread of this process, by thread id,
+// from /proc (clock tick resolution, usually 10 ms).
+std::map<int, ThreadCpu> ReadThreadCpu() {
+  std::map<int, ThreadCpu> threads;
+  const double tick = 1.0 / sysconf(_SC_CLK_TCK);
+
+  DIR* dir = opendir("/proc/self/task");
+  if (!dir) return threads;
+
+  while (struct dirent* entry = readdir(dir)) {
+    int tid = atoi(entry->d_name);
+    if (tid <= 0) continue;
+
+    char path[64];
+    char line[512];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+    FILE* file = fopen(path, "r");
+    if (!file) continue;
+    bool ok = fgets(line, sizeof(line), file) != nullptr;
+    fclose(file);
+
+    // The name is in parentheses and may itself hold spaces or parentheses
+    char* open = ok ? strchr(line, '(') : nullptr;
+    char* close = ok ? strrchr(line, ')') : nullptr;
+    unsigned long utime;
+    unsigned long stime;
+    if (!open || !close || close < open ||
+        sscanf(close + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime,
+               &stime) != 2) {
+      continue;
+    }
+
+    ThreadCpu& thread = threads[tid];
+    thread.name.assign(open + 1, close);
+    thread.seconds = (utime + stime) * tick;
+  }
+  closedir(dir);
+  return threads;
+}
+
+com_ptr<IDeckLinkDisplayMode> FindDisplayMode(IDeckLinkInput* input, const std::string& name) {
+  com_ptr<IDeckLinkDisplayModeIterator> iterator;
+  com_ptr<IDeckLinkDisplayMode> mode;
+
+  if (input->GetDisplayModeIterator(iterator.releaseAndGetAddressOf()) != S_OK) return nullptr;
+
+  while (iterator->Next(mode.releaseAndGetAddressOf()) == S_OK) {
+    const char* modeName;
+    if (mode->GetName(&modeName) != S_OK) continue;
+    bool match = name == modeName;
+    free(const_cast<char*>(modeName));
+    if (match) return mode;
+  }
+  return nullptr;
+}
+
+void PrintModes(IDeckLinkInput* input) {
+  com_ptr<IDeckLinkDisplayModeIterator> iterator;
+  com_ptr<IDeckLinkDisplayMode> mode;
+
+  if (input->GetDisplayModeIterator(iterator.releaseAndGetAddressOf()) != S_OK) return;
+  fprintf(stderr, "Display modes:");
+  while (iterator->Next(mode.releaseAndGetAddressOf()) == S_OK) {
+    const char* modeName;
+    if (mode->GetName(&modeName) != S_OK) continue;
+    fprintf(stderr, " %s", modeName);
+    free(const_cast<char*>(modeName));
+  }
+  fprintf(stderr, "\n");
+}
+
+struct Report {
+  BenchConfig config;
+  int width;
+  int height;
+  double fps;
+  double seconds;
+  CaptureQueueStats stats;  // Counters over the measured interval
+  uint64_t expectedFrames;  // Paced only
+  LatencyHistogram const* latency[kLatencyStageCount];
+  std::map<int, ThreadCpu> threads;  // CPU time over the measured interval
+};
+
+uint64_t Shortfall(const Report& report) {
+  return report.expectedFrames > report.stats.framesCaptured
+             ? report.expectedFrames - report.stats.framesCaptured
+             : 0;
+}
+
+double TotalCpuSeconds(const Report& report) {
+  double total = 0;
+  for (const auto& thread : report.threads) total += thread.second.seconds;
+  return total;
+}
+
+void PrintTable(const Report& report) {
+  const CaptureQueueStats& stats = report.stats;
+
+  printf("\n%s %dx%d @ %.3f fps, source %s (%s), output %s, %d convert thread(s), sink %s\n",
+         report.config.mode.c_str(), report.width, report.height, report.fps,
+         report.config.replay.empty() ? "test signal" : report.config.replay.c_str(),
+         report.config.paced ? "paced" : "unpaced", report.config.output.c_str(),
+         report.config.threads, report.config.sink.c_str());
+  printf("Measured %.2f s after %.2f s warm-up\n\n", report.seconds, report.config.warmupSeconds);
+
+  printf("%-22s %12s\n", "frames", "count");
+  printf("%-22s %12llu\n", "captured", (unsigned long long)stats.framesCaptured);
+  if (report.config.paced) {
+    printf("%-22s %12llu\n", "expected", (unsigned long long)report.expectedFrames);
+    printf("%-22s %12llu\n", "source shortfall", (unsigned long long)Shortfall(report));
+  }
+  printf("%-22s %12llu\n", "converted", (unsigned long long)stats.framesConverted);
+  printf("%-22s %12llu\n", "sent", (unsigned long long)stats.framesSent);
+  printf("%-22s %12llu\n", "capture drops", (unsigned long long)stats.captureDrops);
+  printf("%-22s %12llu\n", "convert drops", (unsigned long long)stats.convertDrops);
+  printf("%-22s %12llu\n", "send drops", (unsigned long long)stats.sendDrops);
+  printf("%-22s %12llu\n", "send failures", (unsigned long long)stats.sendFailures);
+  printf("%-22s %12.2f\n", "sustained fps", stats.framesSent / report.seconds);
+  printf("%-22s %12llu\n", "audio chunks sent", (unsigned long long)stats.audioChunksSent);
+  printf("%-22s %12llu\n", "audio send failures", (unsigned long long)stats.audioSendFailures);
+  printf("%-22s %12llu\n", "audio underruns", (unsigned long long)stats.audioUnderruns);
+
+  printf("\n%-14s %10s %10s %10s %10s %10s %10s (us)\n", "stage", "count", "mean", "p50", "p95",
+         "p99", "max");
+  for (int i = 0; i < kLatencyStageCount; i++) {
+    const LatencyHistogram& latency = *report.latency[i];
+    printf("%-14s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+           CapturePipeline::getLatencyStageName(static_cast<CaptureLatencyStage>(i)),
+           (unsigned long long)latency.Count(), latency.MeanNs() / 1e3,
+           latency.PercentileNs(50) / 1e3, latency.PercentileNs(95) / 1e3,
+           latency.PercentileNs(99) / 1e3, latency.MaxNs() / 1e3);
+  }
+
+  printf("\n%-8s %-16s %10s %8s\n", "tid", "thread", "cpu s", "cpu %");
+  for (const auto& thread : report.threads) {
+    printf("%-8d %-16s %10.2f %8.1f\n", thread.first, thread.second.name.c_str(),
+           thread.second.seconds, 100.0 * thread.second.seconds / report.seconds);
+  }
+  double total = TotalCpuSeconds(report);
+  printf("%-8s %-16s %10.2f %8.1f\n", "", "total", total, 100.0 * total / report.seconds);
+}
+
+bool WriteJson(const Report& report, const std::string& path) {
+  FILE* file = path == "-" ? stdout : fopen(path.c_str(), "w");
+  if (!file) {
+    fprintf(stderr, "Unable to write %s\n", path.c_str());
+    return false;
+  }
+
+  const BenchConfig& config = report.config;
+  const CaptureQueueStats& stats = report.stats;
+  fprintf(file, "{\n");
+  fprintf(file,
+          "  \"config\": {\"mode\": \"%s\", \"width\": %d, \"height\": %d, \"fps\": %.6f, "
+          "\"source\": \"%s\", \"pixel_format\": \"%s\", \"paced\": %s, \"output\": \"%s\", "
+          "\"convert_threads\": %d, \"slices\": %d, \"queue_depth\": %d, "
+          "\"allocator_buffers\": %d, \"sync\": %s, \"sink\": \"%s\", \"warmup_seconds\": %.3f},\n",
+          config.mode.c_str(), report.width, report.height, report.fps,
+          config.replay.empty() ? "test" : "replay", config.pixelFormat.c_str(),
+          config.paced ? "true" : "false", config.output.c_str(), config.threads, config.slices,
+          config.queueDepth, config.allocatorBuffers, config.sync ? "true" : "false",
+          config.sink.c_str(), config.warmupSeconds);
+  fprintf(file, "  \"seconds\": %.3f,\n", report.seconds);
+  fprintf(file,
+          "  \"frames\": {\"captured\": %llu, \"expected\": %llu, \"source_shortfall\": %llu, "
+          "\"converted\": %llu, \"sent\": %llu, \"capture_drops\": %llu, "
+          "\"convert_drops\": %llu, \"send_drops\": %llu, \"send_failures\": %llu, "
+          "\"fps\": %.3f},\n",
+          (unsigned long long)stats.framesCaptured, (unsigned long long)report.expectedFrames,
+          (unsigned long long)Shortfall(report), (unsigned long long)stats.framesConverted,
+          (unsigned long long)stats.framesSent, (unsigned long long)stats.captureDrops,
+          (unsigned long long)stats.convertDrops, (unsigned long long)stats.sendDrops,
+          (unsigned long long)stats.sendFailures, stats.framesSent / report.seconds);
+  fprintf(file,
+          "  \"audio\": {\"chunks_sent\": %llu, \"send_failures\": %llu, \"underruns\": %llu},\n",
+          (unsigned long long)stats.audioChunksSent, (unsigned long long)stats.audioSendFailures,
+          (unsigned long long)stats.audioUnderruns);
+
+  fprintf(file, "  \"latency_us\": {\n");
+  for (int i = 0; i < kLatencyStageCount; i++) {
+    const LatencyHistogram& latency = *report.latency[i];
+    fprintf(file,
+            "    \"%s\": {\"count\": %llu, \"mean\": %.1f, \"p50\": %.1f, \"p95\": %.1f, "
+            "\"p99\": %.1f, \"max\": %.1f}%s\n",
+            CapturePipeline::getLatencyStageName(static_cast<CaptureLatencyStage>(i)),
+            (unsigned long long)latency.Count(), latency.MeanNs() / 1e3,
+            latency.PercentileNs(50) / 1e3, latency.PercentileNs(95) / 1e3,
+            latency.PercentileNs(99) / 1e3, latency.MaxNs() / 1e3,
+            i + 1 < kLatencyStageCount ? "," : "");
+  }
+  fprintf(file, "  },\n");
+
+  fprintf(file, "  \"threads\": [\n");
+  size_t index = 0;
+  for (const auto& thread : report.threads) {
+    fprintf(file,
+            "    {\"tid\": %d, \"name\": \"%s\", \"cpu_seconds\": %.3f, \"cpu_percent\": %.1f}%s\n",
+            thread.first, thread.second.name.c_str(), thread.second.seconds,
+            100.0 * thread.second.seconds / report.seconds,
+            ++index < report.threads.size() ? "," : "");
+  }
+  fprintf(file, "  ],\n");
+  fprintf(file, "  \"cpu_percent_total\": %.1f\n",
+          100.0 * TotalCpuSeconds(report) / report.seconds);
+  fprintf(file, "}\n");
+
+  if (file != stdout) fclose(file);
+  return true;
+}
+
+void SleepSeconds(double seconds) {
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  BenchConfig config;
+  bool help = false;
+  opt_parser parser;
+  parser.add_long_opt("mode", &config.mode, "Display mode, e.g. 720p50, 1080p59.94, 2160p25");
+  parser.add_long_opt("seconds", &config.seconds, "Measured duration");
+  parser.add_long_opt("warmup", &config.warmupSeconds, "Warm-up before measuring, in seconds");
+  parser.add_long_opt("threads", &config.threads, "Conversion threads per frame");
+  parser.add_long_opt("slices", &config.slices, "Row slices per frame, 0 for one per thread");
+  parser.add_long_opt("pin", &config.pin, "Pin conversion workers to CPUs (0/1)");
+  parser.add_long_opt("queue", &config.queueDepth, "Capture and send queue depth, in frames");
+  parser.add_long_opt("allocator-buffers", &config.allocatorBuffers,
+                      "Capture buffers in the hugepage allocator, 0 for none");
+  parser.add_long_opt("replay", &config.replay,
+                      "Raw video file to replay instead of the test signal");
+  parser.add_long_opt("replay-audio", &config.replayAudio, "Raw PCM or .wav to replay with --replay");
+  parser.add_long_opt("pixel-format", &config.pixelFormat,
+                      "Pixel format of --replay: uyvy or v210");
+  parser.add_long_opt("paced", &config.paced,
+                      "Deliver at the mode's frame rate (1) or as fast as the pipeline takes (0)");
+  parser.add_long_opt("sync", &config.sync,
+                      "Correct A/V offset with the delay lines (0/1); shows in send-queue latency");
+  parser.add_long_opt("output", &config.output, "Converted layout: i420 or i422");
+  parser.add_long_opt("sink", &config.sink, "null, file or crc");
+  parser.add_long_opt("video-file", &options.sink.videoFile, "Video output of the file sink");
+  parser.add_long_opt("audio-file", &options.sink.audioFile, "Audio output of the file sink");
+  parser.add_long_opt("crc-file", &options.sink.crcFile, "Checksum list of the crc sink");
+  parser.add_long_opt("verify", &config.verify,
+                      "Check against --crc-file instead of writing it (0/1)");
+  parser.add_long_opt("json", &config.json, "Where to write the JSON report, - for stdout");
+  parser.add_long_opt("help", &help, "Print this help (1)");
+
+  if (!parser.parse_opts(argc, argv) || help || config.seconds <= 0 || config.threads < 1 ||
+      (config.output != "i420" && config.output != "i422") ||
+      !ParseSink(config.sink, &options.sink.type)) {
+    parser.print_usage(argv[0], std::cerr);
+    return 1;
+  }
+
+  // The same options DeckLinkInputDevice and the pipeline read
+  ReplaySegment segment;
+  segment.displayMode = config.mode;
+  segment.pixelFormat = config.pixelFormat;
+  segment.testSignal = config.replay.empty();
+  segment.videoFile = config.replay;
+  options.replay.segments.assign(1, segment);
+  options.replay.audioFile = config.replayAudio;
+  options.replay.realTime = config.paced;
+  options.capture.convertThreads = config.threads;
+  options.capture.convertSlices = config.slices;
+  options.capture.pinConvertThreads = config.pin;
+  options.capture.queueDepth = config.queueDepth;
+  options.capture.allocatorBuffers = config.allocatorBuffers;
+  options.sync.autoCorrect = config.sync;
+  options.video.pixelFormat = config.output == "i420" ? agora::media::base::VIDEO_PIXEL_I420
+                                                      : agora::media::base::VIDEO_PIXEL_I422;
+  options.sink.crcVerify = config.verify;
+
+  com_ptr<ReplayDeckLink> deckLink = make_com_ptr<ReplayDeckLink>();
+  if (!deckLink->Init()) return 1;
+  com_ptr<IDeckLinkInput> input(IID_IDeckLinkInput, com_ptr<IDeckLink>(deckLink.get()));
+
+  com_ptr<IDeckLinkDisplayMode> displayMode = FindDisplayMode(input.get(), config.mode);
+  if (!displayMode) {
+    fprintf(stderr, "Unknown display mode %s\n", config.mode.c_str());
+    PrintModes(input.get());
+    return 1;
+  }
+
+  BMDTimeValue frameDuration;
+  BMDTimeScale timeScale;
+  displayMode->GetFrameRate(&frameDuration, &timeScale);
+
+  Report report;
+  report.config = config;
+  report.width = static_cast<int>(displayMode->GetWidth());
+  report.height = static_cast<int>(displayMode->GetHeight());
+  report.fps = static_cast<double>(timeScale) / frameDuration;
+
+  mediaSink = createOfflineMediaSink();
+  if (!mediaSink) {
+    fprintf(stderr, "Failed to create the %s sink\n", config.sink.c_str());
+    return 1;
+  }
+
+  CapturePipeline pipeline;
+  BenchCallback callback(&pipeline);
+  com_ptr<DeckLinkMemoryAllocator> allocator;
+
+  input->SetCallback(&callback);
+  if (config.allocatorBuffers > 0) {
+    allocator = make_com_ptr<DeckLinkMemoryAllocator>(config.allocatorBuffers);
+    input->SetVideoInputFrameMemoryAllocator(allocator.get());
+  }
+
+  BMDPixelFormat pixelFormat = config.pixelFormat == "v210" ? bmdFormat10BitYUV : bmdFormat8BitYUV;
+  BMDAudioSampleType sampleType = options.capture.audioSampleBits == 32
+                                      ? bmdAudioSampleType32bitInteger
+                                      : bmdAudioSampleType16bitInteger;
+  if (input->EnableVideoInput(displayMode->GetDisplayMode(), pixelFormat,
+                              bmdVideoInputFlagDefault) != S_OK ||
+      input->EnableAudioInput(bmdAudioSampleRate48kHz, sampleType,
+                              options.capture.audioChannels) != S_OK) {
+    fprintf(stderr, "Unable to enable the replay input\n");
+    return 1;
+  }
+
+  I420Buffer::Type outputType = config.output == "i420" ? I420Buffer::kI420 : I420Buffer::kI422;
+  if (!pipeline.start(report.width, report.height, report.fps, outputType, config.queueDepth,
+                      options.capture.overflowPolicy) ||
+      input->StartStreams() != S_OK) {
+    fprintf(stderr, "Unable to start capturing\n");
+    return 1;
+  }
+
+  SleepSeconds(config.warmupSeconds);
+
+  // Counters are cumulative since start(); the histograms start over
+  CaptureQueueStats before = pipeline.getStats();
+  std::map<int, ThreadCpu> cpuBefore = ReadThreadCpu();
+  pipeline.resetLatency();
+  auto start = std::chrono::steady_clock::now();
+
+  SleepSeconds(config.seconds);
+
+  CaptureQueueStats after = pipeline.getStats();
+  report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  report.threads = ReadThreadCpu();
+
+  input->StopStreams();
+  input->SetCallback(nullptr);
+
+  report.stats = after;
+  report.stats.framesCaptured -= before.framesCaptured;
+  report.stats.framesConverted -= before.framesConverted;
+  report.stats.framesSent -= before.framesSent;
+  report.stats.captureDrops -= before.captureDrops;
+  report.stats.convertDrops -= before.convertDrops;
+  report.stats.sendDrops -= before.sendDrops;
+  report.stats.sendFailures -= before.sendFailures;
+  report.stats.audioChunksSent -= before.audioChunksSent;
+  report.stats.audioSendFailures -= before.audioSendFailures;
+  report.stats.audioUnderruns -= before.audioUnderruns;
+  report.expectedFrames = config.paced ? static_cast<uint64_t>(report.seconds * report.fps) : 0;
+  for (auto& thread : report.threads) {
+    auto earlier = cpuBefore.find(thread.first);
+    if (earlier != cpuBefore.end()) thread.second.seconds -= earlier->second.seconds;
+  }
+  for (int i = 0; i < kLatencyStageCount; i++) {
+    report.latency[i] = &pipeline.getLatency(static_cast<CaptureLatencyStage>(i));
+  }
+
+  PrintTable(report);
+  bool written = WriteJson(report, config.json);
+
+  pipeline.stop();
+  // Offline sinks flush their files or report their checks here
+  mediaSink.reset();
+  return written ? 0 : 1;
+}
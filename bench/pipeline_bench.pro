@@ -0,0 +1,63 @@
+#-------------------------------------------------
+#
+# End-to-end capture pipeline benchmark on the replay input, no card or Qt.
+#   cd bench && qmake pipeline_bench.pro && make && ./pipeline_bench --help 1
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = pipeline_bench
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+INCLUDEPATH += .. ../../../include
+QMAKE_CXXFLAGS_RELEASE += -O3
+LIBS += -ldl -lpthread
+
+SOURCES += \
+        pipeline_bench.cpp \
+        ../../../include/DeckLinkAPIDispatch.cpp \
+        ../CapturePipeline.cpp \
+        ../AudioSendPath.cpp \
+        ../DeckLinkMemoryAllocator.cpp \
+        ../ReplayDeckLinkInput.cpp \
+        ../MediaSinkSend.cpp \
+        ../common/opt_parser.cpp \
+        ../common/sample_event.cpp \
+        ../utils/aligned_alloc.cpp \
+        ../utils/audio_convert.cpp \
+        ../utils/audio_convert_sse2.cpp \
+        ../utils/audio_convert_avx2.cpp \
+        ../utils/audio_drift.cpp \
+        ../utils/audio_mixer.cpp \
+        ../utils/audio_resampler.cpp \
+        ../utils/audio_ring.cpp \
+        ../utils/I420_buffer.cpp \
+        ../utils/frame_pool.cpp \
+        ../utils/frame_view.cpp \
+        ../utils/hugepage_arena.cpp \
+        ../utils/latency_histogram.cpp \
+        ../utils/loudness_meter.cpp \
+        ../utils/mapped_file.cpp \
+        ../utils/test_signal.cpp \
+        ../utils/media_sink.cpp \
+        ../utils/crc32.cpp \
+        ../utils/cpu_features.cpp \
+        ../utils/drift_resampler.cpp \
+        ../utils/file_parser/aac_file_parser.cpp \
+        ../utils/file_parser/audio_file_parser_factory.cpp \
+        ../utils/file_parser/fixed_frame_length_audio_file_parser.cpp \
+        ../utils/file_parser/wav_pcm_file_parser.cpp \
+        ../utils/pixel_convert.cpp \
+        ../utils/pixel_convert_sse2.cpp \
+        ../utils/pixel_convert_avx2.cpp \
+        ../utils/pixel_convert_avx512.cpp \
+        ../utils/silence_detector.cpp \
+        ../utils/wav_header.cpp \
+        ../utils/worker_pool.cpp
+
+# The offline sinks stand in for the service and nothing links the SDK; its
+# headers are still needed for the types in SampleOptions
+INCLUDEPATH += $$PWD/../../../../../../../桌面/sxd/Agora_Native_SDK_for_Linux_x64_rel.v2.7.1.909_FULL_20200731_1130/lib/linux/agora_media_sdk/include
+DEPENDPATH += $$PWD/../../../../../../../桌面/sxd/Agora_Native_SDK_for_Linux_x64_rel.v2.7.1.909_FULL_20200731_1130/lib/linux/agora_media_sdk/include
@@ -3,6 +3,8 @@
 #include <cstring>
 #include <vector>
 
+#include "ConnectToAgora.h"
+
 HelperAudioFileParser::HelperAudioFileParser(const char* filepath, AUDIO_FILE_TYPE filetype)
     : file_path(filepath), file_type(filetype) {}
 
@@ -12,6 +14,8 @@ bool HelperAudioFileParser::initialize() {
   AudioFileParserFactory::ParserConfig config;
   config.filePath = file_path.c_str();
   config.fileType = file_type;
+  // WAV files at another rate are resampled to the rate audio is sent at
+  config.outputSampleRateHz = options.audio.sampleRate;
   file_parser_ = std::move(AudioFileParserFactory::Instance().createAudioFileParser(config));
   if (!file_parser_ || !file_parser_->open()) {
     printf("Open opus file %s failed\n", file_path.c_str());
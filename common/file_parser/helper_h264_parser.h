@@ -1,6 +1,9 @@
 #pragma once
 
+#include <stdint.h>
+
 #include <memory>
+#include <string>
 
 struct HelperH264Frame {
   bool isKeyFrame;
@@ -8,6 +11,11 @@ struct HelperH264Frame {
   int bufferLen;
 };
 
+// Finds the next NAL unit in |buf|: |nal_start| is the offset of its start
+// code and |nal_end| of its last byte. Returns the length, 0 if there is no
+// start code, or -1 if the unit runs to the end of |buf|.
+int find_nal_unit(uint8_t* buf, int size, uint8_t& nal_type, int& nal_start, int& nal_end);
+
 class HelperH264FileParser {
  public:
   HelperH264FileParser(const char* filepath);
@@ -9,6 +9,45 @@ int main(int argc, char *argv[])
 
 	qRegisterMetaType<com_ptr<IDeckLinkVideoFrame>>("com_ptr<IDeckLinkVideoFrame>");
 
+	// QApplication has taken out the arguments it knows; the rest choose
+	// where the pipeline sends, which has to be settled before connecting,
+	// and can add the virtual replay input in place of a card:
+	//   CapturePreview --sink crc --sink-crc-file run.crc --sink-verify 1
+	//   CapturePreview --replay capture.v210 --replay-mode 2160p25 --replay-pixel-format v210
+	std::string		sink;
+	ReplaySegment	replay;
+	bool			replayTestSignal = false;
+	bool			help = false;
+	opt_parser		parser;
+
+	parser.add_long_opt("sink", &sink, "agora (default), null, file or crc");
+	parser.add_long_opt("sink-video-file", &options.sink.videoFile, "Video output of the file sink");
+	parser.add_long_opt("sink-audio-file", &options.sink.audioFile, "Audio output of the file sink");
+	parser.add_long_opt("sink-crc-file", &options.sink.crcFile, "Checksum list of the crc sink");
+	parser.add_long_opt("sink-verify", &options.sink.crcVerify, "Check against --sink-crc-file instead of writing it (0/1)");
+	parser.add_long_opt("replay", &replay.videoFile, "Raw video file for the virtual replay input");
+	parser.add_long_opt("replay-test-signal", &replayTestSignal, "Replay a generated test signal instead of a file (0/1)");
+	parser.add_long_opt("replay-mode", &replay.displayMode, "Display mode of the replay, e.g. 1080p25");
+	parser.add_long_opt("replay-pixel-format", &replay.pixelFormat, "Pixel format of --replay: uyvy or v210");
+	parser.add_long_opt("replay-audio", &options.replay.audioFile, "Raw interleaved 48 kHz PCM, or a .wav at any rate, to replay with the video");
+	parser.add_long_opt("replay-audio-channels", &options.replay.audioChannels, "Channels of raw --replay-audio");
+	parser.add_long_opt("replay-audio-bits", &options.replay.audioSampleBits, "Sample size of raw --replay-audio: 16 or 32");
+	parser.add_long_opt("replay-real-time", &options.replay.realTime, "Replay at the frame rate of the mode, else as fast as possible (0/1)");
+	parser.add_long_opt("help", &help, "Print this help (1)");
+	if (!parser.parse_opts(argc, argv) || help || (!sink.empty() && !ParseMediaSinkType(sink, &options.sink.type)) ||
+		(replayTestSignal && !replay.videoFile.empty()))
+	{
+		parser.print_usage(argv[0], std::cerr);
+		return 1;
+	}
+
+	// One replayed segment, looping, in place of any configured ones
+	if (!replay.videoFile.empty() || replayTestSignal)
+	{
+		replay.testSignal = replayTestSignal;
+		options.replay.segments.assign(1, replay);
+	}
+
     if (connectAgora() > 0);  //printf("success connect to agora")
     CapturePreview w;
     w.show();
@@ -1,59 +1,94 @@
 #include "I420_buffer.h"
-#include "aligned_alloc.h"
-#include "wrapper/utils.h"
+#include <cassert>
 #include <cstring>
 
 // Aligning pointer to 64 bytes for improved performance, e.g. use SIMD.
 static const int kBufferAlignment = 64;
 
-static int I420DataSize(int height, int stride_y, int stride_u, int stride_v) {
-  return stride_y * height + (stride_u + stride_v) * ((height + 1) / 2);
+static int ChromaRows(I420Buffer::Type type, int height) {
+  return type == I420Buffer::kI422 ? height : (height + 1) / 2;
 }
 
-I420Buffer::I420Buffer(int width, int height)
-    : I420Buffer(width, height, width, (width + 1) / 2, (width + 1) / 2) {}
+static int DefaultStrideU(I420Buffer::Type type, int width) {
+  return type == I420Buffer::kNV12 ? 2 * ((width + 1) / 2) : (width + 1) / 2;
+}
+
+static int DefaultStrideV(I420Buffer::Type type, int width) {
+  return type == I420Buffer::kNV12 ? 0 : (width + 1) / 2;
+}
+
+static int YuvDataSize(I420Buffer::Type type, int height, int stride_y, int stride_u,
+                       int stride_v) {
+  return stride_y * height + (stride_u + stride_v) * ChromaRows(type, height);
+}
+
+I420Buffer::I420Buffer(int width, int height, Type type)
+    : I420Buffer(width, height, type, width, DefaultStrideU(type, width),
+                 DefaultStrideV(type, width)) {}
 
 I420Buffer::I420Buffer(int width,
                        int height,
+                       Type type,
                        int stride_y,
                        int stride_u,
                        int stride_v)
-    : width_(width),
+    : type_(type),
+      width_(width),
       height_(height),
       stride_y_(stride_y),
       stride_u_(stride_u),
       stride_v_(stride_v),
       data_(static_cast<uint8_t*>(
-          AlignedMalloc(I420DataSize(height, stride_y, stride_u, stride_v),
+          AlignedMalloc(YuvDataSize(type, height, stride_y, stride_u, stride_v),
                         kBufferAlignment))) {
   assert(width > 0);
   assert(height > 0);
   assert(stride_y >= width);
-  assert(stride_u >= (width + 1) / 2);
-  assert(stride_v >= (width + 1) / 2);
+  assert(stride_u >= DefaultStrideU(type, width));
+  assert(stride_v >= DefaultStrideV(type, width));
 }
 
-I420Buffer::~I420Buffer() {
-    if (data_) AlignedFree(data_.get());
-}
+I420Buffer::~I420Buffer() {}
 
 // static
 I420Buffer* I420Buffer::Create(int width, int height) {
-  return new I420Buffer(width, height);
+  return new I420Buffer(width, height, kI420);
+}
+
+// static
+I420Buffer* I420Buffer::Create(int width, int height, Type type) {
+  return new I420Buffer(width, height, type);
+}
+
+// static
+I420Buffer* I420Buffer::Create(int width,
+                               int height,
+                               int stride_y,
+                               int stride_u,
+                               int stride_v) {
+  return new I420Buffer(width, height, kI420, stride_y, stride_u, stride_v);
 }
 
 // static
 I420Buffer* I420Buffer::Create(int width,
                                int height,
+                               Type type,
                                int stride_y,
                                int stride_u,
                                int stride_v) {
-  return new I420Buffer(width, height, stride_y, stride_u, stride_v);
+  return new I420Buffer(width, height, type, stride_y, stride_u, stride_v);
 }
 
 void I420Buffer::InitializeData() {
-  memset(data_.get(), 0,
-         I420DataSize(height_, stride_y_, stride_u_, stride_v_));
+  memset(data_.get(), 0, DataSize());
+}
+
+int I420Buffer::DataSize() const {
+  return YuvDataSize(type_, height_, stride_y_, stride_u_, stride_v_);
+}
+
+I420Buffer::Type I420Buffer::type() const {
+  return type_;
 }
 
 int I420Buffer::width() const {
@@ -69,7 +104,7 @@ int I420Buffer::ChromaWidth() const {
 }
 
 int I420Buffer::ChromaHeight() const {
-  return (height() + 1) / 2;
+  return ChromaRows(type_, height());
 }
 
 const uint8_t* I420Buffer::Data() const {
@@ -85,7 +120,8 @@ const uint8_t* I420Buffer::DataU() const {
 }
 
 const uint8_t* I420Buffer::DataV() const {
-  return data_.get() + stride_y_ * height_ + stride_u_ * ((height_ + 1) / 2);
+  if (type_ == kNV12) return nullptr;
+  return data_.get() + stride_y_ * height_ + stride_u_ * ChromaHeight();
 }
 
 int I420Buffer::StrideY() const {
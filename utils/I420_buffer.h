@@ -3,12 +3,24 @@
 #include <stdint.h>
 #include <memory>
 
+#include "aligned_alloc.h"
+
+// Planar YUV buffer. Despite the name it also covers the other 8-bit layouts
+// used on the capture path: I422 (full height chroma) and NV12 (one
+// interleaved UV plane, returned by DataU()/StrideU(); DataV() is null).
+// All planes live in one contiguous 64-byte aligned allocation.
 class I420Buffer {
  public:
+  enum Type { kI420 = 0, kI422, kNV12 };
+
   static I420Buffer* Create(int width, int height);
+  static I420Buffer* Create(int width, int height, Type type);
   static I420Buffer* Create(int width, int height,
                             int stride_y, int stride_u,
                             int stride_v);
+  static I420Buffer* Create(int width, int height, Type type,
+                            int stride_y, int stride_u,
+                            int stride_v);
   static void Release(I420Buffer* buffer) { delete buffer; }
 
  public:
@@ -21,6 +33,7 @@ class I420Buffer {
   // are resolved in a better way. Or in the mean time, use SetBlack.
   void InitializeData();
 
+  Type type() const;
   int width() const;
   int height() const;
   int ChromaWidth() const;
@@ -31,6 +44,9 @@ class I420Buffer {
   const uint8_t* DataU() const;
   const uint8_t* DataV() const;
 
+  // Size in bytes of all planes, including stride padding.
+  int DataSize() const;
+
   int StrideY() const;
   int StrideU() const;
   int StrideV() const;
@@ -40,16 +56,17 @@ class I420Buffer {
   uint8_t* MutableDataV();
 
  protected:
-  I420Buffer(int width, int height);
-  I420Buffer(int width, int height, int stride_y, int stride_u, int stride_v);
+  I420Buffer(int width, int height, Type type);
+  I420Buffer(int width, int height, Type type, int stride_y, int stride_u, int stride_v);
 
   ~I420Buffer();
 
  private:
+  const Type type_;
   const int width_;
   const int height_;
   const int stride_y_;
   const int stride_u_;
   const int stride_v_;
-  const std::unique_ptr<uint8_t> data_;
+  const std::unique_ptr<uint8_t, AlignedFreeDeleter> data_;
 };
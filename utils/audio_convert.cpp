@@ -0,0 +1,253 @@
+#include "audio_convert.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "audio_convert_row.h"
+
+static const int kGainBits = 14;
+static const int kPolyphaseBits = 15;
+
+static int16_t Clamp16(int32_t value) {
+  return static_cast<int16_t>(value < -32768 ? -32768 : (value > 32767 ? 32767 : value));
+}
+
+void MixChannels_C(const int16_t* src, int16_t* dst, const ChannelMatrix* matrix, int frames) {
+  const int src_channels = matrix->src_channels;
+  const int dst_channels = matrix->dst_channels;
+  for (int f = 0; f < frames; f++) {
+    for (int o = 0; o < dst_channels; o++) {
+      int32_t sum = 1 << (kGainBits - 1);
+      for (int i = 0; i < src_channels; i++) sum += src[i] * matrix->gains[o][i];
+      dst[o] = Clamp16(sum >> kGainBits);
+    }
+    src += src_channels;
+    dst += dst_channels;
+  }
+}
+
+static uint32_t Xorshift32(uint32_t* state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+// Sample i draws from generator i % 8. The two 16-bit halves of one draw are
+// summed into triangular noise in -65535..65535, i.e. +/-1 output LSB. The
+// high and low halves of the input are handled separately so nothing
+// overflows 32 bits.
+void S32ToS16_C(const int32_t* src, int16_t* dst, uint32_t* dither_state, int count) {
+  for (int i = 0; i < count; i++) {
+    int32_t noise = 0;
+    if (dither_state) {
+      uint32_t r = Xorshift32(&dither_state[i & 7]);
+      noise = static_cast<int32_t>(r & 0xffff) + static_cast<int32_t>(r >> 16) - 65535;
+    }
+    int32_t low = (src[i] & 0xffff) + noise + 32768;
+    dst[i] = Clamp16((src[i] >> 16) + (low >> 16));
+  }
+}
+
+static const float kS32ToFloatScale = 1.0f / 2147483648.0f;
+static const float kFloatToS32Scale = 2147483648.0f;
+// Largest float below 2^31; larger values would not convert to int32.
+static const float kFloatToS32Max = 2147483520.0f;
+
+void S32ToFloat_C(const int32_t* src, float* dst, int count) {
+  for (int i = 0; i < count; i++) dst[i] = static_cast<float>(src[i]) * kS32ToFloatScale;
+}
+
+void FloatToS32_C(const float* src, int32_t* dst, int count) {
+  for (int i = 0; i < count; i++) {
+    float value = src[i] * kFloatToS32Scale;
+    value = value > kFloatToS32Max ? kFloatToS32Max : value;
+    value = value < -kFloatToS32Scale ? -kFloatToS32Scale : value;
+    dst[i] = static_cast<int32_t>(lrintf(value));
+  }
+}
+
+void PolyphaseS16_C(const int16_t* src, const int16_t* bank, int taps, const int32_t* offsets,
+                    const int32_t* phases, int count, int16_t* dst, int dst_stride) {
+  for (int i = 0; i < count; i++) {
+    const int16_t* x = src + offsets[i];
+    const int16_t* h = bank + phases[i] * taps;
+    int32_t sum = 0;
+    for (int k = 0; k < taps; k++) sum += x[k] * h[k];
+    dst[i * dst_stride] = Clamp16((sum + (1 << (kPolyphaseBits - 1))) >> kPolyphaseBits);
+  }
+}
+
+// Lane order of the SIMD variants: tap k goes to lane k % 8, and the lanes
+// are summed as ((0 + 4) + (2 + 6)) + ((1 + 5) + (3 + 7)).
+void PolyphaseFloat_C(const float* src, const float* bank, int taps, const int32_t* offsets,
+                      const int32_t* phases, int count, float* dst, int dst_stride) {
+  for (int i = 0; i < count; i++) {
+    const float* x = src + offsets[i];
+    const float* h = bank + phases[i] * taps;
+    float lane[8] = {0};
+    for (int k = 0; k < taps; k += 8) {
+      for (int j = 0; j < 8; j++) lane[j] += x[k + j] * h[k + j];
+    }
+    float even = (lane[0] + lane[4]) + (lane[2] + lane[6]);
+    float odd = (lane[1] + lane[5]) + (lane[3] + lane[7]);
+    dst[i * dst_stride] = even + odd;
+  }
+}
+
+void MeasureLevel_C(const int16_t* src, int count, AudioLevel* level) {
+  int peak = level->peak;
+  uint64_t sum_squares = level->sum_squares;
+  for (int i = 0; i < count; i++) {
+    int magnitude = src[i] < 0 ? -src[i] : src[i];
+    if (magnitude > 32767) magnitude = 32767;
+    if (magnitude > peak) peak = magnitude;
+    sum_squares += static_cast<uint64_t>(src[i] * src[i]);
+  }
+  level->peak = peak;
+  level->sum_squares = sum_squares;
+}
+
+static int32_t AddSaturate32(int32_t a, int32_t b) {
+  int64_t sum = static_cast<int64_t>(a) + b;
+  return static_cast<int32_t>(sum < INT32_MIN ? INT32_MIN : (sum > INT32_MAX ? INT32_MAX : sum));
+}
+
+// The gain steps in unsigned arithmetic, which the SIMD lanes reproduce.
+void AccumulateGain_C(const int16_t* src, int32_t* acc, int32_t gain, int32_t gain_step,
+                      int count) {
+  uint32_t g = static_cast<uint32_t>(gain);
+  for (int i = 0; i < count; i++) {
+    acc[i] = AddSaturate32(acc[i], src[i] * (static_cast<int32_t>(g) >> 16));
+    g += static_cast<uint32_t>(gain_step);
+  }
+}
+
+// ((x >> 13) + 1) >> 1 rounds x / 2^14 to nearest without overflowing.
+void PackAccumulator_C(const int32_t* acc, int16_t* dst, int count) {
+  for (int i = 0; i < count; i++) dst[i] = Clamp16(((acc[i] >> (kGainBits - 1)) + 1) >> 1);
+}
+
+static const AudioKernels kAudioKernels[kIsaCount] = {
+    {kIsaC, MixChannels_C, S32ToS16_C, S32ToFloat_C, FloatToS32_C, PolyphaseS16_C,
+     PolyphaseFloat_C, MeasureLevel_C, AccumulateGain_C, PackAccumulator_C},
+    {kIsaSSE2, MixChannels_SSE2, S32ToS16_SSE2, S32ToFloat_SSE2, FloatToS32_SSE2,
+     PolyphaseS16_SSE2, PolyphaseFloat_SSE2, MeasureLevel_SSE2, AccumulateGain_SSE2,
+     PackAccumulator_SSE2},
+    {kIsaAVX2, MixChannels_AVX2, S32ToS16_AVX2, S32ToFloat_AVX2, FloatToS32_AVX2,
+     PolyphaseS16_AVX2, PolyphaseFloat_AVX2, MeasureLevel_AVX2, AccumulateGain_AVX2,
+     PackAccumulator_AVX2},
+    {kIsaAVX512, MixChannels_AVX2, S32ToS16_AVX2, S32ToFloat_AVX2, FloatToS32_AVX2,
+     PolyphaseS16_AVX2, PolyphaseFloat_AVX2, MeasureLevel_AVX2, AccumulateGain_AVX2,
+     PackAccumulator_AVX2},
+};
+
+const AudioKernels* GetAudioKernels(CpuIsa isa) {
+  if (isa < kIsaC || isa >= kIsaCount || !CpuSupportsIsa(isa)) return nullptr;
+  return &kAudioKernels[isa];
+}
+
+static const AudioKernels* ResolveKernels(const AudioKernels* kernels) {
+  static const AudioKernels* best = GetAudioKernels(GetBestCpuIsa());
+  return kernels ? kernels : best;
+}
+
+bool InitChannelMatrix(ChannelMatrix* matrix, int src_channels, int dst_channels,
+                       const float* gains) {
+  if (src_channels < 1 || src_channels > kMaxAudioChannels || dst_channels < 1 ||
+      dst_channels > kMaxAudioChannels) {
+    return false;
+  }
+
+  memset(matrix, 0, sizeof(*matrix));
+  matrix->src_channels = src_channels;
+  matrix->dst_channels = dst_channels;
+
+  for (int o = 0; o < dst_channels; o++) {
+    int32_t total = 0;
+    for (int i = 0; i < src_channels; i++) {
+      float gain = gains ? gains[o * src_channels + i] : (i == o ? 1.0f : 0.0f);
+      long q = lrintf(gain * (1 << kGainBits));
+      if (q > 32767) q = 32767;
+      if (q < -32767) q = -32767;
+      matrix->gains[o][i] = static_cast<int16_t>(q);
+      total += q < 0 ? -q : q;
+    }
+    // |sum| stays below 32768 * 65536 = 2^31.
+    if (total >= 4 << kGainBits) return false;
+  }
+
+  matrix->identity = src_channels == dst_channels;
+  for (int o = 0; o < dst_channels; o++) {
+    for (int i = 0; i < src_channels; i++) {
+      if (matrix->gains[o][i] != (i == o ? 1 << kGainBits : 0)) matrix->identity = false;
+    }
+    for (int k = 0; k < (src_channels + 1) / 2; k++) {
+      uint16_t lo = static_cast<uint16_t>(matrix->gains[o][2 * k]);
+      uint16_t hi = static_cast<uint16_t>(matrix->gains[o][2 * k + 1]);
+      matrix->pair_gains[o][k] = static_cast<int32_t>(lo | (static_cast<uint32_t>(hi) << 16));
+      if (lo || hi) matrix->active_pairs[o][matrix->active_pair_count[o]++] = static_cast<uint8_t>(k);
+    }
+  }
+  return true;
+}
+
+void MixChannels(const int16_t* src, int16_t* dst, int frames, const ChannelMatrix& matrix,
+                 const AudioKernels* kernels) {
+  if (matrix.identity) {
+    memcpy(dst, src, sizeof(int16_t) * matrix.src_channels * frames);
+    return;
+  }
+  ResolveKernels(kernels)->mix_channels(src, dst, &matrix, frames);
+}
+
+void SplitChannels(const int16_t* src, int frames, int src_channels, const int* run_channels,
+                   int runs, int16_t* const* dst) {
+  for (int f = 0; f < frames; f++) {
+    const int16_t* frame = src + static_cast<size_t>(f) * src_channels;
+    for (int r = 0; r < runs; r++) {
+      int channels = run_channels[r];
+      memcpy(dst[r] + static_cast<size_t>(f) * channels, frame, sizeof(int16_t) * channels);
+      frame += channels;
+    }
+  }
+}
+
+void InitAudioDither(AudioDither* dither, uint32_t seed) {
+  // Spread the seed over the generators; xorshift needs non-zero state.
+  for (int i = 0; i < 8; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    dither->state[i] = seed ? seed : 1;
+  }
+}
+
+void ConvertS32ToS16(const int32_t* src, int16_t* dst, int count, AudioDither* dither,
+                     const AudioKernels* kernels) {
+  ResolveKernels(kernels)->s32_to_s16(src, dst, dither ? dither->state : nullptr, count);
+}
+
+void ConvertS32ToFloat(const int32_t* src, float* dst, int count, const AudioKernels* kernels) {
+  ResolveKernels(kernels)->s32_to_float(src, dst, count);
+}
+
+void ConvertFloatToS32(const float* src, int32_t* dst, int count, const AudioKernels* kernels) {
+  ResolveKernels(kernels)->float_to_s32(src, dst, count);
+}
+
+void MeasureAudioLevel(const int16_t* src, int count, AudioLevel* level,
+                       const AudioKernels* kernels) {
+  level->peak = 0;
+  level->sum_squares = 0;
+  ResolveKernels(kernels)->measure_level(src, count, level);
+}
+
+void AccumulateAudio(const int16_t* src, int32_t* acc, int count, int32_t gain, int32_t gain_step,
+                     const AudioKernels* kernels) {
+  ResolveKernels(kernels)->accumulate_gain(src, acc, gain, gain_step, count);
+}
+
+void PackAudioAccumulator(const int32_t* acc, int16_t* dst, int count,
+                          const AudioKernels* kernels) {
+  ResolveKernels(kernels)->pack_accumulator(acc, dst, count);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+// Sample processing used on the capture audio path.
+//
+// Like pixel_convert.h, every operation is built from kernels that have a
+// scalar reference plus SIMD variants (see audio_convert_row.h); the default
+// is the widest variant the running CPU supports and all variants produce
+// bit-identical output.
+
+#include <stdint.h>
+
+struct AudioKernels;
+
+// Most channels a DeckLink input embeds (16 on SDI).
+static const int kMaxAudioChannels = 16;
+
+// Routing/downmix matrix from |src_channels| to |dst_channels| interleaved
+// channels. Gains are Q14 fixed point (16384 = unity, range just under
+// +/-2.0); each output is rounded and saturated to 16 bits.
+struct ChannelMatrix {
+  int src_channels;
+  int dst_channels;
+  bool identity;  // Output equals input; MixChannels() is a copy.
+  int16_t gains[kMaxAudioChannels][kMaxAudioChannels];  // [dst][src]
+
+  // Derived for the SIMD kernels: gains of input pairs (2k, 2k+1) packed into
+  // one 32-bit word, and per output the pairs with a non-zero gain.
+  int32_t pair_gains[kMaxAudioChannels][kMaxAudioChannels / 2];
+  uint8_t active_pairs[kMaxAudioChannels][kMaxAudioChannels / 2];
+  int active_pair_count[kMaxAudioChannels];
+};
+
+// Builds |matrix| from |gains|, |dst_channels| rows of |src_channels| linear
+// gains each, or from the identity (output c takes input c, missing inputs
+// are silent) if |gains| is null. Fails if a channel count is outside
+// 1..kMaxAudioChannels or an output's absolute gains add up to 4.0 or more,
+// which could overflow the 32-bit accumulators.
+bool InitChannelMatrix(ChannelMatrix* matrix, int src_channels, int dst_channels,
+                       const float* gains);
+
+// Applies |matrix| to |frames| interleaved frames. |src| and |dst| must not
+// overlap.
+void MixChannels(const int16_t* src, int16_t* dst, int frames, const ChannelMatrix& matrix,
+                 const AudioKernels* kernels = nullptr);
+
+// Splits |frames| interleaved frames into consecutive runs of channels, run
+// k taking the next |run_channels[k]| channels and writing them interleaved
+// to |dst[k]|, in a single pass over |src|. The runs must add up to
+// |src_channels|.
+void SplitChannels(const int16_t* src, int frames, int src_channels, const int* run_channels,
+                   int runs, int16_t* const* dst);
+
+// Sample format conversion. Counts are samples, i.e. frames * channels.
+
+// State of the TPDF dither used by ConvertS32ToS16(): eight xorshift32
+// generators, one per sample position modulo 8, so the SIMD variants draw
+// exactly the noise the scalar code does.
+struct AudioDither {
+  uint32_t state[8];
+};
+
+void InitAudioDither(AudioDither* dither, uint32_t seed);
+
+// 32-bit to 16-bit PCM. With |dither|, triangular noise of +/-1 output LSB is
+// added before rounding, which turns the requantization error into benign
+// white noise instead of distortion correlated with quiet signals; with a
+// null |dither| samples are rounded to nearest. Saturates.
+void ConvertS32ToS16(const int32_t* src, int16_t* dst, int count, AudioDither* dither,
+                     const AudioKernels* kernels = nullptr);
+
+// Full scale 32-bit PCM to float in [-1, 1) and back. Float to 32-bit rounds
+// to nearest and saturates to [-1, 1 - 2^-24]; input must be finite.
+void ConvertS32ToFloat(const int32_t* src, float* dst, int count,
+                       const AudioKernels* kernels = nullptr);
+void ConvertFloatToS32(const float* src, int32_t* dst, int count,
+                       const AudioKernels* kernels = nullptr);
+
+// Peak and energy of a run of 16-bit samples. |peak| is the largest
+// magnitude, with -32768 counted as 32767.
+struct AudioLevel {
+  int peak;
+  uint64_t sum_squares;
+};
+
+// Measures |count| samples (all channels alike) into |level|.
+void MeasureAudioLevel(const int16_t* src, int count, AudioLevel* level,
+                       const AudioKernels* kernels = nullptr);
+
+// Mixing. Inputs are summed into a 32-bit accumulator in Q14 (16384 times
+// the 16-bit sample value), which holds four full-scale inputs before it
+// saturates.
+
+// Unity in the Q30 gains of AccumulateAudio(); gains range over [-2.0, 2.0).
+static const int32_t kAudioGainUnity = 1 << 30;
+
+// Adds |count| samples of |src| to |acc| with saturation, scaled by a linear
+// gain ramp: the gain starts at |gain|, is applied through its top 16 bits
+// and moves by |gain_step| after every sample. The ramp must stay in range.
+void AccumulateAudio(const int16_t* src, int32_t* acc, int count, int32_t gain, int32_t gain_step,
+                     const AudioKernels* kernels = nullptr);
+
+// Rounds |count| accumulated samples to 16 bits, saturating.
+void PackAudioAccumulator(const int32_t* acc, int16_t* dst, int count,
+                          const AudioKernels* kernels = nullptr);
@@ -0,0 +1,289 @@
+// AVX2 audio kernels. Keep this file free of STL includes: everything inlined
+// here is compiled for AVX2 and must not leak into other translation units.
+#pragma GCC target("avx2")
+
+#include <immintrin.h>
+
+#include "audio_convert_row.h"
+
+namespace {
+
+// Eight frames per vector, frames 0-3 in the low lane and 4-7 in the high
+// lane, so the in-lane shuffles of the SSE2 kernel carry over unchanged.
+inline __m256i Load2x128(const int16_t* lo, const int16_t* hi) {
+  return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lo))),
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(hi)), 1);
+}
+
+inline void Transpose4x4(const __m256i r[4], __m256i* p) {
+  __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+  __m256i t1 = _mm256_unpacklo_epi32(r[2], r[3]);
+  __m256i t2 = _mm256_unpackhi_epi32(r[0], r[1]);
+  __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+  p[0] = _mm256_unpacklo_epi64(t0, t1);
+  p[1] = _mm256_unpackhi_epi64(t0, t1);
+  p[2] = _mm256_unpacklo_epi64(t2, t3);
+  p[3] = _mm256_unpackhi_epi64(t2, t3);
+}
+
+// Loads eight frames of |pairs| channel pairs as one vector per pair.
+inline void LoadPairs(const int16_t* src, int pairs, __m256i* p) {
+  __m256i r[4];
+  switch (pairs) {
+    case 1:
+      p[0] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+      break;
+    case 2: {
+      __m256i a = _mm256_shuffle_epi32(Load2x128(src, src + 16), 0xd8);
+      __m256i b = _mm256_shuffle_epi32(Load2x128(src + 8, src + 24), 0xd8);
+      p[0] = _mm256_unpacklo_epi64(a, b);
+      p[1] = _mm256_unpackhi_epi64(a, b);
+      break;
+    }
+    case 4:
+      for (int f = 0; f < 4; f++) r[f] = Load2x128(src + f * 8, src + (f + 4) * 8);
+      Transpose4x4(r, p);
+      break;
+    case 8:
+      for (int f = 0; f < 4; f++) r[f] = Load2x128(src + f * 16, src + (f + 4) * 16);
+      Transpose4x4(r, p);
+      for (int f = 0; f < 4; f++) r[f] = Load2x128(src + f * 16 + 8, src + (f + 4) * 16 + 8);
+      Transpose4x4(r, p + 4);
+      break;
+  }
+}
+
+inline __m256i Xorshift32(__m256i x) {
+  x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+  x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+  return _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+}
+
+inline __m256i TriangularNoise(__m256i r) {
+  const __m256i low_mask = _mm256_set1_epi32(0xffff);
+  const __m256i offset = _mm256_set1_epi32(65535);
+  return _mm256_sub_epi32(
+      _mm256_add_epi32(_mm256_and_si256(r, low_mask), _mm256_srli_epi32(r, 16)), offset);
+}
+
+inline __m256i S32ToS16x8(__m256i x, __m256i noise) {
+  const __m256i low_mask = _mm256_set1_epi32(0xffff);
+  const __m256i half = _mm256_set1_epi32(32768);
+  __m256i low = _mm256_add_epi32(_mm256_add_epi32(_mm256_and_si256(x, low_mask), noise), half);
+  return _mm256_add_epi32(_mm256_srai_epi32(x, 16), _mm256_srai_epi32(low, 16));
+}
+
+inline __m256i Load(const int16_t* src) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+}
+
+inline __m256i AddSaturate32(__m256i a, __m256i b) {
+  __m256i sum = _mm256_add_epi32(a, b);
+  __m256i overflow =
+      _mm256_srai_epi32(_mm256_and_si256(_mm256_xor_si256(a, sum), _mm256_xor_si256(b, sum)), 31);
+  __m256i limit = _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(0x7fffffff));
+  return _mm256_blendv_epi8(sum, limit, overflow);
+}
+
+}  // namespace
+
+void MixChannels_AVX2(const int16_t* src, int16_t* dst, const ChannelMatrix* matrix,
+                      int frames) {
+  const int src_channels = matrix->src_channels;
+  const int dst_channels = matrix->dst_channels;
+  if ((src_channels != 2 && src_channels != 4 && src_channels != 8 && src_channels != 16) ||
+      dst_channels > 2) {
+    MixChannels_C(src, dst, matrix, frames);
+    return;
+  }
+
+  const int pairs = src_channels / 2;
+  const __m256i round = _mm256_set1_epi32(1 << 13);
+  __m256i gains[2][kMaxAudioChannels / 2];
+  for (int o = 0; o < dst_channels; o++) {
+    for (int k = 0; k < pairs; k++) gains[o][k] = _mm256_set1_epi32(matrix->pair_gains[o][k]);
+  }
+
+  int f = 0;
+  for (; f + 8 <= frames; f += 8) {
+    __m256i p[kMaxAudioChannels / 2];
+    __m256i out[2];
+    LoadPairs(src, pairs, p);
+    for (int o = 0; o < dst_channels; o++) {
+      __m256i sum = round;
+      for (int j = 0; j < matrix->active_pair_count[o]; j++) {
+        int k = matrix->active_pairs[o][j];
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(p[k], gains[o][k]));
+      }
+      out[o] = _mm256_srai_epi32(sum, 14);
+    }
+
+    if (dst_channels == 2) {
+      __m256i packed = _mm256_packs_epi32(out[0], out[1]);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                          _mm256_unpacklo_epi16(packed, _mm256_bsrli_epi128(packed, 8)));
+    } else {
+      __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(out[0], out[0]), 0x08);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(packed));
+    }
+    src += 8 * src_channels;
+    dst += 8 * dst_channels;
+  }
+  MixChannels_SSE2(src, dst, matrix, frames - f);
+}
+
+// 16 samples per iteration; the eight dither generators advance twice.
+void S32ToS16_AVX2(const int32_t* src, int16_t* dst, uint32_t* dither_state, int count) {
+  __m256i state = _mm256_setzero_si256();
+  if (dither_state) state = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dither_state));
+
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256i noise0 = _mm256_setzero_si256();
+    __m256i noise1 = _mm256_setzero_si256();
+    if (dither_state) {
+      state = Xorshift32(state);
+      noise0 = TriangularNoise(state);
+      state = Xorshift32(state);
+      noise1 = TriangularNoise(state);
+    }
+    __m256i a = S32ToS16x8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), noise0);
+    __m256i b =
+        S32ToS16x8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 8)), noise1);
+    // packs works per 128-bit lane; restore sample order.
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xd8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+  }
+
+  if (dither_state) _mm256_storeu_si256(reinterpret_cast<__m256i*>(dither_state), state);
+  S32ToS16_SSE2(src + i, dst + i, dither_state, count - i);
+}
+
+void S32ToFloat_AVX2(const int32_t* src, float* dst, int count) {
+  const __m256 scale = _mm256_set1_ps(1.0f / 2147483648.0f);
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+  }
+  S32ToFloat_SSE2(src + i, dst + i, count - i);
+}
+
+void FloatToS32_AVX2(const float* src, int32_t* dst, int count) {
+  const __m256 scale = _mm256_set1_ps(2147483648.0f);
+  const __m256 max = _mm256_set1_ps(2147483520.0f);
+  const __m256 min = _mm256_set1_ps(-2147483648.0f);
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 value = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+    value = _mm256_max_ps(_mm256_min_ps(value, max), min);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_cvtps_epi32(value));
+  }
+  FloatToS32_SSE2(src + i, dst + i, count - i);
+}
+
+void PolyphaseS16_AVX2(const int16_t* src, const int16_t* bank, int taps,
+                       const int32_t* offsets, const int32_t* phases, int count, int16_t* dst,
+                       int dst_stride) {
+  for (int i = 0; i < count; i++) {
+    const int16_t* x = src + offsets[i];
+    const int16_t* h = bank + phases[i] * taps;
+    __m256i sum = _mm256_setzero_si256();
+    for (int k = 0; k < taps; k += 16) {
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(Load(x + k), Load(h + k)));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    __m128i value = _mm_srai_epi32(_mm_add_epi32(half, _mm_set1_epi32(1 << 14)), 15);
+    dst[i * dst_stride] = static_cast<int16_t>(_mm_cvtsi128_si32(_mm_packs_epi32(value, value)));
+  }
+}
+
+void PolyphaseFloat_AVX2(const float* src, const float* bank, int taps,
+                         const int32_t* offsets, const int32_t* phases, int count, float* dst,
+                         int dst_stride) {
+  for (int i = 0; i < count; i++) {
+    const float* x = src + offsets[i];
+    const float* h = bank + phases[i] * taps;
+    __m256 sum = _mm256_setzero_ps();
+    for (int k = 0; k < taps; k += 8) {
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(x + k), _mm256_loadu_ps(h + k)));
+    }
+    // Same lane order as PolyphaseFloat_C
+    __m128 t = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    t = _mm_add_ps(t, _mm_movehl_ps(t, t));
+    dst[i * dst_stride] =
+        _mm_cvtss_f32(_mm_add_ss(t, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1))));
+  }
+}
+
+void MeasureLevel_AVX2(const int16_t* src, int count, AudioLevel* level) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i peak = zero;
+  __m256i sum = zero;
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256i x = Load(src + i);
+    peak = _mm256_max_epi16(peak, _mm256_max_epi16(x, _mm256_subs_epi16(zero, x)));
+    __m256i squares = _mm256_madd_epi16(x, x);
+    sum = _mm256_add_epi64(sum, _mm256_unpacklo_epi32(squares, zero));
+    sum = _mm256_add_epi64(sum, _mm256_unpackhi_epi32(squares, zero));
+  }
+  __m128i peak128 = _mm_max_epi16(_mm256_castsi256_si128(peak), _mm256_extracti128_si256(peak, 1));
+  peak128 = _mm_max_epi16(peak128, _mm_shuffle_epi32(peak128, _MM_SHUFFLE(1, 0, 3, 2)));
+  peak128 = _mm_max_epi16(peak128, _mm_shuffle_epi32(peak128, _MM_SHUFFLE(2, 3, 0, 1)));
+  peak128 = _mm_max_epi16(peak128, _mm_shufflelo_epi16(peak128, _MM_SHUFFLE(2, 3, 0, 1)));
+  int vector_peak = _mm_extract_epi16(peak128, 0);
+  if (vector_peak > level->peak) level->peak = vector_peak;
+  __m128i sum128 = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  sum128 = _mm_add_epi64(sum128, _mm_unpackhi_epi64(sum128, sum128));
+  level->sum_squares += static_cast<uint64_t>(_mm_cvtsi128_si64(sum128));
+  MeasureLevel_SSE2(src + i, count - i, level);
+}
+
+// Sign-extending eight samples per vector keeps them in order, so the gains
+// are eight consecutive steps and the product is a plain 32-bit multiply.
+void AccumulateGain_AVX2(const int16_t* src, int32_t* acc, int32_t gain, int32_t gain_step,
+                         int count) {
+  const uint32_t g = static_cast<uint32_t>(gain);
+  const uint32_t step = static_cast<uint32_t>(gain_step);
+  __m256i gain0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(g)),
+                                   _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int32_t>(step)),
+                                                      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+  __m256i step8 = _mm256_set1_epi32(static_cast<int32_t>(8 * step));
+  __m256i gain1 = _mm256_add_epi32(gain0, step8);
+  __m256i step16 = _mm256_add_epi32(step8, step8);
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256i x0 = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+    __m256i x1 =
+        _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)));
+    __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+    _mm256_storeu_si256(a, AddSaturate32(_mm256_loadu_si256(a),
+                                         _mm256_mullo_epi32(x0, _mm256_srai_epi32(gain0, 16))));
+    _mm256_storeu_si256(a + 1, AddSaturate32(_mm256_loadu_si256(a + 1),
+                                             _mm256_mullo_epi32(x1, _mm256_srai_epi32(gain1, 16))));
+    gain0 = _mm256_add_epi32(gain0, step16);
+    gain1 = _mm256_add_epi32(gain1, step16);
+  }
+  AccumulateGain_SSE2(src + i, acc + i, static_cast<int32_t>(g + static_cast<uint32_t>(i) * step),
+                      gain_step, count - i);
+}
+
+void PackAccumulator_AVX2(const int32_t* acc, int16_t* dst, int count) {
+  const __m256i one = _mm256_set1_epi32(1);
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m256i* a = reinterpret_cast<const __m256i*>(acc + i);
+    __m256i lo =
+        _mm256_srai_epi32(_mm256_add_epi32(_mm256_srai_epi32(_mm256_loadu_si256(a), 13), one), 1);
+    __m256i hi = _mm256_srai_epi32(
+        _mm256_add_epi32(_mm256_srai_epi32(_mm256_loadu_si256(a + 1), 13), one), 1);
+    // packs works within 128-bit lanes; put the quarters back in order
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+  }
+  PackAccumulator_SSE2(acc + i, dst + i, count - i);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+// Kernels behind audio_convert.h. The SIMD variants live in their own
+// translation units, compiled for their instruction set with
+// "#pragma GCC target"; only call them through GetAudioKernels(), which
+// checks CpuSupportsIsa(). Variants that only cover some layouts fall back to
+// a narrower kernel for the others and for the frames left at the end.
+
+#include <stdint.h>
+
+#include "utils/audio_convert.h"
+#include "utils/cpu_features.h"
+
+typedef void (*MixChannelsFunc)(const int16_t* src, int16_t* dst,
+                                const ChannelMatrix* matrix, int frames);
+
+// |dither_state| points at AudioDither::state, or is null for plain rounding.
+typedef void (*S32ToS16Func)(const int32_t* src, int16_t* dst, uint32_t* dither_state,
+                             int count);
+typedef void (*S32ToFloatFunc)(const int32_t* src, float* dst, int count);
+typedef void (*FloatToS32Func)(const float* src, int32_t* dst, int count);
+// Folds |count| samples into |level|, which holds the running result.
+typedef void (*MeasureLevelFunc)(const int16_t* src, int count, AudioLevel* level);
+// Adds src[i] times the top 16 bits of the Q30 |gain| to acc[i] with 32-bit
+// saturation, |gain| moving by |gain_step| (modulo 2^32) after every sample.
+typedef void (*AccumulateGainFunc)(const int16_t* src, int32_t* acc, int32_t gain,
+                                   int32_t gain_step, int count);
+// Rounds a Q14 accumulator to 16-bit samples, saturating.
+typedef void (*PackAccumulatorFunc)(const int32_t* acc, int16_t* dst, int count);
+
+// One channel of a polyphase FIR: output i is the dot product of |taps|
+// samples at src + offsets[i] with filter phases[i] of |bank| (|taps|
+// coefficients per phase), written to dst[i * dst_stride]. |taps| is a
+// multiple of 16. The 16-bit variant takes Q15 coefficients and rounds and
+// saturates; the float variant accumulates in 8 lanes (tap k in lane k % 8)
+// and sums the lanes in a fixed order, so every ISA gives the same bits.
+typedef void (*PolyphaseS16Func)(const int16_t* src, const int16_t* bank, int taps,
+                                 const int32_t* offsets, const int32_t* phases, int count,
+                                 int16_t* dst, int dst_stride);
+typedef void (*PolyphaseFloatFunc)(const float* src, const float* bank, int taps,
+                                   const int32_t* offsets, const int32_t* phases, int count,
+                                   float* dst, int dst_stride);
+
+// One set of kernels per instruction set. Slots without a dedicated variant
+// for an ISA hold the next narrower one.
+struct AudioKernels {
+  CpuIsa isa;
+  MixChannelsFunc mix_channels;
+  S32ToS16Func s32_to_s16;
+  S32ToFloatFunc s32_to_float;
+  FloatToS32Func float_to_s32;
+  PolyphaseS16Func polyphase_s16;
+  PolyphaseFloatFunc polyphase_float;
+  MeasureLevelFunc measure_level;
+  AccumulateGainFunc accumulate_gain;
+  PackAccumulatorFunc pack_accumulator;
+};
+
+// Returns the kernels for |isa|, or nullptr if the CPU lacks |isa|.
+const AudioKernels* GetAudioKernels(CpuIsa isa);
+
+// The SIMD variants handle 2, 4, 8 or 16 input channels to 1 or 2 outputs,
+// the layouts a DeckLink capture is mixed to for sending.
+void MixChannels_C(const int16_t* src, int16_t* dst, const ChannelMatrix* matrix, int frames);
+void MixChannels_SSE2(const int16_t* src, int16_t* dst, const ChannelMatrix* matrix,
+                      int frames);
+void MixChannels_AVX2(const int16_t* src, int16_t* dst, const ChannelMatrix* matrix,
+                      int frames);
+
+void S32ToS16_C(const int32_t* src, int16_t* dst, uint32_t* dither_state, int count);
+void S32ToS16_SSE2(const int32_t* src, int16_t* dst, uint32_t* dither_state, int count);
+void S32ToS16_AVX2(const int32_t* src, int16_t* dst, uint32_t* dither_state, int count);
+
+void S32ToFloat_C(const int32_t* src, float* dst, int count);
+void S32ToFloat_SSE2(const int32_t* src, float* dst, int count);
+void S32ToFloat_AVX2(const int32_t* src, float* dst, int count);
+
+void FloatToS32_C(const float* src, int32_t* dst, int count);
+void FloatToS32_SSE2(const float* src, int32_t* dst, int count);
+void FloatToS32_AVX2(const float* src, int32_t* dst, int count);
+
+void MeasureLevel_C(const int16_t* src, int count, AudioLevel* level);
+void MeasureLevel_SSE2(const int16_t* src, int count, AudioLevel* level);
+void MeasureLevel_AVX2(const int16_t* src, int count, AudioLevel* level);
+
+void AccumulateGain_C(const int16_t* src, int32_t* acc, int32_t gain, int32_t gain_step,
+                      int count);
+void AccumulateGain_SSE2(const int16_t* src, int32_t* acc, int32_t gain, int32_t gain_step,
+                         int count);
+void AccumulateGain_AVX2(const int16_t* src, int32_t* acc, int32_t gain, int32_t gain_step,
+                         int count);
+
+void PackAccumulator_C(const int32_t* acc, int16_t* dst, int count);
+void PackAccumulator_SSE2(const int32_t* acc, int16_t* dst, int count);
+void PackAccumulator_AVX2(const int32_t* acc, int16_t* dst, int count);
+
+void PolyphaseS16_C(const int16_t* src, const int16_t* bank, int taps, const int32_t* offsets,
+                    const int32_t* phases, int count, int16_t* dst, int dst_stride);
+void PolyphaseS16_SSE2(const int16_t* src, const int16_t* bank, int taps,
+                       const int32_t* offsets, const int32_t* phases, int count, int16_t* dst,
+                       int dst_stride);
+void PolyphaseS16_AVX2(const int16_t* src, const int16_t* bank, int taps,
+                       const int32_t* offsets, const int32_t* phases, int count, int16_t* dst,
+                       int dst_stride);
+
+void PolyphaseFloat_C(const float* src, const float* bank, int taps, const int32_t* offsets,
+                      const int32_t* phases, int count, float* dst, int dst_stride);
+void PolyphaseFloat_SSE2(const float* src, const float* bank, int taps,
+                         const int32_t* offsets, const int32_t* phases, int count, float* dst,
+                         int dst_stride);
+void PolyphaseFloat_AVX2(const float* src, const float* bank, int taps,
+                         const int32_t* offsets, const int32_t* phases, int count, float* dst,
+                         int dst_stride);
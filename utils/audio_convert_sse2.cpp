@@ -0,0 +1,294 @@
+// SSE2 audio kernels. Keep this file free of STL includes: everything inlined
+// here is compiled for SSE2 and must not leak into other translation units.
+#pragma GCC target("sse2")
+
+#include <immintrin.h>
+
+#include "audio_convert_row.h"
+
+namespace {
+
+// Treating each pair of 16-bit channels as one 32-bit lane, a 4x4 transpose of
+// four frames gives one vector per channel pair holding those four frames.
+inline void Transpose4x4(const __m128i r[4], __m128i* p) {
+  __m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+  __m128i t1 = _mm_unpacklo_epi32(r[2], r[3]);
+  __m128i t2 = _mm_unpackhi_epi32(r[0], r[1]);
+  __m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+  p[0] = _mm_unpacklo_epi64(t0, t1);
+  p[1] = _mm_unpackhi_epi64(t0, t1);
+  p[2] = _mm_unpacklo_epi64(t2, t3);
+  p[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+inline __m128i Load(const int16_t* src) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+// Loads four frames of |pairs| channel pairs as one vector per pair.
+inline void LoadPairs(const int16_t* src, int pairs, __m128i* p) {
+  __m128i r[4];
+  switch (pairs) {
+    case 1:
+      p[0] = Load(src);
+      break;
+    case 2: {
+      __m128i a = _mm_shuffle_epi32(Load(src), 0xd8);
+      __m128i b = _mm_shuffle_epi32(Load(src + 8), 0xd8);
+      p[0] = _mm_unpacklo_epi64(a, b);
+      p[1] = _mm_unpackhi_epi64(a, b);
+      break;
+    }
+    case 4:
+      for (int f = 0; f < 4; f++) r[f] = Load(src + f * 8);
+      Transpose4x4(r, p);
+      break;
+    case 8:
+      for (int f = 0; f < 4; f++) r[f] = Load(src + f * 16);
+      Transpose4x4(r, p);
+      for (int f = 0; f < 4; f++) r[f] = Load(src + f * 16 + 8);
+      Transpose4x4(r, p + 4);
+      break;
+  }
+}
+
+// Advances four of the xorshift32 dither generators.
+inline __m128i Xorshift32(__m128i x) {
+  x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+  x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+  return _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+}
+
+// Four samples of S32ToS16, |noise| already triangular.
+inline __m128i S32ToS16x4(__m128i x, __m128i noise) {
+  const __m128i low_mask = _mm_set1_epi32(0xffff);
+  const __m128i half = _mm_set1_epi32(32768);
+  __m128i low = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(x, low_mask), noise), half);
+  return _mm_add_epi32(_mm_srai_epi32(x, 16), _mm_srai_epi32(low, 16));
+}
+
+inline __m128i TriangularNoise(__m128i r) {
+  const __m128i low_mask = _mm_set1_epi32(0xffff);
+  const __m128i offset = _mm_set1_epi32(65535);
+  return _mm_sub_epi32(_mm_add_epi32(_mm_and_si128(r, low_mask), _mm_srli_epi32(r, 16)), offset);
+}
+
+// Horizontal sum of four 32-bit lanes.
+inline int32_t SumLanes(__m128i x) {
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(x);
+}
+
+// Sums lanes 0-3 in |lo| and 4-7 in |hi| in the order of PolyphaseFloat_C.
+inline float SumLanes(__m128 lo, __m128 hi) {
+  __m128 t = _mm_add_ps(lo, hi);          // 0+4 1+5 2+6 3+7
+  t = _mm_add_ps(t, _mm_movehl_ps(t, t));  // even odd
+  return _mm_cvtss_f32(_mm_add_ss(t, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+
+// a + b, or the int32 limit on the side of a where the sum overflowed.
+inline __m128i AddSaturate32(__m128i a, __m128i b) {
+  __m128i sum = _mm_add_epi32(a, b);
+  __m128i overflow =
+      _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(a, sum), _mm_xor_si128(b, sum)), 31);
+  __m128i limit = _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(0x7fffffff));
+  return _mm_or_si128(_mm_and_si128(overflow, limit), _mm_andnot_si128(overflow, sum));
+}
+
+}  // namespace
+
+// Four frames per iteration: every output is a sum of pmaddwd products of a
+// channel-pair vector and that pair's two gains.
+void MixChannels_SSE2(const int16_t* src, int16_t* dst, const ChannelMatrix* matrix,
+                      int frames) {
+  const int src_channels = matrix->src_channels;
+  const int dst_channels = matrix->dst_channels;
+  if ((src_channels != 2 && src_channels != 4 && src_channels != 8 && src_channels != 16) ||
+      dst_channels > 2) {
+    MixChannels_C(src, dst, matrix, frames);
+    return;
+  }
+
+  const int pairs = src_channels / 2;
+  const __m128i round = _mm_set1_epi32(1 << 13);
+  __m128i gains[2][kMaxAudioChannels / 2];
+  for (int o = 0; o < dst_channels; o++) {
+    for (int k = 0; k < pairs; k++) gains[o][k] = _mm_set1_epi32(matrix->pair_gains[o][k]);
+  }
+
+  int f = 0;
+  for (; f + 4 <= frames; f += 4) {
+    __m128i p[kMaxAudioChannels / 2];
+    __m128i out[2];
+    LoadPairs(src, pairs, p);
+    for (int o = 0; o < dst_channels; o++) {
+      __m128i sum = round;
+      for (int j = 0; j < matrix->active_pair_count[o]; j++) {
+        int k = matrix->active_pairs[o][j];
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(p[k], gains[o][k]));
+      }
+      out[o] = _mm_srai_epi32(sum, 14);
+    }
+
+    if (dst_channels == 2) {
+      __m128i packed = _mm_packs_epi32(out[0], out[1]);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                       _mm_unpacklo_epi16(packed, _mm_srli_si128(packed, 8)));
+    } else {
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packs_epi32(out[0], out[0]));
+    }
+    src += 4 * src_channels;
+    dst += 4 * dst_channels;
+  }
+  MixChannels_C(src, dst, matrix, frames - f);
+}
+
+// Eight samples per iteration, one per dither generator.
+void S32ToS16_SSE2(const int32_t* src, int16_t* dst, uint32_t* dither_state, int count) {
+  __m128i state0 = _mm_setzero_si128();
+  __m128i state1 = _mm_setzero_si128();
+  if (dither_state) {
+    state0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither_state));
+    state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither_state + 4));
+  }
+
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i noise0 = _mm_setzero_si128();
+    __m128i noise1 = _mm_setzero_si128();
+    if (dither_state) {
+      state0 = Xorshift32(state0);
+      state1 = Xorshift32(state1);
+      noise0 = TriangularNoise(state0);
+      noise1 = TriangularNoise(state1);
+    }
+    __m128i a = S32ToS16x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), noise0);
+    __m128i b = S32ToS16x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4)), noise1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(a, b));
+  }
+
+  if (dither_state) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither_state), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither_state + 4), state1);
+  }
+  S32ToS16_C(src + i, dst + i, dither_state, count - i);
+}
+
+void S32ToFloat_SSE2(const int32_t* src, float* dst, int count) {
+  const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+  }
+  S32ToFloat_C(src + i, dst + i, count - i);
+}
+
+void FloatToS32_SSE2(const float* src, int32_t* dst, int count) {
+  const __m128 scale = _mm_set1_ps(2147483648.0f);
+  const __m128 max = _mm_set1_ps(2147483520.0f);
+  const __m128 min = _mm_set1_ps(-2147483648.0f);
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 value = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+    value = _mm_max_ps(_mm_min_ps(value, max), min);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_cvtps_epi32(value));
+  }
+  FloatToS32_C(src + i, dst + i, count - i);
+}
+
+void PolyphaseS16_SSE2(const int16_t* src, const int16_t* bank, int taps,
+                       const int32_t* offsets, const int32_t* phases, int count, int16_t* dst,
+                       int dst_stride) {
+  for (int i = 0; i < count; i++) {
+    const int16_t* x = src + offsets[i];
+    const int16_t* h = bank + phases[i] * taps;
+    __m128i sum = _mm_setzero_si128();
+    for (int k = 0; k < taps; k += 8) {
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(Load(x + k), Load(h + k)));
+    }
+    __m128i value = _mm_cvtsi32_si128((SumLanes(sum) + (1 << 14)) >> 15);
+    dst[i * dst_stride] = static_cast<int16_t>(_mm_cvtsi128_si32(_mm_packs_epi32(value, value)));
+  }
+}
+
+void PolyphaseFloat_SSE2(const float* src, const float* bank, int taps,
+                         const int32_t* offsets, const int32_t* phases, int count, float* dst,
+                         int dst_stride) {
+  for (int i = 0; i < count; i++) {
+    const float* x = src + offsets[i];
+    const float* h = bank + phases[i] * taps;
+    __m128 lo = _mm_setzero_ps();
+    __m128 hi = _mm_setzero_ps();
+    for (int k = 0; k < taps; k += 8) {
+      lo = _mm_add_ps(lo, _mm_mul_ps(_mm_loadu_ps(x + k), _mm_loadu_ps(h + k)));
+      hi = _mm_add_ps(hi, _mm_mul_ps(_mm_loadu_ps(x + k + 4), _mm_loadu_ps(h + k + 4)));
+    }
+    dst[i * dst_stride] = SumLanes(lo, hi);
+  }
+}
+
+// A pair of squares can reach 2^31, so the madd results are widened as
+// unsigned into 64-bit lanes.
+void MeasureLevel_SSE2(const int16_t* src, int count, AudioLevel* level) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i peak = zero;
+  __m128i sum = zero;
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i x = Load(src + i);
+    peak = _mm_max_epi16(peak, _mm_max_epi16(x, _mm_subs_epi16(zero, x)));
+    __m128i squares = _mm_madd_epi16(x, x);
+    sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(squares, zero));
+    sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(squares, zero));
+  }
+  peak = _mm_max_epi16(peak, _mm_shuffle_epi32(peak, _MM_SHUFFLE(1, 0, 3, 2)));
+  peak = _mm_max_epi16(peak, _mm_shuffle_epi32(peak, _MM_SHUFFLE(2, 3, 0, 1)));
+  peak = _mm_max_epi16(peak, _mm_shufflelo_epi16(peak, _MM_SHUFFLE(2, 3, 0, 1)));
+  int vector_peak = _mm_extract_epi16(peak, 0);
+  if (vector_peak > level->peak) level->peak = vector_peak;
+  sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+  level->sum_squares += static_cast<uint64_t>(_mm_cvtsi128_si64(sum));
+  MeasureLevel_C(src + i, count - i, level);
+}
+
+// Samples are widened to (x, 0) pairs so that madd with the Q14 gain in the
+// low half of each 32-bit lane gives the full product.
+void AccumulateGain_SSE2(const int16_t* src, int32_t* acc, int32_t gain, int32_t gain_step,
+                         int count) {
+  const __m128i zero = _mm_setzero_si128();
+  const uint32_t g = static_cast<uint32_t>(gain);
+  const uint32_t step = static_cast<uint32_t>(gain_step);
+  __m128i gain_lo = _mm_setr_epi32(static_cast<int32_t>(g), static_cast<int32_t>(g + step),
+                                   static_cast<int32_t>(g + 2 * step),
+                                   static_cast<int32_t>(g + 3 * step));
+  __m128i step4 = _mm_set1_epi32(static_cast<int32_t>(4 * step));
+  __m128i step8 = _mm_add_epi32(step4, step4);
+  __m128i gain_hi = _mm_add_epi32(gain_lo, step4);
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i x = Load(src + i);
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(x, zero), _mm_srai_epi32(gain_lo, 16));
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(x, zero), _mm_srai_epi32(gain_hi, 16));
+    __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+    _mm_storeu_si128(a, AddSaturate32(_mm_loadu_si128(a), lo));
+    _mm_storeu_si128(a + 1, AddSaturate32(_mm_loadu_si128(a + 1), hi));
+    gain_lo = _mm_add_epi32(gain_lo, step8);
+    gain_hi = _mm_add_epi32(gain_hi, step8);
+  }
+  AccumulateGain_C(src + i, acc + i, static_cast<int32_t>(g + static_cast<uint32_t>(i) * step),
+                   gain_step, count - i);
+}
+
+void PackAccumulator_SSE2(const int32_t* acc, int16_t* dst, int count) {
+  const __m128i one = _mm_set1_epi32(1);
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i* a = reinterpret_cast<const __m128i*>(acc + i);
+    __m128i lo = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(_mm_loadu_si128(a), 13), one), 1);
+    __m128i hi = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(_mm_loadu_si128(a + 1), 13), one), 1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(lo, hi));
+  }
+  PackAccumulator_C(acc + i, dst + i, count - i);
+}
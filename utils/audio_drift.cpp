@@ -0,0 +1,128 @@
+#include "audio_drift.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// Timestamps further than this from where the frame count puts them mean the
+// stream was interrupted, not that the clock drifted.
+static const int64_t kDiscontinuityMs = 100;
+
+// Real clocks are within a few hundred ppm; anything beyond this is a bad fit.
+static const double kMaxDriftPpm = 2000.0;
+
+AudioDriftEstimator::AudioDriftEstimator()
+    : nominal_rate_(48000),
+      interval_ms_(1000),
+      window_points_(0),
+      min_points_(0),
+      next_point_(0),
+      point_count_(0),
+      started_(false),
+      frames_(0),
+      origin_ms_(0),
+      expected_ms_(0),
+      interval_end_ms_(0),
+      interval_timestamp_sum_(0),
+      interval_frames_sum_(0),
+      interval_packets_(0),
+      drift_ppb_(0),
+      has_estimate_(false) {}
+
+void AudioDriftEstimator::Init(int nominal_rate, int interval_ms, int window_points) {
+  nominal_rate_ = nominal_rate > 0 ? nominal_rate : 48000;
+  interval_ms_ = interval_ms > 0 ? interval_ms : 1000;
+  window_points_ = window_points >= 2 ? static_cast<size_t>(window_points) : 2;
+  // A slope over less than ten intervals is mostly timestamp noise
+  min_points_ = window_points_ < 10 ? window_points_ : 10;
+  points_.assign(window_points_, Point());
+  Reset();
+}
+
+void AudioDriftEstimator::Reset() {
+  next_point_ = 0;
+  point_count_ = 0;
+  started_ = false;
+  frames_ = 0;
+  origin_ms_ = 0;
+  expected_ms_ = 0;
+  interval_end_ms_ = 0;
+  interval_timestamp_sum_ = 0;
+  interval_frames_sum_ = 0;
+  interval_packets_ = 0;
+  drift_ppb_.store(0, std::memory_order_relaxed);
+  has_estimate_.store(false, std::memory_order_release);
+}
+
+void AudioDriftEstimator::AddPacket(int64_t timestamp_ms, size_t frame_count) {
+  if (points_.empty()) return;
+
+  if (started_ && llabs(timestamp_ms - expected_ms_) > kDiscontinuityMs) Reset();
+
+  if (!started_) {
+    started_ = true;
+    origin_ms_ = timestamp_ms;
+    interval_end_ms_ = timestamp_ms + interval_ms_;
+  }
+
+  if (timestamp_ms >= interval_end_ms_ && interval_packets_ > 0) {
+    Point& point = points_[next_point_];
+    point.timestamp_ms = interval_timestamp_sum_ / interval_packets_;
+    point.frames = interval_frames_sum_ / interval_packets_;
+    next_point_ = (next_point_ + 1) % window_points_;
+    if (point_count_ < window_points_) point_count_++;
+    interval_timestamp_sum_ = 0;
+    interval_frames_sum_ = 0;
+    interval_packets_ = 0;
+    interval_end_ms_ += interval_ms_;
+    // Catch up after a gap shorter than the discontinuity threshold
+    if (interval_end_ms_ <= timestamp_ms) interval_end_ms_ = timestamp_ms + interval_ms_;
+    if (point_count_ >= min_points_) Fit();
+  }
+
+  // Each packet pairs the timestamp of its first frame with the number of
+  // frames captured before it
+  interval_timestamp_sum_ += static_cast<double>(timestamp_ms - origin_ms_);
+  interval_frames_sum_ += static_cast<double>(frames_);
+  interval_packets_++;
+
+  frames_ += frame_count;
+  expected_ms_ = timestamp_ms + static_cast<int64_t>(frame_count) * 1000 / nominal_rate_;
+}
+
+void AudioDriftEstimator::Fit() {
+  size_t oldest = (next_point_ + window_points_ - point_count_) % window_points_;
+  double mean_t = 0;
+  double mean_n = 0;
+  for (size_t i = 0; i < point_count_; i++) {
+    const Point& point = points_[(oldest + i) % window_points_];
+    mean_t += point.timestamp_ms;
+    mean_n += point.frames;
+  }
+  mean_t /= point_count_;
+  mean_n /= point_count_;
+
+  double stt = 0;
+  double stn = 0;
+  for (size_t i = 0; i < point_count_; i++) {
+    const Point& point = points_[(oldest + i) % window_points_];
+    double t = point.timestamp_ms - mean_t;
+    double n = point.frames - mean_n;
+    stt += t * t;
+    stn += t * n;
+  }
+  if (stt <= 0) return;
+
+  // Frames per millisecond against the nominal rate
+  double ppm = (stn / stt * 1000.0 / nominal_rate_ - 1.0) * 1e6;
+  if (fabs(ppm) > kMaxDriftPpm) {
+    Reset();
+    return;
+  }
+  drift_ppb_.store(llrint(ppm * 1000.0), std::memory_order_relaxed);
+  has_estimate_.store(true, std::memory_order_release);
+}
+
+double AudioDriftEstimator::DriftPpm() const {
+  if (!HasEstimate()) return 0;
+  return static_cast<double>(drift_ppb_.load(std::memory_order_relaxed)) / 1000.0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+// Estimates how fast a capture audio clock runs against the reference clock
+// its packets are timestamped on, from the number of frames captured versus
+// the elapsed reference time.
+//
+// The producer feeds every packet. Packet timestamps and running frame counts
+// are averaged over each |interval_ms| into one point, and the rate is the
+// least squares slope over the last |window_points| points. Averaging within
+// an interval and fitting over a long window remove both timestamp rounding
+// and the jitter of packets that arrive in bursts at the video frame rate. A
+// timestamp that disagrees with the frame count by more than a packet or so
+// (signal loss, format change) restarts the estimate.
+//
+// AddPacket() is for a single producer thread; DriftPpm() may be read from
+// any thread.
+class AudioDriftEstimator {
+ public:
+  AudioDriftEstimator();
+
+  AudioDriftEstimator(const AudioDriftEstimator&) = delete;
+  AudioDriftEstimator& operator=(const AudioDriftEstimator&) = delete;
+
+  // Must not run concurrently with AddPacket().
+  void Init(int nominal_rate, int interval_ms = 1000, int window_points = 120);
+  void Reset();
+
+  // |frame_count| frames whose first frame was captured at |timestamp_ms|.
+  void AddPacket(int64_t timestamp_ms, size_t frame_count);
+
+  // True once the window spans enough intervals for a usable slope.
+  bool HasEstimate() const { return has_estimate_.load(std::memory_order_acquire); }
+
+  // Capture rate error in parts per million of the nominal rate, positive
+  // when the capture clock runs fast. 0 without an estimate.
+  double DriftPpm() const;
+
+ private:
+  // Relative to the first packet since Reset()
+  struct Point {
+    double timestamp_ms;
+    double frames;
+  };
+
+  void Fit();
+
+  int nominal_rate_;
+  int interval_ms_;
+  size_t window_points_;
+  size_t min_points_;
+
+  // Producer thread only
+  std::vector<Point> points_;
+  size_t next_point_;
+  size_t point_count_;
+  bool started_;
+  uint64_t frames_;
+  int64_t origin_ms_;
+  int64_t expected_ms_;  // Timestamp the next packet should carry
+  int64_t interval_end_ms_;
+  double interval_timestamp_sum_;
+  double interval_frames_sum_;
+  int interval_packets_;
+
+  std::atomic<int64_t> drift_ppb_;
+  std::atomic<bool> has_estimate_;
+};
@@ -0,0 +1,133 @@
+#include "audio_mixer.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "audio_convert.h"
+
+const int AudioMixer::kMaxInputs;
+const int AudioMixer::kProgramInput;
+
+static const int kAlignment = 64;
+
+// Largest gain the Q30 format holds, just under 2.0.
+static const double kMaxGain = 2147483647.0 / kAudioGainUnity;
+
+static uint64_t PackGainRequest(int32_t gain, int ramp_chunks) {
+  return static_cast<uint32_t>(gain) | (static_cast<uint64_t>(ramp_chunks) << 32);
+}
+
+AudioMixer::AudioMixer()
+    : channels_(0), chunk_frames_(0), chunk_ms_(0), inputs_(0), slipped_chunks_(0) {
+  ResetGains();
+}
+
+bool AudioMixer::Init(int channels, int sample_rate, int chunk_frames, int inputs,
+                      int ring_chunks) {
+  if (channels < 1 || chunk_frames < 1 || sample_rate < 1 || inputs < 0 || inputs > kMaxInputs) {
+    return false;
+  }
+  for (int i = 0; i < inputs; i++) {
+    if (!rings_[i].Init(channels, sizeof(int16_t), sample_rate, chunk_frames, ring_chunks)) {
+      return false;
+    }
+  }
+  accumulator_.reset(AlignedMalloc<int32_t>(
+      static_cast<size_t>(chunk_frames) * channels * sizeof(int32_t), kAlignment));
+  if (!accumulator_) return false;
+
+  channels_ = channels;
+  chunk_frames_ = chunk_frames;
+  chunk_ms_ = static_cast<int>(static_cast<int64_t>(chunk_frames) * 1000 / sample_rate);
+  inputs_ = inputs;
+  ResetGains();
+  slipped_chunks_.store(0, std::memory_order_relaxed);
+  return true;
+}
+
+void AudioMixer::ResetGains() {
+  for (Gain& gain : gains_) {
+    gain.applied_request = PackGainRequest(kAudioGainUnity, 1);
+    gain.request.store(gain.applied_request, std::memory_order_relaxed);
+    gain.current = kAudioGainUnity;
+    gain.target = kAudioGainUnity;
+    gain.remaining_chunks = 0;
+  }
+}
+
+size_t AudioMixer::Write(int input, const int16_t* samples, size_t frames,
+                         int64_t timestamp_ms) {
+  if (input < 1 || input > inputs_) return 0;
+  return rings_[input - 1].Write(samples, frames, timestamp_ms);
+}
+
+void AudioMixer::SetGain(int input, double gain, int ramp_ms) {
+  if (input < kProgramInput || input > kMaxInputs) return;
+  if (gain > kMaxGain) gain = kMaxGain;
+  if (gain < -2.0) gain = -2.0;
+  int ramp_chunks = chunk_ms_ > 0 ? (ramp_ms + chunk_ms_ - 1) / chunk_ms_ : 1;
+  if (ramp_chunks < 1) ramp_chunks = 1;
+  gains_[input].request.store(
+      PackGainRequest(static_cast<int32_t>(llround(gain * kAudioGainUnity)), ramp_chunks),
+      std::memory_order_relaxed);
+}
+
+// Spreads what is left of a ramp evenly over its remaining chunks. The last
+// chunk ends within a rounding step of the target, which then applies as is.
+int32_t AudioMixer::NextGainRamp(Gain* gain, int32_t* step) {
+  uint64_t request = gain->request.load(std::memory_order_relaxed);
+  if (request != gain->applied_request) {
+    gain->applied_request = request;
+    gain->target = static_cast<int32_t>(static_cast<uint32_t>(request));
+    gain->remaining_chunks = static_cast<int>(request >> 32);
+  }
+
+  int32_t start = gain->current;
+  *step = 0;
+  if (gain->remaining_chunks == 0) return start;
+
+  const int count = chunk_frames_ * channels_;
+  int64_t chunk_delta = (static_cast<int64_t>(gain->target) - start) / gain->remaining_chunks;
+  *step = static_cast<int32_t>(chunk_delta / count);
+  if (--gain->remaining_chunks == 0) {
+    gain->current = gain->target;
+  } else {
+    gain->current = static_cast<int32_t>(start + static_cast<int64_t>(*step) * count);
+  }
+  return start;
+}
+
+void AudioMixer::Mix(const int16_t* program, int64_t timestamp_ms, int16_t* dst) {
+  const int count = chunk_frames_ * channels_;
+  const int64_t half_chunk_ms = chunk_ms_ / 2;
+  int32_t* accumulator = accumulator_.get();
+  int32_t gain;
+  int32_t step;
+
+  memset(accumulator, 0, static_cast<size_t>(count) * sizeof(int32_t));
+  gain = NextGainRamp(&gains_[kProgramInput], &step);
+  AccumulateAudio(program, accumulator, count, gain, step);
+
+  for (int i = 0; i < inputs_; i++) {
+    AudioRing& ring = rings_[i];
+    const void* chunk;
+    int64_t chunk_timestamp_ms;
+
+    // Ramps run on whether or not the input has audio right now
+    gain = NextGainRamp(&gains_[i + 1], &step);
+
+    while ((chunk = ring.PeekChunk(&chunk_timestamp_ms)) != nullptr &&
+           chunk_timestamp_ms < timestamp_ms - half_chunk_ms) {
+      ring.ConsumeChunk();
+      slipped_chunks_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (chunk == nullptr || chunk_timestamp_ms >= timestamp_ms + chunk_ms_ - half_chunk_ms) {
+      continue;
+    }
+
+    AccumulateAudio(static_cast<const int16_t*>(chunk), accumulator, count, gain, step);
+    ring.ConsumeChunk();
+  }
+
+  PackAudioAccumulator(accumulator, dst, count);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+
+#include "aligned_alloc.h"
+#include "audio_ring.h"
+
+// Mixes program audio with a few further inputs captured elsewhere, such as
+// an announcer microphone on a second DeckLink input.
+//
+// Each extra input is written by its own capture thread into an AudioRing of
+// 16-bit chunks, stamped on a clock shared with the program. Mix() takes one
+// program chunk and, per input, the chunk captured within half a chunk of it:
+// older chunks are dropped and an input running ahead sits out until the
+// program catches up, so inputs on unlocked clocks slip by a whole chunk once
+// they drift half a chunk apart. Every input, the program included, has a
+// gain that ramps linearly, sample by sample, to a new target. The sum is
+// accumulated in 32 bits with saturation and rounded to 16 bits once.
+class AudioMixer {
+ public:
+  static const int kMaxInputs = 4;   // Extra inputs besides the program
+  static const int kProgramInput = 0;
+
+  AudioMixer();
+
+  AudioMixer(const AudioMixer&) = delete;
+  AudioMixer& operator=(const AudioMixer&) = delete;
+
+  // |inputs| extra inputs of |channels| interleaved 16-bit channels, each
+  // buffering up to |ring_chunks| chunks. Resets all gains to unity. Must not
+  // run concurrently with the other calls.
+  bool Init(int channels, int sample_rate, int chunk_frames, int inputs, int ring_chunks);
+
+  int inputs() const { return inputs_; }
+  int channels() const { return channels_; }
+
+  // Capture thread of extra input |input|, 1 to inputs(). |timestamp_ms| is
+  // the capture time of the first frame on the shared clock.
+  size_t Write(int input, const int16_t* samples, size_t frames, int64_t timestamp_ms);
+
+  // Any thread. Moves the gain of |input|, or of the program for
+  // kProgramInput, to the linear |gain| over |ramp_ms|, at least one chunk.
+  void SetGain(int input, double gain, int ramp_ms);
+
+  // Mixing thread. Writes one chunk: |program| captured at |timestamp_ms|
+  // plus the extra inputs' audio from the same time. |dst| may be |program|.
+  void Mix(const int16_t* program, int64_t timestamp_ms, int16_t* dst);
+
+  // Extra input chunks dropped because they were captured too early.
+  uint64_t SlippedChunks() const { return slipped_chunks_.load(std::memory_order_relaxed); }
+
+ private:
+  // Requests pack the Q30 target gain in the low and the ramp length in
+  // chunks in the high 32 bits, so a new one is picked up atomically.
+  struct Gain {
+    std::atomic<uint64_t> request;
+    uint64_t applied_request;  // Mixing thread only, as are the rest
+    int32_t current;
+    int32_t target;
+    int remaining_chunks;
+  };
+
+  void ResetGains();
+  int32_t NextGainRamp(Gain* gain, int32_t* step);
+
+  int channels_;
+  int chunk_frames_;
+  int chunk_ms_;
+  int inputs_;
+  AudioRing rings_[kMaxInputs];
+  Gain gains_[kMaxInputs + 1];
+  std::unique_ptr<int32_t, AlignedFreeDeleter> accumulator_;
+  std::atomic<uint64_t> slipped_chunks_;
+};
@@ -0,0 +1,212 @@
+#include "audio_resampler.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "audio_convert.h"
+#include "audio_convert_row.h"
+
+const int PolyphaseResampler::kMaxPhases;
+const int PolyphaseResampler::kBlockFrames;
+
+static const int kAlignment = 64;
+static const int kMaxTaps = 512;
+// Q15; the filter peak stays below 1.0, so no tap reaches 32768.
+static const int kCoefficientOne = 1 << 15;
+
+// Kaiser window for about 90 dB of stopband attenuation.
+static const double kStopbandDb = 90.0;
+static const double kKaiserBeta = 0.1102 * (kStopbandDb - 8.7);
+
+static int GreatestCommonDivisor(int a, int b) {
+  while (b != 0) {
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// Zeroth order modified Bessel function of the first kind.
+static double BesselI0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 64; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < sum * 1e-17) break;
+  }
+  return sum;
+}
+
+static double Sinc(double x) {
+  if (fabs(x) < 1e-12) return 1.0;
+  return sin(M_PI * x) / (M_PI * x);
+}
+
+PolyphaseResampler::PolyphaseResampler()
+    : input_rate_(0),
+      output_rate_(0),
+      channels_(0),
+      taps_(0),
+      up_(1),
+      down_(1),
+      kernels_(nullptr),
+      history_stride_(0),
+      position_(0),
+      phase_(0) {}
+
+bool PolyphaseResampler::Init(int input_rate, int output_rate, int channels, int taps,
+                              const AudioKernels* kernels) {
+  if (input_rate <= 0 || output_rate <= 0 || channels < 1 || channels > kMaxAudioChannels ||
+      taps < 16 || taps > 256 || taps % 16 != 0) {
+    return false;
+  }
+  int divisor = GreatestCommonDivisor(input_rate, output_rate);
+  if (output_rate / divisor > kMaxPhases) return false;
+
+  if (!kernels) kernels = GetAudioKernels(GetBestCpuIsa());
+  input_rate_ = input_rate;
+  output_rate_ = output_rate;
+  channels_ = channels;
+  up_ = output_rate / divisor;
+  down_ = input_rate / divisor;
+  kernels_ = kernels;
+
+  // When decimating, the filter has to span proportionally more input
+  // frames for the same transition band
+  if (down_ > up_) taps = (taps * down_ + up_ - 1) / up_;
+  taps = (taps + 15) / 16 * 16;
+  taps_ = taps < kMaxTaps ? taps : kMaxTaps;
+
+  size_t bank_size = static_cast<size_t>(up_) * taps_;
+  bank_s16_.reset(AlignedMalloc<int16_t>(bank_size * sizeof(int16_t), kAlignment));
+  bank_float_.reset(AlignedMalloc<float>(bank_size * sizeof(float), kAlignment));
+  history_stride_ = (taps_ - 1 + kBlockFrames + 15) / 16 * 16;
+  size_t history_size = static_cast<size_t>(history_stride_) * channels_;
+  history_s16_.reset(AlignedMalloc<int16_t>(history_size * sizeof(int16_t), kAlignment));
+  history_float_.reset(AlignedMalloc<float>(history_size * sizeof(float), kAlignment));
+  if (!bank_s16_ || !bank_float_ || !history_s16_ || !history_float_) return false;
+
+  offsets_.assign(MaxOutputFrames(kBlockFrames), 0);
+  phases_.assign(offsets_.size(), 0);
+  DesignFilter();
+  Reset();
+  return true;
+}
+
+void PolyphaseResampler::Reset() {
+  size_t history_size = static_cast<size_t>(history_stride_) * channels_;
+  if (history_s16_) memset(history_s16_.get(), 0, history_size * sizeof(int16_t));
+  if (history_float_) memset(history_float_.get(), 0, history_size * sizeof(float));
+  position_ = taps_ - 1;
+  phase_ = 0;
+}
+
+// Phase p, tap k sits at t = taps / 2 - 1 - k + p / L input frames from the
+// output instant. Each phase is normalized to unity gain; the Q15 copy puts
+// its rounding error on the largest tap so DC passes exactly.
+void PolyphaseResampler::DesignFilter() {
+  double half = taps_ / 2.0;
+  double ratio = up_ < down_ ? static_cast<double>(up_) / down_ : 1.0;
+  double transition = (kStopbandDb - 7.95) / (14.36 * taps_);
+  double cutoff = 0.5 * ratio - transition / 2;
+  if (cutoff < 0.25 * ratio) cutoff = 0.25 * ratio;
+  double window_scale = 1.0 / BesselI0(kKaiserBeta);
+  std::vector<double> phase(taps_);
+
+  for (int p = 0; p < up_; p++) {
+    double sum = 0;
+    for (int k = 0; k < taps_; k++) {
+      double t = half - 1 - k + static_cast<double>(p) / up_;
+      double x = t / half;
+      double window = x >= 1.0 || x <= -1.0
+                          ? 0.0
+                          : BesselI0(kKaiserBeta * sqrt(1.0 - x * x)) * window_scale;
+      phase[k] = 2 * cutoff * Sinc(2 * cutoff * t) * window;
+      sum += phase[k];
+    }
+
+    float* bank_float = bank_float_.get() + static_cast<size_t>(p) * taps_;
+    int16_t* bank_s16 = bank_s16_.get() + static_cast<size_t>(p) * taps_;
+    int total = 0;
+    int largest = 0;
+    for (int k = 0; k < taps_; k++) {
+      bank_float[k] = static_cast<float>(phase[k] / sum);
+      bank_s16[k] = static_cast<int16_t>(lrint(phase[k] / sum * kCoefficientOne));
+      total += bank_s16[k];
+      if (bank_s16[k] > bank_s16[largest]) largest = k;
+    }
+    bank_s16[largest] += kCoefficientOne - total;
+  }
+}
+
+int PolyphaseResampler::MaxOutputFrames(int input_frames) const {
+  return static_cast<int>((static_cast<int64_t>(input_frames) * up_ + down_ - 1) / down_) + 1;
+}
+
+// Lists the outputs whose newest tap falls in the block just appended to the
+// history, then rebases the position for the next block.
+int PolyphaseResampler::PlanBlock(int block_frames) {
+  int newest = taps_ - 2 + block_frames;
+  int count = 0;
+  while (position_ <= newest) {
+    offsets_[count] = position_ - (taps_ - 1);
+    phases_[count] = phase_;
+    count++;
+    phase_ += down_;
+    position_ += phase_ / up_;
+    phase_ %= up_;
+  }
+  position_ -= block_frames;
+  return count;
+}
+
+int PolyphaseResampler::Process(const int16_t* src, int input_frames, int16_t* dst) {
+  int written = 0;
+  while (input_frames > 0) {
+    int block = input_frames < kBlockFrames ? input_frames : kBlockFrames;
+    for (int c = 0; c < channels_; c++) {
+      int16_t* history = history_s16_.get() + static_cast<size_t>(c) * history_stride_;
+      for (int f = 0; f < block; f++) history[taps_ - 1 + f] = src[f * channels_ + c];
+    }
+
+    int count = PlanBlock(block);
+    for (int c = 0; c < channels_; c++) {
+      int16_t* history = history_s16_.get() + static_cast<size_t>(c) * history_stride_;
+      kernels_->polyphase_s16(history, bank_s16_.get(), taps_, offsets_.data(), phases_.data(),
+                              count, dst + written * channels_ + c, channels_);
+      memmove(history, history + block, (taps_ - 1) * sizeof(int16_t));
+    }
+
+    written += count;
+    src += block * channels_;
+    input_frames -= block;
+  }
+  return written;
+}
+
+int PolyphaseResampler::Process(const float* src, int input_frames, float* dst) {
+  int written = 0;
+  while (input_frames > 0) {
+    int block = input_frames < kBlockFrames ? input_frames : kBlockFrames;
+    for (int c = 0; c < channels_; c++) {
+      float* history = history_float_.get() + static_cast<size_t>(c) * history_stride_;
+      for (int f = 0; f < block; f++) history[taps_ - 1 + f] = src[f * channels_ + c];
+    }
+
+    int count = PlanBlock(block);
+    for (int c = 0; c < channels_; c++) {
+      float* history = history_float_.get() + static_cast<size_t>(c) * history_stride_;
+      kernels_->polyphase_float(history, bank_float_.get(), taps_, offsets_.data(),
+                                phases_.data(), count, dst + written * channels_ + c,
+                                channels_);
+      memmove(history, history + block, (taps_ - 1) * sizeof(float));
+    }
+
+    written += count;
+    src += block * channels_;
+    input_frames -= block;
+  }
+  return written;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "aligned_alloc.h"
+
+struct AudioKernels;
+
+// Sample rate converter for interleaved 16-bit or float PCM between any two
+// rates whose ratio reduces to at most kMaxPhases output steps, e.g.
+// 44100 -> 48000 (160/147) or 22050 -> 48000 (320/147).
+//
+// The output rate is L/M times the input rate. A windowed sinc low-pass at
+// the lower of the two Nyquist frequencies is designed once in Init() and
+// split into L phases of |taps| coefficients, so each output sample is one
+// dot product against the phase it falls on. Input is de-interleaved into a
+// per-channel history and the dot products run on the kernels of
+// audio_convert_row.h, one channel at a time.
+//
+// Output lags input by taps / 2 input frames, starting from silence. Use one
+// sample type per instance; Reset() before switching.
+class PolyphaseResampler {
+ public:
+  // Largest reduced output step count L accepted, i.e. the bank size limit.
+  static const int kMaxPhases = 1024;
+
+  PolyphaseResampler();
+
+  PolyphaseResampler(const PolyphaseResampler&) = delete;
+  PolyphaseResampler& operator=(const PolyphaseResampler&) = delete;
+
+  // |taps| per phase: a multiple of 16 from 16 to 256; more taps give a
+  // narrower transition band. Decimation scales it by the rate ratio (up to
+  // 512). Fails on unsupported rates or channel counts.
+  bool Init(int input_rate, int output_rate, int channels, int taps = 64,
+            const AudioKernels* kernels = nullptr);
+  void Reset();
+
+  int input_rate() const { return input_rate_; }
+  int output_rate() const { return output_rate_; }
+  int channels() const { return channels_; }
+  int taps() const { return taps_; }
+
+  // Upper bound on the frames one Process() of |input_frames| frames writes.
+  int MaxOutputFrames(int input_frames) const;
+
+  // Consumes all |input_frames| frames and returns the number of frames
+  // written to |dst|, which must hold MaxOutputFrames(input_frames).
+  int Process(const int16_t* src, int input_frames, int16_t* dst);
+  int Process(const float* src, int input_frames, float* dst);
+
+ private:
+  // Input is taken in blocks of this many frames.
+  static const int kBlockFrames = 256;
+
+  void DesignFilter();
+  int PlanBlock(int block_frames);
+
+  int input_rate_;
+  int output_rate_;
+  int channels_;
+  int taps_;
+  int up_;    // L: output steps per M input frames
+  int down_;  // M
+  const AudioKernels* kernels_;
+
+  std::unique_ptr<int16_t, AlignedFreeDeleter> bank_s16_;  // Q15, [phase][tap]
+  std::unique_ptr<float, AlignedFreeDeleter> bank_float_;
+  // Per channel: taps - 1 frames of history followed by one block.
+  std::unique_ptr<int16_t, AlignedFreeDeleter> history_s16_;
+  std::unique_ptr<float, AlignedFreeDeleter> history_float_;
+  int history_stride_;
+  std::vector<int32_t> offsets_;
+  std::vector<int32_t> phases_;
+
+  int position_;  // History index of the newest tap of the next output
+  int phase_;     // Phase of the next output, 0..up_ - 1
+};
@@ -0,0 +1,93 @@
+#include "audio_ring.h"
+
+#include <string.h>
+
+static const size_t kChunkAlignment = 64;
+
+AudioRing::AudioRing()
+    : channels_(0),
+      sample_bytes_(0),
+      frame_bytes_(0),
+      sample_rate_(0),
+      chunk_frames_(0),
+      capacity_frames_(0),
+      chunk_stride_(0),
+      overrun_frames_(0),
+      read_frames_(0),
+      write_frames_(0) {}
+
+bool AudioRing::Init(int channels, int sample_bytes, int sample_rate, int chunk_frames,
+                     int chunk_count) {
+  if (channels <= 0 || sample_bytes <= 0 || sample_rate <= 0 || chunk_frames <= 0 ||
+      chunk_count <= 0) {
+    return false;
+  }
+
+  size_t chunk_bytes = static_cast<size_t>(sample_bytes) * channels * chunk_frames;
+  size_t stride_bytes = (chunk_bytes + kChunkAlignment - 1) / kChunkAlignment * kChunkAlignment;
+  samples_.reset(AlignedMalloc<uint8_t>(stride_bytes * chunk_count, kChunkAlignment));
+  if (!samples_) return false;
+  memset(samples_.get(), 0, stride_bytes * chunk_count);
+
+  channels_ = channels;
+  sample_bytes_ = sample_bytes;
+  frame_bytes_ = static_cast<size_t>(sample_bytes) * channels;
+  sample_rate_ = sample_rate;
+  chunk_frames_ = chunk_frames;
+  capacity_frames_ = static_cast<uint64_t>(chunk_frames) * chunk_count;
+  chunk_stride_ = stride_bytes;
+  chunk_timestamps_.assign(chunk_count, 0);
+  overrun_frames_ = 0;
+  read_frames_ = 0;
+  write_frames_ = 0;
+  return true;
+}
+
+size_t AudioRing::Write(const void* samples, size_t frame_count, int64_t timestamp_ms) {
+  const uint8_t* src = static_cast<const uint8_t*>(samples);
+  uint64_t write = write_frames_.load(std::memory_order_relaxed);
+  uint64_t free_frames = capacity_frames_ - (write - read_frames_.load(std::memory_order_acquire));
+  size_t count = frame_count < free_frames ? frame_count : static_cast<size_t>(free_frames);
+  if (count < frame_count) overrun_frames_.fetch_add(frame_count - count, std::memory_order_relaxed);
+
+  size_t done = 0;
+  while (done < count) {
+    uint64_t position = write + done;
+    uint64_t chunk = position / chunk_frames_;
+    size_t offset = static_cast<size_t>(position % chunk_frames_);
+    size_t slot = static_cast<size_t>(chunk % chunk_timestamps_.size());
+    size_t frames = chunk_frames_ - offset;
+    if (frames > count - done) frames = count - done;
+
+    if (offset == 0) {
+      chunk_timestamps_[slot] =
+          timestamp_ms + static_cast<int64_t>(done) * 1000 / sample_rate_;
+    }
+    memcpy(samples_.get() + slot * chunk_stride_ + offset * frame_bytes_,
+           src + done * frame_bytes_, frame_bytes_ * frames);
+    done += frames;
+  }
+
+  write_frames_.store(write + count, std::memory_order_release);
+  return count;
+}
+
+size_t AudioRing::AvailableChunks() const {
+  uint64_t write = write_frames_.load(std::memory_order_acquire);
+  uint64_t read = read_frames_.load(std::memory_order_relaxed);
+  return static_cast<size_t>((write - read) / chunk_frames_);
+}
+
+const void* AudioRing::PeekChunk(int64_t* timestamp_ms) const {
+  if (AvailableChunks() == 0) return nullptr;
+  uint64_t chunk = read_frames_.load(std::memory_order_relaxed) / chunk_frames_;
+  size_t slot = static_cast<size_t>(chunk % chunk_timestamps_.size());
+  if (timestamp_ms) *timestamp_ms = chunk_timestamps_[slot];
+  return samples_.get() + slot * chunk_stride_;
+}
+
+void AudioRing::ConsumeChunk() {
+  if (AvailableChunks() == 0) return;
+  read_frames_.store(read_frames_.load(std::memory_order_relaxed) + chunk_frames_,
+                     std::memory_order_release);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "aligned_alloc.h"
+
+// Lock-free single-producer/single-consumer ring of interleaved PCM that
+// re-chunks packets of any size into fixed-size chunks. Samples are opaque
+// |sample_bytes| values (16-bit or 32-bit PCM).
+//
+// The producer appends whatever a capture callback delivered; the consumer
+// takes whole chunks. Capacity is a whole number of chunks and chunks start on
+// 64-byte boundaries, so a chunk never wraps and PeekChunk() always returns a
+// pointer into the ring: the only copy is the one into the ring. Each chunk
+// carries the capture timestamp of its first sample, interpolated from the
+// timestamp of the packet it started in.
+class AudioRing {
+ public:
+  AudioRing();
+
+  AudioRing(const AudioRing&) = delete;
+  AudioRing& operator=(const AudioRing&) = delete;
+
+  // Allocates |chunk_count| chunks of |chunk_frames| frames. Must not run
+  // concurrently with either side.
+  bool Init(int channels, int sample_bytes, int sample_rate, int chunk_frames, int chunk_count);
+
+  int channels() const { return channels_; }
+  int sample_bytes() const { return sample_bytes_; }
+  int sample_rate() const { return sample_rate_; }
+  int chunk_frames() const { return chunk_frames_; }
+  size_t CapacityChunks() const { return chunk_timestamps_.size(); }
+
+  // Producer side. Appends |frame_count| interleaved frames whose first frame
+  // was captured at |timestamp_ms|. Frames that do not fit are dropped and
+  // counted; returns the number of frames written.
+  size_t Write(const void* samples, size_t frame_count, int64_t timestamp_ms);
+
+  // Number of complete chunks queued. Exact from the consumer.
+  size_t AvailableChunks() const;
+
+  // Consumer side. Returns the oldest complete chunk, valid until
+  // ConsumeChunk(), or nullptr if none is queued.
+  const void* PeekChunk(int64_t* timestamp_ms) const;
+  void ConsumeChunk();
+
+  // Frames dropped by Write() because the ring was full.
+  uint64_t OverrunFrames() const { return overrun_frames_.load(std::memory_order_relaxed); }
+
+ private:
+  int channels_;
+  int sample_bytes_;
+  size_t frame_bytes_;
+  int sample_rate_;
+  int chunk_frames_;
+  uint64_t capacity_frames_;
+  size_t chunk_stride_;  // Bytes between chunk starts, padded to 64 bytes.
+  std::unique_ptr<uint8_t, AlignedFreeDeleter> samples_;
+  std::vector<int64_t> chunk_timestamps_;
+  std::atomic<uint64_t> overrun_frames_;
+
+  // Positions in frames since Init(), never wrapped. Padded as in SpscRing.
+  char pad0_[64];
+  std::atomic<uint64_t> read_frames_;
+  char pad1_[64 - sizeof(std::atomic<uint64_t>)];
+  std::atomic<uint64_t> write_frames_;
+};
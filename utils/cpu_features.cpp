@@ -0,0 +1,68 @@
+#include "cpu_features.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool DetectIsa(CpuIsa isa) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  switch (isa) {
+    case kIsaC:
+      return true;
+    case kIsaSSE2:
+      return __builtin_cpu_supports("sse2");
+    case kIsaAVX2:
+      return __builtin_cpu_supports("avx2");
+    case kIsaAVX512:
+      return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    default:
+      return false;
+  }
+#else
+  return isa == kIsaC;
+#endif
+}
+
+static CpuIsa DetectBestIsa() {
+  CpuIsa limit = static_cast<CpuIsa>(kIsaCount - 1);
+  const char* env = getenv("HDVT_MAX_ISA");
+  if (env) {
+    for (int i = 0; i < kIsaCount; i++) {
+      if (strcmp(env, CpuIsaName(static_cast<CpuIsa>(i))) == 0) {
+        limit = static_cast<CpuIsa>(i);
+        break;
+      }
+    }
+  }
+  for (int i = limit; i > kIsaC; i--) {
+    if (CpuSupportsIsa(static_cast<CpuIsa>(i))) return static_cast<CpuIsa>(i);
+  }
+  return kIsaC;
+}
+
+bool CpuSupportsIsa(CpuIsa isa) {
+  static const bool supported[kIsaCount] = {
+      DetectIsa(kIsaC), DetectIsa(kIsaSSE2), DetectIsa(kIsaAVX2), DetectIsa(kIsaAVX512)};
+  if (isa < kIsaC || isa >= kIsaCount) return false;
+  return supported[isa];
+}
+
+CpuIsa GetBestCpuIsa() {
+  static const CpuIsa best = DetectBestIsa();
+  return best;
+}
+
+const char* CpuIsaName(CpuIsa isa) {
+  switch (isa) {
+    case kIsaC:
+      return "c";
+    case kIsaSSE2:
+      return "sse2";
+    case kIsaAVX2:
+      return "avx2";
+    case kIsaAVX512:
+      return "avx512";
+    default:
+      return "unknown";
+  }
+}
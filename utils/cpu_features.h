@@ -0,0 +1,23 @@
+#pragma once
+
+// Runtime detection of the x86 instruction set extensions used by the SIMD
+// pixel and audio kernels. Detection runs once; the result is cached.
+
+enum CpuIsa {
+  kIsaC = 0,
+  kIsaSSE2,
+  kIsaAVX2,
+  kIsaAVX512,
+  kIsaCount
+};
+
+// Returns true if the running CPU (and OS) supports |isa|.
+bool CpuSupportsIsa(CpuIsa isa);
+
+// Returns the widest instruction set supported by the running CPU. Setting the
+// environment variable HDVT_MAX_ISA to "c", "sse2", "avx2" or "avx512" caps
+// the result, which is useful when comparing kernels on the same machine.
+CpuIsa GetBestCpuIsa();
+
+// Human readable name of |isa|, e.g. "avx2".
+const char* CpuIsaName(CpuIsa isa);
@@ -0,0 +1,47 @@
+#include "crc32.h"
+
+#include <string.h>
+
+static const uint32_t kCrc32Polynomial = 0xEDB88320u;
+
+namespace {
+
+// tables[k][b] is the CRC of byte b followed by k zero bytes.
+struct Crc32Tables {
+  uint32_t tables[8][256];
+
+  Crc32Tables() {
+    for (uint32_t b = 0; b < 256; b++) {
+      uint32_t crc = b;
+      for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (kCrc32Polynomial & (0u - (crc & 1)));
+      tables[0][b] = crc;
+    }
+    for (uint32_t b = 0; b < 256; b++) {
+      for (int k = 1; k < 8; k++) {
+        tables[k][b] = (tables[k - 1][b] >> 8) ^ tables[0][tables[k - 1][b] & 0xff];
+      }
+    }
+  }
+};
+
+}  // namespace
+
+uint32_t Crc32Update(uint32_t crc, const void* data, size_t size) {
+  static const Crc32Tables kTables;
+  const uint32_t(*t)[256] = kTables.tables;
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+
+  crc = ~crc;
+  // Little-endian loads: the low word folds into the running CRC.
+  for (; size >= 8; size -= 8, p += 8) {
+    uint32_t lo;
+    uint32_t hi;
+    memcpy(&lo, p, 4);
+    memcpy(&hi, p + 4, 4);
+    lo ^= crc;
+    crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+          t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+  }
+  for (; size > 0; size--, p++) crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+  return ~crc;
+}
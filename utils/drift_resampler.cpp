@@ -0,0 +1,113 @@
+#include "drift_resampler.h"
+
+#include <math.h>
+#include <string.h>
+
+const int DriftResampler::kHistoryFrames;
+const int DriftResampler::kLookaheadFrames;
+
+static const double kPositionOne = 4294967296.0;  // 1 << 32
+
+static inline uint64_t StepForRatio(double ratio) {
+  return static_cast<uint64_t>(llrint(ratio * kPositionOne));
+}
+
+static inline int16_t SaturateS16(float value) {
+  long sample = lrintf(value);
+  if (sample > 32767) return 32767;
+  if (sample < -32768) return -32768;
+  return static_cast<int16_t>(sample);
+}
+
+DriftResampler::DriftResampler()
+    : channels_(0), capacity_frames_(0), frame_count_(0), position_(0), primed_(false) {}
+
+bool DriftResampler::Init(int channels, int max_input_frames) {
+  if (channels <= 0 || max_input_frames <= 0) return false;
+  channels_ = channels;
+  capacity_frames_ = max_input_frames + kHistoryFrames + kLookaheadFrames;
+  buffer_.assign(static_cast<size_t>(capacity_frames_) * channels, 0);
+  Reset();
+  return true;
+}
+
+void DriftResampler::Reset() {
+  frame_count_ = 0;
+  position_ = static_cast<uint64_t>(kHistoryFrames) << 32;
+  primed_ = false;
+}
+
+int DriftResampler::InputFramesNeeded(int output_frames, double ratio) const {
+  if (output_frames <= 0) return 0;
+  uint64_t last = position_ + static_cast<uint64_t>(output_frames - 1) * StepForRatio(ratio);
+  // Before the first Push() the history frame is still to be synthesized
+  int buffered = primed_ ? frame_count_ : kHistoryFrames;
+  int needed = static_cast<int>(last >> 32) + kLookaheadFrames + 1 - buffered;
+  return needed > 0 ? needed : 0;
+}
+
+bool DriftResampler::Push(const int16_t* samples, int frame_count) {
+  if (frame_count <= 0) return true;
+  size_t frame_samples = static_cast<size_t>(channels_);
+
+  // Drop what the read position has passed, keeping the history frame
+  int consumed = static_cast<int>(position_ >> 32) - kHistoryFrames;
+  if (consumed > frame_count_) consumed = frame_count_;
+  if (consumed > 0) {
+    memmove(buffer_.data(), buffer_.data() + consumed * frame_samples,
+            (frame_count_ - consumed) * frame_samples * sizeof(int16_t));
+    frame_count_ -= consumed;
+    position_ -= static_cast<uint64_t>(consumed) << 32;
+  }
+
+  // Start from a repeat of the first frame rather than from silence
+  int history = primed_ ? 0 : kHistoryFrames;
+  if (frame_count_ + history + frame_count > capacity_frames_) return false;
+  for (int i = 0; i < history; i++) {
+    memcpy(buffer_.data() + (frame_count_ + i) * frame_samples, samples,
+           frame_samples * sizeof(int16_t));
+  }
+  frame_count_ += history;
+  primed_ = true;
+
+  memcpy(buffer_.data() + frame_count_ * frame_samples, samples,
+         frame_count * frame_samples * sizeof(int16_t));
+  frame_count_ += frame_count;
+  return true;
+}
+
+void DriftResampler::Pull(int16_t* dst, int output_frames, double ratio) {
+  uint64_t step = StepForRatio(ratio);
+  const int16_t* buffer = buffer_.data();
+  int channels = channels_;
+
+  for (int i = 0; i < output_frames; i++) {
+    int index = static_cast<int>(position_ >> 32);
+    const int16_t* x0 = buffer + index * channels;
+    float t = static_cast<float>(static_cast<uint32_t>(position_)) * (1.0f / 4294967296.0f);
+
+    if (t == 0.0f) {
+      memcpy(dst, x0, channels * sizeof(int16_t));
+    } else {
+      const int16_t* xm1 = x0 - channels;
+      const int16_t* x1 = x0 + channels;
+      const int16_t* x2 = x1 + channels;
+      for (int c = 0; c < channels; c++) {
+        float a = xm1[c];
+        float b = x0[c];
+        float d = x1[c];
+        float e = x2[c];
+        float c1 = 0.5f * (d - a);
+        float c2 = a - 2.5f * b + 2.0f * d - 0.5f * e;
+        float c3 = 0.5f * (e - a) + 1.5f * (b - d);
+        dst[c] = SaturateS16(((c3 * t + c2) * t + c1) * t + b);
+      }
+    }
+    dst += channels;
+    position_ += step;
+  }
+}
+
+double DriftResampler::PendingFrames() const {
+  return frame_count_ - static_cast<double>(position_) / kPositionOne;
+}
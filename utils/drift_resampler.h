@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+// Resamples interleaved 16-bit PCM by a ratio close to 1 that may change on
+// every call, to absorb the drift between a capture clock and the clock that
+// paces sending.
+//
+// Drift is at most a few hundred ppm, so the read position slides through a
+// sample only every few thousand frames and 4-point cubic Hermite
+// interpolation is transparent at a fraction of the cost of a windowed sinc.
+// Whenever the read position falls on a whole frame, as it always does at a
+// ratio of exactly 1, that frame is copied unchanged. The read position is a
+// 32.32 fixed-point frame index, so no error accumulates over long sessions.
+//
+// Input is pushed as it arrives and kept in a small linear buffer; Pull()
+// consumes it at |ratio| input frames per output frame.
+class DriftResampler {
+ public:
+  DriftResampler();
+
+  // |max_input_frames| bounds what may be buffered ahead of the read
+  // position.
+  bool Init(int channels, int max_input_frames);
+  void Reset();
+
+  // Frames Push() must add before Pull(|output_frames|, |ratio|) can run.
+  int InputFramesNeeded(int output_frames, double ratio) const;
+
+  // Returns false, adding nothing, if the frames do not fit.
+  bool Push(const int16_t* samples, int frame_count);
+
+  // Writes |output_frames| frames, reading |ratio| input frames per output
+  // frame. The caller must have pushed InputFramesNeeded() frames.
+  void Pull(int16_t* dst, int output_frames, double ratio);
+
+  // Input frames buffered ahead of the read position, including the fraction
+  // of the current one.
+  double PendingFrames() const;
+
+ private:
+  static const int kHistoryFrames = 1;  // Frames kept before the read position
+  static const int kLookaheadFrames = 2;
+
+  int channels_;
+  int capacity_frames_;
+  std::vector<int16_t> buffer_;
+  int frame_count_;    // Frames in |buffer_|, history included
+  uint64_t position_;  // Read position in |buffer_|, 32.32 fixed point
+  bool primed_;
+};
@@ -30,7 +30,7 @@ std::unique_ptr<AudioFileParser> AudioFileParserFactory::createAudioFileParser(
   } else if (config.fileType == AUDIO_FILE_TYPE::AUDIO_FILE_HEAAC) {
     parser = std::move(createHEAACFileParser(config.filePath));
   } else if (config.fileType == AUDIO_FILE_TYPE::AUDIO_FILE_PCM) {
-    parser = std::move(createWavPcmFileParser(config.filePath));
+    parser = std::move(createWavPcmFileParser(config.filePath, config.outputSampleRateHz));
   } else if (config.fileType == AUDIO_FILE_TYPE::AUDIO_FILE_FIX_LENGTH_FRAME) {
     parser = std::move(createFixFrameLengthFileParser(config.filePath, config.sampleRateHz,
                                                       config.numberOfChannels, config.audioCodec,
@@ -61,8 +61,8 @@ std::unique_ptr<AudioFileParser> AudioFileParserFactory::createOpusFileParser(
 }
 
 std::unique_ptr<AudioFileParser> AudioFileParserFactory::createWavPcmFileParser(
-    const char* filepath) {
-  std::unique_ptr<WavPcmFileParser> parser(new WavPcmFileParser(filepath));
+    const char* filepath, int outputSampleRateHz) {
+  std::unique_ptr<WavPcmFileParser> parser(new WavPcmFileParser(filepath, outputSampleRateHz));
   return std::move(parser);
 }
 
@@ -22,6 +22,8 @@ class AudioFileParserFactory {
     int numberOfChannels{2};
     agora::rtc::AUDIO_CODEC_TYPE audioCodec{agora::rtc::AUDIO_CODEC_PCMA};
     int frameLength{0};
+    // PCM only: resample to this rate, 0 keeps the file's rate
+    int outputSampleRateHz{0};
   };
 
  public:
@@ -34,7 +36,8 @@ class AudioFileParserFactory {
   std::unique_ptr<AudioFileParser> createAACFileParser(const char* filepath);
   std::unique_ptr<AudioFileParser> createHEAACFileParser(const char* filepath);
   std::unique_ptr<AudioFileParser> createOpusFileParser(const char* filepath);
-  std::unique_ptr<AudioFileParser> createWavPcmFileParser(const char* filepath);
+  std::unique_ptr<AudioFileParser> createWavPcmFileParser(const char* filepath,
+                                                          int outputSampleRateHz);
   std::unique_ptr<AudioFileParser> createFixFrameLengthFileParser(
       const char* filepath, int sampleRateHz, int numberOfChannels,
       agora::rtc::AUDIO_CODEC_TYPE codec, int frameLength);
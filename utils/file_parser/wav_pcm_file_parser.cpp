@@ -2,12 +2,16 @@
 #include <stdlib.h>
 #include <string.h>
 
-WavPcmFileParser::WavPcmFileParser(const char* filepath)
+WavPcmFileParser::WavPcmFileParser(const char* filepath, int outputSampleRateHz)
     : wavFilePath_(strdup(filepath)),
       wavFile_(nullptr),
       readedLength_(0),
       bufDataLength_(0),
-      isEof_(false) {}
+      isEof_(false),
+      chunkCount_(0),
+      outputSampleRateHz_(outputSampleRateHz),
+      resampling_(false),
+      resampledCount_(0) {}
 
 WavPcmFileParser::~WavPcmFileParser() {
   if (wavFile_) {
@@ -53,6 +57,34 @@ bool WavPcmFileParser::open() {
     wavHeader_.sampleRateHz = 0;
     return false;
   }
+
+  if (outputSampleRateHz_ > 0 && outputSampleRateHz_ != wavHeader_.sampleRateHz) {
+    if (wavHeader_.bitsPerSample != 16 ||
+        !resampler_.Init(wavHeader_.sampleRateHz, outputSampleRateHz_,
+                         wavHeader_.numberOfChannels)) {
+      printf("Cannot resample %s from %d Hz to %d Hz\n", wavFilePath_, wavHeader_.sampleRateHz,
+             outputSampleRateHz_);
+      wavHeader_.numberOfChannels = 0;
+      wavHeader_.sampleRateHz = 0;
+      return false;
+    }
+    int inputFrames = (wavHeader_.sampleRateHz + 99) / 100;
+    inputFrames_.assign(static_cast<size_t>(inputFrames) * wavHeader_.numberOfChannels, 0);
+    // Less than one output chunk is left over when a read adds its output
+    int capacity = resampler_.MaxOutputFrames(inputFrames) + outputSampleRateHz_ / 100 + 1;
+    resampledFrames_.assign(static_cast<size_t>(capacity) * wavHeader_.numberOfChannels, 0);
+    resampledCount_ = 0;
+    resampling_ = true;
+  }
+
+  int chunkRate = resampling_ ? outputSampleRateHz_ : wavHeader_.sampleRateHz;
+  if ((chunkRate + 99) / 100 * wavHeader_.numberOfChannels * wavHeader_.bitsPerSample / 8 >
+      BufferSize) {
+    printf("Unsupported test file format %s: 10 ms exceeds %d bytes\n", wavFilePath_, BufferSize);
+    wavHeader_.numberOfChannels = 0;
+    wavHeader_.sampleRateHz = 0;
+    return false;
+  }
   return true;
 }
 
@@ -61,6 +93,9 @@ bool WavPcmFileParser::hasNext() {
     return false;
   }
   readData();
+  if (resampling_) {
+    return bufDataLength_ > 0;
+  }
   if (isEof_ || readedLength_ >= wavHeader_.dataLength) {
     return false;
   }
@@ -71,6 +106,12 @@ int WavPcmFileParser::reset() {
   fseek(wavFile_, 0, SEEK_SET);
   readedLength_ = 0;
   isEof_ = false;
+  chunkCount_ = 0;
+  resampledCount_ = 0;
+  bufDataLength_ = 0;
+  if (resampling_) {
+    resampler_.Reset();
+  }
   return 0;
 }
 
@@ -89,17 +130,32 @@ agora::rtc::AUDIO_CODEC_TYPE WavPcmFileParser::getCodecType() {
   return agora::rtc::AUDIO_CODEC_PCMU;
 }
 
-int WavPcmFileParser::getSampleRateHz() { return getSampleRate(); }
+int WavPcmFileParser::getSampleRateHz() {
+  return resampling_ ? outputSampleRateHz_ : getSampleRate();
+}
+
+// 10 ms is not a whole number of frames at every rate (22050, 11025 Hz), so
+// chunk n ends at frame rate * (n + 1) / 100 and no time is lost over a file.
+int WavPcmFileParser::nextChunkFrames(int sampleRateHz) {
+  int frames = static_cast<int>(sampleRateHz * (chunkCount_ + 1) / 100 -
+                                sampleRateHz * chunkCount_ / 100);
+  chunkCount_++;
+  return frames;
+}
 
 void WavPcmFileParser::readData() {
+  if (resampling_) {
+    readResampledData();
+    return;
+  }
   if (isEof_ || readedLength_ >= wavHeader_.dataLength) {
     return;
   }
-  int length =
-      wavHeader_.sampleRateHz / 100 * wavHeader_.numberOfChannels * wavHeader_.bitsPerSample / 8;
   if (bufDataLength_ > 0) {
     return;
   }
+  int length = nextChunkFrames(wavHeader_.sampleRateHz) * wavHeader_.numberOfChannels *
+               wavHeader_.bitsPerSample / 8;
   size_t readsize = fread(dataBuffer_, 1, length, wavFile_);
   if (readsize < length) {
     isEof_ = true;
@@ -107,3 +163,38 @@ void WavPcmFileParser::readData() {
   readedLength_ += readsize;
   bufDataLength_ = readsize;
 }
+
+// Reads and resamples file data until a whole 10 ms chunk at the output rate
+// is ready. The partial chunk left at the end of the file is dropped, as the
+// unresampled path drops a short read.
+void WavPcmFileParser::readResampledData() {
+  if (bufDataLength_ > 0) {
+    return;
+  }
+  int channels = wavHeader_.numberOfChannels;
+  int frameBytes = channels * static_cast<int>(sizeof(int16_t));
+  int chunkFrames = static_cast<int>(outputSampleRateHz_ * (chunkCount_ + 1) / 100 -
+                                     outputSampleRateHz_ * chunkCount_ / 100);
+
+  while (resampledCount_ < static_cast<size_t>(chunkFrames)) {
+    if (isEof_ || readedLength_ >= wavHeader_.dataLength) {
+      return;
+    }
+    size_t readsize =
+        fread(inputFrames_.data(), 1, inputFrames_.size() * sizeof(int16_t), wavFile_);
+    if (readsize < inputFrames_.size() * sizeof(int16_t)) {
+      isEof_ = true;
+    }
+    readedLength_ += readsize;
+    resampledCount_ += resampler_.Process(inputFrames_.data(), readsize / frameBytes,
+                                          resampledFrames_.data() + resampledCount_ * channels);
+  }
+
+  int length = chunkFrames * frameBytes;
+  memcpy(dataBuffer_, resampledFrames_.data(), length);
+  resampledCount_ -= chunkFrames;
+  memmove(resampledFrames_.data(), resampledFrames_.data() + chunkFrames * channels,
+          resampledCount_ * frameBytes);
+  bufDataLength_ = length;
+  chunkCount_++;
+}
@@ -3,15 +3,21 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <vector>
+
 #include "audio_file_parser_factory.h"
+#include "utils/audio_resampler.h"
 #include "utils/wav_header.h"
 
 void makeWAVHeader(unsigned char _dst[44], const WavHeader& header);
 void parseWAVHeader(const unsigned char _dst[44], WavHeader& header);
 
+// Hands out 10 ms of PCM per getNext(). With |outputSampleRateHz| set and
+// different from the file's rate, 16-bit files are resampled to it, e.g. so
+// 44.1 kHz material can be mixed with 48 kHz capture.
 class WavPcmFileParser : public AudioFileParser {
  public:
-  explicit WavPcmFileParser(const char* filepath);
+  explicit WavPcmFileParser(const char* filepath, int outputSampleRateHz = 0);
   ~WavPcmFileParser();
   bool open() override;
   bool hasNext() override;
@@ -27,9 +33,12 @@ class WavPcmFileParser : public AudioFileParser {
 
  private:
   void readData();
+  void readResampledData();
+  int nextChunkFrames(int sampleRateHz);
 
  private:
-  static constexpr int BufferSize = 4096;
+  // 10 ms of up to 16 channels of 32-bit PCM at 48 kHz
+  static constexpr int BufferSize = 30720;
 
   char* wavFilePath_;
   FILE* wavFile_;
@@ -38,4 +47,11 @@ class WavPcmFileParser : public AudioFileParser {
   int32_t readedLength_;
   int32_t bufDataLength_;
   bool isEof_;
+  int64_t chunkCount_;
+  int outputSampleRateHz_;
+  bool resampling_;
+  PolyphaseResampler resampler_;
+  std::vector<int16_t> inputFrames_;
+  std::vector<int16_t> resampledFrames_;  // Resampled, not yet handed out
+  size_t resampledCount_;
 };
@@ -0,0 +1,71 @@
+#include "frame_pool.h"
+
+#include <string.h>
+
+PooledFrame::PooledFrame(FramePool* pool, I420Buffer* buffer)
+    : pool_(pool), buffer_(buffer, I420Buffer::Release), ref_count_(0) {}
+
+void PooledFrame::Release() {
+  if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    pool_->Return(this);
+  }
+}
+
+FramePool::FramePool() : width_(0), height_(0), type_(I420Buffer::kI422) {}
+
+FramePool::~FramePool() { Reset(); }
+
+bool FramePool::Init(int width, int height, I420Buffer::Type type, int count) {
+  if (width <= 0 || height <= 0 || count <= 0) return false;
+  if (!Reset()) return false;
+
+  width_ = width;
+  height_ = height;
+  type_ = type;
+
+  frames_.reserve(count);
+  free_list_.reserve(count);
+  for (int i = 0; i < count; i++) {
+    I420Buffer* buffer = I420Buffer::Create(width, height, type);
+    if (!buffer->Data()) {
+      I420Buffer::Release(buffer);
+      Reset();
+      return false;
+    }
+    // Prefault: write every page now rather than on the first captured frame.
+    buffer->InitializeData();
+    frames_.emplace_back(new PooledFrame(this, buffer));
+    free_list_.push_back(frames_.back().get());
+  }
+  return true;
+}
+
+bool FramePool::Reset() {
+  std::lock_guard<std::mutex> _(free_list_lock_);
+  if (free_list_.size() != frames_.size()) return false;
+  free_list_.clear();
+  frames_.clear();
+  width_ = 0;
+  height_ = 0;
+  return true;
+}
+
+PooledFrame* FramePool::Acquire() {
+  std::lock_guard<std::mutex> _(free_list_lock_);
+  if (free_list_.empty()) return nullptr;
+  PooledFrame* frame = free_list_.back();
+  free_list_.pop_back();
+  frame->ref_count_.store(1, std::memory_order_relaxed);
+  return frame;
+}
+
+size_t FramePool::Available() const {
+  std::lock_guard<std::mutex> _(free_list_lock_);
+  return free_list_.size();
+}
+
+void FramePool::Return(PooledFrame* frame) {
+  std::lock_guard<std::mutex> _(free_list_lock_);
+  // Capacity was reserved in Init(), so this never reallocates.
+  free_list_.push_back(frame);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "I420_buffer.h"
+
+class FramePool;
+
+// A buffer owned by a FramePool. Reference counted: the frame goes back to
+// its pool when the last reference is released. Acquire() hands it out with
+// one reference, so a pointer can travel through lock-free queues and be
+// released by whichever thread finishes with it.
+class PooledFrame {
+ public:
+  I420Buffer* buffer() const { return buffer_.get(); }
+
+  void AddRef() { ref_count_.fetch_add(1, std::memory_order_relaxed); }
+  void Release();
+
+ private:
+  friend class FramePool;
+  PooledFrame(FramePool* pool, I420Buffer* buffer);
+
+  FramePool* pool_;
+  std::unique_ptr<I420Buffer, void (*)(I420Buffer*)> buffer_;
+  std::atomic<int> ref_count_;
+};
+
+// Fixed set of preallocated, 64-byte aligned frame buffers of one geometry.
+//
+// All memory is allocated and prefaulted in Init(); Acquire() and Release()
+// only move pointers on a preallocated free list, so steady-state capture does
+// no heap allocation. The pool must outlive every frame it handed out.
+class FramePool {
+ public:
+  FramePool();
+  ~FramePool();
+
+  FramePool(const FramePool&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+
+  // Allocates |count| buffers and touches every page so the first captured
+  // frames do not take page faults. Fails if frames are still outstanding.
+  bool Init(int width, int height, I420Buffer::Type type, int count);
+
+  // Frees all buffers. Fails if frames are still outstanding.
+  bool Reset();
+
+  // Returns a frame holding one reference, or nullptr if the pool is empty.
+  PooledFrame* Acquire();
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  I420Buffer::Type type() const { return type_; }
+  size_t Capacity() const { return frames_.size(); }
+  size_t Available() const;
+
+ private:
+  friend class PooledFrame;
+  void Return(PooledFrame* frame);
+
+  int width_;
+  int height_;
+  I420Buffer::Type type_;
+  std::vector<std::unique_ptr<PooledFrame>> frames_;
+  std::vector<PooledFrame*> free_list_;
+  mutable std::mutex free_list_lock_;
+};
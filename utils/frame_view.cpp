@@ -0,0 +1,84 @@
+#include "frame_view.h"
+
+#include <string.h>
+
+static PlaneView MakePlane(const void* data, int stride, int width, int height) {
+  PlaneView plane;
+  plane.data = static_cast<uint8_t*>(const_cast<void*>(data));
+  plane.stride = stride;
+  plane.width = width;
+  plane.height = height;
+  return plane;
+}
+
+FrameView PackedFrameView(const void* data, int stride, int width, int height) {
+  FrameView view;
+  memset(&view, 0, sizeof(view));
+  view.layout = kFramePacked;
+  view.width = width;
+  view.height = height;
+  view.plane_count = 1;
+  view.planes[0] = MakePlane(data, stride, width, height);
+  return view;
+}
+
+FrameView PlanarFrameView(I420Buffer* buffer) {
+  FrameView view;
+  memset(&view, 0, sizeof(view));
+  if (buffer->type() == I420Buffer::kNV12) return view;
+
+  view.layout = buffer->type() == I420Buffer::kI420 ? kFrameI420 : kFrameI422;
+  view.width = buffer->width();
+  view.height = buffer->height();
+  view.plane_count = 3;
+  view.planes[0] = MakePlane(buffer->DataY(), buffer->StrideY(), buffer->width(),
+                             buffer->height());
+  view.planes[1] = MakePlane(buffer->DataU(), buffer->StrideU(), buffer->ChromaWidth(),
+                             buffer->ChromaHeight());
+  view.planes[2] = MakePlane(buffer->DataV(), buffer->StrideV(), buffer->ChromaWidth(),
+                             buffer->ChromaHeight());
+  return view;
+}
+
+FrameView SliceFrameView(const FrameView& view, int first_row, int row_count) {
+  FrameView slice = view;
+  slice.height = row_count;
+  for (int i = 0; i < view.plane_count; i++) {
+    PlaneView& plane = slice.planes[i];
+    int first = first_row;
+    int count = row_count;
+    if (i > 0 && view.layout == kFrameI420) {
+      first = first_row / 2;
+      count = (row_count + 1) / 2;
+    }
+    plane.data += static_cast<intptr_t>(plane.stride) * first;
+    plane.height = count;
+  }
+  return slice;
+}
+
+bool IsContiguousYuv(const FrameView& view) {
+  if (view.layout == kFramePacked || view.plane_count != 3) return false;
+  const PlaneView& y = view.planes[0];
+  const PlaneView& u = view.planes[1];
+  const PlaneView& v = view.planes[2];
+  return y.stride % 2 == 0 && u.stride == y.stride / 2 && v.stride == u.stride &&
+         u.data == y.data + static_cast<intptr_t>(y.stride) * y.height &&
+         v.data == u.data + static_cast<intptr_t>(u.stride) * u.height;
+}
+
+void CopyFrameView(const FrameView& src, const FrameView& dst) {
+  for (int i = 0; i < src.plane_count && i < dst.plane_count; i++) {
+    const PlaneView& from = src.planes[i];
+    const PlaneView& to = dst.planes[i];
+    // Packed planes hold width pixels of unknown size, so copy the whole
+    // common row.
+    int row_bytes = src.layout == kFramePacked
+                        ? (from.stride < to.stride ? from.stride : to.stride)
+                        : from.width;
+    for (int row = 0; row < from.height; row++) {
+      memcpy(to.data + static_cast<intptr_t>(to.stride) * row,
+             from.data + static_cast<intptr_t>(from.stride) * row, row_bytes);
+    }
+  }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "I420_buffer.h"
+
+// Non-owning description of one video frame in memory.
+//
+// Each plane carries its own pointer, stride and size, so padded rows (v210
+// rows are rounded up to 128 bytes, some SD modes pad further) are described
+// as they are instead of being repacked into a tightly packed copy. Strides
+// are in bytes; plane widths are in samples of that plane.
+struct PlaneView {
+  uint8_t* data;
+  int stride;
+  int width;
+  int height;
+};
+
+enum FrameLayout {
+  kFramePacked = 0,  // One plane of interleaved pixels (UYVY, v210, BGRA, r210).
+  kFrameI420,
+  kFrameI422,
+};
+
+struct FrameView {
+  FrameLayout layout;
+  int width;
+  int height;
+  int plane_count;
+  PlaneView planes[3];
+};
+
+// Single-plane view of packed pixels, e.g. a DeckLink frame with
+// GetBytes() / GetRowBytes().
+FrameView PackedFrameView(const void* data, int stride, int width, int height);
+
+// View of an I420 or I422 buffer. NV12 buffers are not supported and give an
+// empty view (plane_count 0).
+FrameView PlanarFrameView(I420Buffer* buffer);
+
+// Rows [first_row, first_row + row_count) of |view|. For I420, |first_row|
+// must be even; the chroma rows covering the luma rows are included.
+FrameView SliceFrameView(const FrameView& view, int first_row, int row_count);
+
+// True if |view| is planar YUV with the planes back to back and each chroma
+// stride half the luma stride, i.e. fully described by a base pointer and a
+// luma stride.
+bool IsContiguousYuv(const FrameView& view);
+
+// Copies the planes of |src| to |dst| row by row. Both must have the same
+// layout and plane sizes.
+void CopyFrameView(const FrameView& src, const FrameView& dst);
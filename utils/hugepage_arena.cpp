@@ -0,0 +1,137 @@
+#include "hugepage_arena.h"
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "utils/log.h"
+
+const size_t HugePageArena::kHugePageSize;
+const size_t HugePageArena::kBlockAlignment;
+
+static size_t RoundUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+HugePageArena::HugePageArena()
+    : base_(nullptr),
+      arena_bytes_(0),
+      block_size_(0),
+      block_count_(0),
+      huge_pages_(false),
+      transparent_huge_pages_(false),
+      locked_(false),
+      peak_in_use_(0),
+      allocations_(0),
+      fallback_allocations_(0) {}
+
+HugePageArena::~HugePageArena() { Release(); }
+
+bool HugePageArena::Init(size_t block_size, size_t block_count) {
+  if (block_size == 0 || block_count == 0) return false;
+  if (!Release()) return false;
+
+  size_t rounded_block = RoundUp(block_size, kBlockAlignment);
+  size_t bytes = RoundUp(rounded_block * block_count, kHugePageSize);
+
+  void* mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  bool huge_pages = mem != MAP_FAILED;
+  bool transparent_huge_pages = false;
+  if (!huge_pages) {
+    mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+      AG_LOG(ERROR, "HugePageArena: failed to map %zu bytes", bytes);
+      return false;
+    }
+    transparent_huge_pages = madvise(mem, bytes, MADV_HUGEPAGE) == 0;
+    AG_LOG(WARNING, "HugePageArena: no hugepages reserved, using normal pages%s",
+           transparent_huge_pages ? " with THP advice" : "");
+  }
+
+  // Lock first so the prefault below populates resident pages; failure only
+  // means the pages may be swapped, so it is not fatal.
+  bool locked = mlock(mem, bytes) == 0;
+  if (!locked) {
+    AG_LOG(WARNING, "HugePageArena: mlock of %zu bytes failed, check RLIMIT_MEMLOCK", bytes);
+  }
+  memset(mem, 0, bytes);
+
+  std::lock_guard<std::mutex> _(lock_);
+  base_ = static_cast<uint8_t*>(mem);
+  arena_bytes_ = bytes;
+  block_size_ = rounded_block;
+  block_count_ = block_count;
+  huge_pages_ = huge_pages;
+  transparent_huge_pages_ = transparent_huge_pages;
+  locked_ = locked;
+  free_blocks_.clear();
+  free_blocks_.reserve(block_count);
+  // Hand out low addresses first.
+  for (size_t i = block_count; i > 0; i--) free_blocks_.push_back(static_cast<uint32_t>(i - 1));
+  peak_in_use_ = 0;
+  allocations_ = 0;
+  fallback_allocations_ = 0;
+  return true;
+}
+
+bool HugePageArena::Release() {
+  std::lock_guard<std::mutex> _(lock_);
+  if (!base_) return true;
+  if (free_blocks_.size() != block_count_) return false;
+
+  if (locked_) munlock(base_, arena_bytes_);
+  munmap(base_, arena_bytes_);
+  base_ = nullptr;
+  arena_bytes_ = 0;
+  block_size_ = 0;
+  block_count_ = 0;
+  free_blocks_.clear();
+  return true;
+}
+
+void* HugePageArena::Allocate(size_t size) {
+  std::lock_guard<std::mutex> _(lock_);
+  if (!base_ || size > block_size_ || free_blocks_.empty()) return nullptr;
+
+  uint32_t index = free_blocks_.back();
+  free_blocks_.pop_back();
+  ++allocations_;
+  size_t in_use = block_count_ - free_blocks_.size();
+  if (in_use > peak_in_use_) peak_in_use_ = in_use;
+  return base_ + static_cast<size_t>(index) * block_size_;
+}
+
+bool HugePageArena::Owns(const void* ptr) const {
+  const uint8_t* p = static_cast<const uint8_t*>(ptr);
+  return base_ && p >= base_ && p < base_ + block_size_ * block_count_;
+}
+
+bool HugePageArena::Free(void* ptr) {
+  std::lock_guard<std::mutex> _(lock_);
+  if (!Owns(ptr)) return false;
+  size_t offset = static_cast<uint8_t*>(ptr) - base_;
+  free_blocks_.push_back(static_cast<uint32_t>(offset / block_size_));
+  return true;
+}
+
+void HugePageArena::RecordFallback() {
+  std::lock_guard<std::mutex> _(lock_);
+  ++fallback_allocations_;
+}
+
+HugePageArenaStats HugePageArena::GetStats() const {
+  std::lock_guard<std::mutex> _(lock_);
+  HugePageArenaStats stats;
+  stats.arena_bytes = arena_bytes_;
+  stats.block_size = block_size_;
+  stats.block_count = block_count_;
+  stats.blocks_in_use = block_count_ - free_blocks_.size();
+  stats.peak_blocks_in_use = peak_in_use_;
+  stats.allocations = allocations_;
+  stats.fallback_allocations = fallback_allocations_;
+  stats.huge_pages = huge_pages_;
+  stats.transparent_huge_pages = transparent_huge_pages_;
+  stats.locked = locked_;
+  return stats;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mutex>
+#include <vector>
+
+struct HugePageArenaStats {
+  size_t arena_bytes;        // Mapped size, a multiple of the page size used.
+  size_t block_size;         // Bytes per block, a multiple of 64.
+  size_t block_count;
+  size_t blocks_in_use;
+  size_t peak_blocks_in_use;
+  uint64_t allocations;      // Served from the arena.
+  uint64_t fallback_allocations;  // Arena exhausted or request too large.
+  bool huge_pages;           // Backed by explicit 2 MB hugepages (MAP_HUGETLB).
+  bool transparent_huge_pages;  // Normal mapping with MADV_HUGEPAGE advice.
+  bool locked;               // mlock() succeeded.
+};
+
+// Fixed-size block allocator over one anonymous mapping.
+//
+// The mapping is tried with explicit 2 MB hugepages first; when none are
+// reserved (vm.nr_hugepages) it falls back to normal pages with transparent
+// hugepage advice. The whole arena is mlock'ed when RLIMIT_MEMLOCK allows and
+// prefaulted, so handing out a block never takes a page fault. Blocks are
+// 64-byte aligned. Thread safe.
+class HugePageArena {
+ public:
+  static const size_t kHugePageSize = 2 * 1024 * 1024;
+  static const size_t kBlockAlignment = 64;
+
+  HugePageArena();
+  ~HugePageArena();
+
+  HugePageArena(const HugePageArena&) = delete;
+  HugePageArena& operator=(const HugePageArena&) = delete;
+
+  // Maps |block_count| blocks of at least |block_size| bytes. Fails if the
+  // arena is already initialized and blocks are outstanding.
+  bool Init(size_t block_size, size_t block_count);
+
+  // Unmaps the arena. Fails if blocks are outstanding.
+  bool Release();
+
+  bool IsInitialized() const { return base_ != nullptr; }
+  size_t block_size() const { return block_size_; }
+
+  // Returns a block of block_size() bytes, or nullptr if the arena is empty
+  // or |size| does not fit in a block.
+  void* Allocate(size_t size);
+  // Returns false if |ptr| does not belong to this arena.
+  bool Free(void* ptr);
+  bool Owns(const void* ptr) const;
+
+  // Counts an allocation the caller had to serve elsewhere.
+  void RecordFallback();
+
+  HugePageArenaStats GetStats() const;
+
+ private:
+  uint8_t* base_;
+  size_t arena_bytes_;
+  size_t block_size_;
+  size_t block_count_;
+  bool huge_pages_;
+  bool transparent_huge_pages_;
+  bool locked_;
+
+  mutable std::mutex lock_;
+  std::vector<uint32_t> free_blocks_;
+  size_t peak_in_use_;
+  uint64_t allocations_;
+  uint64_t fallback_allocations_;
+};
@@ -0,0 +1,66 @@
+#include "latency_histogram.h"
+
+const int LatencyHistogram::kLinearBuckets;
+const int LatencyHistogram::kSubBucketBits;
+const int LatencyHistogram::kBucketCount;
+
+LatencyHistogram::LatencyHistogram() { Reset(); }
+
+int LatencyHistogram::BucketIndex(uint64_t microseconds) {
+  if (microseconds < kLinearBuckets) return static_cast<int>(microseconds);
+  int octave = 63 - __builtin_clzll(microseconds);  // >= 4
+  int sub = static_cast<int>(microseconds >> (octave - kSubBucketBits)) & ((1 << kSubBucketBits) - 1);
+  return kLinearBuckets + ((octave - 4) << kSubBucketBits) + sub;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(int index) {
+  if (index < kLinearBuckets) return static_cast<uint64_t>(index) + 1;
+  int octave = ((index - kLinearBuckets) >> kSubBucketBits) + 4;
+  uint64_t sub = (index - kLinearBuckets) & ((1 << kSubBucketBits) - 1);
+  uint64_t step = 1ull << (octave - kSubBucketBits);
+  return (1ull << octave) + (sub + 1) * step;
+}
+
+void LatencyHistogram::Record(int64_t nanoseconds) {
+  if (nanoseconds < 0) nanoseconds = 0;
+  buckets_[BucketIndex(static_cast<uint64_t>(nanoseconds) / 1000)].fetch_add(
+      1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_ns_.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+  int64_t max = max_ns_.load(std::memory_order_relaxed);
+  while (nanoseconds > max &&
+         !max_ns_.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+  }
+}
+
+void LatencyHistogram::Reset() {
+  for (int i = 0; i < kBucketCount; i++) buckets_[i].store(0, std::memory_order_relaxed);
+  count_.store(0, std::memory_order_relaxed);
+  sum_ns_.store(0, std::memory_order_relaxed);
+  max_ns_.store(0, std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::MeanNs() const {
+  uint64_t count = Count();
+  return count ? sum_ns_.load(std::memory_order_relaxed) / static_cast<int64_t>(count) : 0;
+}
+
+int64_t LatencyHistogram::PercentileNs(double percentile) const {
+  uint64_t count = Count();
+  if (count == 0) return 0;
+
+  // Rank of the sample, 1-based, rounded up as in nearest-rank percentiles.
+  double rank = percentile / 100.0 * static_cast<double>(count);
+  uint64_t target = rank <= 1.0 ? 1 : static_cast<uint64_t>(rank + 0.999999);
+  uint64_t seen = 0;
+  for (int i = 0; i < kBucketCount; i++) {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen >= target) {
+      int64_t bound = static_cast<int64_t>(BucketUpperBound(i)) * 1000;
+      int64_t max = MaxNs();
+      return bound < max ? bound : max;
+    }
+  }
+  return MaxNs();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+// Log-linear latency histogram.
+//
+// Values are bucketed by microsecond with 8 sub-buckets per power of two, so
+// every bucket is within 12.5% of the values it holds; exact below 16 us.
+// Record() is wait-free and may run on any thread while another reads
+// percentiles; readers see a slightly stale but consistent-enough snapshot.
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  // Records one latency; negative values count as zero.
+  void Record(int64_t nanoseconds);
+  void Reset();
+
+  uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+  int64_t MaxNs() const { return max_ns_.load(std::memory_order_relaxed); }
+  int64_t MeanNs() const;
+
+  // Upper bound, in nanoseconds, of the bucket holding the |percentile|
+  // (0..100) value. Zero if nothing was recorded.
+  int64_t PercentileNs(double percentile) const;
+
+ private:
+  static const int kLinearBuckets = 16;
+  static const int kSubBucketBits = 3;
+  static const int kBucketCount = kLinearBuckets + (64 - 4) * (1 << kSubBucketBits);
+
+  static int BucketIndex(uint64_t microseconds);
+  static uint64_t BucketUpperBound(int index);
+
+  std::atomic<uint64_t> buckets_[kBucketCount];
+  std::atomic<uint64_t> count_;
+  std::atomic<int64_t> sum_ns_;
+  std::atomic<int64_t> max_ns_;
+};
@@ -0,0 +1,315 @@
+#include "loudness_meter.h"
+
+#include <math.h>
+#include <string.h>
+
+const int LoudnessMeter::kLanes;
+const int LoudnessMeter::kBlockFrames;
+const int LoudnessMeter::kPeakPhases;
+const int LoudnessMeter::kPeakTaps;
+const int LoudnessMeter::kMomentaryBlocks;
+const int LoudnessMeter::kShortTermBlocks;
+const int LoudnessMeter::kHistogramBins;
+
+static const int kAlignment = 64;
+static const int kMaxChannels = 64;
+
+// BS.1770 gating: blocks below the absolute gate never count, and the
+// integrated value only averages blocks within 10 LU of the absolutely
+// gated mean
+static const double kAbsoluteGateLufs = -70.0;
+static const double kRelativeGateLu = -10.0;
+static const double kHistogramStepLu = 0.1;
+
+// Energy that is certainly below anything a meter shows; filter state under
+// it is flushed so digital silence does not decay into denormals
+static const double kDenormalFloor = 1e-30;
+
+static double Sinc(double x) {
+  if (fabs(x) < 1e-12) return 1.0;
+  return sin(M_PI * x) / (M_PI * x);
+}
+
+LoudnessMeter::LoudnessMeter()
+    : sample_rate_(0),
+      channels_(0),
+      padded_channels_(0),
+      sub_block_frames_(0),
+      shelf_(),
+      highpass_(),
+      peak_position_(0),
+      sub_block_filled_(0),
+      sub_block_count_(0),
+      max_peak_(0) {}
+
+// Coefficients of the two K-weighting stages for any sample rate, from the
+// analog prototypes of the BS.1770 48 kHz filters.
+bool LoudnessMeter::Init(int sample_rate, int channels) {
+  if (sample_rate < 8000 || channels < 1 || channels > kMaxChannels) return false;
+
+  sample_rate_ = sample_rate;
+  channels_ = channels;
+  padded_channels_ = (channels + kLanes - 1) / kLanes * kLanes;
+  sub_block_frames_ = sample_rate / 10;
+
+  double k = tan(M_PI * 1681.974450955533 / sample_rate);
+  double q = 0.7071752369554196;
+  double vh = pow(10.0, 3.999843853973347 / 20.0);
+  double vb = pow(vh, 0.4996667741545416);
+  double a0 = 1.0 + k / q + k * k;
+  shelf_.b0 = (vh + vb * k / q + k * k) / a0;
+  shelf_.b1 = 2.0 * (k * k - vh) / a0;
+  shelf_.b2 = (vh - vb * k / q + k * k) / a0;
+  shelf_.a1 = 2.0 * (k * k - 1.0) / a0;
+  shelf_.a2 = (1.0 - k / q + k * k) / a0;
+
+  k = tan(M_PI * 38.13547087602444 / sample_rate);
+  q = 0.5003270373238773;
+  a0 = 1.0 + k / q + k * k;
+  highpass_.b0 = 1.0;
+  highpass_.b1 = -2.0;
+  highpass_.b2 = 1.0;
+  highpass_.a1 = 2.0 * (k * k - 1.0) / a0;
+  highpass_.a2 = (1.0 - k / q + k * k) / a0;
+
+  // Phase p interpolates p / 4 of the way between the middle two taps: a
+  // Hann-windowed sinc, normalized to unity gain. Phase 0 is the sample
+  // itself; phase 3 is phase 1 reversed
+  double taps[kPeakPhases][kPeakTaps];
+  for (int p = 1; p < kPeakPhases; p++) {
+    double sum = 0;
+    for (int t = 0; t < kPeakTaps; t++) {
+      double x = t - (kPeakTaps / 2 - 1) - static_cast<double>(p) / kPeakPhases;
+      taps[p][t] = Sinc(x) * 0.5 * (1.0 + cos(M_PI * x / (kPeakTaps / 2)));
+      sum += taps[p][t];
+    }
+    for (int t = 0; t < kPeakTaps; t++) taps[p][t] /= sum;
+  }
+  for (int t = 0; t < kPeakTaps / 2; t++) {
+    peak_even_[t] = static_cast<float>((taps[1][t] + taps[1][kPeakTaps - 1 - t]) / 2);
+    peak_odd_[t] = static_cast<float>((taps[1][t] - taps[1][kPeakTaps - 1 - t]) / 2);
+    peak_middle_[t] = static_cast<float>(taps[2][t]);
+  }
+
+  block_.reset(AlignedMalloc<float>(
+      static_cast<size_t>(kBlockFrames) * padded_channels_ * sizeof(float), kAlignment));
+  peak_history_.reset(AlignedMalloc<float>(
+      static_cast<size_t>(2 * kPeakTaps) * padded_channels_ * sizeof(float), kAlignment));
+  if (!block_ || !peak_history_) return false;
+  memset(block_.get(), 0, static_cast<size_t>(kBlockFrames) * padded_channels_ * sizeof(float));
+
+  groups_.resize(padded_channels_ / kLanes);
+  Reset();
+  return true;
+}
+
+void LoudnessMeter::Reset() {
+  if (peak_history_) {
+    memset(peak_history_.get(), 0,
+           static_cast<size_t>(2 * kPeakTaps) * padded_channels_ * sizeof(float));
+  }
+  for (LaneGroup& group : groups_) memset(&group, 0, sizeof(group));
+  peak_position_ = 0;
+  sub_block_filled_ = 0;
+  sub_block_count_ = 0;
+  memset(sub_blocks_, 0, sizeof(sub_blocks_));
+  memset(histogram_count_, 0, sizeof(histogram_count_));
+  memset(histogram_energy_, 0, sizeof(histogram_energy_));
+  max_peak_ = 0;
+}
+
+void LoudnessMeter::Process(const int16_t* samples, int frames) {
+  ProcessInterleaved(samples, frames, 1.0f / 32768.0f);
+}
+
+void LoudnessMeter::Process(const int32_t* samples, int frames) {
+  ProcessInterleaved(samples, frames, 1.0f / 2147483648.0f);
+}
+
+void LoudnessMeter::Process(const float* samples, int frames) {
+  ProcessInterleaved(samples, frames, 1.0f);
+}
+
+// Padding channels stay zero from Init() on.
+template <typename Sample>
+void LoudnessMeter::ProcessInterleaved(const Sample* samples, int frames, float scale) {
+  if (!block_) return;
+  while (frames > 0) {
+    int count = frames < kBlockFrames ? frames : kBlockFrames;
+    float* block = block_.get();
+    for (int f = 0; f < count; f++) {
+      for (int c = 0; c < channels_; c++) {
+        block[f * padded_channels_ + c] = static_cast<float>(samples[f * channels_ + c]) * scale;
+      }
+    }
+
+    int done = 0;
+    while (done < count) {
+      int run = sub_block_frames_ - sub_block_filled_;
+      if (run > count - done) run = count - done;
+      ProcessBlock(done, run);
+      done += run;
+      sub_block_filled_ += run;
+      if (sub_block_filled_ == sub_block_frames_) FinishSubBlock();
+    }
+
+    samples += static_cast<size_t>(count) * channels_;
+    frames -= count;
+  }
+}
+
+void LoudnessMeter::ProcessBlock(int first_frame, int frames) {
+  const int stride = padded_channels_;
+  float* history = peak_history_.get();
+  const Biquad shelf = shelf_;
+  const Biquad highpass = highpass_;
+
+  for (int f = first_frame; f < first_frame + frames; f++) {
+    const float* in = block_.get() + static_cast<size_t>(f) * stride;
+
+    // Every frame goes in twice, so the last kPeakTaps frames are always
+    // contiguous
+    memcpy(history + peak_position_ * stride, in, stride * sizeof(float));
+    memcpy(history + (peak_position_ + kPeakTaps) * stride, in, stride * sizeof(float));
+    peak_position_ = peak_position_ + 1 == kPeakTaps ? 0 : peak_position_ + 1;
+    const float* window = history + peak_position_ * stride;
+
+    for (size_t g = 0; g < groups_.size(); g++) {
+      LaneGroup& group = groups_[g];
+      const float* x = in + g * kLanes;
+
+      // The high-pass numerator is 1, -2, 1
+      for (int l = 0; l < kLanes; l++) {
+        double y = shelf.b0 * x[l] + group.shelf1[l];
+        group.shelf1[l] = shelf.b1 * x[l] - shelf.a1 * y + group.shelf2[l];
+        group.shelf2[l] = shelf.b2 * x[l] - shelf.a2 * y;
+        double z = y + group.highpass1[l];
+        group.highpass1[l] = -2.0 * y - highpass.a1 * z + group.highpass2[l];
+        group.highpass2[l] = y - highpass.a2 * z;
+        group.energy[l] += z * z;
+      }
+
+      // Phases 1 and 3 mirror each other and phase 2 is symmetric, so the
+      // taps fold around the centre: with a = x[t] + x[11 - t] and
+      // d = x[t] - x[11 - t], y1 = A + D and y3 = A - D
+      float even[kLanes] = {};
+      float odd[kLanes] = {};
+      float middle[kLanes] = {};
+      for (int t = 0; t < kPeakTaps / 2; t++) {
+        const float* early = window + t * stride + g * kLanes;
+        const float* late = window + (kPeakTaps - 1 - t) * stride + g * kLanes;
+        for (int l = 0; l < kLanes; l++) {
+          float a = early[l] + late[l];
+          float d = early[l] - late[l];
+          even[l] += peak_even_[t] * a;
+          odd[l] += peak_odd_[t] * d;
+          middle[l] += peak_middle_[t] * a;
+        }
+      }
+
+      float peak[kLanes];
+      for (int l = 0; l < kLanes; l++) {
+        float magnitude = fabsf(x[l]);
+        float quarter = fabsf(even[l] + odd[l]);
+        float three_quarters = fabsf(even[l] - odd[l]);
+        float half = fabsf(middle[l]);
+        magnitude = quarter > magnitude ? quarter : magnitude;
+        magnitude = three_quarters > magnitude ? three_quarters : magnitude;
+        peak[l] = half > magnitude ? half : magnitude;
+      }
+      for (int l = 0; l < kLanes; l++) {
+        group.peak[l] = peak[l] > group.peak[l] ? peak[l] : group.peak[l];
+      }
+    }
+  }
+}
+
+void LoudnessMeter::FinishSubBlock() {
+  double sum = 0;
+  for (LaneGroup& group : groups_) {
+    for (int l = 0; l < kLanes; l++) {
+      sum += group.energy[l];
+      group.energy[l] = 0;
+      if (fabs(group.shelf1[l]) < kDenormalFloor) group.shelf1[l] = 0;
+      if (fabs(group.shelf2[l]) < kDenormalFloor) group.shelf2[l] = 0;
+      if (fabs(group.highpass1[l]) < kDenormalFloor) group.highpass1[l] = 0;
+      if (fabs(group.highpass2[l]) < kDenormalFloor) group.highpass2[l] = 0;
+    }
+  }
+
+  sub_blocks_[sub_block_count_ % kShortTermBlocks] = sum / sub_block_frames_;
+  sub_block_count_++;
+  sub_block_filled_ = 0;
+  if (sub_block_count_ < kMomentaryBlocks) return;
+
+  // A new 400 ms gating block ends with every 100 ms block
+  double block = 0;
+  for (int i = 1; i <= kMomentaryBlocks; i++) {
+    block += sub_blocks_[(sub_block_count_ - i) % kShortTermBlocks];
+  }
+  block /= kMomentaryBlocks;
+  double lufs = MeanSquareToLufs(block);
+  if (lufs < kAbsoluteGateLufs) return;
+
+  int bin = static_cast<int>((lufs - kAbsoluteGateLufs) / kHistogramStepLu);
+  if (bin >= kHistogramBins) bin = kHistogramBins - 1;
+  histogram_count_[bin]++;
+  histogram_energy_[bin] += block;
+}
+
+double LoudnessMeter::MeanSquareToLufs(double mean_square) {
+  return mean_square > 0 ? -0.691 + 10.0 * log10(mean_square) : -HUGE_VAL;
+}
+
+LoudnessReading LoudnessMeter::Read() {
+  LoudnessReading reading;
+
+  reading.momentary_lufs = -HUGE_VAL;
+  reading.short_term_lufs = -HUGE_VAL;
+  if (sub_block_count_ >= kMomentaryBlocks) {
+    double sum = 0;
+    for (int i = 1; i <= kMomentaryBlocks; i++) {
+      sum += sub_blocks_[(sub_block_count_ - i) % kShortTermBlocks];
+    }
+    reading.momentary_lufs = MeanSquareToLufs(sum / kMomentaryBlocks);
+  }
+  if (sub_block_count_ >= kShortTermBlocks) {
+    double sum = 0;
+    for (int i = 0; i < kShortTermBlocks; i++) sum += sub_blocks_[i];
+    reading.short_term_lufs = MeanSquareToLufs(sum / kShortTermBlocks);
+  }
+
+  uint64_t count = 0;
+  double energy = 0;
+  for (int i = 0; i < kHistogramBins; i++) {
+    count += histogram_count_[i];
+    energy += histogram_energy_[i];
+  }
+  reading.integrated_lufs = -HUGE_VAL;
+  if (count > 0) {
+    double gate = MeanSquareToLufs(energy / count) + kRelativeGateLu;
+    int first = gate > kAbsoluteGateLufs
+                    ? static_cast<int>((gate - kAbsoluteGateLufs) / kHistogramStepLu)
+                    : 0;
+    if (first >= kHistogramBins) first = kHistogramBins - 1;
+    count = 0;
+    energy = 0;
+    for (int i = first; i < kHistogramBins; i++) {
+      count += histogram_count_[i];
+      energy += histogram_energy_[i];
+    }
+    if (count > 0) reading.integrated_lufs = MeanSquareToLufs(energy / count);
+  }
+
+  float interval_peak = 0;
+  for (LaneGroup& group : groups_) {
+    for (int l = 0; l < kLanes; l++) {
+      if (group.peak[l] > interval_peak) interval_peak = group.peak[l];
+      group.peak[l] = 0;
+    }
+  }
+  if (interval_peak > max_peak_) max_peak_ = interval_peak;
+  reading.true_peak_dbtp = interval_peak > 0 ? 20.0 * log10(interval_peak) : -HUGE_VAL;
+  reading.max_true_peak_dbtp = max_peak_ > 0 ? 20.0 * log10(max_peak_) : -HUGE_VAL;
+  return reading;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "aligned_alloc.h"
+
+// One set of meter values. Loudness is in LUFS and peaks in dBTP; both are
+// -HUGE_VAL until there is enough signal to measure.
+struct LoudnessReading {
+  double momentary_lufs;   // Last 400 ms
+  double short_term_lufs;  // Last 3 s
+  double integrated_lufs;  // Gated, since Reset()
+  double true_peak_dbtp;   // Highest over all channels since the last Read()
+  double max_true_peak_dbtp;  // Highest since Reset()
+};
+
+// EBU R128 / ITU-R BS.1770-4 loudness and true-peak meter for interleaved
+// PCM, treating all channels as one programme with unit weights (embedded
+// SDI audio carries no speaker layout).
+//
+// Each channel runs through the two K-weighting biquads and its energy is
+// summed per 100 ms; momentary and short-term loudness average the last 4 and
+// 30 of those, and every 400 ms gating block (75% overlap) lands in a 0.1 LU
+// histogram for the integrated value, so memory stays constant however long
+// the session. True peak is the largest magnitude of the signal upsampled 4x
+// by a 12-tap per phase interpolator.
+//
+// Input is de-interleaved into blocks padded to whole groups of kLanes
+// channels, and every inner loop runs over one group with a fixed trip count
+// so the compiler vectorizes across channels; filter state is double. Not
+// thread-safe: feed and read it from one thread.
+class LoudnessMeter {
+ public:
+  LoudnessMeter();
+
+  LoudnessMeter(const LoudnessMeter&) = delete;
+  LoudnessMeter& operator=(const LoudnessMeter&) = delete;
+
+  bool Init(int sample_rate, int channels);
+  void Reset();
+
+  int channels() const { return channels_; }
+
+  // Full-scale 16-bit, 32-bit or float (+-1.0) interleaved frames.
+  void Process(const int16_t* samples, int frames);
+  void Process(const int32_t* samples, int frames);
+  void Process(const float* samples, int frames);
+
+  // Computes the current values and restarts the interval true peak.
+  LoudnessReading Read();
+
+ private:
+  static const int kLanes = 8;
+  static const int kBlockFrames = 256;
+  static const int kPeakPhases = 4;
+  static const int kPeakTaps = 12;
+  static const int kMomentaryBlocks = 4;   // 100 ms blocks in 400 ms
+  static const int kShortTermBlocks = 30;  // and in 3 s
+  static const int kHistogramBins = 750;   // -70 to +5 LUFS in 0.1 LU steps
+
+  struct Biquad {
+    double b0, b1, b2, a1, a2;
+  };
+
+  // Running state of kLanes channels, kept together so that the compiler
+  // sees the arrays cannot overlap
+  struct LaneGroup {
+    double shelf1[kLanes];  // K-weighting biquad states
+    double shelf2[kLanes];
+    double highpass1[kLanes];
+    double highpass2[kLanes];
+    double energy[kLanes];  // Of the current 100 ms block
+    float peak[kLanes];     // Since the last Read()
+  };
+
+  template <typename Sample>
+  void ProcessInterleaved(const Sample* samples, int frames, float scale);
+  void ProcessBlock(int first_frame, int frames);
+  void FinishSubBlock();
+  static double MeanSquareToLufs(double mean_square);
+
+  int sample_rate_;
+  int channels_;
+  int padded_channels_;
+  int sub_block_frames_;
+
+  Biquad shelf_;
+  Biquad highpass_;
+  // Interpolator taps folded around the centre (see ProcessBlock())
+  float peak_even_[kPeakTaps / 2];
+  float peak_odd_[kPeakTaps / 2];
+  float peak_middle_[kPeakTaps / 2];
+
+  std::unique_ptr<float, AlignedFreeDeleter> block_;  // [frame][channel]
+  std::unique_ptr<float, AlignedFreeDeleter> peak_history_;  // [2 * taps][channel]
+  std::vector<LaneGroup> groups_;
+  int peak_position_;
+
+  int sub_block_filled_;
+  double sub_blocks_[kShortTermBlocks];  // Mean square per 100 ms, a ring
+  int sub_block_count_;                  // Completed since Reset()
+  uint32_t histogram_count_[kHistogramBins];
+  double histogram_energy_[kHistogramBins];
+  float max_peak_;
+};
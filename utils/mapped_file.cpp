@@ -0,0 +1,54 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils/log.h"
+
+MappedFile::MappedFile() : fd_(-1), data_(nullptr), size_(0) {}
+
+MappedFile::~MappedFile() { Close(); }
+
+bool MappedFile::Open(const std::string& path) {
+  Close();
+
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    AG_LOG(ERROR, "MappedFile: unable to open %s", path.c_str());
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    AG_LOG(ERROR, "MappedFile: unable to stat %s", path.c_str());
+    close(fd);
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  void* mem = nullptr;
+  if (size > 0) {
+    mem = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mem == MAP_FAILED) {
+      AG_LOG(ERROR, "MappedFile: failed to map %zu bytes of %s", size, path.c_str());
+      close(fd);
+      return false;
+    }
+    madvise(mem, size, MADV_SEQUENTIAL);
+  }
+
+  fd_ = fd;
+  data_ = static_cast<const uint8_t*>(mem);
+  size_ = size;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_ != nullptr) munmap(const_cast<uint8_t*>(data_), size_);
+  if (fd_ >= 0) close(fd_);
+  fd_ = -1;
+  data_ = nullptr;
+  size_ = 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+// Read-only mapping of a whole file, for replaying recorded raw media without
+// copying it through read(). The kernel is told the file is read sequentially
+// so readahead keeps replay from stalling on page faults.
+class MappedFile {
+ public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Maps |path|, unmapping any previous file. An empty file maps to nothing
+  // and still succeeds.
+  bool Open(const std::string& path);
+  void Close();
+
+  bool IsOpen() const { return fd_ >= 0; }
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  int fd_;
+  const uint8_t* data_;
+  size_t size_;
+};
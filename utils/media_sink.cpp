@@ -0,0 +1,246 @@
+#include "media_sink.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "utils/crc32.h"
+#include "utils/log.h"
+
+// Bytes of one row of |plane| that hold samples. Packed frames do not say
+// how wide their pixels are, so the whole stride counts.
+static size_t VisibleRowBytes(const FrameView& frame, const PlaneView& plane) {
+  return frame.layout == kFramePacked ? static_cast<size_t>(plane.stride)
+                                      : static_cast<size_t>(plane.width);
+}
+
+uint32_t FrameViewCrc32(const FrameView& frame) {
+  uint32_t crc = 0;
+  for (int p = 0; p < frame.plane_count; p++) {
+    const PlaneView& plane = frame.planes[p];
+    const size_t row_bytes = VisibleRowBytes(frame, plane);
+    for (int y = 0; y < plane.height; y++) {
+      crc = Crc32Update(crc, plane.data + static_cast<size_t>(plane.stride) * y, row_bytes);
+    }
+  }
+  return crc;
+}
+
+bool ParseMediaSinkType(const std::string& name, MediaSinkType* type) {
+  if (name == "agora") {
+    *type = kMediaSinkAgora;
+  } else if (name == "null") {
+    *type = kMediaSinkNull;
+  } else if (name == "file") {
+    *type = kMediaSinkRawFile;
+  } else if (name == "crc") {
+    *type = kMediaSinkCrc;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool NullMediaSink::SendVideoFrame(const FrameView&, int64_t) { return true; }
+
+bool NullMediaSink::SendAudioFrame(int, const int16_t*, int, int, int, int64_t) { return true; }
+
+RawFileMediaSink::RawFileMediaSink()
+    : video_file_(nullptr), video_failed_(false), audio_failed_(false) {}
+
+RawFileMediaSink::~RawFileMediaSink() { Close(); }
+
+bool RawFileMediaSink::Open(const std::string& video_path, const std::string& audio_path,
+                            int track_count) {
+  Close();
+  video_failed_ = false;
+  audio_failed_ = false;
+
+  video_file_ = fopen(video_path.c_str(), "wb");
+  if (!video_file_) {
+    AG_LOG(ERROR, "RawFileMediaSink: unable to create %s: %s", video_path.c_str(),
+           strerror(errno));
+    return false;
+  }
+
+  for (int i = 0; i < track_count; i++) {
+    std::string path = i == 0 ? audio_path : audio_path + "." + std::to_string(i);
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+      AG_LOG(ERROR, "RawFileMediaSink: unable to create %s: %s", path.c_str(), strerror(errno));
+      Close();
+      return false;
+    }
+    audio_files_.push_back(file);
+  }
+  return true;
+}
+
+void RawFileMediaSink::Close() {
+  if (video_file_) fclose(video_file_);
+  video_file_ = nullptr;
+  for (FILE* file : audio_files_) fclose(file);
+  audio_files_.clear();
+}
+
+bool RawFileMediaSink::SendVideoFrame(const FrameView& frame, int64_t) {
+  if (!video_file_) return false;
+
+  for (int p = 0; p < frame.plane_count; p++) {
+    const PlaneView& plane = frame.planes[p];
+    const size_t row_bytes = VisibleRowBytes(frame, plane);
+    for (int y = 0; y < plane.height; y++) {
+      const uint8_t* row = plane.data + static_cast<size_t>(plane.stride) * y;
+      if (fwrite(row, row_bytes, 1, video_file_) != 1) {
+        if (!video_failed_) {
+          AG_LOG(ERROR, "RawFileMediaSink: video write failed: %s", strerror(errno));
+          video_failed_ = true;
+        }
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool RawFileMediaSink::SendAudioFrame(int track, const int16_t* samples, int samples_per_channel,
+                                      int channels, int, int64_t) {
+  if (track < 0 || track >= static_cast<int>(audio_files_.size())) return false;
+
+  size_t bytes = sizeof(int16_t) * samples_per_channel * channels;
+  if (fwrite(samples, bytes, 1, audio_files_[track]) != 1) {
+    if (!audio_failed_) {
+      AG_LOG(ERROR, "RawFileMediaSink: audio write failed: %s", strerror(errno));
+      audio_failed_ = true;
+    }
+    return false;
+  }
+  return true;
+}
+
+CrcMediaSink::CrcMediaSink()
+    : record_file_(nullptr), verify_(false), video_frames_(0), video_mismatches_(0) {}
+
+CrcMediaSink::~CrcMediaSink() { Close(); }
+
+bool CrcMediaSink::Open(const std::string& path, bool verify, int track_count) {
+  Close();
+
+  verify_ = verify;
+  video_frames_ = 0;
+  video_mismatches_ = 0;
+  video_expected_.clear();
+  tracks_.assign(track_count, Track());
+
+  if (!verify) {
+    record_file_ = fopen(path.c_str(), "w");
+    if (!record_file_) {
+      AG_LOG(ERROR, "CrcMediaSink: unable to create %s: %s", path.c_str(), strerror(errno));
+      return false;
+    }
+    return true;
+  }
+
+  FILE* file = fopen(path.c_str(), "r");
+  if (!file) {
+    AG_LOG(ERROR, "CrcMediaSink: unable to open %s: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  // Everything to compare against is loaded here, so checking allocates nothing
+  char kind[8];
+  unsigned long long index;
+  unsigned int crc;
+  bool ok = true;
+  while (ok && fscanf(file, "%7s %llu %x", kind, &index, &crc) == 3) {
+    std::vector<uint32_t>* expected = nullptr;
+    int track;
+    if (strcmp(kind, "v") == 0) {
+      expected = &video_expected_;
+    } else if (sscanf(kind, "a%d", &track) == 1 && track >= 0 && track < track_count) {
+      expected = &tracks_[track].expected;
+    }
+    ok = expected != nullptr && index == expected->size();
+    if (ok) expected->push_back(crc);
+  }
+  ok = ok && feof(file);
+  fclose(file);
+
+  if (!ok) {
+    AG_LOG(ERROR, "CrcMediaSink: %s is not a checksum list for %d audio track(s)", path.c_str(),
+           track_count);
+    video_expected_.clear();
+    tracks_.assign(track_count, Track());
+    return false;
+  }
+  return true;
+}
+
+void CrcMediaSink::Close() {
+  if (record_file_) {
+    fclose(record_file_);
+    record_file_ = nullptr;
+    return;
+  }
+
+  if (!verify_) return;
+  verify_ = false;
+
+  uint64_t video_checked = std::min<uint64_t>(video_frames_, video_expected_.size());
+  uint64_t audio_checked = 0;
+  for (const Track& track : tracks_) {
+    audio_checked += std::min<uint64_t>(track.blocks, track.expected.size());
+  }
+  AG_LOG(INFO, "CrcMediaSink: %llu/%llu video frames and %llu/%llu audio blocks differ",
+         static_cast<unsigned long long>(video_mismatches_),
+         static_cast<unsigned long long>(video_checked),
+         static_cast<unsigned long long>(audio_mismatches()),
+         static_cast<unsigned long long>(audio_checked));
+}
+
+uint64_t CrcMediaSink::audio_blocks() const {
+  uint64_t blocks = 0;
+  for (const Track& track : tracks_) blocks += track.blocks;
+  return blocks;
+}
+
+uint64_t CrcMediaSink::audio_mismatches() const {
+  uint64_t mismatches = 0;
+  for (const Track& track : tracks_) mismatches += track.mismatches;
+  return mismatches;
+}
+
+bool CrcMediaSink::SendVideoFrame(const FrameView& frame, int64_t) {
+  uint32_t crc = FrameViewCrc32(frame);
+  uint64_t index = video_frames_++;
+
+  if (record_file_) {
+    fprintf(record_file_, "v %llu %08x\n", static_cast<unsigned long long>(index), crc);
+  } else if (index < video_expected_.size() && video_expected_[index] != crc) {
+    if (video_mismatches_++ == 0) {
+      AG_LOG(ERROR, "CrcMediaSink: video frame %llu is %08x, expected %08x",
+             static_cast<unsigned long long>(index), crc, video_expected_[index]);
+    }
+  }
+  return true;
+}
+
+bool CrcMediaSink::SendAudioFrame(int track, const int16_t* samples, int samples_per_channel,
+                                  int channels, int, int64_t) {
+  if (track < 0 || track >= static_cast<int>(tracks_.size())) return false;
+
+  Track& state = tracks_[track];
+  uint32_t crc = Crc32Update(0, samples, sizeof(int16_t) * samples_per_channel * channels);
+  uint64_t index = state.blocks++;
+
+  if (record_file_) {
+    fprintf(record_file_, "a%d %llu %08x\n", track, static_cast<unsigned long long>(index), crc);
+  } else if (index < state.expected.size() && state.expected[index] != crc) {
+    if (state.mismatches++ == 0) {
+      AG_LOG(ERROR, "CrcMediaSink: audio track %d block %llu is %08x, expected %08x", track,
+             static_cast<unsigned long long>(index), crc, state.expected[index]);
+    }
+  }
+  return true;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "frame_view.h"
+
+// Where converted media leaves the pipeline, chosen at startup.
+enum MediaSinkType {
+  kMediaSinkAgora = 0,  // Publish to the channel (encode and network included)
+  kMediaSinkNull,       // Discard; measures the pipeline alone
+  kMediaSinkRawFile,    // Write raw planar video and PCM to files
+  kMediaSinkCrc,        // Checksum every frame, recording or verifying a list
+};
+
+// Parses the command line name of a sink: "agora", "null", "file" or "crc".
+bool ParseMediaSinkType(const std::string& name, MediaSinkType* type);
+
+// The send stage of the capture pipeline. sendOneYuvFrame() and
+// sendOnePcmFrame() forward to one of these, so the pipeline's own
+// throughput and latency can be measured without the SDK or a live service.
+//
+// Video comes from the pipeline's send thread and audio from its audio
+// thread, possibly at the same time; each kind always from the same thread.
+// Video frames are planar I420 or I422.
+class IMediaSink {
+ public:
+  virtual ~IMediaSink() {}
+
+  virtual bool SendVideoFrame(const FrameView& frame, int64_t timestamp_ms) = 0;
+
+  // |samples| holds |samples_per_channel| frames of |channels| interleaved
+  // samples for audio track |track|.
+  virtual bool SendAudioFrame(int track, const int16_t* samples, int samples_per_channel,
+                              int channels, int sample_rate, int64_t timestamp_ms) = 0;
+};
+
+class NullMediaSink : public IMediaSink {
+ public:
+  bool SendVideoFrame(const FrameView& frame, int64_t timestamp_ms) override;
+  bool SendAudioFrame(int track, const int16_t* samples, int samples_per_channel, int channels,
+                      int sample_rate, int64_t timestamp_ms) override;
+};
+
+// Video goes to one file as back-to-back frames without row padding (what
+// ffplay -f rawvideo expects). Audio track 0 goes to |audio_path| and track n
+// to |audio_path|.n, as headerless interleaved 16-bit PCM.
+class RawFileMediaSink : public IMediaSink {
+ public:
+  RawFileMediaSink();
+  ~RawFileMediaSink() override;
+
+  RawFileMediaSink(const RawFileMediaSink&) = delete;
+  RawFileMediaSink& operator=(const RawFileMediaSink&) = delete;
+
+  bool Open(const std::string& video_path, const std::string& audio_path, int track_count);
+  void Close();
+
+  bool SendVideoFrame(const FrameView& frame, int64_t timestamp_ms) override;
+  bool SendAudioFrame(int track, const int16_t* samples, int samples_per_channel, int channels,
+                      int sample_rate, int64_t timestamp_ms) override;
+
+ private:
+  FILE* video_file_;
+  std::vector<FILE*> audio_files_;
+  // Only the first failed write of each kind is logged; the pipeline counts
+  // the rest. Each is touched by one thread only.
+  bool video_failed_;
+  bool audio_failed_;
+};
+
+// CRC-32 of every video frame (visible bytes of each plane, as the raw file
+// sink writes them) and every audio block. Recording writes one line per
+// frame or block to a text file: "v <index> <crc>" or "a<track> <index>
+// <crc>". Verifying loads such a file and compares each frame and block with
+// the recorded one at the same index, e.g. to check a conversion kernel
+// change end to end against a replayed capture.
+//
+// Timestamps are not checksummed; they differ from run to run.
+class CrcMediaSink : public IMediaSink {
+ public:
+  CrcMediaSink();
+  ~CrcMediaSink() override;
+
+  CrcMediaSink(const CrcMediaSink&) = delete;
+  CrcMediaSink& operator=(const CrcMediaSink&) = delete;
+
+  bool Open(const std::string& path, bool verify, int track_count);
+  // Flushes the record, or logs the outcome of verifying.
+  void Close();
+
+  bool SendVideoFrame(const FrameView& frame, int64_t timestamp_ms) override;
+  bool SendAudioFrame(int track, const int16_t* samples, int samples_per_channel, int channels,
+                      int sample_rate, int64_t timestamp_ms) override;
+
+  uint64_t video_frames() const { return video_frames_; }
+  uint64_t video_mismatches() const { return video_mismatches_; }
+  uint64_t audio_blocks() const;
+  uint64_t audio_mismatches() const;
+
+ private:
+  struct Track {
+    uint64_t blocks = 0;
+    uint64_t mismatches = 0;
+    std::vector<uint32_t> expected;
+  };
+
+  FILE* record_file_;
+  bool verify_;
+  uint64_t video_frames_;
+  uint64_t video_mismatches_;
+  std::vector<uint32_t> video_expected_;
+  std::vector<Track> tracks_;
+};
+
+// CRC-32 of the visible bytes of every row of every plane of |frame|.
+uint32_t FrameViewCrc32(const FrameView& frame);
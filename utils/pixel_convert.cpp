@@ -0,0 +1,558 @@
+#include "pixel_convert.h"
+#include "pixel_convert_row.h"
+
+// Packed rows are converted in segments of this many pixels through small
+// stack buffers, so scratch space stays in L1 and does not depend on the
+// frame width. A multiple of 6 (one v210 group) and of the widest SIMD step.
+static const int kSegmentPixels = 1536;
+
+void UyvyToI422Row_C(const uint8_t* src_uyvy, uint8_t* dst_y, uint8_t* dst_u,
+                     uint8_t* dst_v, int width) {
+  for (int x = 0; x < width - 1; x += 2) {
+    dst_u[0] = src_uyvy[0];
+    dst_y[0] = src_uyvy[1];
+    dst_v[0] = src_uyvy[2];
+    dst_y[1] = src_uyvy[3];
+    src_uyvy += 4;
+    dst_y += 2;
+    dst_u += 1;
+    dst_v += 1;
+  }
+}
+
+void UyvyToI420Row_C(const uint8_t* src_uyvy, int src_stride_uyvy, uint8_t* dst_y,
+                     int dst_stride_y, uint8_t* dst_u, uint8_t* dst_v, int width) {
+  const uint8_t* next = src_uyvy + src_stride_uyvy;
+  uint8_t* next_y = dst_y + dst_stride_y;
+  for (int x = 0; x < width - 1; x += 2) {
+    dst_u[0] = static_cast<uint8_t>((src_uyvy[0] + next[0] + 1) >> 1);
+    dst_v[0] = static_cast<uint8_t>((src_uyvy[2] + next[2] + 1) >> 1);
+    dst_y[0] = src_uyvy[1];
+    dst_y[1] = src_uyvy[3];
+    next_y[0] = next[1];
+    next_y[1] = next[3];
+    src_uyvy += 4;
+    next += 4;
+    dst_y += 2;
+    next_y += 2;
+    dst_u += 1;
+    dst_v += 1;
+  }
+}
+
+void V210ToUyvy16Row_C(const uint8_t* src_v210, uint16_t* dst_uyvy16, int width) {
+  for (int x = 0; x < width; x += 6) {
+    for (int i = 0; i < 4; i++) {
+      uint32_t word = static_cast<uint32_t>(src_v210[0]) |
+                      static_cast<uint32_t>(src_v210[1]) << 8 |
+                      static_cast<uint32_t>(src_v210[2]) << 16 |
+                      static_cast<uint32_t>(src_v210[3]) << 24;
+      dst_uyvy16[0] = word & 0x3ff;
+      dst_uyvy16[1] = (word >> 10) & 0x3ff;
+      dst_uyvy16[2] = (word >> 20) & 0x3ff;
+      src_v210 += 4;
+      dst_uyvy16 += 3;
+    }
+  }
+}
+
+void Uyvy16ToUyvyRow_C(const uint16_t* src_uyvy16, uint8_t* dst_uyvy, const uint16_t* dither,
+                       int width) {
+  for (int i = 0; i < width * 2; i++) {
+    int value = (src_uyvy16[i] + dither[i & 7]) >> 2;
+    dst_uyvy[i] = static_cast<uint8_t>(value > 255 ? 255 : value);
+  }
+}
+
+void Uyvy16ToI210Row_C(const uint16_t* src_uyvy16, uint16_t* dst_y, uint16_t* dst_u,
+                       uint16_t* dst_v, int width) {
+  for (int x = 0; x < width - 1; x += 2) {
+    dst_u[0] = src_uyvy16[0];
+    dst_y[0] = src_uyvy16[1];
+    dst_v[0] = src_uyvy16[2];
+    dst_y[1] = src_uyvy16[3];
+    src_uyvy16 += 4;
+    dst_y += 2;
+    dst_u += 1;
+    dst_v += 1;
+  }
+}
+
+void Uyvy16ToP210Row_C(const uint16_t* src_uyvy16, uint16_t* dst_y, uint16_t* dst_uv,
+                       int width) {
+  for (int x = 0; x < width - 1; x += 2) {
+    dst_uv[0] = static_cast<uint16_t>(src_uyvy16[0] << 6);
+    dst_y[0] = static_cast<uint16_t>(src_uyvy16[1] << 6);
+    dst_uv[1] = static_cast<uint16_t>(src_uyvy16[2] << 6);
+    dst_y[1] = static_cast<uint16_t>(src_uyvy16[3] << 6);
+    src_uyvy16 += 4;
+    dst_y += 2;
+    dst_uv += 2;
+  }
+}
+
+void AverageRow_C(const uint8_t* src_a, const uint8_t* src_b, uint8_t* dst, int count) {
+  for (int i = 0; i < count; i++) {
+    dst[i] = static_cast<uint8_t>((src_a[i] + src_b[i] + 1) >> 1);
+  }
+}
+
+void AverageRow16_C(const uint16_t* src_a, const uint16_t* src_b, uint16_t* dst, int count) {
+  for (int i = 0; i < count; i++) {
+    dst[i] = static_cast<uint16_t>((src_a[i] + src_b[i] + 1) >> 1);
+  }
+}
+
+void BgraToRgb16Row_C(const uint8_t* src_bgra, int16_t* dst_r, int16_t* dst_g, int16_t* dst_b,
+                      int width) {
+  for (int x = 0; x < width; x++) {
+    dst_b[x] = static_cast<int16_t>(src_bgra[0] << 2 | src_bgra[0] >> 6);
+    dst_g[x] = static_cast<int16_t>(src_bgra[1] << 2 | src_bgra[1] >> 6);
+    dst_r[x] = static_cast<int16_t>(src_bgra[2] << 2 | src_bgra[2] >> 6);
+    src_bgra += 4;
+  }
+}
+
+void R210ToRgb16Row_C(const uint8_t* src_r210, int16_t* dst_r, int16_t* dst_g, int16_t* dst_b,
+                      int width) {
+  for (int x = 0; x < width; x++) {
+    uint32_t word = static_cast<uint32_t>(src_r210[0]) << 24 |
+                    static_cast<uint32_t>(src_r210[1]) << 16 |
+                    static_cast<uint32_t>(src_r210[2]) << 8 |
+                    static_cast<uint32_t>(src_r210[3]);
+    dst_r[x] = static_cast<int16_t>((word >> 20) & 0x3ff);
+    dst_g[x] = static_cast<int16_t>((word >> 10) & 0x3ff);
+    dst_b[x] = static_cast<int16_t>(word & 0x3ff);
+    src_r210 += 4;
+  }
+}
+
+static inline uint8_t ApplyMatrix(const int16_t* c, int32_t offset, int r, int g, int b) {
+  int32_t value = (c[0] * r + c[1] * g + c[2] * b + offset) >> 16;
+  return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+void Rgb16ToYRow_C(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                   uint8_t* dst_y, const RgbToYuvCoefficients* coefficients, int width) {
+  for (int x = 0; x < width; x++) {
+    dst_y[x] = ApplyMatrix(coefficients->y, coefficients->y_offset, src_r[x], src_g[x],
+                           src_b[x]);
+  }
+}
+
+static inline int FilterChroma(const int16_t* src, int x) {
+  return (src[x - 1] + 2 * src[x] + src[x + 1] + 2) >> 2;
+}
+
+void Rgb16ToUVRow_C(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                    uint8_t* dst_u, uint8_t* dst_v, const RgbToYuvCoefficients* coefficients,
+                    int width) {
+  for (int x = 0; x < width - 1; x += 2) {
+    int r = FilterChroma(src_r, x);
+    int g = FilterChroma(src_g, x);
+    int b = FilterChroma(src_b, x);
+    dst_u[x / 2] = ApplyMatrix(coefficients->u, coefficients->uv_offset, r, g, b);
+    dst_v[x / 2] = ApplyMatrix(coefficients->v, coefficients->uv_offset, r, g, b);
+  }
+}
+
+static const PixelRowKernels kRowKernels[kIsaCount] = {
+    {kIsaC, UyvyToI422Row_C, UyvyToI420Row_C, V210ToUyvy16Row_C, Uyvy16ToUyvyRow_C, Uyvy16ToI210Row_C,
+     Uyvy16ToP210Row_C, AverageRow_C, AverageRow16_C, BgraToRgb16Row_C, R210ToRgb16Row_C,
+     Rgb16ToYRow_C, Rgb16ToUVRow_C},
+    {kIsaSSE2, UyvyToI422Row_SSE2, UyvyToI420Row_SSE2, V210ToUyvy16Row_C, Uyvy16ToUyvyRow_SSE2,
+     Uyvy16ToI210Row_SSE2, Uyvy16ToP210Row_SSE2, AverageRow_SSE2, AverageRow16_SSE2,
+     BgraToRgb16Row_SSE2, R210ToRgb16Row_SSE2, Rgb16ToYRow_SSE2, Rgb16ToUVRow_SSE2},
+    {kIsaAVX2, UyvyToI422Row_AVX2, UyvyToI420Row_AVX2, V210ToUyvy16Row_AVX2, Uyvy16ToUyvyRow_AVX2,
+     Uyvy16ToI210Row_AVX2, Uyvy16ToP210Row_AVX2, AverageRow_AVX2, AverageRow16_AVX2,
+     BgraToRgb16Row_AVX2, R210ToRgb16Row_AVX2, Rgb16ToYRow_AVX2, Rgb16ToUVRow_AVX2},
+    {kIsaAVX512, UyvyToI422Row_AVX512, UyvyToI420Row_AVX512, V210ToUyvy16Row_AVX512, Uyvy16ToUyvyRow_AVX2,
+     Uyvy16ToI210Row_AVX2, Uyvy16ToP210Row_AVX2, AverageRow_AVX2, AverageRow16_AVX2,
+     BgraToRgb16Row_AVX2, R210ToRgb16Row_AVX2, Rgb16ToYRow_AVX2, Rgb16ToUVRow_AVX2},
+};
+
+const PixelRowKernels* GetPixelRowKernels(CpuIsa isa) {
+  if (isa < kIsaC || isa >= kIsaCount || !CpuSupportsIsa(isa)) return nullptr;
+  return &kRowKernels[isa];
+}
+
+// Matrices are built at compile time from the luma weights Kr and Kb of each
+// standard. Input is 10-bit RGB, full range (0..1023) or video levels (black
+// 64, white 940); output is 8-bit with Y in 16..235 and chroma in 16..240 for
+// limited range, 0..255 for full range. Video level black is taken off
+// through the luma offset; chroma weights sum to zero, so it cancels there.
+// The largest chroma weight is derived from the other two so that grey maps
+// to exactly 128.
+static constexpr int16_t FixedPoint(double value) {
+  return static_cast<int16_t>(value * 65536.0 + (value < 0 ? -0.5 : 0.5));
+}
+
+static constexpr int16_t Negate(int16_t a, int16_t b) { return static_cast<int16_t>(-(a + b)); }
+
+static constexpr double LumaScale(bool video_input, bool full_range) {
+  return (full_range ? 255.0 : 219.0) / (video_input ? 876.0 : 1023.0);
+}
+
+static constexpr double ChromaScale(bool video_input, bool full_range) {
+  return (full_range ? 255.0 : 224.0) / (video_input ? 876.0 : 1023.0);
+}
+
+// Sum of the fixed-point luma weights, so black lands exactly on its code.
+static constexpr int32_t LumaWeightSum(double kr, double kb, double scale) {
+  return FixedPoint(kr * scale) + FixedPoint((1 - kr - kb) * scale) + FixedPoint(kb * scale);
+}
+
+static constexpr RgbToYuvCoefficients MakeCoefficients(double kr, double kb, double luma,
+                                                       double chroma, int32_t input_black,
+                                                       int32_t output_black) {
+  return RgbToYuvCoefficients{
+      {FixedPoint(kr * luma), FixedPoint((1 - kr - kb) * luma), FixedPoint(kb * luma)},
+      {FixedPoint(-kr / (2 * (1 - kb)) * chroma),
+       FixedPoint(-(1 - kr - kb) / (2 * (1 - kb)) * chroma),
+       Negate(FixedPoint(-kr / (2 * (1 - kb)) * chroma),
+              FixedPoint(-(1 - kr - kb) / (2 * (1 - kb)) * chroma))},
+      {Negate(FixedPoint(-(1 - kr - kb) / (2 * (1 - kr)) * chroma),
+              FixedPoint(-kb / (2 * (1 - kr)) * chroma)),
+       FixedPoint(-(1 - kr - kb) / (2 * (1 - kr)) * chroma),
+       FixedPoint(-kb / (2 * (1 - kr)) * chroma)},
+      (output_black << 16) + (1 << 15) - input_black * LumaWeightSum(kr, kb, luma),
+      (128 << 16) + (1 << 15)};
+}
+
+static constexpr RgbToYuvCoefficients MakeCoefficients(double kr, double kb, bool video_input,
+                                                       bool full_range) {
+  return MakeCoefficients(kr, kb, LumaScale(video_input, full_range),
+                          ChromaScale(video_input, full_range), video_input ? 64 : 0,
+                          full_range ? 0 : 16);
+}
+
+// Indexed by RgbRange, YuvColorMatrix, then YuvRange.
+static constexpr RgbToYuvCoefficients kRgbToYuv[2][3][2] = {
+    {{MakeCoefficients(0.299, 0.114, false, false), MakeCoefficients(0.299, 0.114, false, true)},
+     {MakeCoefficients(0.2126, 0.0722, false, false),
+      MakeCoefficients(0.2126, 0.0722, false, true)},
+     {MakeCoefficients(0.2627, 0.0593, false, false),
+      MakeCoefficients(0.2627, 0.0593, false, true)}},
+    {{MakeCoefficients(0.299, 0.114, true, false), MakeCoefficients(0.299, 0.114, true, true)},
+     {MakeCoefficients(0.2126, 0.0722, true, false), MakeCoefficients(0.2126, 0.0722, true, true)},
+     {MakeCoefficients(0.2627, 0.0593, true, false),
+      MakeCoefficients(0.2627, 0.0593, true, true)}},
+};
+
+const RgbToYuvCoefficients* GetRgbToYuvCoefficients(YuvColorMatrix matrix, RgbRange input_range,
+                                                    YuvRange range) {
+  return &kRgbToYuv[input_range][matrix][range];
+}
+
+static const PixelRowKernels* ResolveKernels(const PixelRowKernels* kernels) {
+  static const PixelRowKernels* best = GetPixelRowKernels(GetBestCpuIsa());
+  return kernels ? kernels : best;
+}
+
+// Per-sample offsets added before dropping 2 bits, repeating every 8 UYVY
+// samples (two pixel pairs). The dither follows a 2x2 Bayer matrix indexed by
+// pixel position for luma and by chroma sample position for U and V.
+static void GetDitherRow(int y, bool dither, uint16_t pattern[8]) {
+  static const uint16_t kBayer[2][2] = {{0, 2}, {3, 1}};
+  if (!dither) {
+    for (int i = 0; i < 8; i++) pattern[i] = 2;
+    return;
+  }
+  uint16_t even = kBayer[y & 1][0];
+  uint16_t odd = kBayer[y & 1][1];
+  // U0 Y0 V0 Y1 U2 Y2 V2 Y3
+  pattern[0] = even;
+  pattern[1] = even;
+  pattern[2] = even;
+  pattern[3] = odd;
+  pattern[4] = odd;
+  pattern[5] = even;
+  pattern[6] = odd;
+  pattern[7] = odd;
+}
+
+void UyvyToI422(const uint8_t* src_uyvy, int src_stride_uyvy,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height,
+                const PixelRowKernels* kernels) {
+  UyvyToI422RowFunc row = ResolveKernels(kernels)->uyvy_to_i422;
+  for (int y = 0; y < height; y++) {
+    row(src_uyvy, dst_y, dst_u, dst_v, width);
+    src_uyvy += src_stride_uyvy;
+    dst_y += dst_stride_y;
+    dst_u += dst_stride_u;
+    dst_v += dst_stride_v;
+  }
+}
+
+void UyvyToI420(const uint8_t* src_uyvy, int src_stride_uyvy,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height,
+                const PixelRowKernels* kernels) {
+  UyvyToI420RowFunc row = ResolveKernels(kernels)->uyvy_to_i420;
+  for (int y = 0; y < height; y += 2) {
+    // The last row of an odd height pairs with itself.
+    int pair = height - y > 1 ? 1 : 0;
+    row(src_uyvy, src_stride_uyvy * pair, dst_y, dst_stride_y * pair, dst_u, dst_v, width);
+    src_uyvy += src_stride_uyvy * 2;
+    dst_y += dst_stride_y * 2;
+    dst_u += dst_stride_u;
+    dst_v += dst_stride_v;
+  }
+}
+
+// Byte offset of pixel |x| (a multiple of 6) in a v210 row.
+static inline int V210Offset(int x) { return x / 6 * 16; }
+
+void V210ToI422(const uint8_t* src_v210, int src_stride_v210,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height, bool dither,
+                const PixelRowKernels* kernels) {
+  const PixelRowKernels* k = ResolveKernels(kernels);
+  alignas(64) uint16_t uyvy16[kSegmentPixels * 2];
+  alignas(64) uint8_t uyvy[kSegmentPixels * 2];
+  uint16_t pattern[8];
+
+  for (int y = 0; y < height; y++) {
+    GetDitherRow(y, dither, pattern);
+    for (int x = 0; x < width; x += kSegmentPixels) {
+      int count = width - x < kSegmentPixels ? width - x : kSegmentPixels;
+      k->v210_to_uyvy16(src_v210 + V210Offset(x), uyvy16, count);
+      k->uyvy16_to_uyvy(uyvy16, uyvy, pattern, count);
+      k->uyvy_to_i422(uyvy, dst_y + x, dst_u + x / 2, dst_v + x / 2, count);
+    }
+    src_v210 += src_stride_v210;
+    dst_y += dst_stride_y;
+    dst_u += dst_stride_u;
+    dst_v += dst_stride_v;
+  }
+}
+
+void V210ToI420(const uint8_t* src_v210, int src_stride_v210,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height, bool dither,
+                const PixelRowKernels* kernels) {
+  const PixelRowKernels* k = ResolveKernels(kernels);
+  alignas(64) uint16_t uyvy16[kSegmentPixels * 2];
+  alignas(64) uint8_t uyvy[2][kSegmentPixels * 2];
+  uint16_t pattern[2][8];
+
+  GetDitherRow(0, dither, pattern[0]);
+  GetDitherRow(1, dither, pattern[1]);
+
+  for (int y = 0; y < height; y += 2) {
+    // The last row of an odd height pairs with itself.
+    int pair = height - y > 1 ? 1 : 0;
+    for (int x = 0; x < width; x += kSegmentPixels) {
+      int count = width - x < kSegmentPixels ? width - x : kSegmentPixels;
+      for (int r = 0; r <= pair; r++) {
+        k->v210_to_uyvy16(src_v210 + r * src_stride_v210 + V210Offset(x), uyvy16, count);
+        k->uyvy16_to_uyvy(uyvy16, uyvy[r], pattern[r], count);
+      }
+      k->uyvy_to_i420(uyvy[0], static_cast<int>(sizeof(uyvy[0])) * pair, dst_y + x,
+                      dst_stride_y * pair, dst_u + x / 2, dst_v + x / 2, count);
+    }
+    src_v210 += src_stride_v210 * 2;
+    dst_y += dst_stride_y * 2;
+    dst_u += dst_stride_u;
+    dst_v += dst_stride_v;
+  }
+}
+
+void V210ToI010(const uint8_t* src_v210, int src_stride_v210,
+                uint16_t* dst_y, int dst_stride_y,
+                uint16_t* dst_u, int dst_stride_u,
+                uint16_t* dst_v, int dst_stride_v,
+                int width, int height,
+                const PixelRowKernels* kernels) {
+  const PixelRowKernels* k = ResolveKernels(kernels);
+  alignas(64) uint16_t uyvy16[kSegmentPixels * 2];
+  alignas(64) uint16_t u[2][kSegmentPixels / 2];
+  alignas(64) uint16_t v[2][kSegmentPixels / 2];
+
+  for (int y = 0; y < height; y += 2) {
+    int rows = height - y > 1 ? 2 : 1;
+    for (int x = 0; x < width; x += kSegmentPixels) {
+      int count = width - x < kSegmentPixels ? width - x : kSegmentPixels;
+      for (int r = 0; r < rows; r++) {
+        k->v210_to_uyvy16(src_v210 + r * src_stride_v210 + V210Offset(x), uyvy16, count);
+        k->uyvy16_to_i210(uyvy16, dst_y + r * dst_stride_y + x, u[r], v[r], count);
+      }
+      int last = rows - 1;
+      k->average_row16(u[0], u[last], dst_u + x / 2, count / 2);
+      k->average_row16(v[0], v[last], dst_v + x / 2, count / 2);
+    }
+    src_v210 += src_stride_v210 * 2;
+    dst_y += dst_stride_y * 2;
+    dst_u += dst_stride_u;
+    dst_v += dst_stride_v;
+  }
+}
+
+void V210ToP010(const uint8_t* src_v210, int src_stride_v210,
+                uint16_t* dst_y, int dst_stride_y,
+                uint16_t* dst_uv, int dst_stride_uv,
+                int width, int height,
+                const PixelRowKernels* kernels) {
+  const PixelRowKernels* k = ResolveKernels(kernels);
+  alignas(64) uint16_t uyvy16[2][kSegmentPixels * 2];
+  alignas(64) uint16_t scratch[kSegmentPixels];
+
+  for (int y = 0; y < height; y += 2) {
+    int rows = height - y > 1 ? 2 : 1;
+    for (int x = 0; x < width; x += kSegmentPixels) {
+      int count = width - x < kSegmentPixels ? width - x : kSegmentPixels;
+      for (int r = 0; r < rows; r++) {
+        k->v210_to_uyvy16(src_v210 + r * src_stride_v210 + V210Offset(x), uyvy16[r], count);
+        k->uyvy16_to_p210(uyvy16[r], dst_y + r * dst_stride_y + x, scratch, count);
+      }
+      // Average while still 10-bit in the low bits so the result rounds the
+      // same way as the other outputs; the averaged luma is discarded.
+      k->average_row16(uyvy16[0], uyvy16[rows - 1], uyvy16[0], count * 2);
+      k->uyvy16_to_p210(uyvy16[0], scratch, dst_uv + x, count);
+    }
+    src_v210 += src_stride_v210 * 2;
+    dst_y += dst_stride_y * 2;
+    dst_uv += dst_stride_uv;
+  }
+}
+
+// Left padding of the RGB scratch rows: index -1 holds the pixel left of the
+// segment for the chroma filter, the rest keeps rows 16-byte aligned.
+static const int kRgbRowPadding = 8;
+
+struct RgbScratchRow {
+  alignas(64) int16_t data[3][kRgbRowPadding + kSegmentPixels];
+  int16_t* r() { return data[0] + kRgbRowPadding; }
+  int16_t* g() { return data[1] + kRgbRowPadding; }
+  int16_t* b() { return data[2] + kRgbRowPadding; }
+};
+
+// Unpacks pixels |x| .. |x| + |count| of |src| and the one before it.
+static void UnpackRgbSegment(RgbUnpackRowFunc unpack, const uint8_t* src, int x, int count,
+                             RgbScratchRow* row) {
+  if (x == 0) {
+    unpack(src, row->r(), row->g(), row->b(), count);
+    row->r()[-1] = row->r()[0];
+    row->g()[-1] = row->g()[0];
+    row->b()[-1] = row->b()[0];
+  } else {
+    unpack(src + (x - 1) * 4, row->r() - 1, row->g() - 1, row->b() - 1, count + 1);
+  }
+}
+
+static void RgbToI422(RgbUnpackRowFunc unpack, const PixelRowKernels* k,
+                      const uint8_t* src, int src_stride,
+                      uint8_t* dst_y, int dst_stride_y,
+                      uint8_t* dst_u, int dst_stride_u,
+                      uint8_t* dst_v, int dst_stride_v,
+                      int width, int height, const RgbToYuvCoefficients* coefficients) {
+  RgbScratchRow row;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x += kSegmentPixels) {
+      int count = width - x < kSegmentPixels ? width - x : kSegmentPixels;
+      UnpackRgbSegment(unpack, src, x, count, &row);
+      k->rgb16_to_y(row.r(), row.g(), row.b(), dst_y + x, coefficients, count);
+      k->rgb16_to_uv(row.r(), row.g(), row.b(), dst_u + x / 2, dst_v + x / 2, coefficients,
+                     count);
+    }
+    src += src_stride;
+    dst_y += dst_stride_y;
+    dst_u += dst_stride_u;
+    dst_v += dst_stride_v;
+  }
+}
+
+static void RgbToI420(RgbUnpackRowFunc unpack, const PixelRowKernels* k,
+                      const uint8_t* src, int src_stride,
+                      uint8_t* dst_y, int dst_stride_y,
+                      uint8_t* dst_u, int dst_stride_u,
+                      uint8_t* dst_v, int dst_stride_v,
+                      int width, int height, const RgbToYuvCoefficients* coefficients) {
+  RgbScratchRow rows[2];
+  RgbScratchRow average;
+  for (int y = 0; y < height; y += 2) {
+    int pair = height - y > 1 ? 2 : 1;
+    for (int x = 0; x < width; x += kSegmentPixels) {
+      int count = width - x < kSegmentPixels ? width - x : kSegmentPixels;
+      for (int r = 0; r < pair; r++) {
+        RgbScratchRow* row = &rows[r];
+        UnpackRgbSegment(unpack, src + r * src_stride, x, count, row);
+        k->rgb16_to_y(row->r(), row->g(), row->b(), dst_y + r * dst_stride_y + x, coefficients,
+                      count);
+      }
+      // Scratch values are 10-bit, so the unsigned average applies; include
+      // the filter's left neighbour.
+      for (int c = 0; c < 3; c++) {
+        const uint16_t* top = reinterpret_cast<const uint16_t*>(rows[0].data[c] + kRgbRowPadding - 1);
+        const uint16_t* bottom =
+            reinterpret_cast<const uint16_t*>(rows[pair - 1].data[c] + kRgbRowPadding - 1);
+        k->average_row16(top, bottom,
+                         reinterpret_cast<uint16_t*>(average.data[c] + kRgbRowPadding - 1),
+                         count + 1);
+      }
+      k->rgb16_to_uv(average.r(), average.g(), average.b(), dst_u + x / 2, dst_v + x / 2,
+                     coefficients, count);
+    }
+    src += src_stride * 2;
+    dst_y += dst_stride_y * 2;
+    dst_u += dst_stride_u;
+    dst_v += dst_stride_v;
+  }
+}
+
+void BgraToI422(const uint8_t* src_bgra, int src_stride_bgra,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height, YuvColorMatrix matrix, YuvRange range,
+                const PixelRowKernels* kernels) {
+  const PixelRowKernels* k = ResolveKernels(kernels);
+  RgbToI422(k->bgra_to_rgb16, k, src_bgra, src_stride_bgra, dst_y, dst_stride_y, dst_u,
+            dst_stride_u, dst_v, dst_stride_v, width, height,
+            GetRgbToYuvCoefficients(matrix, kRgbFullRange, range));
+}
+
+void BgraToI420(const uint8_t* src_bgra, int src_stride_bgra,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height, YuvColorMatrix matrix, YuvRange range,
+                const PixelRowKernels* kernels) {
+  const PixelRowKernels* k = ResolveKernels(kernels);
+  RgbToI420(k->bgra_to_rgb16, k, src_bgra, src_stride_bgra, dst_y, dst_stride_y, dst_u,
+            dst_stride_u, dst_v, dst_stride_v, width, height,
+            GetRgbToYuvCoefficients(matrix, kRgbFullRange, range));
+}
+
+void R210ToI422(const uint8_t* src_r210, int src_stride_r210,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height, YuvColorMatrix matrix, RgbRange input_range,
+                YuvRange range, const PixelRowKernels* kernels) {
+  const PixelRowKernels* k = ResolveKernels(kernels);
+  RgbToI422(k->r210_to_rgb16, k, src_r210, src_stride_r210, dst_y, dst_stride_y, dst_u,
+            dst_stride_u, dst_v, dst_stride_v, width, height,
+            GetRgbToYuvCoefficients(matrix, input_range, range));
+}
+
+void R210ToI420(const uint8_t* src_r210, int src_stride_r210,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height, YuvColorMatrix matrix, RgbRange input_range,
+                YuvRange range, const PixelRowKernels* kernels) {
+  const PixelRowKernels* k = ResolveKernels(kernels);
+  RgbToI420(k->r210_to_rgb16, k, src_r210, src_stride_r210, dst_y, dst_stride_y, dst_u,
+            dst_stride_u, dst_v, dst_stride_v, width, height,
+            GetRgbToYuvCoefficients(matrix, input_range, range));
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+// Packed-to-planar pixel format conversion used on the capture path.
+//
+// Every conversion is built from row kernels that have a scalar reference
+// plus SIMD variants (see pixel_convert_row.h). The plane functions below use
+// the widest variant the running CPU supports unless |kernels| names a
+// specific set; all variants produce bit-identical output.
+
+#include <stdint.h>
+
+struct PixelRowKernels;
+
+// YUV matrix and output range for RGB input.
+enum YuvColorMatrix { kYuvRec601, kYuvRec709, kYuvRec2020 };
+enum YuvRange { kYuvLimitedRange, kYuvFullRange };
+
+// Levels of RGB input: full range, or SMPTE video levels with black at 64
+// and white at 940 of 10 bits.
+enum RgbRange { kRgbFullRange, kRgbVideoRange };
+
+// Converts packed UYVY 4:2:2 (U0 Y0 V0 Y1) to planar I422.
+// |width| must be even.
+void UyvyToI422(const uint8_t* src_uyvy, int src_stride_uyvy,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height,
+                const PixelRowKernels* kernels = nullptr);
+
+// Converts packed UYVY 4:2:2 to planar I420. Each output chroma row is the
+// average of two input rows (chroma sited between them, as in MPEG-2), so
+// I420 output halves the chroma data without the aliasing of dropping rows.
+// |width| must be even.
+void UyvyToI420(const uint8_t* src_uyvy, int src_stride_uyvy,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height,
+                const PixelRowKernels* kernels = nullptr);
+
+// v210 is 10-bit 4:2:2 packed as three samples per little-endian 32-bit word,
+// six pixels per 16 bytes. DeckLink rows are padded to 128 bytes, so always
+// pass GetRowBytes() as |src_stride_v210|. |width| must be even.
+
+// Converts v210 to 8-bit planar I422. With |dither| the 2 dropped bits are
+// replaced by a 2x2 ordered dither instead of rounding, which avoids banding
+// on smooth gradients.
+void V210ToI422(const uint8_t* src_v210, int src_stride_v210,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height, bool dither,
+                const PixelRowKernels* kernels = nullptr);
+
+// Converts v210 to 8-bit planar I420. Each output chroma row is the average
+// of two input rows (chroma sited between them, as in MPEG-2).
+void V210ToI420(const uint8_t* src_v210, int src_stride_v210,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height, bool dither,
+                const PixelRowKernels* kernels = nullptr);
+
+// 10-bit outputs. Strides of 16-bit planes are in samples, not bytes.
+
+// Converts v210 to planar 4:2:0 with 10-bit samples in the low bits (I010).
+void V210ToI010(const uint8_t* src_v210, int src_stride_v210,
+                uint16_t* dst_y, int dst_stride_y,
+                uint16_t* dst_u, int dst_stride_u,
+                uint16_t* dst_v, int dst_stride_v,
+                int width, int height,
+                const PixelRowKernels* kernels = nullptr);
+
+// Converts v210 to P010: 10-bit samples in the high bits, luma plane plus one
+// interleaved UV plane at half height.
+void V210ToP010(const uint8_t* src_v210, int src_stride_v210,
+                uint16_t* dst_y, int dst_stride_y,
+                uint16_t* dst_uv, int dst_stride_uv,
+                int width, int height,
+                const PixelRowKernels* kernels = nullptr);
+
+// |matrix| and |range| select the YUV encoding. Chroma is filtered
+// [1 2 1] / 4 and co-sited with even pixels; 4:2:0 output additionally
+// averages row pairs (MPEG-2 siting). |width| must be even.
+
+// 8-bit BGRA (B G R A in memory), alpha ignored, taken as full range.
+void BgraToI422(const uint8_t* src_bgra, int src_stride_bgra,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height, YuvColorMatrix matrix, YuvRange range,
+                const PixelRowKernels* kernels = nullptr);
+void BgraToI420(const uint8_t* src_bgra, int src_stride_bgra,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height, YuvColorMatrix matrix, YuvRange range,
+                const PixelRowKernels* kernels = nullptr);
+
+// 10-bit r210: big-endian 32-bit words, 2 padding bits then R G B. DeckLink
+// bmdFormat10BitRGB carries video levels (|input_range| kRgbVideoRange);
+// codes beyond 64..940 keep to the foot- and headroom of limited range
+// output and clip in full range output.
+void R210ToI422(const uint8_t* src_r210, int src_stride_r210,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height, YuvColorMatrix matrix, RgbRange input_range,
+                YuvRange range, const PixelRowKernels* kernels = nullptr);
+void R210ToI420(const uint8_t* src_r210, int src_stride_r210,
+                uint8_t* dst_y, int dst_stride_y,
+                uint8_t* dst_u, int dst_stride_u,
+                uint8_t* dst_v, int dst_stride_v,
+                int width, int height, YuvColorMatrix matrix, RgbRange input_range,
+                YuvRange range, const PixelRowKernels* kernels = nullptr);
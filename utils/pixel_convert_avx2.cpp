@@ -0,0 +1,371 @@
+// AVX2 row kernels. Keep this file free of STL includes: everything inlined
+// here is compiled for AVX2 and must not leak into other translation units.
+#pragma GCC target("avx2")
+
+#include <immintrin.h>
+
+#include "pixel_convert_row.h"
+
+// _mm256_packus_epi16 packs within 128-bit lanes; this restores linear order
+// of the four 64-bit quarters (0 2 1 3).
+static inline __m256i PackUs16Linear(__m256i a, __m256i b) {
+  return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+}
+
+static inline __m256i PackS32Linear(__m256i a, __m256i b) {
+  return _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xd8);
+}
+
+// 64 pixels (128 bytes of UYVY) per iteration.
+void UyvyToI422Row_AVX2(const uint8_t* src_uyvy, uint8_t* dst_y, uint8_t* dst_u,
+                        uint8_t* dst_v, int width) {
+  const __m256i lo_mask = _mm256_set1_epi16(0x00ff);
+  int x = 0;
+  for (; x + 64 <= width; x += 64) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy + 32));
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy + 64));
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy + 96));
+
+    __m256i y0 = PackUs16Linear(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+    __m256i y1 = PackUs16Linear(_mm256_srli_epi16(c, 8), _mm256_srli_epi16(d, 8));
+
+    __m256i uv0 = PackUs16Linear(_mm256_and_si256(a, lo_mask), _mm256_and_si256(b, lo_mask));
+    __m256i uv1 = PackUs16Linear(_mm256_and_si256(c, lo_mask), _mm256_and_si256(d, lo_mask));
+    __m256i u = PackUs16Linear(_mm256_and_si256(uv0, lo_mask), _mm256_and_si256(uv1, lo_mask));
+    __m256i v = PackUs16Linear(_mm256_srli_epi16(uv0, 8), _mm256_srli_epi16(uv1, 8));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_y), y0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_y + 32), y1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_u), u);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_v), v);
+
+    src_uyvy += 128;
+    dst_y += 64;
+    dst_u += 32;
+    dst_v += 32;
+  }
+  if (x < width) UyvyToI422Row_SSE2(src_uyvy, dst_y, dst_u, dst_v, width - x);
+}
+
+// 64 pixels of two rows per iteration, as UyvyToI420Row_SSE2.
+void UyvyToI420Row_AVX2(const uint8_t* src_uyvy, int src_stride_uyvy, uint8_t* dst_y,
+                        int dst_stride_y, uint8_t* dst_u, uint8_t* dst_v, int width) {
+  const __m256i lo_mask = _mm256_set1_epi16(0x00ff);
+  const uint8_t* next = src_uyvy + src_stride_uyvy;
+  uint8_t* next_y = dst_y + dst_stride_y;
+  int x = 0;
+  for (; x + 64 <= width; x += 64) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy + 32));
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy + 64));
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy + 96));
+    __m256i na = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(next));
+    __m256i nb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(next + 32));
+    __m256i nc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(next + 64));
+    __m256i nd = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(next + 96));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_y),
+                        PackUs16Linear(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_y + 32),
+                        PackUs16Linear(_mm256_srli_epi16(c, 8), _mm256_srli_epi16(d, 8)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(next_y),
+                        PackUs16Linear(_mm256_srli_epi16(na, 8), _mm256_srli_epi16(nb, 8)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(next_y + 32),
+                        PackUs16Linear(_mm256_srli_epi16(nc, 8), _mm256_srli_epi16(nd, 8)));
+
+    a = _mm256_avg_epu8(a, na);
+    b = _mm256_avg_epu8(b, nb);
+    c = _mm256_avg_epu8(c, nc);
+    d = _mm256_avg_epu8(d, nd);
+    __m256i uv0 = PackUs16Linear(_mm256_and_si256(a, lo_mask), _mm256_and_si256(b, lo_mask));
+    __m256i uv1 = PackUs16Linear(_mm256_and_si256(c, lo_mask), _mm256_and_si256(d, lo_mask));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_u),
+                        PackUs16Linear(_mm256_and_si256(uv0, lo_mask), _mm256_and_si256(uv1, lo_mask)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_v),
+                        PackUs16Linear(_mm256_srli_epi16(uv0, 8), _mm256_srli_epi16(uv1, 8)));
+
+    src_uyvy += 128;
+    next += 128;
+    dst_y += 64;
+    next_y += 64;
+    dst_u += 32;
+    dst_v += 32;
+  }
+  if (x < width) {
+    UyvyToI420Row_SSE2(src_uyvy, src_stride_uyvy, dst_y, dst_stride_y, dst_u, dst_v, width - x);
+  }
+}
+
+// 12 pixels (two 16-byte v210 groups, one per 128-bit lane) per iteration.
+// Each 32-bit word holds three samples; the first two are spread into 16-bit
+// lanes by one shift, the third by another, and two byte shuffles per output
+// put them back in UYVY order.
+void V210ToUyvy16Row_AVX2(const uint8_t* src_v210, uint16_t* dst_uyvy16, int width) {
+  const __m256i mask0 = _mm256_set1_epi32(0x000003ff);
+  const __m256i mask1 = _mm256_set1_epi32(0x03ff0000);
+  // Word k gives samples 3k .. 3k+2; |ab| holds 3k and 3k+1 in its 16-bit
+  // halves, |c| holds 3k+2 in the low half.
+  const __m256i lo_ab = _mm256_setr_epi8(0, 1, 2, 3, -1, -1, 4, 5, 6, 7, -1, -1, 8, 9, 10, 11,
+                                         0, 1, 2, 3, -1, -1, 4, 5, 6, 7, -1, -1, 8, 9, 10, 11);
+  const __m256i lo_c = _mm256_setr_epi8(-1, -1, -1, -1, 0, 1, -1, -1, -1, -1, 4, 5, -1, -1, -1, -1,
+                                        -1, -1, -1, -1, 0, 1, -1, -1, -1, -1, 4, 5, -1, -1, -1, -1);
+  const __m256i hi_ab = _mm256_setr_epi8(-1, -1, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                         -1, -1, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i hi_c = _mm256_setr_epi8(8, 9, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        8, 9, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+  int x = 0;
+  for (; x + 12 <= width; x += 12) {
+    __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_v210));
+    __m256i ab = _mm256_or_si256(_mm256_and_si256(w, mask0),
+                                 _mm256_and_si256(_mm256_slli_epi32(w, 6), mask1));
+    __m256i c = _mm256_and_si256(_mm256_srli_epi32(w, 20), mask0);
+
+    __m256i lo = _mm256_or_si256(_mm256_shuffle_epi8(ab, lo_ab), _mm256_shuffle_epi8(c, lo_c));
+    __m256i hi = _mm256_or_si256(_mm256_shuffle_epi8(ab, hi_ab), _mm256_shuffle_epi8(c, hi_c));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_uyvy16), _mm256_castsi256_si128(lo));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst_uyvy16 + 8), _mm256_castsi256_si128(hi));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_uyvy16 + 12), _mm256_extracti128_si256(lo, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst_uyvy16 + 20), _mm256_extracti128_si256(hi, 1));
+
+    src_v210 += 32;
+    dst_uyvy16 += 24;
+  }
+  if (x < width) V210ToUyvy16Row_C(src_v210, dst_uyvy16, width - x);
+}
+
+// 16 pixels (32 samples) per iteration.
+void Uyvy16ToUyvyRow_AVX2(const uint16_t* src_uyvy16, uint8_t* dst_uyvy,
+                          const uint16_t* dither, int width) {
+  const __m256i offset =
+      _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dither)));
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy16));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy16 + 16));
+    a = _mm256_srli_epi16(_mm256_add_epi16(a, offset), 2);
+    b = _mm256_srli_epi16(_mm256_add_epi16(b, offset), 2);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_uyvy), PackUs16Linear(a, b));
+    src_uyvy16 += 32;
+    dst_uyvy += 32;
+  }
+  if (x < width) Uyvy16ToUyvyRow_SSE2(src_uyvy16, dst_uyvy, dither, width - x);
+}
+
+// 32 pixels (64 samples) per iteration.
+void Uyvy16ToI210Row_AVX2(const uint16_t* src_uyvy16, uint16_t* dst_y, uint16_t* dst_u,
+                          uint16_t* dst_v, int width) {
+  const __m256i lo_mask = _mm256_set1_epi32(0x0000ffff);
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy16));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy16 + 16));
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy16 + 32));
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy16 + 48));
+
+    __m256i y0 = PackS32Linear(_mm256_srli_epi32(a, 16), _mm256_srli_epi32(b, 16));
+    __m256i y1 = PackS32Linear(_mm256_srli_epi32(c, 16), _mm256_srli_epi32(d, 16));
+
+    __m256i uv0 = PackS32Linear(_mm256_and_si256(a, lo_mask), _mm256_and_si256(b, lo_mask));
+    __m256i uv1 = PackS32Linear(_mm256_and_si256(c, lo_mask), _mm256_and_si256(d, lo_mask));
+    __m256i u = PackS32Linear(_mm256_and_si256(uv0, lo_mask), _mm256_and_si256(uv1, lo_mask));
+    __m256i v = PackS32Linear(_mm256_srli_epi32(uv0, 16), _mm256_srli_epi32(uv1, 16));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_y), y0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_y + 16), y1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_u), u);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_v), v);
+
+    src_uyvy16 += 64;
+    dst_y += 32;
+    dst_u += 16;
+    dst_v += 16;
+  }
+  if (x < width) Uyvy16ToI210Row_SSE2(src_uyvy16, dst_y, dst_u, dst_v, width - x);
+}
+
+// 16 pixels (32 samples) per iteration.
+void Uyvy16ToP210Row_AVX2(const uint16_t* src_uyvy16, uint16_t* dst_y, uint16_t* dst_uv,
+                          int width) {
+  const __m256i lo_mask = _mm256_set1_epi32(0x0000ffff);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy16));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_uyvy16 + 16));
+    __m256i y = PackS32Linear(_mm256_srli_epi32(a, 16), _mm256_srli_epi32(b, 16));
+    __m256i uv = PackS32Linear(_mm256_and_si256(a, lo_mask), _mm256_and_si256(b, lo_mask));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_y), _mm256_slli_epi16(y, 6));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_uv), _mm256_slli_epi16(uv, 6));
+    src_uyvy16 += 32;
+    dst_y += 16;
+    dst_uv += 16;
+  }
+  if (x < width) Uyvy16ToP210Row_SSE2(src_uyvy16, dst_y, dst_uv, width - x);
+}
+
+void AverageRow_AVX2(const uint8_t* src_a, const uint8_t* src_b, uint8_t* dst, int count) {
+  int i = 0;
+  for (; i + 32 <= count; i += 32) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_a + i));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_avg_epu8(a, b));
+  }
+  if (i < count) AverageRow_SSE2(src_a + i, src_b + i, dst + i, count - i);
+}
+
+void AverageRow16_AVX2(const uint16_t* src_a, const uint16_t* src_b, uint16_t* dst,
+                       int count) {
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_a + i));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_avg_epu16(a, b));
+  }
+  if (i < count) AverageRow16_SSE2(src_a + i, src_b + i, dst + i, count - i);
+}
+
+static inline __m256i Widen8To10(__m256i v) {
+  return _mm256_or_si256(_mm256_slli_epi16(v, 2), _mm256_srli_epi16(v, 6));
+}
+
+// 16 pixels per iteration.
+void BgraToRgb16Row_AVX2(const uint8_t* src_bgra, int16_t* dst_r, int16_t* dst_g,
+                         int16_t* dst_b, int width) {
+  const __m256i mask = _mm256_set1_epi32(0xff);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_bgra));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_bgra + 32));
+    __m256i blue = PackS32Linear(_mm256_and_si256(a, mask), _mm256_and_si256(b, mask));
+    __m256i green = PackS32Linear(_mm256_and_si256(_mm256_srli_epi32(a, 8), mask),
+                                  _mm256_and_si256(_mm256_srli_epi32(b, 8), mask));
+    __m256i red = PackS32Linear(_mm256_and_si256(_mm256_srli_epi32(a, 16), mask),
+                                _mm256_and_si256(_mm256_srli_epi32(b, 16), mask));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_r + x), Widen8To10(red));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_g + x), Widen8To10(green));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_b + x), Widen8To10(blue));
+    src_bgra += 64;
+  }
+  if (x < width) BgraToRgb16Row_SSE2(src_bgra, dst_r + x, dst_g + x, dst_b + x, width - x);
+}
+
+// 16 pixels per iteration.
+void R210ToRgb16Row_AVX2(const uint8_t* src_r210, int16_t* dst_r, int16_t* dst_g,
+                         int16_t* dst_b, int width) {
+  const __m256i mask = _mm256_set1_epi32(0x3ff);
+  const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m256i a = _mm256_shuffle_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_r210)), swap);
+    __m256i b = _mm256_shuffle_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_r210 + 32)), swap);
+    __m256i red = PackS32Linear(_mm256_and_si256(_mm256_srli_epi32(a, 20), mask),
+                                _mm256_and_si256(_mm256_srli_epi32(b, 20), mask));
+    __m256i green = PackS32Linear(_mm256_and_si256(_mm256_srli_epi32(a, 10), mask),
+                                  _mm256_and_si256(_mm256_srli_epi32(b, 10), mask));
+    __m256i blue = PackS32Linear(_mm256_and_si256(a, mask), _mm256_and_si256(b, mask));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_r + x), red);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_g + x), green);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_b + x), blue);
+    src_r210 += 64;
+  }
+  if (x < width) R210ToRgb16Row_SSE2(src_r210, dst_r + x, dst_g + x, dst_b + x, width - x);
+}
+
+namespace {
+
+struct MatrixRow {
+  __m256i rg;
+  __m256i b;
+  __m256i offset;
+};
+
+}  // namespace
+
+static inline MatrixRow LoadMatrixRow(const int16_t* c, int32_t offset) {
+  MatrixRow row;
+  row.rg = _mm256_set1_epi32(static_cast<int32_t>(
+      static_cast<uint32_t>(static_cast<uint16_t>(c[1])) << 16 | static_cast<uint16_t>(c[0])));
+  row.b = _mm256_set1_epi32(static_cast<uint16_t>(c[2]));
+  row.offset = _mm256_set1_epi32(offset);
+  return row;
+}
+
+// Applies |m| to 16 pixels. Unpack and pack both work within 128-bit lanes,
+// so the results come out in input order.
+static inline __m256i ApplyMatrix(__m256i r, __m256i g, __m256i b, const MatrixRow& m) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i lo = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(r, g), m.rg),
+                                _mm256_madd_epi16(_mm256_unpacklo_epi16(b, zero), m.b));
+  __m256i hi = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(r, g), m.rg),
+                                _mm256_madd_epi16(_mm256_unpackhi_epi16(b, zero), m.b));
+  lo = _mm256_srai_epi32(_mm256_add_epi32(lo, m.offset), 16);
+  hi = _mm256_srai_epi32(_mm256_add_epi32(hi, m.offset), 16);
+  return _mm256_packs_epi32(lo, hi);
+}
+
+// 32 pixels per iteration.
+void Rgb16ToYRow_AVX2(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                      uint8_t* dst_y, const RgbToYuvCoefficients* coefficients, int width) {
+  const MatrixRow m = LoadMatrixRow(coefficients->y, coefficients->y_offset);
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m256i y0 = ApplyMatrix(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_r + x)),
+                             _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_g + x)),
+                             _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_b + x)), m);
+    __m256i y1 =
+        ApplyMatrix(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_r + x + 16)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_g + x + 16)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_b + x + 16)), m);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_y + x), PackUs16Linear(y0, y1));
+  }
+  if (x < width) {
+    Rgb16ToYRow_SSE2(src_r + x, src_g + x, src_b + x, dst_y + x, coefficients, width - x);
+  }
+}
+
+static inline __m256i EvenSamples(__m256i a, __m256i b) {
+  const __m256i mask = _mm256_set1_epi32(0xffff);
+  return PackS32Linear(_mm256_and_si256(a, mask), _mm256_and_si256(b, mask));
+}
+
+static inline __m256i OddSamples(__m256i a, __m256i b) {
+  return PackS32Linear(_mm256_srli_epi32(a, 16), _mm256_srli_epi32(b, 16));
+}
+
+// [1 2 1] / 4 around the 16 even pixels starting at |src|.
+static inline __m256i FilterChroma(const int16_t* src) {
+  __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+  __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 16));
+  __m256i pa = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src - 1));
+  __m256i pb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 15));
+  __m256i even = EvenSamples(a, b);
+  __m256i sum = _mm256_add_epi16(EvenSamples(pa, pb), OddSamples(a, b));
+  sum = _mm256_add_epi16(sum, _mm256_add_epi16(even, even));
+  return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(2)), 2);
+}
+
+// 32 pixels (16 chroma samples) per iteration.
+void Rgb16ToUVRow_AVX2(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                       uint8_t* dst_u, uint8_t* dst_v, const RgbToYuvCoefficients* coefficients,
+                       int width) {
+  const MatrixRow mu = LoadMatrixRow(coefficients->u, coefficients->uv_offset);
+  const MatrixRow mv = LoadMatrixRow(coefficients->v, coefficients->uv_offset);
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m256i r = FilterChroma(src_r + x);
+    __m256i g = FilterChroma(src_g + x);
+    __m256i b = FilterChroma(src_b + x);
+    // U in the low 128 bits, V in the high.
+    __m256i uv = PackUs16Linear(ApplyMatrix(r, g, b, mu), ApplyMatrix(r, g, b, mv));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_u + x / 2), _mm256_castsi256_si128(uv));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_v + x / 2), _mm256_extracti128_si256(uv, 1));
+  }
+  if (x < width) {
+    Rgb16ToUVRow_SSE2(src_r + x, src_g + x, src_b + x, dst_u + x / 2, dst_v + x / 2,
+                      coefficients, width - x);
+  }
+}
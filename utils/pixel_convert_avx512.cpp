@@ -0,0 +1,130 @@
+// AVX-512 (F + BW) row kernels. Keep this file free of STL includes:
+// everything inlined here is compiled for AVX-512 and must not leak into other
+// translation units.
+#pragma GCC target("avx512f,avx512bw")
+
+#include <immintrin.h>
+
+#include "pixel_convert_row.h"
+
+// _mm512_packus_epi16 packs within 128-bit lanes; this restores linear order
+// of the eight 64-bit quarters. The zero-masking form avoids GCC's bogus
+// maybe-uninitialized warning on the unmasked intrinsic.
+static inline __m512i PackUs16Linear(__m512i a, __m512i b) {
+  const __m512i order = _mm512_set_epi64(7, 5, 3, 1, 6, 4, 2, 0);
+  return _mm512_maskz_permutexvar_epi64(0xff, order, _mm512_packus_epi16(a, b));
+}
+
+// 128 pixels (256 bytes of UYVY) per iteration.
+void UyvyToI422Row_AVX512(const uint8_t* src_uyvy, uint8_t* dst_y, uint8_t* dst_u,
+                          uint8_t* dst_v, int width) {
+  const __m512i lo_mask = _mm512_set1_epi16(0x00ff);
+  int x = 0;
+  for (; x + 128 <= width; x += 128) {
+    __m512i a = _mm512_loadu_si512(src_uyvy);
+    __m512i b = _mm512_loadu_si512(src_uyvy + 64);
+    __m512i c = _mm512_loadu_si512(src_uyvy + 128);
+    __m512i d = _mm512_loadu_si512(src_uyvy + 192);
+
+    __m512i y0 = PackUs16Linear(_mm512_srli_epi16(a, 8), _mm512_srli_epi16(b, 8));
+    __m512i y1 = PackUs16Linear(_mm512_srli_epi16(c, 8), _mm512_srli_epi16(d, 8));
+
+    __m512i uv0 = PackUs16Linear(_mm512_and_si512(a, lo_mask), _mm512_and_si512(b, lo_mask));
+    __m512i uv1 = PackUs16Linear(_mm512_and_si512(c, lo_mask), _mm512_and_si512(d, lo_mask));
+    __m512i u = PackUs16Linear(_mm512_and_si512(uv0, lo_mask), _mm512_and_si512(uv1, lo_mask));
+    __m512i v = PackUs16Linear(_mm512_srli_epi16(uv0, 8), _mm512_srli_epi16(uv1, 8));
+
+    _mm512_storeu_si512(dst_y, y0);
+    _mm512_storeu_si512(dst_y + 64, y1);
+    _mm512_storeu_si512(dst_u, u);
+    _mm512_storeu_si512(dst_v, v);
+
+    src_uyvy += 256;
+    dst_y += 128;
+    dst_u += 64;
+    dst_v += 64;
+  }
+  if (x < width) UyvyToI422Row_AVX2(src_uyvy, dst_y, dst_u, dst_v, width - x);
+}
+
+// 128 pixels of two rows per iteration, as UyvyToI420Row_SSE2.
+void UyvyToI420Row_AVX512(const uint8_t* src_uyvy, int src_stride_uyvy, uint8_t* dst_y,
+                          int dst_stride_y, uint8_t* dst_u, uint8_t* dst_v, int width) {
+  const __m512i lo_mask = _mm512_set1_epi16(0x00ff);
+  const uint8_t* next = src_uyvy + src_stride_uyvy;
+  uint8_t* next_y = dst_y + dst_stride_y;
+  int x = 0;
+  for (; x + 128 <= width; x += 128) {
+    __m512i a = _mm512_loadu_si512(src_uyvy);
+    __m512i b = _mm512_loadu_si512(src_uyvy + 64);
+    __m512i c = _mm512_loadu_si512(src_uyvy + 128);
+    __m512i d = _mm512_loadu_si512(src_uyvy + 192);
+    __m512i na = _mm512_loadu_si512(next);
+    __m512i nb = _mm512_loadu_si512(next + 64);
+    __m512i nc = _mm512_loadu_si512(next + 128);
+    __m512i nd = _mm512_loadu_si512(next + 192);
+
+    _mm512_storeu_si512(dst_y, PackUs16Linear(_mm512_srli_epi16(a, 8), _mm512_srli_epi16(b, 8)));
+    _mm512_storeu_si512(dst_y + 64,
+                        PackUs16Linear(_mm512_srli_epi16(c, 8), _mm512_srli_epi16(d, 8)));
+    _mm512_storeu_si512(next_y,
+                        PackUs16Linear(_mm512_srli_epi16(na, 8), _mm512_srli_epi16(nb, 8)));
+    _mm512_storeu_si512(next_y + 64,
+                        PackUs16Linear(_mm512_srli_epi16(nc, 8), _mm512_srli_epi16(nd, 8)));
+
+    a = _mm512_avg_epu8(a, na);
+    b = _mm512_avg_epu8(b, nb);
+    c = _mm512_avg_epu8(c, nc);
+    d = _mm512_avg_epu8(d, nd);
+    __m512i uv0 = PackUs16Linear(_mm512_and_si512(a, lo_mask), _mm512_and_si512(b, lo_mask));
+    __m512i uv1 = PackUs16Linear(_mm512_and_si512(c, lo_mask), _mm512_and_si512(d, lo_mask));
+    _mm512_storeu_si512(dst_u,
+                        PackUs16Linear(_mm512_and_si512(uv0, lo_mask), _mm512_and_si512(uv1, lo_mask)));
+    _mm512_storeu_si512(dst_v, PackUs16Linear(_mm512_srli_epi16(uv0, 8), _mm512_srli_epi16(uv1, 8)));
+
+    src_uyvy += 256;
+    next += 256;
+    dst_y += 128;
+    next_y += 128;
+    dst_u += 64;
+    dst_v += 64;
+  }
+  if (x < width) {
+    UyvyToI420Row_AVX2(src_uyvy, src_stride_uyvy, dst_y, dst_stride_y, dst_u, dst_v, width - x);
+  }
+}
+
+// Output sample order for four v210 groups: |ab| (indices 0-31) holds samples
+// 3k and 3k+1 of word k, |c| (indices 32-63) holds 3k+2 at even positions.
+// Padded to two full vectors; only the first 48 outputs are stored.
+static const uint16_t kV210Order[64] = {
+    0,  1,  32, 2,  3,  34, 4,  5,  36, 6,  7,  38, 8,  9,  40, 10,
+    11, 42, 12, 13, 44, 14, 15, 46, 16, 17, 48, 18, 19, 50, 20, 21,
+    52, 22, 23, 54, 24, 25, 56, 26, 27, 58, 28, 29, 60, 30, 31, 62};
+
+// 24 pixels (four 16-byte v210 groups) per iteration. Same split as the AVX2
+// kernel, but a two-source word permute restores the order across lanes. The
+// shifts use the zero-masking form for the same reason as PackUs16Linear.
+void V210ToUyvy16Row_AVX512(const uint8_t* src_v210, uint16_t* dst_uyvy16, int width) {
+  const __m512i mask0 = _mm512_set1_epi32(0x000003ff);
+  const __m512i mask1 = _mm512_set1_epi32(0x03ff0000);
+  const __m512i order0 = _mm512_loadu_si512(kV210Order);
+  const __m512i order1 = _mm512_loadu_si512(kV210Order + 32);
+  int x = 0;
+  for (; x + 24 <= width; x += 24) {
+    __m512i w = _mm512_loadu_si512(src_v210);
+    __m512i ab = _mm512_or_si512(_mm512_and_si512(w, mask0),
+                                 _mm512_and_si512(_mm512_maskz_slli_epi32(0xffff, w, 6), mask1));
+    __m512i c = _mm512_and_si512(_mm512_maskz_srli_epi32(0xffff, w, 20), mask0);
+
+    __m512i out0 = _mm512_permutex2var_epi16(ab, order0, c);
+    __m512i out1 = _mm512_permutex2var_epi16(ab, order1, c);
+
+    _mm512_storeu_si512(dst_uyvy16, out0);
+    _mm512_mask_storeu_epi16(dst_uyvy16 + 32, 0xffff, out1);
+
+    src_v210 += 64;
+    dst_uyvy16 += 48;
+  }
+  if (x < width) V210ToUyvy16Row_AVX2(src_v210, dst_uyvy16, width - x);
+}
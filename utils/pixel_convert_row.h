@@ -0,0 +1,177 @@
+#pragma once
+
+// Row kernels behind pixel_convert.h. Each kernel processes one row; the
+// SIMD variants handle the bulk of the row and finish the remainder with a
+// narrower kernel, so any width is accepted.
+//
+// The SIMD variants live in their own translation units, compiled for their
+// instruction set with "#pragma GCC target". Only call them through
+// GetPixelRowKernels(), which checks CpuSupportsIsa().
+
+#include <stdint.h>
+
+#include "utils/cpu_features.h"
+#include "utils/pixel_convert.h"
+
+typedef void (*UyvyToI422RowFunc)(const uint8_t* src_uyvy, uint8_t* dst_y,
+                                  uint8_t* dst_u, uint8_t* dst_v, int width);
+// Converts two UYVY rows (the second at |src_stride_uyvy|) in one pass: both
+// luma rows plus one chroma row averaged between them.
+typedef void (*UyvyToI420RowFunc)(const uint8_t* src_uyvy, int src_stride_uyvy,
+                                  uint8_t* dst_y, int dst_stride_y,
+                                  uint8_t* dst_u, uint8_t* dst_v, int width);
+// Unpacks v210 into 16-bit samples in UYVY order (U0 Y0 V0 Y1 ...). Works on
+// whole 6-pixel groups, so |dst_uyvy16| must hold 2 * RoundUp(width, 6)
+// samples.
+typedef void (*V210ToUyvy16RowFunc)(const uint8_t* src_v210, uint16_t* dst_uyvy16, int width);
+// 10-bit UYVY samples to 8-bit: (sample + dither[i % 8]) >> 2, saturated.
+// |dither| holds 8 offsets in 0..3; all 2 means plain rounding.
+typedef void (*Uyvy16ToUyvyRowFunc)(const uint16_t* src_uyvy16, uint8_t* dst_uyvy,
+                                    const uint16_t* dither, int width);
+// 16-bit UYVY to planar 16-bit 4:2:2, values unchanged (LSB aligned).
+typedef void (*Uyvy16ToI210RowFunc)(const uint16_t* src_uyvy16, uint16_t* dst_y,
+                                    uint16_t* dst_u, uint16_t* dst_v, int width);
+// 10-bit UYVY to MSB aligned luma and interleaved UV (P210/P010 layout).
+typedef void (*Uyvy16ToP210RowFunc)(const uint16_t* src_uyvy16, uint16_t* dst_y,
+                                    uint16_t* dst_uv, int width);
+// dst[i] = (a[i] + b[i] + 1) >> 1.
+typedef void (*AverageRowFunc)(const uint8_t* src_a, const uint8_t* src_b, uint8_t* dst,
+                               int count);
+typedef void (*AverageRow16Func)(const uint16_t* src_a, const uint16_t* src_b,
+                                 uint16_t* dst, int count);
+
+// RGB rows go through planar 16-bit R, G, B scratch rows holding 10-bit
+// values; 8-bit input is widened as (v << 2) | (v >> 6) so white stays 1023.
+typedef void (*RgbUnpackRowFunc)(const uint8_t* src, int16_t* dst_r, int16_t* dst_g,
+                                 int16_t* dst_b, int width);
+
+// Fixed-point (16 fractional bits) matrix from 10-bit RGB, full range or video
+// levels, to 8-bit YUV. Offsets include the input black level, the output bias
+// and the rounding term.
+struct RgbToYuvCoefficients {
+  int16_t y[3];  // R G B
+  int16_t u[3];
+  int16_t v[3];
+  int32_t y_offset;
+  int32_t uv_offset;
+};
+
+typedef void (*RgbToYRowFunc)(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                              uint8_t* dst_y, const RgbToYuvCoefficients* coefficients,
+                              int width);
+// Produces width / 2 chroma samples co-sited with the even pixels, filtered
+// [1 2 1] / 4 horizontally. Reads one sample left of each source row, which
+// the caller must fill (replicating the first pixel at the left edge).
+typedef void (*RgbToUVRowFunc)(const int16_t* src_r, const int16_t* src_g,
+                               const int16_t* src_b, uint8_t* dst_u, uint8_t* dst_v,
+                               const RgbToYuvCoefficients* coefficients, int width);
+
+// One set of row kernels per instruction set. Slots without a dedicated
+// variant for an ISA hold the next narrower one.
+struct PixelRowKernels {
+  CpuIsa isa;
+  UyvyToI422RowFunc uyvy_to_i422;
+  UyvyToI420RowFunc uyvy_to_i420;
+  V210ToUyvy16RowFunc v210_to_uyvy16;
+  Uyvy16ToUyvyRowFunc uyvy16_to_uyvy;
+  Uyvy16ToI210RowFunc uyvy16_to_i210;
+  Uyvy16ToP210RowFunc uyvy16_to_p210;
+  AverageRowFunc average_row;
+  AverageRow16Func average_row16;
+  RgbUnpackRowFunc bgra_to_rgb16;
+  RgbUnpackRowFunc r210_to_rgb16;
+  RgbToYRowFunc rgb16_to_y;
+  RgbToUVRowFunc rgb16_to_uv;
+};
+
+// Returns the kernels for |isa|, or nullptr if the CPU lacks |isa|.
+const PixelRowKernels* GetPixelRowKernels(CpuIsa isa);
+
+// Returns the precomputed matrix for |matrix|, |input_range| and |range|.
+const RgbToYuvCoefficients* GetRgbToYuvCoefficients(YuvColorMatrix matrix, RgbRange input_range,
+                                                    YuvRange range);
+
+void UyvyToI422Row_C(const uint8_t* src_uyvy, uint8_t* dst_y, uint8_t* dst_u,
+                     uint8_t* dst_v, int width);
+void UyvyToI422Row_SSE2(const uint8_t* src_uyvy, uint8_t* dst_y, uint8_t* dst_u,
+                        uint8_t* dst_v, int width);
+void UyvyToI422Row_AVX2(const uint8_t* src_uyvy, uint8_t* dst_y, uint8_t* dst_u,
+                        uint8_t* dst_v, int width);
+void UyvyToI422Row_AVX512(const uint8_t* src_uyvy, uint8_t* dst_y, uint8_t* dst_u,
+                          uint8_t* dst_v, int width);
+
+void UyvyToI420Row_C(const uint8_t* src_uyvy, int src_stride_uyvy, uint8_t* dst_y,
+                     int dst_stride_y, uint8_t* dst_u, uint8_t* dst_v, int width);
+void UyvyToI420Row_SSE2(const uint8_t* src_uyvy, int src_stride_uyvy, uint8_t* dst_y,
+                        int dst_stride_y, uint8_t* dst_u, uint8_t* dst_v, int width);
+void UyvyToI420Row_AVX2(const uint8_t* src_uyvy, int src_stride_uyvy, uint8_t* dst_y,
+                        int dst_stride_y, uint8_t* dst_u, uint8_t* dst_v, int width);
+void UyvyToI420Row_AVX512(const uint8_t* src_uyvy, int src_stride_uyvy, uint8_t* dst_y,
+                          int dst_stride_y, uint8_t* dst_u, uint8_t* dst_v, int width);
+
+// The v210 unpack needs a byte shuffle (SSSE3), so there is no SSE2 variant.
+void V210ToUyvy16Row_C(const uint8_t* src_v210, uint16_t* dst_uyvy16, int width);
+void V210ToUyvy16Row_AVX2(const uint8_t* src_v210, uint16_t* dst_uyvy16, int width);
+void V210ToUyvy16Row_AVX512(const uint8_t* src_v210, uint16_t* dst_uyvy16, int width);
+
+void Uyvy16ToUyvyRow_C(const uint16_t* src_uyvy16, uint8_t* dst_uyvy, const uint16_t* dither,
+                       int width);
+void Uyvy16ToUyvyRow_SSE2(const uint16_t* src_uyvy16, uint8_t* dst_uyvy,
+                          const uint16_t* dither, int width);
+void Uyvy16ToUyvyRow_AVX2(const uint16_t* src_uyvy16, uint8_t* dst_uyvy,
+                          const uint16_t* dither, int width);
+
+void Uyvy16ToI210Row_C(const uint16_t* src_uyvy16, uint16_t* dst_y, uint16_t* dst_u,
+                       uint16_t* dst_v, int width);
+void Uyvy16ToI210Row_SSE2(const uint16_t* src_uyvy16, uint16_t* dst_y, uint16_t* dst_u,
+                          uint16_t* dst_v, int width);
+void Uyvy16ToI210Row_AVX2(const uint16_t* src_uyvy16, uint16_t* dst_y, uint16_t* dst_u,
+                          uint16_t* dst_v, int width);
+
+void Uyvy16ToP210Row_C(const uint16_t* src_uyvy16, uint16_t* dst_y, uint16_t* dst_uv,
+                       int width);
+void Uyvy16ToP210Row_SSE2(const uint16_t* src_uyvy16, uint16_t* dst_y, uint16_t* dst_uv,
+                          int width);
+void Uyvy16ToP210Row_AVX2(const uint16_t* src_uyvy16, uint16_t* dst_y, uint16_t* dst_uv,
+                          int width);
+
+void AverageRow_C(const uint8_t* src_a, const uint8_t* src_b, uint8_t* dst, int count);
+void AverageRow_SSE2(const uint8_t* src_a, const uint8_t* src_b, uint8_t* dst, int count);
+void AverageRow_AVX2(const uint8_t* src_a, const uint8_t* src_b, uint8_t* dst, int count);
+
+void AverageRow16_C(const uint16_t* src_a, const uint16_t* src_b, uint16_t* dst, int count);
+void AverageRow16_SSE2(const uint16_t* src_a, const uint16_t* src_b, uint16_t* dst,
+                       int count);
+void AverageRow16_AVX2(const uint16_t* src_a, const uint16_t* src_b, uint16_t* dst,
+                       int count);
+
+void BgraToRgb16Row_C(const uint8_t* src_bgra, int16_t* dst_r, int16_t* dst_g, int16_t* dst_b,
+                      int width);
+void BgraToRgb16Row_SSE2(const uint8_t* src_bgra, int16_t* dst_r, int16_t* dst_g,
+                         int16_t* dst_b, int width);
+void BgraToRgb16Row_AVX2(const uint8_t* src_bgra, int16_t* dst_r, int16_t* dst_g,
+                         int16_t* dst_b, int width);
+
+void R210ToRgb16Row_C(const uint8_t* src_r210, int16_t* dst_r, int16_t* dst_g, int16_t* dst_b,
+                      int width);
+void R210ToRgb16Row_SSE2(const uint8_t* src_r210, int16_t* dst_r, int16_t* dst_g,
+                         int16_t* dst_b, int width);
+void R210ToRgb16Row_AVX2(const uint8_t* src_r210, int16_t* dst_r, int16_t* dst_g,
+                         int16_t* dst_b, int width);
+
+void Rgb16ToYRow_C(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                   uint8_t* dst_y, const RgbToYuvCoefficients* coefficients, int width);
+void Rgb16ToYRow_SSE2(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                      uint8_t* dst_y, const RgbToYuvCoefficients* coefficients, int width);
+void Rgb16ToYRow_AVX2(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                      uint8_t* dst_y, const RgbToYuvCoefficients* coefficients, int width);
+
+void Rgb16ToUVRow_C(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                    uint8_t* dst_u, uint8_t* dst_v, const RgbToYuvCoefficients* coefficients,
+                    int width);
+void Rgb16ToUVRow_SSE2(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                       uint8_t* dst_u, uint8_t* dst_v, const RgbToYuvCoefficients* coefficients,
+                       int width);
+void Rgb16ToUVRow_AVX2(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                       uint8_t* dst_u, uint8_t* dst_v, const RgbToYuvCoefficients* coefficients,
+                       int width);
@@ -0,0 +1,327 @@
+// SSE2 row kernels. Keep this file free of STL includes: everything inlined
+// here is compiled for SSE2 and must not leak into other translation units.
+#pragma GCC target("sse2")
+
+#include <immintrin.h>
+
+#include "pixel_convert_row.h"
+
+// 32 pixels (64 bytes of UYVY) per iteration.
+void UyvyToI422Row_SSE2(const uint8_t* src_uyvy, uint8_t* dst_y, uint8_t* dst_u,
+                        uint8_t* dst_v, int width) {
+  const __m128i lo_mask = _mm_set1_epi16(0x00ff);
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy + 16));
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy + 32));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy + 48));
+
+    // Luma sits in the odd bytes.
+    __m128i y0 = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+    __m128i y1 = _mm_packus_epi16(_mm_srli_epi16(c, 8), _mm_srli_epi16(d, 8));
+
+    // Even bytes are U V U V ...; split them once more.
+    __m128i uv0 = _mm_packus_epi16(_mm_and_si128(a, lo_mask), _mm_and_si128(b, lo_mask));
+    __m128i uv1 = _mm_packus_epi16(_mm_and_si128(c, lo_mask), _mm_and_si128(d, lo_mask));
+    __m128i u = _mm_packus_epi16(_mm_and_si128(uv0, lo_mask), _mm_and_si128(uv1, lo_mask));
+    __m128i v = _mm_packus_epi16(_mm_srli_epi16(uv0, 8), _mm_srli_epi16(uv1, 8));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_y), y0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_y + 16), y1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_u), u);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_v), v);
+
+    src_uyvy += 64;
+    dst_y += 32;
+    dst_u += 16;
+    dst_v += 16;
+  }
+  if (x < width) UyvyToI422Row_C(src_uyvy, dst_y, dst_u, dst_v, width - x);
+}
+
+// 32 pixels of two rows per iteration. Chroma is averaged on the packed
+// bytes before splitting; the averaged luma bytes are discarded.
+void UyvyToI420Row_SSE2(const uint8_t* src_uyvy, int src_stride_uyvy, uint8_t* dst_y,
+                        int dst_stride_y, uint8_t* dst_u, uint8_t* dst_v, int width) {
+  const __m128i lo_mask = _mm_set1_epi16(0x00ff);
+  const uint8_t* next = src_uyvy + src_stride_uyvy;
+  uint8_t* next_y = dst_y + dst_stride_y;
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy + 16));
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy + 32));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy + 48));
+    __m128i na = _mm_loadu_si128(reinterpret_cast<const __m128i*>(next));
+    __m128i nb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(next + 16));
+    __m128i nc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(next + 32));
+    __m128i nd = _mm_loadu_si128(reinterpret_cast<const __m128i*>(next + 48));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_y),
+                     _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_y + 16),
+                     _mm_packus_epi16(_mm_srli_epi16(c, 8), _mm_srli_epi16(d, 8)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(next_y),
+                     _mm_packus_epi16(_mm_srli_epi16(na, 8), _mm_srli_epi16(nb, 8)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(next_y + 16),
+                     _mm_packus_epi16(_mm_srli_epi16(nc, 8), _mm_srli_epi16(nd, 8)));
+
+    a = _mm_avg_epu8(a, na);
+    b = _mm_avg_epu8(b, nb);
+    c = _mm_avg_epu8(c, nc);
+    d = _mm_avg_epu8(d, nd);
+    __m128i uv0 = _mm_packus_epi16(_mm_and_si128(a, lo_mask), _mm_and_si128(b, lo_mask));
+    __m128i uv1 = _mm_packus_epi16(_mm_and_si128(c, lo_mask), _mm_and_si128(d, lo_mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_u),
+                     _mm_packus_epi16(_mm_and_si128(uv0, lo_mask), _mm_and_si128(uv1, lo_mask)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_v),
+                     _mm_packus_epi16(_mm_srli_epi16(uv0, 8), _mm_srli_epi16(uv1, 8)));
+
+    src_uyvy += 64;
+    next += 64;
+    dst_y += 32;
+    next_y += 32;
+    dst_u += 16;
+    dst_v += 16;
+  }
+  if (x < width) {
+    UyvyToI420Row_C(src_uyvy, src_stride_uyvy, dst_y, dst_stride_y, dst_u, dst_v, width - x);
+  }
+}
+
+// 8 pixels (16 samples) per iteration; |dither| repeats every 8 samples.
+void Uyvy16ToUyvyRow_SSE2(const uint16_t* src_uyvy16, uint8_t* dst_uyvy,
+                          const uint16_t* dither, int width) {
+  const __m128i offset = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither));
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy16));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy16 + 8));
+    a = _mm_srli_epi16(_mm_add_epi16(a, offset), 2);
+    b = _mm_srli_epi16(_mm_add_epi16(b, offset), 2);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_uyvy), _mm_packus_epi16(a, b));
+    src_uyvy16 += 16;
+    dst_uyvy += 16;
+  }
+  if (x < width) Uyvy16ToUyvyRow_C(src_uyvy16, dst_uyvy, dither, width - x);
+}
+
+// 16 pixels (32 samples) per iteration. Samples are at most 10 bits, so the
+// signed 32-to-16 bit pack never saturates.
+void Uyvy16ToI210Row_SSE2(const uint16_t* src_uyvy16, uint16_t* dst_y, uint16_t* dst_u,
+                          uint16_t* dst_v, int width) {
+  const __m128i lo_mask = _mm_set1_epi32(0x0000ffff);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy16));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy16 + 8));
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy16 + 16));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy16 + 24));
+
+    __m128i y0 = _mm_packs_epi32(_mm_srli_epi32(a, 16), _mm_srli_epi32(b, 16));
+    __m128i y1 = _mm_packs_epi32(_mm_srli_epi32(c, 16), _mm_srli_epi32(d, 16));
+
+    __m128i uv0 = _mm_packs_epi32(_mm_and_si128(a, lo_mask), _mm_and_si128(b, lo_mask));
+    __m128i uv1 = _mm_packs_epi32(_mm_and_si128(c, lo_mask), _mm_and_si128(d, lo_mask));
+    __m128i u = _mm_packs_epi32(_mm_and_si128(uv0, lo_mask), _mm_and_si128(uv1, lo_mask));
+    __m128i v = _mm_packs_epi32(_mm_srli_epi32(uv0, 16), _mm_srli_epi32(uv1, 16));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_y), y0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_y + 8), y1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_u), u);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_v), v);
+
+    src_uyvy16 += 32;
+    dst_y += 16;
+    dst_u += 8;
+    dst_v += 8;
+  }
+  if (x < width) Uyvy16ToI210Row_C(src_uyvy16, dst_y, dst_u, dst_v, width - x);
+}
+
+// 8 pixels (16 samples) per iteration.
+void Uyvy16ToP210Row_SSE2(const uint16_t* src_uyvy16, uint16_t* dst_y, uint16_t* dst_uv,
+                          int width) {
+  const __m128i lo_mask = _mm_set1_epi32(0x0000ffff);
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy16));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_uyvy16 + 8));
+    __m128i y = _mm_packs_epi32(_mm_srli_epi32(a, 16), _mm_srli_epi32(b, 16));
+    __m128i uv = _mm_packs_epi32(_mm_and_si128(a, lo_mask), _mm_and_si128(b, lo_mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_y), _mm_slli_epi16(y, 6));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_uv), _mm_slli_epi16(uv, 6));
+    src_uyvy16 += 16;
+    dst_y += 8;
+    dst_uv += 8;
+  }
+  if (x < width) Uyvy16ToP210Row_C(src_uyvy16, dst_y, dst_uv, width - x);
+}
+
+void AverageRow_SSE2(const uint8_t* src_a, const uint8_t* src_b, uint8_t* dst, int count) {
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_a + i));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_b + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_avg_epu8(a, b));
+  }
+  if (i < count) AverageRow_C(src_a + i, src_b + i, dst + i, count - i);
+}
+
+void AverageRow16_SSE2(const uint16_t* src_a, const uint16_t* src_b, uint16_t* dst,
+                       int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_a + i));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_b + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_avg_epu16(a, b));
+  }
+  if (i < count) AverageRow16_C(src_a + i, src_b + i, dst + i, count - i);
+}
+
+// 10-bit widening of 8-bit samples, see RgbUnpackRowFunc.
+static inline __m128i Widen8To10(__m128i v) {
+  return _mm_or_si128(_mm_slli_epi16(v, 2), _mm_srli_epi16(v, 6));
+}
+
+// 8 pixels per iteration.
+void BgraToRgb16Row_SSE2(const uint8_t* src_bgra, int16_t* dst_r, int16_t* dst_g,
+                         int16_t* dst_b, int width) {
+  const __m128i mask = _mm_set1_epi32(0xff);
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_bgra));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_bgra + 16));
+    __m128i blue = _mm_packs_epi32(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+    __m128i green = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(a, 8), mask),
+                                    _mm_and_si128(_mm_srli_epi32(b, 8), mask));
+    __m128i red = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(a, 16), mask),
+                                  _mm_and_si128(_mm_srli_epi32(b, 16), mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_r + x), Widen8To10(red));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_g + x), Widen8To10(green));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_b + x), Widen8To10(blue));
+    src_bgra += 32;
+  }
+  if (x < width) BgraToRgb16Row_C(src_bgra, dst_r + x, dst_g + x, dst_b + x, width - x);
+}
+
+// Byte swaps each 32-bit word: bytes within 16-bit halves, then the halves.
+static inline __m128i ByteSwap32(__m128i v) {
+  v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+  return _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+}
+
+// 8 pixels per iteration.
+void R210ToRgb16Row_SSE2(const uint8_t* src_r210, int16_t* dst_r, int16_t* dst_g,
+                         int16_t* dst_b, int width) {
+  const __m128i mask = _mm_set1_epi32(0x3ff);
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i a = ByteSwap32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src_r210)));
+    __m128i b = ByteSwap32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src_r210 + 16)));
+    __m128i red = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(a, 20), mask),
+                                  _mm_and_si128(_mm_srli_epi32(b, 20), mask));
+    __m128i green = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(a, 10), mask),
+                                    _mm_and_si128(_mm_srli_epi32(b, 10), mask));
+    __m128i blue = _mm_packs_epi32(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_r + x), red);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_g + x), green);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_b + x), blue);
+    src_r210 += 32;
+  }
+  if (x < width) R210ToRgb16Row_C(src_r210, dst_r + x, dst_g + x, dst_b + x, width - x);
+}
+
+namespace {
+
+// One row of the matrix, with R and G weights paired for pmaddwd.
+struct MatrixRow {
+  __m128i rg;
+  __m128i b;
+  __m128i offset;
+};
+
+}  // namespace
+
+static inline MatrixRow LoadMatrixRow(const int16_t* c, int32_t offset) {
+  MatrixRow row;
+  row.rg = _mm_set1_epi32(static_cast<int32_t>(static_cast<uint32_t>(static_cast<uint16_t>(c[1])) << 16 |
+                                               static_cast<uint16_t>(c[0])));
+  row.b = _mm_set1_epi32(static_cast<uint16_t>(c[2]));
+  row.offset = _mm_set1_epi32(offset);
+  return row;
+}
+
+// Applies |m| to 8 pixels; returns 8 signed 16-bit results.
+static inline __m128i ApplyMatrix(__m128i r, __m128i g, __m128i b, const MatrixRow& m) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(r, g), m.rg),
+                             _mm_madd_epi16(_mm_unpacklo_epi16(b, zero), m.b));
+  __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(r, g), m.rg),
+                             _mm_madd_epi16(_mm_unpackhi_epi16(b, zero), m.b));
+  lo = _mm_srai_epi32(_mm_add_epi32(lo, m.offset), 16);
+  hi = _mm_srai_epi32(_mm_add_epi32(hi, m.offset), 16);
+  return _mm_packs_epi32(lo, hi);
+}
+
+// 16 pixels per iteration.
+void Rgb16ToYRow_SSE2(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                      uint8_t* dst_y, const RgbToYuvCoefficients* coefficients, int width) {
+  const MatrixRow m = LoadMatrixRow(coefficients->y, coefficients->y_offset);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i y0 = ApplyMatrix(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src_r + x)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_g + x)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_b + x)), m);
+    __m128i y1 = ApplyMatrix(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src_r + x + 8)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_g + x + 8)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_b + x + 8)), m);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_y + x), _mm_packus_epi16(y0, y1));
+  }
+  if (x < width) Rgb16ToYRow_C(src_r + x, src_g + x, src_b + x, dst_y + x, coefficients, width - x);
+}
+
+// Even 16-bit elements of a and b, in order. Inputs are 10-bit, so the
+// signed pack never saturates.
+static inline __m128i EvenSamples(__m128i a, __m128i b) {
+  const __m128i mask = _mm_set1_epi32(0xffff);
+  return _mm_packs_epi32(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+}
+
+static inline __m128i OddSamples(__m128i a, __m128i b) {
+  return _mm_packs_epi32(_mm_srli_epi32(a, 16), _mm_srli_epi32(b, 16));
+}
+
+// [1 2 1] / 4 around the 8 even pixels starting at |src|.
+static inline __m128i FilterChroma(const int16_t* src) {
+  __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8));
+  __m128i pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src - 1));
+  __m128i pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 7));
+  __m128i even = EvenSamples(a, b);
+  __m128i sum = _mm_add_epi16(EvenSamples(pa, pb), OddSamples(a, b));
+  sum = _mm_add_epi16(sum, _mm_add_epi16(even, even));
+  return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+}
+
+// 16 pixels (8 chroma samples) per iteration.
+void Rgb16ToUVRow_SSE2(const int16_t* src_r, const int16_t* src_g, const int16_t* src_b,
+                       uint8_t* dst_u, uint8_t* dst_v, const RgbToYuvCoefficients* coefficients,
+                       int width) {
+  const MatrixRow mu = LoadMatrixRow(coefficients->u, coefficients->uv_offset);
+  const MatrixRow mv = LoadMatrixRow(coefficients->v, coefficients->uv_offset);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i r = FilterChroma(src_r + x);
+    __m128i g = FilterChroma(src_g + x);
+    __m128i b = FilterChroma(src_b + x);
+    __m128i uv = _mm_packus_epi16(ApplyMatrix(r, g, b, mu), ApplyMatrix(r, g, b, mv));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst_u + x / 2), uv);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst_v + x / 2), _mm_srli_si128(uv, 8));
+  }
+  if (x < width) {
+    Rgb16ToUVRow_C(src_r + x, src_g + x, src_b + x, dst_u + x / 2, dst_v + x / 2, coefficients,
+                   width - x);
+  }
+}
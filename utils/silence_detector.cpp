@@ -0,0 +1,75 @@
+#include "silence_detector.h"
+
+#include <math.h>
+
+const double SilenceDetector::kCrestDb = 20.0;
+
+static const double kFullScale = 32768.0;
+
+static double DbfsToMagnitude(double dbfs) { return kFullScale * pow(10.0, dbfs / 20.0); }
+
+static int DbfsToPeak(double dbfs) {
+  double magnitude = DbfsToMagnitude(dbfs);
+  return magnitude > 32767.0 ? 32767 : static_cast<int>(magnitude);
+}
+
+SilenceDetector::SilenceDetector()
+    : enter_mean_square_(0),
+      exit_mean_square_(0),
+      enter_peak_(0),
+      exit_peak_(0),
+      hold_chunks_(1),
+      quiet_chunks_(0),
+      silent_(false) {}
+
+void SilenceDetector::Init(double threshold_dbfs, double hysteresis_db, int hold_chunks) {
+  if (hysteresis_db < 0) hysteresis_db = 0;
+  double enter = DbfsToMagnitude(threshold_dbfs);
+  double exit = DbfsToMagnitude(threshold_dbfs + hysteresis_db);
+  enter_mean_square_ = enter * enter;
+  exit_mean_square_ = exit * exit;
+  enter_peak_ = DbfsToPeak(threshold_dbfs + kCrestDb);
+  exit_peak_ = DbfsToPeak(threshold_dbfs + hysteresis_db + kCrestDb);
+  hold_chunks_ = hold_chunks > 0 ? hold_chunks : 1;
+  Reset();
+}
+
+void SilenceDetector::Reset() {
+  quiet_chunks_ = 0;
+  silent_ = false;
+}
+
+bool SilenceDetector::Update(const AudioLevel& level, int count) {
+  double mean_square = count > 0 ? static_cast<double>(level.sum_squares) / count : 0.0;
+
+  if (silent_) {
+    if (mean_square > exit_mean_square_ || level.peak > exit_peak_) {
+      silent_ = false;
+      quiet_chunks_ = 0;
+    }
+    return silent_;
+  }
+
+  if (mean_square < enter_mean_square_ && level.peak < enter_peak_) {
+    if (++quiet_chunks_ >= hold_chunks_) silent_ = true;
+  } else {
+    quiet_chunks_ = 0;
+  }
+  return silent_;
+}
+
+// Uniform noise in [-a, a] has an RMS of a / sqrt(3).
+void GenerateComfortNoise(int16_t* dst, int count, double level_dbfs, uint32_t* state) {
+  int amplitude = static_cast<int>(DbfsToMagnitude(level_dbfs) * sqrt(3.0) + 0.5);
+  if (amplitude > 32767) amplitude = 32767;
+  uint32_t x = *state ? *state : 1;
+  uint32_t range = 2 * static_cast<uint32_t>(amplitude) + 1;
+  for (int i = 0; i < count; i++) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    dst[i] = static_cast<int16_t>(static_cast<int>((static_cast<uint64_t>(x) * range) >> 32) -
+                                  amplitude);
+  }
+  *state = x;
+}
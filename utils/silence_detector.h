@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "audio_convert.h"
+
+// What the sender does with audio the SilenceDetector calls silent.
+enum DtxMode {
+  kDtxOff = 0,         // Send it unchanged
+  kDtxComfortNoise,    // Replace it with low-level noise
+  kDtxSkip,            // Send nothing
+};
+
+// Classifies fixed-size chunks of 16-bit PCM as active or silent, with
+// hysteresis so that fades and pauses between words do not toggle it.
+//
+// A chunk is quiet when its RMS is below |threshold_dbfs| and its peak is
+// below the threshold plus a crest allowance. After |hold_chunks| quiet
+// chunks in a row the detector turns silent; it turns active again on the
+// first chunk whose RMS or peak exceeds those levels by |hysteresis_db|.
+// Thresholds are kept as linear energy and magnitude, so a chunk costs one
+// MeasureAudioLevel() and no logarithms.
+class SilenceDetector {
+ public:
+  SilenceDetector();
+
+  void Init(double threshold_dbfs, double hysteresis_db, int hold_chunks);
+  void Reset();
+
+  // Feeds one chunk of |count| samples; returns true while silent.
+  bool Update(const AudioLevel& level, int count);
+  bool silent() const { return silent_; }
+
+ private:
+  // Allowed peak-to-RMS ratio of a quiet chunk, so that a click in
+  // otherwise silent audio still counts as activity.
+  static const double kCrestDb;
+
+  double enter_mean_square_;
+  double exit_mean_square_;
+  int enter_peak_;
+  int exit_peak_;
+  int hold_chunks_;
+  int quiet_chunks_;
+  bool silent_;
+};
+
+// Fills |count| samples with white noise at |level_dbfs| RMS. |state| is a
+// non-zero xorshift32 seed, updated in place.
+void GenerateComfortNoise(int16_t* dst, int count, double level_dbfs, uint32_t* state);
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <type_traits>
+#include <vector>
+
+// What a full ring does with a new item.
+enum RingOverflowPolicy {
+  kRingDropNewest = 0,  // Refuse the new item; the queue keeps its backlog.
+  kRingDropOldest = 1,  // Evict the oldest queued item to make room.
+};
+
+// Bounded lock-free single-producer/single-consumer ring.
+//
+// Storage is allocated once in the constructor; Push/Pop never allocate. The
+// producer may evict the oldest item when the ring is full, so the read index
+// is advanced with a compare-and-swap by both sides: whoever wins the CAS owns
+// the item. A consumer that loses the race discards the slot it copied, which
+// is why T must be trivially copyable (typically a handful of pointers).
+template <typename T>
+class SpscRing {
+  static_assert(std::is_trivially_copyable<T>::value, "SpscRing items must be trivially copyable");
+
+ public:
+  explicit SpscRing(size_t capacity)
+      : slots_(capacity > 0 ? capacity : 1), head_(0), tail_(0) {}
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  size_t Capacity() const { return slots_.size(); }
+
+  // Number of queued items. Exact when called from either end, approximate
+  // from any other thread.
+  size_t Size() const {
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    return tail > head ? static_cast<size_t>(tail - head) : 0;
+  }
+
+  bool Empty() const { return Size() == 0; }
+
+  // Producer side. Returns false (and leaves |item| with the caller) if the
+  // ring is full.
+  bool TryPush(const T& item) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= slots_.size()) return false;
+    slots_[tail % slots_.size()] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Producer side. Queues |item| according to |policy|. Returns true if
+  // |item| was queued. If an older item was evicted to make room, it is
+  // handed back in |*dropped| and |*has_dropped| is set; the caller owns it.
+  bool Push(const T& item, RingOverflowPolicy policy, T* dropped, bool* has_dropped) {
+    *has_dropped = false;
+    if (TryPush(item)) return true;
+    if (policy == kRingDropNewest) return false;
+
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail - head >= slots_.size()) {
+      T oldest = slots_[head % slots_.size()];
+      if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+        *dropped = oldest;
+        *has_dropped = true;
+        break;
+      }
+      // The consumer popped concurrently; |head| now holds the new value.
+    }
+    slots_[tail % slots_.size()] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false if the ring is empty.
+  bool TryPop(T* item) {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    while (head != tail_.load(std::memory_order_acquire)) {
+      T value = slots_[head % slots_.size()];
+      if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+        *item = value;
+        return true;
+      }
+      // The producer evicted this slot; retry with the updated |head|.
+    }
+    return false;
+  }
+
+ private:
+  // The padding keeps the two indices on separate cache lines without
+  // needing over-aligned allocation (not available before C++17).
+  std::vector<T> slots_;
+  char pad0_[64];
+  std::atomic<uint64_t> head_;
+  char pad1_[64 - sizeof(std::atomic<uint64_t>)];
+  std::atomic<uint64_t> tail_;
+};
@@ -0,0 +1,155 @@
+#include "test_signal.h"
+
+#include <math.h>
+#include <string.h>
+
+const int TestPatternGenerator::kBarScrollPixels;
+const int TestPatternGenerator::kCounterBits;
+const int TestToneGenerator::kSampleRate;
+const int TestToneGenerator::kToneHz;
+const int TestToneGenerator::kIdentPeriodMs;
+const int TestToneGenerator::kIdentGapMs;
+const int TestToneGenerator::kCycleSamples;
+
+// 75% colour bars in BT.709 video range: white, yellow, cyan, green,
+// magenta, red, blue, as Y, Cb, Cr.
+static const uint8_t kBars[7][3] = {
+    {180, 128, 128}, {168, 44, 136}, {145, 147, 44}, {133, 63, 52},
+    {63, 193, 204},  {51, 109, 212}, {28, 212, 120},
+};
+
+static const uint8_t kBlack = 16;
+static const uint8_t kWhite = 235;
+static const uint8_t kNeutralChroma = 128;
+
+// Luma thresholds for reading the barcode back.
+static const uint8_t kDecodeBlackMax = 64;
+static const uint8_t kDecodeWhiteMin = 192;
+
+static void PatternLayout(int height, int* bar_rows, int* counter_top) {
+  int counter_rows = (height / 12) & ~1;
+  if (counter_rows < 2) counter_rows = 2;
+  *bar_rows = (height * 7 / 12) & ~1;
+  *counter_top = height - counter_rows;
+}
+
+TestPatternGenerator::TestPatternGenerator()
+    : width_(0), height_(0), bar_rows_(0), counter_top_(0) {}
+
+bool TestPatternGenerator::Init(int width, int height) {
+  if (width < 2 * kCounterBits || (width & 1) != 0 || height < 24) return false;
+
+  width_ = width;
+  height_ = height;
+  PatternLayout(height, &bar_rows_, &counter_top_);
+
+  bar_row_.resize(row_bytes() * 2);
+  for (int x = 0; x < 2 * width; x += 2) {
+    const uint8_t* bar = kBars[(x % width) * 7 / width];
+    uint8_t* p = &bar_row_[static_cast<size_t>(x) * 2];
+    p[0] = bar[1];
+    p[1] = bar[0];
+    p[2] = bar[2];
+    p[3] = bar[0];
+  }
+
+  // Phase k * r^2 reaches half a cycle per pixel at the left and right edges
+  const int zone_rows = counter_top_ - bar_rows_;
+  const double half_width = width / 2.0;
+  const double k = M_PI / (2.0 * half_width);
+  zone_plate_.resize(row_bytes() * zone_rows);
+  for (int y = 0; y < zone_rows; y++) {
+    double dy = y + 0.5 - zone_rows / 2.0;
+    uint8_t* row = &zone_plate_[row_bytes() * y];
+    for (int x = 0; x < width; x++) {
+      double dx = x + 0.5 - half_width;
+      row[x * 2] = kNeutralChroma;
+      row[x * 2 + 1] = static_cast<uint8_t>(126 + lround(109.0 * cos(k * (dx * dx + dy * dy))));
+    }
+  }
+  return true;
+}
+
+void TestPatternGenerator::RenderUyvy(uint32_t frame_number, uint8_t* dst, size_t stride,
+                                      bool static_valid) const {
+  const size_t bytes = row_bytes();
+  const size_t scroll =
+      static_cast<size_t>((static_cast<uint64_t>(frame_number) * kBarScrollPixels) % width_) * 2;
+
+  for (int y = 0; y < bar_rows_; y++) {
+    memcpy(dst + stride * y, &bar_row_[scroll], bytes);
+  }
+
+  if (!static_valid) {
+    for (int y = bar_rows_; y < counter_top_; y++) {
+      memcpy(dst + stride * y, &zone_plate_[bytes * (y - bar_rows_)], bytes);
+    }
+  }
+
+  // One barcode row, most significant bit first, then copies of it
+  const int cell = width_ / kCounterBits;
+  uint8_t* row = dst + stride * counter_top_;
+  for (int x = 0; x < width_; x++) {
+    int bit = x / cell;
+    bool set = bit < kCounterBits && ((frame_number >> (kCounterBits - 1 - bit)) & 1) != 0;
+    row[x * 2] = kNeutralChroma;
+    row[x * 2 + 1] = set ? kWhite : kBlack;
+  }
+  for (int y = counter_top_ + 1; y < height_; y++) {
+    memcpy(dst + stride * y, row, bytes);
+  }
+}
+
+bool TestPatternGenerator::DecodeFrameCounter(const uint8_t* luma, size_t stride, int width,
+                                              int height, uint32_t* frame_number) {
+  int bar_rows;
+  int counter_top;
+
+  if (width < 2 * kCounterBits || height < 24) return false;
+  PatternLayout(height, &bar_rows, &counter_top);
+
+  const int cell = width / kCounterBits;
+  const uint8_t* row = luma + stride * ((counter_top + height) / 2);
+  uint32_t value = 0;
+  for (int bit = 0; bit < kCounterBits; bit++) {
+    uint8_t y = row[bit * cell + cell / 2];
+    if (y > kDecodeBlackMax && y < kDecodeWhiteMin) return false;
+    value = (value << 1) | (y >= kDecodeWhiteMin ? 1 : 0);
+  }
+  *frame_number = value;
+  return true;
+}
+
+TestToneGenerator::TestToneGenerator() { Init(-18.0); }
+
+void TestToneGenerator::Init(double level_dbfs) {
+  double amplitude = pow(10.0, level_dbfs / 20.0);
+  if (amplitude > 1.0) amplitude = 1.0;
+  for (int i = 0; i < kCycleSamples; i++) {
+    double phase = 2.0 * M_PI * i / kCycleSamples;
+    cycle_[i] = static_cast<int32_t>(lround(amplitude * 2147483647.0 * sin(phase)));
+  }
+}
+
+void TestToneGenerator::Render(int64_t position, int channels, int sample_bytes, void* dst,
+                               size_t frames) const {
+  const int64_t period = static_cast<int64_t>(kSampleRate) * kIdentPeriodMs / 1000;
+  const int64_t gap = static_cast<int64_t>(kSampleRate) * kIdentGapMs / 1000;
+  int16_t* dst16 = static_cast<int16_t*>(dst);
+  int32_t* dst32 = static_cast<int32_t*>(dst);
+
+  for (size_t i = 0; i < frames; i++) {
+    int64_t sample = position + static_cast<int64_t>(i);
+    int64_t ident = sample % period;
+    int32_t value = cycle_[sample % kCycleSamples];
+
+    for (int c = 0; c < channels; c++) {
+      int32_t out = ident < gap * (c + 1) ? 0 : value;
+      if (sample_bytes == 2) {
+        *dst16++ = static_cast<int16_t>(out >> 16);
+      } else {
+        *dst32++ = out;
+      }
+    }
+  }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// Synthetic UYVY test pattern for load testing without a source, at any even
+// width and height. From the top: 75% colour bars (BT.709) scrolling left by
+// kBarScrollPixels a frame, a static circular zone plate that sweeps up to
+// Nyquist at its left and right edges, and a barcode of the frame number that
+// DecodeFrameCounter() reads back after conversion, to spot dropped or
+// reordered frames downstream.
+//
+// Init() precomputes two cycles of one bar row and the whole zone plate, so
+// rendering a frame only copies rows and writes the barcode; nothing is
+// allocated per frame.
+class TestPatternGenerator {
+ public:
+  static const int kBarScrollPixels = 8;
+  static const int kCounterBits = 32;
+
+  TestPatternGenerator();
+
+  TestPatternGenerator(const TestPatternGenerator&) = delete;
+  TestPatternGenerator& operator=(const TestPatternGenerator&) = delete;
+
+  bool Init(int width, int height);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  size_t row_bytes() const { return static_cast<size_t>(width_) * 2; }
+
+  // Renders frame |frame_number| into |dst|, |stride| bytes per row. With
+  // |static_valid| the zone plate is assumed to be in |dst| already, from an
+  // earlier frame of this generator, and is not copied again.
+  void RenderUyvy(uint32_t frame_number, uint8_t* dst, size_t stride, bool static_valid) const;
+
+  // Reads the frame number back from the luma plane of a frame this pattern
+  // rendered at |width| x |height|. Returns false unless every barcode cell is
+  // clearly black or white.
+  static bool DecodeFrameCounter(const uint8_t* luma, size_t stride, int width, int height,
+                                 uint32_t* frame_number);
+
+ private:
+  int width_;
+  int height_;
+  int bar_rows_;
+  int counter_top_;
+  std::vector<uint8_t> bar_row_;     // Two bar cycles, so any scroll is one copy
+  std::vector<uint8_t> zone_plate_;  // Rows bar_rows_ to counter_top_
+};
+
+// 1 kHz line-up tone with a channel ident: at the start of every
+// kIdentPeriodMs, channel n (from 0) drops out for (n + 1) * kIdentGapMs, so
+// it can be told apart wherever routing puts it. A tone cycle is exactly 48
+// samples at 48 kHz, so samples come from one table and never drift.
+class TestToneGenerator {
+ public:
+  static const int kSampleRate = 48000;
+  static const int kToneHz = 1000;
+  static const int kIdentPeriodMs = 4000;
+  static const int kIdentGapMs = 100;
+
+  TestToneGenerator();
+
+  // Peak level of the tone in dBFS.
+  void Init(double level_dbfs);
+
+  // Writes |frames| frames of |channels| interleaved 16-bit (|sample_bytes|
+  // 2) or 32-bit (4) samples, starting at absolute sample |position|.
+  void Render(int64_t position, int channels, int sample_bytes, void* dst, size_t frames) const;
+
+ private:
+  static const int kCycleSamples = kSampleRate / kToneHz;
+
+  int32_t cycle_[kCycleSamples];
+};
@@ -0,0 +1,117 @@
+#include "worker_pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#include "utils/log.h"
+
+WorkerPool::WorkerPool()
+    : generation_(0),
+      pending_workers_(0),
+      stopping_(false),
+      task_(nullptr),
+      context_(nullptr),
+      count_(0),
+      next_(0) {}
+
+WorkerPool::~WorkerPool() { Stop(); }
+
+bool WorkerPool::Start(int thread_count, bool pin, const char* name) {
+  Stop();
+  if (thread_count <= 0) return true;
+
+  std::vector<int> cpus;
+  if (pin) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+      for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+      }
+    }
+  }
+
+  stopping_ = false;
+  generation_ = 0;
+  threads_.reserve(thread_count);
+  for (int i = 0; i < thread_count; i++) {
+    threads_.emplace_back(&WorkerPool::WorkerLoop, this);
+    pthread_t handle = threads_.back().native_handle();
+
+    char thread_name[16];
+    snprintf(thread_name, sizeof(thread_name), "%s-%d", name, i);
+    pthread_setname_np(handle, thread_name);
+
+    if (!cpus.empty()) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(cpus[(i + 1) % cpus.size()], &set);
+      if (pthread_setaffinity_np(handle, sizeof(set), &set) != 0) {
+        AG_LOG(WARNING, "WorkerPool: failed to pin %s to cpu %d", thread_name,
+               cpus[(i + 1) % cpus.size()]);
+      }
+    }
+  }
+  return true;
+}
+
+void WorkerPool::Stop() {
+  {
+    std::lock_guard<std::mutex> _(lock_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto& thread : threads_) thread.join();
+  threads_.clear();
+}
+
+void WorkerPool::ParallelFor(int count, TaskFunc task, void* context) {
+  if (threads_.empty() || count <= 1) {
+    for (int i = 0; i < count; i++) task(context, i);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> _(lock_);
+    task_ = task;
+    context_ = context;
+    count_ = count;
+    next_.store(0, std::memory_order_relaxed);
+    pending_workers_ = static_cast<int>(threads_.size());
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  RunTasks();
+
+  // Wait for stragglers still running a task, and for workers that have not
+  // woken yet, so none can pick up a task of the next job with stale state.
+  std::unique_lock<std::mutex> lock(lock_);
+  done_.wait(lock, [this] { return pending_workers_ == 0; });
+}
+
+void WorkerPool::RunTasks() {
+  for (;;) {
+    int index = next_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= count_) break;
+    task_(context_, index);
+  }
+}
+
+void WorkerPool::WorkerLoop() {
+  uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+      if (stopping_) return;
+      seen = generation_;
+    }
+
+    RunTasks();
+
+    std::lock_guard<std::mutex> _(lock_);
+    if (--pending_workers_ == 0) done_.notify_one();
+  }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs index-parallel jobs on persistent threads.
+//
+// ParallelFor() splits a job into |count| tasks that the workers and the
+// calling thread claim one at a time, and returns once every task is done and
+// every worker has left the job. Threads are created once in Start() and can
+// be pinned to CPUs, so a job costs one wakeup per worker and no allocation.
+// Jobs must be issued from one thread at a time.
+class WorkerPool {
+ public:
+  typedef void (*TaskFunc)(void* context, int index);
+
+  WorkerPool();
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // Starts |thread_count| workers; zero is valid and makes ParallelFor() run
+  // inline. With |pin|, worker i is bound to CPU i + 1 of the process
+  // affinity mask (wrapping), keeping the first CPU for the calling thread.
+  bool Start(int thread_count, bool pin, const char* name = "worker");
+  void Stop();
+
+  int thread_count() const { return static_cast<int>(threads_.size()); }
+
+  void ParallelFor(int count, TaskFunc task, void* context);
+
+  // Calls func(index) for every index in [0, count).
+  template <typename Func>
+  void ParallelFor(int count, const Func& func) {
+    ParallelFor(count, &InvokeTask<Func>, const_cast<Func*>(&func));
+  }
+
+ private:
+  template <typename Func>
+  static void InvokeTask(void* context, int index) {
+    (*static_cast<const Func*>(context))(index);
+  }
+
+  void WorkerLoop();
+  void RunTasks();
+
+  std::vector<std::thread> threads_;
+
+  std::mutex lock_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  uint64_t generation_;
+  int pending_workers_;
+  bool stopping_;
+
+  // Current job; written under |lock_| before |generation_| changes and left
+  // alone until every worker has checked out.
+  TaskFunc task_;
+  void* context_;
+  int count_;
+  std::atomic<int> next_;
+};